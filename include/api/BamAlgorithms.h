@@ -12,6 +12,7 @@
 #ifndef BAMALGORITHMS_H
 #define BAMALGORITHMS_H
 
+#include "api/algorithms/RecordBuffer.h"
 #include "api/algorithms/Sort.h"
 
 /*! \namespace BamTools::Algorithms
@@ -2,7 +2,7 @@
 // BamIndex.h (c) 2009 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 10 October 2011 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Provides basic BAM index interface
 // ***************************************************************************
@@ -39,6 +39,7 @@ class API_EXPORT BamIndex {
         // list of supported BamIndex types
         enum IndexType { BAMTOOLS = 0
                        , STANDARD
+                       , CSI
                        };
   
     // ctor & dtor
@@ -2,7 +2,7 @@
 // BamMultiReader.h (c) 2010 Erik Garrison, Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 25 October 2011 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Convenience class for reading multiple BAM files.
 // ***************************************************************************
@@ -60,6 +60,8 @@ class API_EXPORT BamMultiReader {
                        const int& leftPosition,
                        const int& rightRefID,
                        const int& rightPosition);
+        // sets multiple target regions of interest
+        bool SetRegions(const std::vector<BamRegion>& regions);
 
         // ----------------------
         // access alignment data
@@ -69,6 +71,8 @@ class API_EXPORT BamMultiReader {
         bool GetNextAlignment(BamAlignment& alignment);
         // retrieves next available alignment (without populating the alignment's string data fields)
         bool GetNextAlignmentCore(BamAlignment& alignment);
+        // returns regions (from SetRegions()) that the last alignment retrieved overlaps
+        const std::vector<int>& GetCurrentRegionIndexes(void) const;
 
         // ----------------------
         // access auxiliary data
@@ -98,6 +102,26 @@ class API_EXPORT BamMultiReader {
         // opens index files for current BAM files.
         bool OpenIndexes(const std::vector<std::string>& indexFilenames);
 
+        // ----------------------
+        // decompressed block cache
+        // ----------------------
+
+        // returns number of BGZF blocks served from decompressed block cache
+        uint64_t GetBlockCacheHits(void) const;
+        // returns number of BGZF blocks not found in decompressed block cache
+        uint64_t GetBlockCacheMisses(void) const;
+        // sets size (in MB) of decompressed block cache, 0 disables cache
+        void SetBlockCacheSize(const unsigned int megabytes);
+
+        // ----------------------
+        // asynchronous reads
+        // ----------------------
+
+        // enables/disables asynchronous reads of local BAM files opened afterwards
+        void SetAsyncIO(bool ok);
+        // sets number of threads used to decompress each BAM file opened afterwards
+        void SetNumThreads(const unsigned int numThreads);
+
         // ----------------------
         // error handling
         // ----------------------
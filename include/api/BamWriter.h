@@ -2,7 +2,7 @@
 // BamWriter.h (c) 2009 Michael Str�mberg, Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 10 October 2011 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Provides the basic functionality for producing BAM files
 // ***************************************************************************
@@ -42,6 +42,8 @@ class API_EXPORT BamWriter {
     public:
         //  closes the current BAM file
         void Close(void);
+        // copies all alignments of another BAM file, mostly without decompressing them
+        bool CopyAlignments(const std::string& filename);
         // returns a human-readable description of the last error that occurred
         std::string GetErrorString(void) const;
         // returns true if BAM file is open for writing
@@ -54,10 +56,16 @@ class API_EXPORT BamWriter {
         bool Open(const std::string& filename,
                   const SamHeader& samHeader,
                   const RefVector& referenceSequences);
+        // opens an existing BAM file, to save more alignments after its current ones
+        bool OpenForAppend(const std::string& filename);
         // saves the alignment to the alignment archive
         bool SaveAlignment(const BamAlignment& alignment);
+        // saves a raw BAM record (as retrieved by BamReader::GetNextRawAlignment())
+        bool SaveRawAlignment(const char* data, const size_t length);
         // sets the output compression mode
         void SetCompressionMode(const BamWriter::CompressionMode& compressionMode);
+        // sets the number of threads used to compress output
+        void SetNumThreads(const unsigned int numThreads);
 
     // private implementation
     private:
@@ -0,0 +1,110 @@
+// ***************************************************************************
+// RecordBuffer.h (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides a buffer of raw BAM records that can be sorted on packed
+// integer keys, without building BamAlignment objects.
+// ***************************************************************************
+
+#ifndef ALGORITHMS_RECORDBUFFER_H
+#define ALGORITHMS_RECORDBUFFER_H
+
+#include "api/api_global.h"
+#include "api/BamAux.h"
+#include <string>
+#include <vector>
+
+namespace BamTools {
+
+class BamReader;
+class BamWriter;
+
+namespace Algorithms {
+
+/*! \class BamTools::Algorithms::RecordBuffer
+    \brief Stores raw BAM records in a single arena & sorts them by extracted keys
+
+    Unlike the Sort function objects, which compare full BamAlignment objects,
+    RecordBuffer extracts a fixed-width integer key from each raw record as it is
+    added. Sorting then only moves (key, offset) pairs around, using an LSD radix
+    sort, and the records themselves are never decoded.
+
+    \code
+        BamReader reader;
+        BamWriter writer;
+        // open files
+
+        Algorithms::RecordBuffer buffer(Algorithms::RecordBuffer::ByPosition);
+        while ( buffer.Add(reader) ) { }
+        buffer.Sort();
+        buffer.Write(writer);
+    \endcode
+*/
+class API_EXPORT RecordBuffer {
+
+    // enums
+    public:
+        //! Provides explicit values for the key extracted from each record
+        enum SortKey { ByPosition = 0 //!< (refID, position, strand), unmapped reads last
+                     , ByName         //!< read name (leading bytes as key, ties resolved on full name)
+                     };
+
+    // nested types
+    public:
+        //! A single buffered record's sort key & location in the arena
+        struct Entry {
+            uint64_t Key;    //!< packed sort key
+            uint64_t Offset; //!< offset of raw record in arena
+        };
+
+    // ctor & dtor
+    public:
+        explicit RecordBuffer(const SortKey& sortKey = ByPosition);
+        ~RecordBuffer(void);
+
+    // RecordBuffer interface
+    public:
+        // appends a raw record (as returned from BamReader::GetNextRawAlignment())
+        void Add(const char* data, const size_t length);
+        // reads next raw record from reader & appends it, returns false if none available
+        bool Add(BamReader& reader);
+        // removes all records
+        void Clear(void);
+        // returns number of buffered records
+        size_t Count(void) const;
+        // returns true if no records are buffered
+        bool IsEmpty(void) const;
+        // returns approximate number of bytes used by records & keys
+        size_t MemoryUsage(void) const;
+        // returns raw record at index (in current order)
+        const char* Record(const size_t index) const;
+        // stable-sorts records on their keys
+        void Sort(void);
+        // saves all records to writer (in current order)
+        bool Write(BamWriter& writer) const;
+
+    // static key & sort methods
+    public:
+        // compares read names of two raw records (as strcmp)
+        static int CompareNames(const char* lhs, const char* rhs);
+        // returns the name key (first 8 name bytes starting at offset) for a raw record
+        static uint64_t NameKey(const char* data, const size_t offset = 0);
+        // returns the coordinate key for a raw record
+        static uint64_t PositionKey(const char* data);
+        // stable LSD radix sort on entry keys
+        static void RadixSort(std::vector<Entry>& entries);
+
+    // data members
+    private:
+        SortKey m_sortKey;
+        std::vector<char>  m_arena;
+        std::vector<Entry> m_entries;
+        std::string m_record;
+};
+
+} // namespace Algorithms
+} // namespace BamTools
+
+#endif // ALGORITHMS_RECORDBUFFER_H
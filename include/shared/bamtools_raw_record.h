@@ -0,0 +1,216 @@
+// ***************************************************************************
+// bamtools_raw_record.h (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides access to the fields & tags of a raw BAM alignment record (as read
+// by BamReader::GetNextRawAlignment()), without building a BamAlignment.
+// Shared by the API & toolkit.
+// ***************************************************************************
+
+#ifndef BAMTOOLS_RAW_RECORD_H
+#define BAMTOOLS_RAW_RECORD_H
+
+#include "api/BamAux.h"
+#include "api/BamConstants.h"
+#include <cstring>
+#include <string>
+
+namespace BamTools {
+
+// A raw record is laid out exactly as in the (uncompressed) BAM stream:
+//
+//   [ block length (4) | core data (32) | name | cigar | seq | qual | tags ]
+//
+// All multi-byte values are stored little-endian.
+struct RawRecord {
+
+    // byte offsets, relative to start of record (including block length)
+    enum Offset { BlockLengthOffset  = 0
+                , RefIdOffset        = 4
+                , PositionOffset     = 8
+                , BinMqNameOffset    = 12
+                , FlagNumCigarOffset = 16
+                , SeqLengthOffset    = 20
+                , MateRefIdOffset    = 24
+                , MatePositionOffset = 28
+                , InsertSizeOffset   = 32
+                , NameOffset         = 36
+                };
+
+    // array tag values start with element type & count
+    // (BAM_TAG_ARRAYBASE_SIZE also counts the tag name & 'B')
+    enum { TagArrayHeaderLength = Constants::BAM_TAG_ARRAYBASE_SIZE
+                                - Constants::BAM_TAG_TAGSIZE
+                                - Constants::BAM_TAG_TYPESIZE
+         };
+
+    // ---------------------------------------------
+    // value access
+
+    static inline int32_t ReadInt32(const char* data) {
+        int32_t value = BamTools::UnpackSignedInt(data);
+        if ( BamTools::SystemIsBigEndian() ) BamTools::SwapEndian_32(value);
+        return value;
+    }
+
+    static inline uint32_t ReadUInt32(const char* data) {
+        uint32_t value = BamTools::UnpackUnsignedInt(data);
+        if ( BamTools::SystemIsBigEndian() ) BamTools::SwapEndian_32(value);
+        return value;
+    }
+
+    static inline void WriteUInt32(char* data, uint32_t value) {
+        if ( BamTools::SystemIsBigEndian() ) BamTools::SwapEndian_32(value);
+        BamTools::PackUnsignedInt(data, value);
+    }
+
+    // ---------------------------------------------
+    // core data
+
+    // total number of bytes in record (block length + 4)
+    static inline uint32_t Size(const char* record) {
+        return ReadUInt32(record + BlockLengthOffset) + Constants::BAM_SIZEOF_INT;
+    }
+
+    static inline int32_t RefID(const char* record) {
+        return ReadInt32(record + RefIdOffset);
+    }
+
+    static inline int32_t Position(const char* record) {
+        return ReadInt32(record + PositionOffset);
+    }
+
+    static inline uint16_t Bin(const char* record) {
+        return ReadUInt32(record + BinMqNameOffset) >> 16;
+    }
+
+    static inline uint16_t MapQuality(const char* record) {
+        return ( ReadUInt32(record + BinMqNameOffset) >> 8 ) & 0xff;
+    }
+
+    static inline uint32_t NameLength(const char* record) {
+        return ReadUInt32(record + BinMqNameOffset) & 0xff;
+    }
+
+    static inline uint32_t AlignmentFlag(const char* record) {
+        return ReadUInt32(record + FlagNumCigarOffset) >> 16;
+    }
+
+    static inline uint32_t NumCigarOperations(const char* record) {
+        return ReadUInt32(record + FlagNumCigarOffset) & 0xffff;
+    }
+
+    static inline uint32_t SeqLength(const char* record) {
+        return ReadUInt32(record + SeqLengthOffset);
+    }
+
+    // read name (null-terminated)
+    static inline const char* Name(const char* record) {
+        return record + NameOffset;
+    }
+
+    // offset of base qualities (SeqLength() bytes)
+    static inline size_t QualitiesOffset(const char* record) {
+        const uint32_t seqLength = SeqLength(record);
+        return NameOffset + NameLength(record)
+             + NumCigarOperations(record)*Constants::BAM_SIZEOF_INT
+             + (seqLength+1)/2;
+    }
+
+    // offset of tag data (runs to end of record)
+    static inline size_t TagDataOffset(const char* record) {
+        return QualitiesOffset(record) + SeqLength(record);
+    }
+
+    // calculates alignment end position (same as BamAlignment::GetEndPosition())
+    static inline int32_t EndPosition(const char* record) {
+        int32_t end = Position(record);
+        const char* cigar = record + NameOffset + NameLength(record);
+        const uint32_t numCigarOps = NumCigarOperations(record);
+        for ( uint32_t i = 0; i < numCigarOps; ++i ) {
+            const uint32_t op = ReadUInt32(cigar + i*Constants::BAM_SIZEOF_INT);
+            switch ( op & Constants::BAM_CIGAR_MASK ) {
+                case ( Constants::BAM_CIGAR_MATCH )    :
+                case ( Constants::BAM_CIGAR_DEL )      :
+                case ( Constants::BAM_CIGAR_REFSKIP )  :
+                case ( Constants::BAM_CIGAR_SEQMATCH ) :
+                case ( Constants::BAM_CIGAR_MISMATCH ) :
+                    end += ( op >> Constants::BAM_CIGAR_SHIFT );
+                    break;
+                default:
+                    break;
+            }
+        }
+        return end;
+    }
+
+    // ---------------------------------------------
+    // tags
+
+    // returns size of a single (non-array) tag value, or 0 for variable-length & unknown types
+    static inline size_t TagValueSize(const char type) {
+        switch ( type ) {
+            case (Constants::BAM_TAG_TYPE_ASCII)  :
+            case (Constants::BAM_TAG_TYPE_INT8)   :
+            case (Constants::BAM_TAG_TYPE_UINT8)  : return 1;
+            case (Constants::BAM_TAG_TYPE_INT16)  :
+            case (Constants::BAM_TAG_TYPE_UINT16) : return 2;
+            case (Constants::BAM_TAG_TYPE_INT32)  :
+            case (Constants::BAM_TAG_TYPE_UINT32) :
+            case (Constants::BAM_TAG_TYPE_FLOAT)  : return 4;
+            default                               : return 0;
+        }
+    }
+
+    // returns end of the tag starting at @tagData, or 0 if it is malformed or runs past @tagEnd
+    static inline const char* SkipTag(const char* tagData, const char* tagEnd) {
+
+        if ( tagData + Constants::BAM_TAG_TAGSIZE + Constants::BAM_TAG_TYPESIZE > tagEnd )
+            return 0;
+        const char type = tagData[Constants::BAM_TAG_TAGSIZE];
+        const char* value = tagData + Constants::BAM_TAG_TAGSIZE + Constants::BAM_TAG_TYPESIZE;
+
+        if ( type == Constants::BAM_TAG_TYPE_STRING || type == Constants::BAM_TAG_TYPE_HEX ) {
+            const char* terminator = static_cast<const char*>( memchr(value, '\0', tagEnd - value) );
+            return ( terminator == 0 ? 0 : terminator + 1 );
+        }
+
+        if ( type == Constants::BAM_TAG_TYPE_ARRAY ) {
+            if ( value + TagArrayHeaderLength > tagEnd ) return 0;
+            const size_t elementSize = TagValueSize(value[0]);
+            if ( elementSize == 0 ) return 0;
+            const uint64_t numElements = ReadUInt32(value + Constants::BAM_TAG_TYPESIZE);
+            const uint64_t valueSize = TagArrayHeaderLength + numElements*elementSize;
+            return ( valueSize > static_cast<uint64_t>(tagEnd - value) ? 0 : value + valueSize );
+        }
+
+        const size_t valueSize = TagValueSize(type);
+        if ( valueSize == 0 || value + valueSize > tagEnd ) return 0;
+        return value + valueSize;
+    }
+
+    // returns start of tag's value in record (& stores its type), or 0 if not found
+    static inline const char* FindTag(const char* record, const std::string& tag, char& type) {
+
+        if ( tag.size() != Constants::BAM_TAG_TAGSIZE )
+            return 0;
+
+        const char* tagData = record + TagDataOffset(record);
+        const char* tagEnd  = record + Size(record);
+        while ( tagData + Constants::BAM_TAG_TAGSIZE + Constants::BAM_TAG_TYPESIZE <= tagEnd ) {
+            if ( tagData[0] == tag[0] && tagData[1] == tag[1] ) {
+                type = tagData[Constants::BAM_TAG_TAGSIZE];
+                return tagData + Constants::BAM_TAG_TAGSIZE + Constants::BAM_TAG_TYPESIZE;
+            }
+            tagData = SkipTag(tagData, tagEnd);
+            if ( tagData == 0 ) return 0;
+        }
+        return 0;
+    }
+};
+
+} // namespace BamTools
+
+#endif // BAMTOOLS_RAW_RECORD_H
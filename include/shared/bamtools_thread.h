@@ -0,0 +1,128 @@
+// ***************************************************************************
+// bamtools_thread.h (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides minimal threading primitives (mutex, wait condition, thread),
+// shared by the API & toolkit. Implemented on top of POSIX threads.
+// ***************************************************************************
+
+#ifndef BAMTOOLS_THREAD_H
+#define BAMTOOLS_THREAD_H
+
+#include <pthread.h>
+
+namespace BamTools {
+
+/*! \brief Mutual exclusion lock
+    \internal
+*/
+class BamMutex {
+
+    public:
+        BamMutex(void)  { pthread_mutex_init(&m_mutex, 0); }
+        ~BamMutex(void) { pthread_mutex_destroy(&m_mutex); }
+
+        void Lock(void)   { pthread_mutex_lock(&m_mutex); }
+        void Unlock(void) { pthread_mutex_unlock(&m_mutex); }
+
+    private:
+        // not copyable
+        BamMutex(const BamMutex&);
+        BamMutex& operator=(const BamMutex&);
+
+    private:
+        pthread_mutex_t m_mutex;
+        friend class BamWaitCondition;
+};
+
+/*! \brief Locks a BamMutex for the lifetime of this object
+    \internal
+*/
+class BamMutexLocker {
+
+    public:
+        explicit BamMutexLocker(BamMutex& mutex)
+            : m_mutex(mutex)
+        {
+            m_mutex.Lock();
+        }
+        ~BamMutexLocker(void) { m_mutex.Unlock(); }
+
+    private:
+        // not copyable
+        BamMutexLocker(const BamMutexLocker&);
+        BamMutexLocker& operator=(const BamMutexLocker&);
+
+    private:
+        BamMutex& m_mutex;
+};
+
+/*! \brief Condition variable, used together with a (locked) BamMutex
+    \internal
+*/
+class BamWaitCondition {
+
+    public:
+        BamWaitCondition(void)  { pthread_cond_init(&m_condition, 0); }
+        ~BamWaitCondition(void) { pthread_cond_destroy(&m_condition); }
+
+        // atomically unlocks mutex & waits, mutex is re-locked before returning
+        void Wait(BamMutex& mutex) { pthread_cond_wait(&m_condition, &mutex.m_mutex); }
+        void WakeOne(void) { pthread_cond_signal(&m_condition); }
+        void WakeAll(void) { pthread_cond_broadcast(&m_condition); }
+
+    private:
+        // not copyable
+        BamWaitCondition(const BamWaitCondition&);
+        BamWaitCondition& operator=(const BamWaitCondition&);
+
+    private:
+        pthread_cond_t m_condition;
+};
+
+/*! \brief Base class for a thread of execution - subclasses implement Run()
+    \internal
+*/
+class BamThread {
+
+    public:
+        BamThread(void) : m_isStarted(false) { }
+        virtual ~BamThread(void) { Wait(); }
+
+        // starts executing Run() in a new thread, returns false if thread could not be created
+        bool Start(void) {
+            if ( m_isStarted ) return false;
+            m_isStarted = ( pthread_create(&m_thread, 0, &BamThread::Execute, this) == 0 );
+            return m_isStarted;
+        }
+
+        // blocks until Run() has returned (no-op if thread was never started)
+        void Wait(void) {
+            if ( !m_isStarted ) return;
+            pthread_join(m_thread, 0);
+            m_isStarted = false;
+        }
+
+    protected:
+        virtual void Run(void) = 0;
+
+    private:
+        static void* Execute(void* thread) {
+            static_cast<BamThread*>(thread)->Run();
+            return 0;
+        }
+
+        // not copyable
+        BamThread(const BamThread&);
+        BamThread& operator=(const BamThread&);
+
+    private:
+        pthread_t m_thread;
+        bool m_isStarted;
+};
+
+} // namespace BamTools
+
+#endif // BAMTOOLS_THREAD_H
@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+# ***************************************************************************
+# bam_http_server.py (c) 2026
+# Marth Lab, Department of Biology, Boston College
+# ---------------------------------------------------------------------------
+# Last modified: 19 October 2026
+# ---------------------------------------------------------------------------
+# Local stand-in for a remote HTTP server hosting BAM files, for exercising
+# BamHttp (http:// inputs). Serves files below a directory, with single byte
+# range support, & can mimic less capable servers:
+#
+#   --ignore-range   answers every GET with the full file (200), ignoring Range
+#   --http10         answers as HTTP/1.0 & closes the connection after each
+#                    response (without saying so in a Connection header)
+#   --hide-size      sends 'Content-Range: bytes a-b/*', so the client only
+#                    finds the end of the file from a 416 response
+#
+# & can make it look far away:
+#
+#   --latency MS     waits MS milliseconds before answering each request
+#   --rate KB        sends each response at no more than KB kilobytes/s
+#                    (i.e. limits each connection's bandwidth)
+#
+# Each request is logged (to --log, or stderr) as one line:
+#
+#   <connection> <method> <path> <range> <status> <body bytes>
+#
+# where <connection> identifies the client connection it arrived on.
+# ***************************************************************************
+
+import argparse
+import os
+import re
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import unquote, urlsplit
+
+CHUNK_SIZE = 0x10000
+RANGE_PATTERN = re.compile(r'^bytes=(\d+)-(\d*)$')
+
+
+class BamHttpHandler(BaseHTTPRequestHandler):
+
+    protocol_version = 'HTTP/1.1'
+
+    def do_GET(self):
+        self.send_file(True)
+
+    def do_HEAD(self):
+        self.send_file(False)
+
+    # BaseHTTPRequestHandler's own logging (replaced by log_request_line())
+    def log_message(self, format, *args):
+        pass
+
+    def log_request_line(self, status, num_bytes):
+        requested = self.headers.get('Range', '-').replace(' ', '')
+        self.server.log('%s:%d %s %s %s %d %d' % (self.client_address[0], self.client_address[1],
+                                                  self.command, self.path, requested,
+                                                  status, num_bytes))
+
+    def resolve_path(self):
+        relative = unquote(urlsplit(self.path).path).lstrip('/')
+        path = os.path.normpath(os.path.join(self.server.root, relative))
+        if not path.startswith(self.server.root + os.sep) or not os.path.isfile(path):
+            return None
+        return path
+
+    def send_file(self, is_body_sent):
+
+        # round trip to a distant server
+        if self.server.latency > 0:
+            time.sleep(self.server.latency)
+
+        path = self.resolve_path()
+        if path is None:
+            self.send_empty(404)
+            return
+        file_size = os.path.getsize(path)
+
+        # work out which part of file was requested
+        status, start, end = 200, 0, file_size - 1
+        requested = self.headers.get('Range')
+        if requested and not self.server.ignore_range:
+            match = RANGE_PATTERN.match(requested.replace(' ', ''))
+            if match:
+                start = int(match.group(1))
+                if start >= file_size:
+                    self.send_empty(416, 'bytes */%d' % file_size)
+                    return
+                if match.group(2):
+                    end = min(int(match.group(2)), file_size - 1)
+                status = 206
+
+        num_bytes = end - start + 1
+        self.send_response(status)
+        self.send_header('Content-Type', 'application/octet-stream')
+        self.send_header('Content-Length', str(num_bytes))
+        if not self.server.ignore_range:
+            self.send_header('Accept-Ranges', 'bytes')
+        if status == 206:
+            total_size = '*' if self.server.hide_size else str(file_size)
+            self.send_header('Content-Range', 'bytes %d-%d/%s' % (start, end, total_size))
+        self.end_headers()
+        self.log_request_line(status, num_bytes if is_body_sent else 0)
+
+        if is_body_sent:
+            with open(path, 'rb') as f:
+                f.seek(start)
+                self.send_body(f, num_bytes)
+
+    def send_body(self, f, num_bytes):
+        started = time.time()
+        num_sent = 0
+        while num_sent < num_bytes:
+            data = f.read(min(CHUNK_SIZE, num_bytes - num_sent))
+            if not data:
+                break
+            self.wfile.write(data)
+            num_sent += len(data)
+
+            # hold back until connection's bandwidth allows for what was sent so far
+            if self.server.rate > 0:
+                delay = started + float(num_sent) / self.server.rate - time.time()
+                if delay > 0:
+                    time.sleep(delay)
+
+    def send_empty(self, status, content_range=None):
+        self.send_response(status)
+        self.send_header('Content-Length', '0')
+        if content_range is not None:
+            self.send_header('Content-Range', content_range)
+        self.end_headers()
+        self.log_request_line(status, 0)
+
+
+class BamHttpServer(ThreadingHTTPServer):
+
+    daemon_threads = True
+    allow_reuse_address = True
+
+    def __init__(self, address, options):
+        handler = type('Handler', (BamHttpHandler,),
+                       {'protocol_version': 'HTTP/1.0' if options.http10 else 'HTTP/1.1'})
+        ThreadingHTTPServer.__init__(self, address, handler)
+        self.root = os.path.abspath(options.root)
+        self.ignore_range = options.ignore_range
+        self.hide_size = options.hide_size
+        self.latency = options.latency / 1000.0
+        self.rate = options.rate * 1024
+        self.log_file = open(options.log, 'a') if options.log else sys.stderr
+        self.log_lock = threading.Lock()
+
+    # clients may hang up mid-response (e.g. abandoned prefetches), that's not an error here
+    def handle_error(self, request, client_address):
+        if not isinstance(sys.exc_info()[1], ConnectionError):
+            ThreadingHTTPServer.handle_error(self, request, client_address)
+
+    def log(self, line):
+        with self.log_lock:
+            self.log_file.write(line + '\n')
+            self.log_file.flush()
+
+
+def parse_args(args=None):
+    parser = argparse.ArgumentParser(description='Serves BAM files over HTTP for testing BamHttp.')
+    parser.add_argument('--port', type=int, default=8000, help='port to listen on (default: 8000)')
+    parser.add_argument('--root', default='.', help='directory to serve (default: current)')
+    parser.add_argument('--log', help='file to append request log to (default: stderr)')
+    parser.add_argument('--ignore-range', action='store_true', help='always send full file (200)')
+    parser.add_argument('--http10', action='store_true', help='close connection after each response')
+    parser.add_argument('--hide-size', action='store_true', help="send '*' as total size in Content-Range")
+    parser.add_argument('--latency', type=int, default=0, help='delay before each response, in ms')
+    parser.add_argument('--rate', type=int, default=0, help='max rate per connection, in KB/s')
+    return parser.parse_args(args)
+
+
+def main():
+    options = parse_args()
+    server = BamHttpServer(('127.0.0.1', options.port), options)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    server.server_close()
+
+
+if __name__ == '__main__':
+    main()
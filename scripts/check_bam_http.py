@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+# ***************************************************************************
+# check_bam_http.py (c) 2026
+# Marth Lab, Department of Biology, Boston College
+# ---------------------------------------------------------------------------
+# Last modified: 19 October 2026
+# ---------------------------------------------------------------------------
+# Checks that bamtools reads a BAM file over HTTP exactly as it reads the local
+# file, against each kind of server bam_http_server.py can mimic:
+#
+#   range        HTTP/1.1 with Range & keep-alive (connections are reused)
+#   ignore-range server sends full file (200), reader skips ahead on the stream
+#   http10       server closes connection after each response (reader reconnects)
+#   hide-size    file size unknown up front, so reading runs into a 416 at end of
+#                file (served BAM is a copy without its BGZF EOF marker block,
+#                otherwise reading stops at the marker)
+#
+# For each, a full read & a region query (BAM must be indexed) are converted to
+# SAM & compared with the same commands on the local file, & the server's
+# request log is checked for the status codes & connection use expected.
+#
+# usage: check_bam_http.py [--bamtools bin/bamtools] file.bam chr1:1000..50000
+# ***************************************************************************
+
+import argparse
+import hashlib
+import os
+import shutil
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+SERVER_SCRIPT = os.path.join(SCRIPT_DIR, 'bam_http_server.py')
+
+BGZF_EOF_MARKER_LENGTH = 28
+INDEX_EXTENSIONS = ['.bai', '.bti']
+
+# server options & request log expectations, per server kind
+SERVER_KINDS = [
+    ('range',        [],                 {'statuses': {206}, 'reused': True}),
+    ('ignore-range', ['--ignore-range'], {'statuses': {200}}),
+    ('http10',       ['--http10'],       {'statuses': {206}, 'reused': False}),
+    ('hide-size',    ['--hide-size'],    {'statuses': {206, 416}, 'full_read_ends': 416,
+                                          'no_eof_marker': True}),
+]
+
+
+class RequestLog(object):
+
+    def __init__(self, path):
+        self.requests = []
+        with open(path) as f:
+            for line in f:
+                fields = line.split()
+                if len(fields) == 6:
+                    self.requests.append({'connection': fields[0], 'path': fields[2],
+                                          'status': int(fields[4])})
+
+    # requests for the BAM file itself (leaves out index lookups)
+    def data_requests(self, bam_name):
+        return [r for r in self.requests if r['path'].endswith('/' + bam_name)]
+
+
+def free_port():
+    s = socket.socket()
+    s.bind(('127.0.0.1', 0))
+    port = s.getsockname()[1]
+    s.close()
+    return port
+
+
+def start_server(root, options, log_path):
+    port = free_port()
+    server = subprocess.Popen([sys.executable, SERVER_SCRIPT, '--port', str(port), '--root', root,
+                               '--log', log_path] + options)
+    for _ in range(100):
+        try:
+            socket.create_connection(('127.0.0.1', port), 0.1).close()
+            return server, port
+        except OSError:
+            time.sleep(0.05)
+    server.kill()
+    raise RuntimeError('HTTP server did not start')
+
+
+def run_bamtools(bamtools, args):
+    result = subprocess.run([bamtools] + args, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    return result.returncode, hashlib.md5(result.stdout).hexdigest(), result.stderr.decode().strip()
+
+
+# sets up directory to serve, with (links to) BAM & its index, & a copy of the BAM
+# without EOF marker under 'no_eof_marker/'
+def make_server_root(bam):
+    root = tempfile.mkdtemp(prefix='check_bam_http.')
+    os.mkdir(os.path.join(root, 'no_eof_marker'))
+    bam_name = os.path.basename(bam)
+    for extension in [''] + INDEX_EXTENSIONS:
+        if os.path.exists(bam + extension):
+            for directory in [root, os.path.join(root, 'no_eof_marker')]:
+                os.symlink(os.path.abspath(bam + extension), os.path.join(directory, bam_name + extension))
+    stripped = os.path.join(root, 'no_eof_marker', bam_name)
+    os.remove(stripped)
+    with open(bam, 'rb') as f:
+        data = f.read()
+    with open(stripped, 'wb') as f:
+        f.write(data[:-BGZF_EOF_MARKER_LENGTH])
+    return root
+
+
+def check_log(log, bam_name, expected, is_full_read):
+    problems = []
+    requests = log.data_requests(bam_name)
+    if not requests:
+        return ['no requests for %s' % bam_name]
+    statuses = set(r['status'] for r in requests)
+    if not statuses <= expected['statuses']:
+        problems.append('statuses %s, expected %s' % (sorted(statuses), sorted(expected['statuses'])))
+    if is_full_read and 'full_read_ends' in expected and requests[-1]['status'] != expected['full_read_ends']:
+        problems.append('last status %d, expected %d' % (requests[-1]['status'], expected['full_read_ends']))
+    if 'reused' in expected:
+        num_connections = len(set(r['connection'] for r in requests))
+        is_reused = num_connections < len(requests)
+        if is_reused != expected['reused']:
+            problems.append('%d requests over %d connections' % (len(requests), num_connections))
+    return problems
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compares bamtools reads over HTTP with local reads.')
+    parser.add_argument('--bamtools', default=os.path.join(SCRIPT_DIR, '..', 'bin', 'bamtools'))
+    parser.add_argument('bam', help='indexed BAM file')
+    parser.add_argument('region', help="region for query, e.g. 'chr1:1000..50000'")
+    options = parser.parse_args()
+
+    bam_name = os.path.basename(options.bam)
+    root = make_server_root(os.path.abspath(options.bam))
+    checks = [('full read', ['convert', '-format', 'sam']),
+              ('region query', ['convert', '-format', 'sam', '-region', options.region])]
+
+    # expected output, from local file
+    expected_md5 = {}
+    for name, args in checks:
+        rc, md5, error = run_bamtools(options.bamtools, args + ['-in', options.bam])
+        if rc != 0:
+            sys.exit('local %s failed: %s' % (name, error))
+        expected_md5[name] = md5
+
+    num_failed = 0
+    for kind, server_options, expected in SERVER_KINDS:
+        for name, args in checks:
+
+            log_fd, log_path = tempfile.mkstemp(suffix='.log')
+            os.close(log_fd)
+            server, port = start_server(root, server_options, log_path)
+            try:
+                served_name = ( 'no_eof_marker/' if expected.get('no_eof_marker') else '' ) + bam_name
+                url = 'http://127.0.0.1:%d/%s' % (port, served_name)
+                rc, md5, error = run_bamtools(options.bamtools, args + ['-in', url])
+            finally:
+                server.terminate()
+                server.wait()
+            log = RequestLog(log_path)
+            os.remove(log_path)
+
+            problems = []
+            if rc != 0:
+                problems.append('exit code %d: %s' % (rc, error))
+            elif md5 != expected_md5[name]:
+                problems.append('output differs from local file')
+            problems += check_log(log, bam_name, expected, name == 'full read')
+
+            requests = log.data_requests(bam_name)
+            print('%-13s %-13s %-6s (%d requests, %d connections)%s'
+                  % (kind, name, 'FAILED' if problems else 'ok', len(requests),
+                     len(set(r['connection'] for r in requests)),
+                     ''.join('\n    ' + p for p in problems)))
+            if problems:
+                num_failed += 1
+
+    shutil.rmtree(root)
+    sys.exit(1 if num_failed else 0)
+
+
+if __name__ == '__main__':
+    main()
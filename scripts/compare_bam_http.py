@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+# ***************************************************************************
+# compare_bam_http.py (c) 2026
+# Marth Lab, Department of Biology, Boston College
+# ---------------------------------------------------------------------------
+# Last modified: 19 October 2026
+# ---------------------------------------------------------------------------
+# Times reads of a BAM file over HTTP from a server that injects latency &
+# limits each connection's bandwidth (see bam_http_server.py), for one or more
+# bamtools builds - e.g. with & without HttpRangeFetcher's extra connections.
+#
+# Each build reads the whole file (& optionally a region) at each rate. Output
+# is checked against the same build's read of the local file. The table shows time
+# taken, requests sent & connections used.
+#
+# usage: compare_bam_http.py --bamtools old/bin/bamtools --bamtools bin/bamtools
+#                            [--latency 100] [--rate 20480 --rate 5120]
+#                            file.bam [chr1:1000..50000]
+# ***************************************************************************
+
+import argparse
+import os
+import sys
+import tempfile
+import time
+
+from check_bam_http import SCRIPT_DIR, RequestLog, run_bamtools, start_server
+
+DEFAULT_LATENCY = 100           # ms
+DEFAULT_RATES   = [20480, 5120] # KB/s
+
+
+def time_read(bamtools, root, bam_name, args, server_options):
+
+    log_fd, log_path = tempfile.mkstemp(suffix='.log')
+    os.close(log_fd)
+    server, port = start_server(root, server_options, log_path)
+    try:
+        url = 'http://127.0.0.1:%d/%s' % (port, bam_name)
+        started = time.time()
+        rc, md5, error = run_bamtools(bamtools, args + ['-in', url])
+        elapsed = time.time() - started
+    finally:
+        server.terminate()
+        server.wait()
+    requests = RequestLog(log_path).data_requests(bam_name)
+    os.remove(log_path)
+
+    return { 'rc': rc, 'md5': md5, 'error': error, 'seconds': elapsed,
+             'requests': len(requests),
+             'connections': len(set(r['connection'] for r in requests)) }
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Times bamtools reads from a slow, distant HTTP server.')
+    parser.add_argument('--bamtools', action='append',
+                        help='bamtools build to time (may be given more than once)')
+    parser.add_argument('--latency', type=int, default=DEFAULT_LATENCY,
+                        help='delay before each response, in ms (default: %d)' % DEFAULT_LATENCY)
+    parser.add_argument('--rate', type=int, action='append',
+                        help='max rate per connection, in KB/s (may be given more than once, default: %s)'
+                             % ', '.join(str(r) for r in DEFAULT_RATES))
+    parser.add_argument('bam', help='BAM file (indexed, if a region is given)')
+    parser.add_argument('region', nargs='?', help="region for query, e.g. 'chr1:1000..50000'")
+    options = parser.parse_args()
+
+    builds = options.bamtools or [os.path.join(SCRIPT_DIR, '..', 'bin', 'bamtools')]
+    rates = options.rate or DEFAULT_RATES
+    root, bam_name = os.path.split(os.path.abspath(options.bam))
+
+    reads = [('full read', ['count'])]
+    if options.region:
+        reads.append(('region query', ['convert', '-format', 'sam', '-region', options.region]))
+
+    # expected output, from local file (per build, output format may differ between them)
+    expected_md5 = {}
+    for bamtools in builds:
+        for name, args in reads:
+            rc, md5, error = run_bamtools(bamtools, args + ['-in', options.bam])
+            if rc != 0:
+                sys.exit('%s: local %s failed: %s' % (bamtools, name, error))
+            expected_md5[(bamtools, name)] = md5
+
+    print('latency %d ms' % options.latency)
+    print('%-13s %9s  %-40s %8s %9s %12s' % ('read', 'KB/s', 'bamtools', 'seconds', 'requests', 'connections'))
+
+    num_failed = 0
+    for name, args in reads:
+        for rate in rates:
+            server_options = ['--latency', str(options.latency), '--rate', str(rate)]
+            for bamtools in builds:
+                result = time_read(bamtools, root, bam_name, args, server_options)
+
+                problem = ''
+                if result['rc'] != 0:
+                    problem = '  FAILED (exit code %d: %s)' % (result['rc'], result['error'])
+                elif result['md5'] != expected_md5[(bamtools, name)]:
+                    problem = '  FAILED (output differs from local file)'
+                if problem:
+                    num_failed += 1
+
+                print('%-13s %9d  %-40s %8.2f %9d %12d%s'
+                      % (name, rate, bamtools[-40:], result['seconds'], result['requests'],
+                         result['connections'], problem))
+
+    sys.exit(1 if num_failed else 0)
+
+
+if __name__ == '__main__':
+    main()
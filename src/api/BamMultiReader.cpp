@@ -2,7 +2,7 @@
 // BamMultiReader.cpp (c) 2010 Erik Garrison, Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 25 October 2011 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Convenience class for reading multiple BAM files.
 //
@@ -88,6 +88,35 @@ const std::vector<std::string> BamMultiReader::Filenames(void) const {
     return d->Filenames();
 }
 
+/*! \fn uint64_t BamMultiReader::GetBlockCacheHits(void) const
+    \brief Returns number of BGZF blocks served from the decompressed block caches, over all readers.
+    \sa BamReader::GetBlockCacheHits()
+*/
+uint64_t BamMultiReader::GetBlockCacheHits(void) const {
+    return d->GetBlockCacheHits();
+}
+
+/*! \fn uint64_t BamMultiReader::GetBlockCacheMisses(void) const
+    \brief Returns number of BGZF blocks not found in the decompressed block caches, over all readers.
+    \sa BamReader::GetBlockCacheMisses()
+*/
+uint64_t BamMultiReader::GetBlockCacheMisses(void) const {
+    return d->GetBlockCacheMisses();
+}
+
+/*! \fn const std::vector<int>& BamMultiReader::GetCurrentRegionIndexes(void) const
+    \brief Returns the regions overlapped by the last alignment retrieved.
+
+    After SetRegions(), lists (in ascending order) the positions in its \a regions
+    of every region that the alignment last returned by GetNextAlignment() or
+    GetNextAlignmentCore() overlaps. Empty if SetRegions() is not in effect.
+
+    \sa SetRegions(), BamReader::GetCurrentRegionIndexes()
+*/
+const std::vector<int>& BamMultiReader::GetCurrentRegionIndexes(void) const {
+    return d->GetCurrentRegionIndexes();
+}
+
 /*! \fn std::string BamMultiReader::GetErrorString(void) const
     \brief Returns a human-readable description of the last error that occurred
 
@@ -139,6 +168,9 @@ std::string BamMultiReader::GetHeaderText(void) const {
     This method takes care of determining which alignment actually is 'next'
     across multiple files, depending on their sort order.
 
+    Reading stops at the first alignment that can't be read from any of the files.
+    GetErrorString() then describes the problem (it is empty at the normal end of data).
+
     \param[out] alignment destination for alignment record data
     \returns \c true if a valid alignment was found
     \sa GetNextAlignmentCore(), SetRegion(), BamReader::GetNextAlignment()
@@ -321,6 +353,46 @@ bool BamMultiReader::Rewind(void) {
     return d->Rewind();
 }
 
+/*! \fn void BamMultiReader::SetAsyncIO(bool ok)
+    \brief Enables/disables asynchronous reads of local BAM files.
+
+    Applies to BAM files opened afterwards. All files read asynchronously share
+    one queue of reads in flight, so the storage device sees several requests at
+    once rather than one blocking read per file in turn.
+
+    \param[in] ok \c true to read asynchronously
+    \sa BamReader::SetAsyncIO()
+*/
+void BamMultiReader::SetAsyncIO(bool ok) {
+    d->SetAsyncIO(ok);
+}
+
+/*! \fn void BamMultiReader::SetBlockCacheSize(const unsigned int megabytes)
+    \brief Sets the size of each reader's decompressed block cache.
+
+    Applies to all open BAM files, as well as any opened later. Each file gets
+    its own cache of this size.
+
+    \param[in] megabytes maximum size of decompressed data held per file, in MB
+    \sa BamReader::SetBlockCacheSize()
+*/
+void BamMultiReader::SetBlockCacheSize(const unsigned int megabytes) {
+    d->SetBlockCacheSize(megabytes);
+}
+
+/*! \fn void BamMultiReader::SetNumThreads(const unsigned int numThreads)
+    \brief Sets the number of threads used to decompress each input file.
+
+    Applies to BAM files opened afterwards. Each file gets its own pool of
+    \a numThreads decompression threads.
+
+    \param[in] numThreads number of decompression threads per file
+    \sa BamReader::SetNumThreads()
+*/
+void BamMultiReader::SetNumThreads(const unsigned int numThreads) {
+    d->SetNumThreads(numThreads);
+}
+
 /*! \fn bool BamMultiReader::SetRegion(const BamRegion& region)
     \brief Sets a target region of interest
 
@@ -365,3 +437,18 @@ bool BamMultiReader::SetRegion(const int& leftRefID,
 {
     return d->SetRegion( BamRegion(leftRefID, leftPosition, rightRefID, rightPosition) );
 }
+
+/*! \fn bool BamMultiReader::SetRegions(const std::vector<BamRegion>& regions)
+    \brief Sets multiple target regions of interest
+
+    Equivalent to calling BamReader::SetRegions() on all open BAM files.
+    After each merged alignment, GetCurrentRegionIndexes() lists the positions
+    in \a regions of every region it overlaps.
+
+    \param[in] regions desired regions-of-interest to activate (may overlap, in any order)
+    \returns \c true if ALL readers set the regions successfully
+    \sa GetCurrentRegionIndexes(), HasIndexes(), SetRegion(), BamReader::SetRegions()
+*/
+bool BamMultiReader::SetRegions(const std::vector<BamRegion>& regions) {
+    return d->SetRegions(regions);
+}
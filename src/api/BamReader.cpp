@@ -2,7 +2,7 @@
 // BamReader.cpp (c) 2009 Derek Barnett, Michael Str�mberg
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 18 November 2012 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Provides read access to BAM files.
 // ***************************************************************************
@@ -50,6 +50,68 @@ bool BamReader::Close(void) {
     return d->Close();
 }
 
+/*! \fn bool BamReader::CountAlignments(uint64_t& count)
+    \brief Counts all alignments in BAM file.
+
+    Equivalent to CountAlignments(const BamRegion&, uint64_t&) with a null region.
+
+    \param[out] count number of alignments found
+    \return \c true if alignments counted OK
+*/
+bool BamReader::CountAlignments(uint64_t& count) {
+    return d->CountAlignments(BamRegion(), count);
+}
+
+/*! \fn bool BamReader::CountAlignments(const BamRegion& region, uint64_t& count)
+    \brief Counts alignments in region.
+
+    The count is the number of alignments that GetNextAlignment() would return after
+    SetRegion(\a region). A null region counts every alignment in the file.
+
+    Index statistics are used wherever they give an exact answer, so that little or no
+    alignment data has to be read. The standard & CSI index formats store the number of
+    alignments on each reference (a whole-file count then reads no alignments at all).
+    The BamTools index stores fixed-size blocks of alignments, so only the blocks that
+    straddle a region boundary are read. Without index data, only a whole-file count is
+    possible, and all alignments are read (input that can't be rewound, such as stdin,
+    is counted from the reader's current position).
+
+    Any region set on the reader is cleared. Call Rewind() or SetRegion() before
+    retrieving alignments afterwards.
+
+    \param[in]  region target region (a null region means entire file)
+    \param[out] count  number of alignments found
+    \return \c true if alignments counted OK
+    \sa SetRegion(), LocateIndex()
+*/
+bool BamReader::CountAlignments(const BamRegion& region, uint64_t& count) {
+    return d->CountAlignments(region, count);
+}
+
+/*! \fn bool BamReader::CreateCsiIndex(const int& minShift, const int& depth)
+    \brief Creates a CSI index file (*.csi) for current BAM file.
+
+    CSI generalizes the standard BAM index binning: the smallest bins span
+    2^\a minShift bases, and each of the \a depth levels above them is 8 times
+    coarser. A smaller \a minShift gives finer bins (less data read per
+    random-access query, larger index file). If the longest reference does not
+    fit into the requested scheme, levels are added until it does.
+
+    CreateIndex(BamIndex::CSI) is equivalent to CreateCsiIndex(14, 5), which
+    uses the same bins as the standard BAM index.
+
+    \a minShift must be at least 10, and \a depth at most 10 (so that bin IDs
+    fit into 32 bits).
+
+    \param[in] minShift bit-width of the smallest bins
+    \param[in] depth    number of bin levels (below the single bin covering everything)
+    \return \c true if index created OK
+    \sa CreateIndex(), LocateIndex(), OpenIndex()
+*/
+bool BamReader::CreateCsiIndex(const int& minShift, const int& depth) {
+    return d->CreateCsiIndex(minShift, depth);
+}
+
 /*! \fn bool BamReader::CreateIndex(const BamIndex::IndexType& type)
     \brief Creates an index file for current BAM file.
 
@@ -77,6 +139,42 @@ const SamHeader& BamReader::GetConstSamHeader(void) const {
     return d->GetConstSamHeader();
 }
 
+/*! \fn uint64_t BamReader::GetBlockCacheHits(void) const
+    \brief Returns number of BGZF blocks served from the decompressed block cache.
+
+    \sa GetBlockCacheMisses(), SetBlockCacheSize()
+*/
+uint64_t BamReader::GetBlockCacheHits(void) const {
+    return d->GetBlockCacheHits();
+}
+
+/*! \fn uint64_t BamReader::GetBlockCacheMisses(void) const
+    \brief Returns number of BGZF blocks looked up in, but not found in, the decompressed block cache.
+
+    Each miss means a block was read from the device & decompressed.
+
+    \sa GetBlockCacheHits(), SetBlockCacheSize()
+*/
+uint64_t BamReader::GetBlockCacheMisses(void) const {
+    return d->GetBlockCacheMisses();
+}
+
+/*! \fn const std::vector<int>& BamReader::GetCurrentRegionIndexes(void) const
+    \brief Returns the regions overlapped by the last alignment retrieved.
+
+    After SetRegions(), lists (in ascending order) the positions in its \a regions
+    of every region that the alignment last returned by GetNextAlignment(),
+    GetNextAlignmentCore() or GetNextRawAlignment() overlaps. Empty if SetRegions()
+    is not in effect.
+
+    The list is replaced by the next call to any of those methods.
+
+    \sa SetRegions()
+*/
+const std::vector<int>& BamReader::GetCurrentRegionIndexes(void) const {
+    return d->GetCurrentRegionIndexes();
+}
+
 /*! \fn std::string BamReader::GetErrorString(void) const
     \brief Returns a human-readable description of the last error that occurred
 
@@ -157,6 +255,9 @@ std::string BamReader::GetHeaderText(void) const {
     are required, consider using GetNextAlignmentCore() for a significant
     performance boost.
 
+    If no alignment is returned, GetErrorString() tells apart the end of the data (empty
+    description) from a record that could not be read, such as a malformed SAM line.
+
     \param[out] alignment destination for alignment record data
     \returns \c true if a valid alignment was found
 */
@@ -175,13 +276,31 @@ bool BamReader::GetNextAlignment(BamAlignment& alignment) {
     populated 'lazily' (as needed) by calling BamAlignment::BuildCharData() later.
 
     \param[out] alignment destination for alignment record data
-    \returns \c true if a valid alignment was found
+    \returns \c true if a valid alignment was found (see GetNextAlignment() on errors)
     \sa SetRegion()
 */
 bool BamReader::GetNextAlignmentCore(BamAlignment& alignment) {
     return d->GetNextAlignmentCore(alignment);
 }
 
+/*! \fn bool BamReader::GetNextRawAlignment(std::string& data)
+    \brief Retrieves next available alignment, as an unparsed BAM record.
+
+    Equivalent to GetNextAlignment() with respect to what is a valid overlapping alignment.
+
+    However, this method does not build a BamAlignment at all. The record is stored
+    in \a data exactly as found in the (uncompressed) BAM stream: the 4-byte block length,
+    followed by the core fields and the variable-length data. This is the cheapest way to
+    move alignments from one file to another (see BamWriter::SaveRawAlignment()).
+
+    \param[out] data destination for raw record bytes
+    \returns \c true if a valid alignment was found (see GetNextAlignment() on errors)
+    \sa SetRegion(), BamWriter::SaveRawAlignment()
+*/
+bool BamReader::GetNextRawAlignment(std::string& data) {
+    return d->GetNextRawAlignment(data);
+}
+
 /*! \fn int BamReader::GetReferenceCount(void) const
     \brief Returns number of reference sequences.
 */
@@ -267,7 +386,13 @@ bool BamReader::LocateIndex(const BamIndex::IndexType& preferredType) {
     If BamReader is already opened on another file, this function closes
     that file, then attempts to open requested \a filename.
 
-    \param[in] filename name of BAM file to open
+    Plain (uncompressed) SAM text is accepted as well, and detected from the
+    first byte of the file. Its alignment lines are converted to the same records
+    that the equivalent BAM file would hold, so all alignment & header access works
+    unchanged. SAM input can't be indexed though, and can only be rewound if it
+    is not read from a pipe.
+
+    \param[in] filename name of BAM (or SAM) file to open
 
     \returns \c true if BAM file was opened successfully
     \sa Close(), IsOpen(), OpenIndex()
@@ -304,6 +429,44 @@ bool BamReader::Rewind(void) {
     return d->Rewind();
 }
 
+/*! \fn void BamReader::SetAsyncIO(bool ok)
+    \brief Enables/disables asynchronous reads of local BAM files.
+
+    Default is disabled. When enabled, several reads ahead of the current file
+    position are kept in flight - using Linux io_uring where available, otherwise a
+    pool of reader threads - instead of one blocking read at a time. The reads of all
+    readers using this mode share one queue, so that reading many files at once (e.g.
+    with BamMultiReader) keeps the storage device busy. This benefits fast, but
+    latency-bound, storage (e.g. NVMe) most.
+
+    Only affects regular files, and must be called before Open().
+
+    \param[in] ok \c true to read asynchronously
+    \sa SetNumThreads()
+*/
+void BamReader::SetAsyncIO(bool ok) {
+    d->SetAsyncIO(ok);
+}
+
+/*! \fn void BamReader::SetBlockCacheSize(const unsigned int megabytes)
+    \brief Sets the size of the decompressed block cache.
+
+    Default is 0 (no cache). When enabled, decompressed BGZF blocks are kept, keyed
+    by their file offset, and the least-recently-used are dropped once the cache is
+    full. Blocks needed again after a random-access jump - e.g. for adjacent or
+    overlapping regions from SetRegion() or Jump() - are then served without another
+    device read or decompression. This benefits slow (e.g. network) storage most.
+
+    The cache is kept across region changes, and cleared when the BAM file is closed.
+    It is only used while decompressing on a single thread (see SetNumThreads()).
+
+    \param[in] megabytes maximum size of decompressed data held, in MB
+    \sa GetBlockCacheHits(), GetBlockCacheMisses()
+*/
+void BamReader::SetBlockCacheSize(const unsigned int megabytes) {
+    d->SetBlockCacheSize(megabytes);
+}
+
 /*! \fn void BamReader::SetIndex(BamIndex* index)
     \brief Sets a custom BamIndex on this reader.
 
@@ -327,6 +490,23 @@ void BamReader::SetIndex(BamIndex* index) {
     d->SetIndex(index);
 }
 
+/*! \fn void BamReader::SetNumThreads(const unsigned int numThreads)
+    \brief Sets the number of threads used to decompress input.
+
+    Default is 1 (all decompression is done on the calling thread). With more threads,
+    upcoming BGZF blocks are read ahead & decompressed in parallel by a pool of worker
+    threads, and handed back in their original order. For SAM input, chunks of lines
+    are parsed in parallel instead. The data returned is identical either way.
+
+    \note Like BamWriter::SetNumThreads(), this must be called before opening the BAM file.
+
+    \param[in] numThreads number of decompression threads
+    \sa Open()
+*/
+void BamReader::SetNumThreads(const unsigned int numThreads) {
+    d->SetNumThreads(numThreads);
+}
+
 /*! \fn bool BamReader::SetRegion(const BamRegion& region)
     \brief Sets a target region of interest
 
@@ -381,3 +561,28 @@ bool BamReader::SetRegion(const int& leftRefID,
 {
     return d->SetRegion( BamRegion(leftRefID, leftBound, rightRefID, rightBound) );
 }
+
+/*! \fn bool BamReader::SetRegions(const std::vector<BamRegion>& regions)
+    \brief Sets multiple target regions of interest
+
+    Requires that index data be available. The regions are sorted & merged,
+    and the index data for all of them is combined up front, so that each part
+    of the BAM file is read at most once (in file order), no matter how many
+    \a regions overlap it.
+
+    Subsequent calls to GetNextAlignment() or GetNextAlignmentCore() will only
+    return alignments that overlap at least one of the \a regions. After each
+    one, GetCurrentRegionIndexes() lists (in ascending order) the positions in
+    \a regions of every region it overlaps.
+
+    Regions follow the same rules as SetRegion(): zero-based, HALF-OPEN intervals,
+    with a missing right boundary meaning open-ended.
+
+    \param[in] regions desired regions-of-interest to activate (may overlap, in any order)
+
+    \returns \c true if reader was able to set up the regions successfully
+    \sa GetCurrentRegionIndexes(), HasIndex(), SetRegion()
+*/
+bool BamReader::SetRegions(const std::vector<BamRegion>& regions) {
+    return d->SetRegions(regions);
+}
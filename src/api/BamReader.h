@@ -2,7 +2,7 @@
 // BamReader.h (c) 2009 Derek Barnett, Michael Str�mberg
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 18 November 2012 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Provides read access to BAM files.
 // ***************************************************************************
@@ -55,15 +55,29 @@ class API_EXPORT BamReader {
                        const int& leftPosition,
                        const int& rightRefID,
                        const int& rightPosition);
+        // sets multiple target regions of interest
+        bool SetRegions(const std::vector<BamRegion>& regions);
+        // enables/disables asynchronous reads of local BAM files
+        void SetAsyncIO(bool ok);
+        // sets number of threads used to decompress input
+        void SetNumThreads(const unsigned int numThreads);
 
         // ----------------------
         // access alignment data
         // ----------------------
 
+        // returns number of alignments in BAM file
+        bool CountAlignments(uint64_t& count);
+        // returns number of alignments in region
+        bool CountAlignments(const BamRegion& region, uint64_t& count);
         // retrieves next available alignment
         bool GetNextAlignment(BamAlignment& alignment);
         // retrieves next available alignmnet (without populating the alignment's string data fields)
         bool GetNextAlignmentCore(BamAlignment& alignment);
+        // retrieves next available alignment as raw BAM record bytes (no fields populated)
+        bool GetNextRawAlignment(std::string& data);
+        // returns regions (from SetRegions()) that the last alignment retrieved overlaps
+        const std::vector<int>& GetCurrentRegionIndexes(void) const;
 
         // ----------------------
         // access header data
@@ -93,6 +107,8 @@ class API_EXPORT BamReader {
 
         // creates an index file for current BAM file, using the requested index type
         bool CreateIndex(const BamIndex::IndexType& type = BamIndex::STANDARD);
+        // creates a CSI index file for current BAM file, using the requested bin scheme
+        bool CreateCsiIndex(const int& minShift = 14, const int& depth = 5);
         // returns true if index data is available
         bool HasIndex(void) const;
         // looks in BAM file's directory for a matching index file
@@ -102,6 +118,17 @@ class API_EXPORT BamReader {
         // sets a custom BamIndex on this reader
         void SetIndex(BamIndex* index);
 
+        // ----------------------
+        // decompressed block cache
+        // ----------------------
+
+        // returns number of BGZF blocks served from decompressed block cache
+        uint64_t GetBlockCacheHits(void) const;
+        // returns number of BGZF blocks not found in decompressed block cache
+        uint64_t GetBlockCacheMisses(void) const;
+        // sets size (in MB) of decompressed block cache, 0 disables cache
+        void SetBlockCacheSize(const unsigned int megabytes);
+
         // ----------------------
         // error handling
         // ----------------------
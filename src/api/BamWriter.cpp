@@ -2,7 +2,7 @@
 // BamWriter.cpp (c) 2009 Michael Str�mberg, Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 25 October 2011 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Provides the basic functionality for producing BAM files
 // ***************************************************************************
@@ -55,6 +55,26 @@ void BamWriter::Close(void) {
     d->Close();
 }
 
+/*! \fn bool BamWriter::CopyAlignments(const std::string& filename)
+    \brief Appends all alignments of another BAM file.
+
+    Most of the file's alignment data is copied as compressed BGZF blocks, without
+    being decompressed or re-compressed. Only the block in which its header ends is
+    re-compressed (it may hold the first alignments), and empty blocks such as its
+    EOF marker are dropped. This makes concatenating BAM files about as fast as
+    copying them.
+
+    The file's header is skipped. Its alignments are copied as-is, so it must use
+    the same reference sequences (in the same order) as the output file.
+
+    \param[in] filename name of BAM file to copy alignments from
+    \return \c true if alignments copied OK
+    \sa SaveRawAlignment()
+*/
+bool BamWriter::CopyAlignments(const std::string& filename) {
+    return d->CopyAlignments(filename);
+}
+
 /*! \fn std::string BamWriter::GetErrorString(void) const
     \brief Returns a human-readable description of the last error that occurred
 
@@ -119,6 +139,25 @@ bool BamWriter::Open(const std::string& filename,
     return d->Open(filename, samHeader.ToString(), referenceSequences);
 }
 
+/*! \fn bool BamWriter::OpenForAppend(const std::string& filename)
+    \brief Opens an existing BAM file, to save more alignments after its current ones.
+
+    The file's header is left as-is (so saved alignments must refer to its
+    reference sequences), and its EOF marker is replaced by the new data. This
+    allows closing a BAM file & continuing it later, for example when too many
+    output files are needed to keep all of them open at once.
+
+    If the file does not exist yet, it is created - but without any header data.
+    Only local files can be appended to.
+
+    \param[in] filename name of existing BAM file
+    \return \c true if opened successfully
+    \sa Open(), Close(), IsOpen()
+*/
+bool BamWriter::OpenForAppend(const std::string& filename) {
+    return d->OpenForAppend(filename);
+}
+
 /*! \fn void BamWriter::SaveAlignment(const BamAlignment& alignment)
     \brief Saves an alignment to the BAM file.
 
@@ -129,6 +168,22 @@ bool BamWriter::SaveAlignment(const BamAlignment& alignment) {
     return d->SaveAlignment(alignment);
 }
 
+/*! \fn bool BamWriter::SaveRawAlignment(const char* data, const size_t length)
+    \brief Saves a raw alignment record to the BAM file.
+
+    The record bytes are copied into the output stream as-is, no fields are
+    re-encoded. \a data must hold a complete record, laid out as returned by
+    BamReader::GetNextRawAlignment() (4-byte block length, core data, char data).
+
+    \param[in] data   raw record bytes
+    \param[in] length number of bytes in record (including the block length)
+    \return \c true if record saved OK
+    \sa BamReader::GetNextRawAlignment()
+*/
+bool BamWriter::SaveRawAlignment(const char* data, const size_t length) {
+    return d->SaveRawAlignment(data, length);
+}
+
 /*! \fn void BamWriter::SetCompressionMode(const BamWriter::CompressionMode& compressionMode)
     \brief Sets the output compression mode.
 
@@ -150,3 +205,20 @@ bool BamWriter::SaveAlignment(const BamAlignment& alignment) {
 void BamWriter::SetCompressionMode(const BamWriter::CompressionMode& compressionMode) {
     d->SetWriteCompressed( compressionMode == BamWriter::Compressed );
 }
+
+/*! \fn void BamWriter::SetNumThreads(const unsigned int numThreads)
+    \brief Sets the number of threads used to compress output.
+
+    Default is 1 (all compression is done on the calling thread). With more threads,
+    output BGZF blocks are compressed in parallel by a pool of worker threads, and
+    written to the file in their original order. The (uncompressed) contents of the
+    file are identical either way.
+
+    \note Like SetCompressionMode(), this must be called before opening the BAM file.
+
+    \param[in] numThreads number of compression threads
+    \sa SetCompressionMode(), Open()
+*/
+void BamWriter::SetNumThreads(const unsigned int numThreads) {
+    d->SetNumThreads(numThreads);
+}
@@ -2,7 +2,7 @@
 // IBamIODevice.h (c) 2011 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 10 November 2011 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Base class for all BAM I/O devices (e.g. local file, pipe, HTTP, FTP, etc.)
 //
@@ -31,6 +31,7 @@ class API_EXPORT IBamIODevice {
                           , ReadOnly  = 0x0001
                           , WriteOnly = 0x0002
                           , ReadWrite = ReadOnly | WriteOnly
+                          , Append    = 0x0004  // with WriteOnly: keep existing data, write after it
                           };
 
     // ctor & dtor
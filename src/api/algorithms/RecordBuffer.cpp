@@ -0,0 +1,345 @@
+// ***************************************************************************
+// RecordBuffer.cpp (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides a buffer of raw BAM records that can be sorted on packed
+// integer keys, without building BamAlignment objects.
+// ***************************************************************************
+
+#include "api/BamConstants.h"
+#include "api/BamReader.h"
+#include "api/BamWriter.h"
+#include "api/algorithms/RecordBuffer.h"
+#include "shared/bamtools_raw_record.h"
+using namespace BamTools;
+using namespace BamTools::Algorithms;
+using namespace BamTools::Internal;
+
+#include <algorithm>
+#include <cstring>
+using namespace std;
+
+namespace BamTools {
+namespace Algorithms {
+
+// radix sort digit size (bits) & number of passes for a 64-bit key
+const unsigned int RADIX_BITS      = 8;
+const unsigned int RADIX_BUCKETS   = (1 << RADIX_BITS);
+const unsigned int RADIX_NUMPASSES = 64 / RADIX_BITS;
+
+// largest position that fits in coordinate key (leaves room for strand bit)
+const uint32_t KEY_MAX_POSITION = 0x7FFFFFFF;
+
+// number of name bytes packed into a name key
+const size_t KEY_NAME_BYTES = sizeof(uint64_t);
+
+// orders entries by the read names of their records, skipping a common prefix
+struct NameSuffixLessThan {
+
+    NameSuffixLessThan(const char* arena, const size_t offset)
+        : m_arena(arena)
+        , m_offset(offset)
+    { }
+
+    bool operator()(const RecordBuffer::Entry& lhs, const RecordBuffer::Entry& rhs) const {
+        const char* lhsName = RawRecord::Name(m_arena + lhs.Offset) + m_offset;
+        const char* rhsName = RawRecord::Name(m_arena + rhs.Offset) + m_offset;
+        return ( strcmp(lhsName, rhsName) < 0 );
+    }
+
+    private:
+        const char* m_arena;
+        size_t m_offset;
+};
+
+} // namespace Algorithms
+} // namespace BamTools
+
+/*! \fn RecordBuffer::RecordBuffer(const SortKey& sortKey = ByPosition)
+    \brief constructor
+
+    \param[in] sortKey key to extract from each record as it is added
+*/
+RecordBuffer::RecordBuffer(const SortKey& sortKey)
+    : m_sortKey(sortKey)
+{ }
+
+/*! \fn RecordBuffer::~RecordBuffer(void)
+    \brief destructor
+*/
+RecordBuffer::~RecordBuffer(void) { }
+
+/*! \fn void RecordBuffer::Add(const char* data, const size_t length)
+    \brief Appends a raw record to the buffer.
+
+    \param[in] data   raw record bytes, as returned by BamReader::GetNextRawAlignment()
+    \param[in] length number of bytes in record
+*/
+void RecordBuffer::Add(const char* data, const size_t length) {
+
+    Entry entry;
+    entry.Offset = m_arena.size();
+    switch ( m_sortKey ) {
+        case ( RecordBuffer::ByPosition ) : entry.Key = PositionKey(data); break;
+        case ( RecordBuffer::ByName )     : entry.Key = NameKey(data);     break;
+        default :
+            BT_ASSERT_UNREACHABLE;
+    }
+
+    m_arena.insert(m_arena.end(), data, data + length);
+    m_entries.push_back(entry);
+}
+
+/*! \fn bool RecordBuffer::Add(BamReader& reader)
+    \brief Reads the next raw record from \a reader and appends it to the buffer.
+
+    \param[in] reader open BamReader
+    \return \c false if no more records are available from \a reader
+*/
+bool RecordBuffer::Add(BamReader& reader) {
+    if ( !reader.GetNextRawAlignment(m_record) )
+        return false;
+    Add(m_record.data(), m_record.size());
+    return true;
+}
+
+/*! \fn void RecordBuffer::Clear(void)
+    \brief Removes all records from the buffer.
+
+    Allocated memory is kept, so that the buffer can be cheaply re-filled.
+*/
+void RecordBuffer::Clear(void) {
+    m_arena.clear();
+    m_entries.clear();
+}
+
+/*! \fn int RecordBuffer::CompareNames(const char* lhs, const char* rhs)
+    \brief Compares the read names of two raw records.
+
+    \param[in] lhs raw record bytes
+    \param[in] rhs raw record bytes
+    \return negative, zero or positive value (as strcmp)
+*/
+int RecordBuffer::CompareNames(const char* lhs, const char* rhs) {
+    return strcmp( RawRecord::Name(lhs), RawRecord::Name(rhs) );
+}
+
+/*! \fn size_t RecordBuffer::Count(void) const
+    \brief Returns number of buffered records.
+*/
+size_t RecordBuffer::Count(void) const {
+    return m_entries.size();
+}
+
+/*! \fn bool RecordBuffer::IsEmpty(void) const
+    \brief Returns \c true if no records are buffered.
+*/
+bool RecordBuffer::IsEmpty(void) const {
+    return m_entries.empty();
+}
+
+/*! \fn size_t RecordBuffer::MemoryUsage(void) const
+    \brief Returns number of bytes used by buffered records & their keys.
+*/
+size_t RecordBuffer::MemoryUsage(void) const {
+    return m_arena.size() + m_entries.size()*sizeof(Entry);
+}
+
+/*! \fn uint64_t RecordBuffer::NameKey(const char* data, const size_t offset = 0)
+    \brief Returns the name sort key for a raw record.
+
+    The key packs up to 8 read name bytes, starting at \a offset, big-endian &
+    zero-padded, so that unsigned key order matches the lexicographic order of
+    those bytes. Names that share their first 8 bytes (after \a offset) have
+    equal keys and must be compared in full, see CompareNames().
+
+    \param[in] data   raw record bytes
+    \param[in] offset number of leading name bytes to skip, must not exceed name length
+    \return packed key
+*/
+uint64_t RecordBuffer::NameKey(const char* data, const size_t offset) {
+
+    const unsigned char* name = reinterpret_cast<const unsigned char*>( RawRecord::Name(data) ) + offset;
+
+    uint64_t key = 0;
+    size_t i = 0;
+    for ( ; i < KEY_NAME_BYTES && name[i] != '\0'; ++i )
+        key = ( key << 8 ) | name[i];
+    for ( ; i < KEY_NAME_BYTES; ++i )
+        key <<= 8;
+    return key;
+}
+
+/*! \fn uint64_t RecordBuffer::PositionKey(const char* data)
+    \brief Returns the coordinate sort key for a raw record.
+
+    The key packs reference ID (high 32 bits), position and strand (low bit), so
+    that unsigned key order matches coordinate order. Unmapped reads (refID -1)
+    sort after all mapped reads.
+
+    \param[in] data raw record bytes
+    \return packed key
+*/
+uint64_t RecordBuffer::PositionKey(const char* data) {
+
+    const uint32_t refID    = static_cast<uint32_t>( RawRecord::RefID(data) ); // -1 becomes max
+    const int32_t  position = RawRecord::Position(data);
+    const uint32_t isReverseStrand = ( (RawRecord::AlignmentFlag(data) & Constants::BAM_ALIGNMENT_REVERSE_STRAND) != 0 );
+
+    // shift position by 1 so that -1 (no position) sorts first
+    uint32_t shiftedPosition = ( position < -1 ? 0 : static_cast<uint32_t>(position + 1) );
+    if ( shiftedPosition > KEY_MAX_POSITION )
+        shiftedPosition = KEY_MAX_POSITION;
+
+    return ( static_cast<uint64_t>(refID) << 32 ) |
+           ( static_cast<uint64_t>(shiftedPosition) << 1 ) |
+           isReverseStrand;
+}
+
+/*! \fn void RecordBuffer::RadixSort(std::vector<Entry>& entries)
+    \brief Sorts entries on their keys (stable).
+
+    Uses an LSD radix sort with 8-bit digits. Digits that are identical across
+    all keys (e.g. high bytes of refID) are skipped.
+
+    \param[in,out] entries entries to sort
+*/
+void RecordBuffer::RadixSort(vector<Entry>& entries) {
+
+    const size_t numEntries = entries.size();
+    if ( numEntries < 2 )
+        return;
+
+    // count all digits up front, in a single pass over the data
+    vector<size_t> counts(RADIX_NUMPASSES*RADIX_BUCKETS, 0);
+    vector<Entry>::const_iterator entryIter = entries.begin();
+    vector<Entry>::const_iterator entryEnd  = entries.end();
+    for ( ; entryIter != entryEnd; ++entryIter ) {
+        const uint64_t key = entryIter->Key;
+        for ( unsigned int pass = 0; pass < RADIX_NUMPASSES; ++pass )
+            ++counts[ pass*RADIX_BUCKETS + ((key >> (pass*RADIX_BITS)) & (RADIX_BUCKETS-1)) ];
+    }
+
+    // scatter entries back & forth between the two buffers, one digit at a time
+    vector<Entry> temp(numEntries);
+    vector<Entry>* source = &entries;
+    vector<Entry>* destination = &temp;
+    for ( unsigned int pass = 0; pass < RADIX_NUMPASSES; ++pass ) {
+
+        const unsigned int shift = pass*RADIX_BITS;
+        size_t* passCounts = &counts[pass*RADIX_BUCKETS];
+
+        // skip pass if every key has the same digit here
+        const uint64_t firstDigit = ((*source)[0].Key >> shift) & (RADIX_BUCKETS-1);
+        if ( passCounts[firstDigit] == numEntries )
+            continue;
+
+        // convert counts to bucket offsets
+        size_t offset = 0;
+        for ( unsigned int bucket = 0; bucket < RADIX_BUCKETS; ++bucket ) {
+            const size_t count = passCounts[bucket];
+            passCounts[bucket] = offset;
+            offset += count;
+        }
+
+        // scatter
+        const Entry* src = &(*source)[0];
+        Entry* dst = &(*destination)[0];
+        for ( size_t i = 0; i < numEntries; ++i ) {
+            const uint64_t digit = (src[i].Key >> shift) & (RADIX_BUCKETS-1);
+            dst[ passCounts[digit]++ ] = src[i];
+        }
+        std::swap(source, destination);
+    }
+
+    // make sure sorted data ends up in caller's container
+    if ( source != &entries )
+        entries.swap(temp);
+}
+
+/*! \fn const char* RecordBuffer::Record(const size_t index) const
+    \brief Returns raw record at \a index (in current order).
+
+    The record is laid out as returned by BamReader::GetNextRawAlignment().
+
+    \param[in] index record index, must be less than Count()
+    \return pointer to start of raw record
+*/
+const char* RecordBuffer::Record(const size_t index) const {
+    return &m_arena[ m_entries.at(index).Offset ];
+}
+
+/*! \fn void RecordBuffer::Sort(void)
+    \brief Sorts buffered records on their keys.
+
+    Sort is stable: records with equal keys keep the order in which they were added.
+
+    When sorting by name, the longest prefix shared by all buffered names is
+    skipped first (read names from one run typically share a long instrument/run
+    prefix), so that the 8-byte keys cover the bytes that actually differ. Any
+    records still tied on key are then ordered by the remainder of their names.
+*/
+void RecordBuffer::Sort(void) {
+
+    if ( m_sortKey != RecordBuffer::ByName || m_entries.empty() ) {
+        RadixSort(m_entries);
+        return;
+    }
+
+    const char* arena = &m_arena[0];
+
+    // find longest name prefix shared by all records
+    const char* firstName = RawRecord::Name(arena + m_entries[0].Offset);
+    size_t prefixLength = strlen(firstName);
+    vector<Entry>::const_iterator entryIter = m_entries.begin() + 1;
+    vector<Entry>::const_iterator entryEnd  = m_entries.end();
+    for ( ; entryIter != entryEnd && prefixLength > 0; ++entryIter ) {
+        const char* name = RawRecord::Name(arena + entryIter->Offset);
+        size_t i = 0;
+        while ( i < prefixLength && name[i] == firstName[i] )
+            ++i;
+        prefixLength = i;
+    }
+
+    // re-key on the bytes following the shared prefix
+    if ( prefixLength > 0 ) {
+        vector<Entry>::iterator iter = m_entries.begin();
+        vector<Entry>::iterator end  = m_entries.end();
+        for ( ; iter != end; ++iter )
+            iter->Key = NameKey(arena + iter->Offset, prefixLength);
+    }
+
+    RadixSort(m_entries);
+
+    // resolve any ties on key by comparing (the rest of) the full names
+    const NameSuffixLessThan nameLessThan(arena, prefixLength);
+    vector<Entry>::iterator runBegin = m_entries.begin();
+    const vector<Entry>::iterator end = m_entries.end();
+    while ( runBegin != end ) {
+        vector<Entry>::iterator runEnd = runBegin + 1;
+        while ( runEnd != end && runEnd->Key == runBegin->Key )
+            ++runEnd;
+        if ( runEnd - runBegin > 1 )
+            std::stable_sort(runBegin, runEnd, nameLessThan);
+        runBegin = runEnd;
+    }
+}
+
+/*! \fn bool RecordBuffer::Write(BamWriter& writer) const
+    \brief Saves all buffered records to \a writer, in current order.
+
+    \param[in] writer open BamWriter
+    \return \c true if all records were saved successfully
+*/
+bool RecordBuffer::Write(BamWriter& writer) const {
+    vector<Entry>::const_iterator entryIter = m_entries.begin();
+    vector<Entry>::const_iterator entryEnd  = m_entries.end();
+    for ( ; entryIter != entryEnd; ++entryIter ) {
+        const char* record = &m_arena[entryIter->Offset];
+        if ( !writer.SaveRawAlignment(record, RawRecord::Size(record)) )
+            return false;
+    }
+    return true;
+}
@@ -2,7 +2,7 @@
 // BamHeader_p.cpp (c) 2010 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 18 November 2012 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Provides the basic functionality for handling BAM headers.
 // ***************************************************************************
@@ -109,6 +109,11 @@ void BamHeader::ReadHeaderText(BgzfStream* stream, const uint32_t& length) {
     free(headerText);
 }
 
+// sets header from SAM-formatted text (e.g. header lines of a SAM file)
+void BamHeader::SetHeaderText(const string& headerText) {
+    m_header.SetHeaderText(headerText);
+}
+
 // returns const-reference to SamHeader data object
 const SamHeader& BamHeader::ToConstSamHeader(void) const {
     return m_header;
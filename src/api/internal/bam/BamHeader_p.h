@@ -2,7 +2,7 @@
 // BamHeader_p.h (c) 2010 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 18 November 2012 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Provides the basic functionality for handling BAM headers.
 // ***************************************************************************
@@ -44,6 +44,8 @@ class BamHeader {
         // load BAM header ('magic number' and SAM header text) from BGZF stream
         // returns true if all OK
         void Load(BgzfStream* stream);
+        // sets header from SAM-formatted text (e.g. header lines of a SAM file)
+        void SetHeaderText(const std::string& headerText);
         // returns (read-only) reference to SamHeader data object
         const SamHeader& ToConstSamHeader(void) const;
         // returns (editable) copy of SamHeader data object
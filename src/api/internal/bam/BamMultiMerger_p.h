@@ -2,7 +2,7 @@
 // BamMultiMerger_p.h (c) 2010 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 10 October 2011 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Provides merging functionality for BamMultiReader.  At this point, supports
 // sorting results by (refId, position) or by read name.
@@ -28,6 +28,7 @@
 #include <functional>
 #include <set>
 #include <string>
+#include <vector>
 
 namespace BamTools {
 namespace Internal {
@@ -37,17 +38,21 @@ struct MergeItem {
     // data members
     BamReader*    Reader;
     BamAlignment* Alignment;
+    std::vector<int> RegionIndexes;     // regions (from SetRegions) that alignment overlaps
 
     // ctors & dtor
     MergeItem(BamReader* reader = 0,
-              BamAlignment* alignment = 0)
+              BamAlignment* alignment = 0,
+              const std::vector<int>& regionIndexes = std::vector<int>())
         : Reader(reader)
         , Alignment(alignment)
+        , RegionIndexes(regionIndexes)
     { }
 
     MergeItem(const MergeItem& other)
         : Reader(other.Reader)
         , Alignment(other.Alignment)
+        , RegionIndexes(other.RegionIndexes)
     { }
 
     ~MergeItem(void) { }
@@ -2,7 +2,7 @@
 // BamMultiReader_p.cpp (c) 2010 Derek Barnett, Erik Garrison
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 25 October 2011 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Functionality for simultaneously reading multiple BAM files
 // *************************************************************************
@@ -25,6 +25,10 @@ using namespace std;
 // ctor
 BamMultiReaderPrivate::BamMultiReaderPrivate(void)
     : m_alignmentCache(0)
+    , m_blockCacheSize(0)
+    , m_isAsyncIO(false)
+    , m_isReadFailed(false)
+    , m_numThreads(1)
 { }
 
 // dtor
@@ -202,6 +206,32 @@ const vector<string> BamMultiReaderPrivate::Filenames(void) const {
     return filenames;
 }
 
+uint64_t BamMultiReaderPrivate::GetBlockCacheHits(void) const {
+    uint64_t numHits = 0;
+    vector<MergeItem>::const_iterator readerIter = m_readers.begin();
+    vector<MergeItem>::const_iterator readerEnd  = m_readers.end();
+    for ( ; readerIter != readerEnd; ++readerIter ) {
+        const BamReader* reader = (*readerIter).Reader;
+        if ( reader ) numHits += reader->GetBlockCacheHits();
+    }
+    return numHits;
+}
+
+uint64_t BamMultiReaderPrivate::GetBlockCacheMisses(void) const {
+    uint64_t numMisses = 0;
+    vector<MergeItem>::const_iterator readerIter = m_readers.begin();
+    vector<MergeItem>::const_iterator readerEnd  = m_readers.end();
+    for ( ; readerIter != readerEnd; ++readerIter ) {
+        const BamReader* reader = (*readerIter).Reader;
+        if ( reader ) numMisses += reader->GetBlockCacheMisses();
+    }
+    return numMisses;
+}
+
+const vector<int>& BamMultiReaderPrivate::GetCurrentRegionIndexes(void) const {
+    return m_currentRegionIndexes;
+}
+
 string BamMultiReaderPrivate::GetErrorString(void) const {
     return m_errorString;
 }
@@ -437,6 +467,9 @@ bool BamMultiReaderPrivate::Open(const vector<string>& filenames) {
 
         // attempt to open BamReader
         BamReader* reader = new BamReader;
+        reader->SetBlockCacheSize(m_blockCacheSize);
+        reader->SetAsyncIO(m_isAsyncIO);
+        reader->SetNumThreads(m_numThreads);
         const bool readerOpened = reader->Open(filename);
 
         // if opened OK, store it
@@ -540,6 +573,11 @@ bool BamMultiReaderPrivate::OpenIndexes(const vector<string>& indexFilenames) {
 
 bool BamMultiReaderPrivate::PopNextCachedAlignment(BamAlignment& al, const bool needCharData) {
 
+    // stop at a reader's error, so that it can be reported (see SaveNextAlignment())
+    if ( m_isReadFailed )
+        return false;
+    m_errorString.clear();
+
     // skip if no alignments available
     if ( m_alignmentCache == 0 || m_alignmentCache->IsEmpty() )
         return false;
@@ -559,6 +597,7 @@ bool BamMultiReaderPrivate::PopNextCachedAlignment(BamAlignment& al, const bool
 
     // store cached alignment into destination parameter (by copy)
     al = *alignment;
+    m_currentRegionIndexes.swap(item.RegionIndexes);
 
     // load next alignment from reader & store in cache
     SaveNextAlignment(reader, alignment);
@@ -619,7 +658,34 @@ void BamMultiReaderPrivate::SaveNextAlignment(BamReader* reader, BamAlignment* a
     //        on demand from client call to future call to GetNextAlignment()
 
     if ( reader->GetNextAlignmentCore(*alignment) )
-        m_alignmentCache->Add( MergeItem(reader, alignment) );
+        m_alignmentCache->Add( MergeItem(reader, alignment, reader->GetCurrentRegionIndexes()) );
+
+    // otherwise, tell reader's error apart from its end of data
+    else {
+        const string readerError = reader->GetErrorString();
+        if ( !readerError.empty() ) {
+            m_isReadFailed = true;
+            SetErrorString("BamMultiReader::GetNextAlignment", reader->GetFilename() + ": " + readerError);
+        }
+    }
+}
+
+void BamMultiReaderPrivate::SetAsyncIO(bool ok) {
+    // only applies to files opened afterwards
+    m_isAsyncIO = ok;
+}
+
+void BamMultiReaderPrivate::SetBlockCacheSize(const unsigned int megabytes) {
+
+    // store size for any readers opened later
+    m_blockCacheSize = megabytes;
+
+    vector<MergeItem>::iterator readerIter = m_readers.begin();
+    vector<MergeItem>::iterator readerEnd  = m_readers.end();
+    for ( ; readerIter != readerEnd; ++readerIter ) {
+        BamReader* reader = (*readerIter).Reader;
+        if ( reader ) reader->SetBlockCacheSize(megabytes);
+    }
 }
 
 void BamMultiReaderPrivate::SetErrorString(const string& where, const string& what) const {
@@ -627,6 +693,11 @@ void BamMultiReaderPrivate::SetErrorString(const string& where, const string& wh
     m_errorString = where + SEPARATOR + what;
 }
 
+void BamMultiReaderPrivate::SetNumThreads(const unsigned int numThreads) {
+    // only applies to files opened afterwards
+    m_numThreads = numThreads;
+}
+
 bool BamMultiReaderPrivate::SetRegion(const BamRegion& region) {
 
     // NB: While it may make sense to track readers in which we can
@@ -650,6 +721,26 @@ bool BamMultiReaderPrivate::SetRegion(const BamRegion& region) {
     return UpdateAlignmentCache();
 }
 
+bool BamMultiReaderPrivate::SetRegions(const vector<BamRegion>& regions) {
+
+    // NB: as with SetRegion(), a failure here means "no alignments here" for that reader
+
+    // iterate over alignments
+    vector<MergeItem>::iterator readerIter = m_readers.begin();
+    vector<MergeItem>::iterator readerEnd  = m_readers.end();
+    for ( ; readerIter != readerEnd; ++readerIter ) {
+        MergeItem& item = (*readerIter);
+        BamReader* reader = item.Reader;
+        if ( reader == 0 ) continue;
+
+        // set regions of interest
+        reader->SetRegions(regions);
+    }
+
+    // return status of cache update
+    return UpdateAlignmentCache();
+}
+
 // updates our alignment cache
 bool BamMultiReaderPrivate::UpdateAlignmentCache(void) {
 
@@ -664,6 +755,7 @@ bool BamMultiReaderPrivate::UpdateAlignmentCache(void) {
 
     // clear any prior cache data
     m_alignmentCache->Clear();
+    m_isReadFailed = false;
 
     // iterate over readers
     vector<MergeItem>::iterator readerIter = m_readers.begin();
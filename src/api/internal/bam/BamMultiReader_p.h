@@ -2,7 +2,7 @@
 // BamMultiReader_p.h (c) 2010 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 25 October 2011 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Functionality for simultaneously reading multiple BAM files
 // *************************************************************************
@@ -52,12 +52,25 @@ class BamMultiReaderPrivate {
         bool OpenFile(const std::string& filename);
         bool Rewind(void);
         bool SetRegion(const BamRegion& region);
+        bool SetRegions(const std::vector<BamRegion>& regions);
 
         // access alignment data
         bool GetNextAlignment(BamAlignment& al);
         bool GetNextAlignmentCore(BamAlignment& al);
+        const std::vector<int>& GetCurrentRegionIndexes(void) const;
         bool HasOpenReaders(void);
 
+        // decompressed block cache
+        uint64_t GetBlockCacheHits(void) const;
+        uint64_t GetBlockCacheMisses(void) const;
+        void SetBlockCacheSize(const unsigned int megabytes);
+
+        // asynchronous reads
+        void SetAsyncIO(bool ok);
+
+        // decompression threads
+        void SetNumThreads(const unsigned int numThreads);
+
         // access auxiliary data
         SamHeader GetHeader(void) const;
         std::string GetHeaderText(void) const;
@@ -90,6 +103,11 @@ class BamMultiReaderPrivate {
     public:
         std::vector<MergeItem> m_readers;
         IMultiMerger* m_alignmentCache;
+        unsigned int m_blockCacheSize;
+        bool m_isAsyncIO;
+        bool m_isReadFailed;                       // a reader failed to refill cache (see m_errorString)
+        unsigned int m_numThreads;
+        std::vector<int> m_currentRegionIndexes;   // regions overlapped by last alignment returned
         mutable std::string m_errorString;
 };
 
@@ -2,7 +2,7 @@
 // BamRandomAccessController_p.cpp (c) 2011 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 25 October 2011(DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Manages random access operations in a BAM file
 // **************************************************************************
@@ -11,17 +11,24 @@
 #include "api/internal/bam/BamRandomAccessController_p.h"
 #include "api/internal/bam/BamReader_p.h"
 #include "api/internal/index/BamIndexFactory_p.h"
+#include "api/internal/index/IBamIndexCounter_p.h"
 #include "api/internal/utils/BamException_p.h"
 using namespace BamTools;
 using namespace BamTools::Internal;
 
+#include <algorithm>
 #include <cassert>
+#include <climits>
 #include <sstream>
 using namespace std;
 
 BamRandomAccessController::BamRandomAccessController(void)
     : m_index(0)
     , m_hasAlignmentsInRegion(true)
+    , m_currentChunk(0)
+    , m_isChunkSeekPending(false)
+    , m_hasMultipleRegions(false)
+    , m_firstLiveInterval(0)
 { }
 
 BamRandomAccessController::~BamRandomAccessController(void) {
@@ -58,29 +65,51 @@ void BamRandomAccessController::AdjustRegion(const int& referenceCount) {
 
 // returns alignments' "RegionState": { Before|Overlaps|After } current region
 BamRandomAccessController::RegionState
-BamRandomAccessController::AlignmentState(const BamAlignment& alignment) const {
+BamRandomAccessController::AlignmentState(const BamAlignment& alignment) {
+
+    // if multiple regions were set
+    if ( m_hasMultipleRegions )
+        return IntervalState(alignment.RefID, alignment.Position, alignment.GetEndPosition());
+
+    // if region has no left bound at all
+    if ( !m_region.isLeftBoundSpecified() )
+        return OverlapsRegion;
+
+    return AlignmentState(alignment.RefID, alignment.Position, alignment.GetEndPosition());
+}
+
+// returns "RegionState" for an alignment described only by its coordinates
+// (used when reading raw records, where no BamAlignment is built)
+BamRandomAccessController::RegionState
+BamRandomAccessController::AlignmentState(const int refID,
+                                          const int position,
+                                          const int endPosition)
+{
+    // if multiple regions were set
+    if ( m_hasMultipleRegions )
+        return IntervalState(refID, position, endPosition);
 
     // if region has no left bound at all
     if ( !m_region.isLeftBoundSpecified() )
         return OverlapsRegion;
 
     // handle unmapped reads - return AFTER region to halt processing
-    if ( alignment.RefID == -1 )
+    if ( refID == -1 )
         return AfterRegion;
 
     // if alignment is on any reference before left bound reference
-    if ( alignment.RefID < m_region.LeftRefID )
+    if ( refID < m_region.LeftRefID )
         return BeforeRegion;
 
     // if alignment is on left bound reference
-    else if ( alignment.RefID == m_region.LeftRefID ) {
+    else if ( refID == m_region.LeftRefID ) {
 
         // if alignment starts at or after left bound position
-        if ( alignment.Position >= m_region.LeftPosition) {
+        if ( position >= m_region.LeftPosition) {
 
-            if ( m_region.isRightBoundSpecified() &&             // right bound is specified AND
-                 m_region.LeftRefID == m_region.RightRefID &&    // left & right bounds on same reference AND
-                 alignment.Position >= m_region.RightPosition )  // alignment starts on or after right bound position
+            if ( m_region.isRightBoundSpecified() &&          // right bound is specified AND
+                 m_region.LeftRefID == m_region.RightRefID && // left & right bounds on same reference AND
+                 position >= m_region.RightPosition )         // alignment starts on or after right bound position
                 return AfterRegion;
 
             // otherwise, alignment overlaps region
@@ -91,7 +120,7 @@ BamRandomAccessController::AlignmentState(const BamAlignment& alignment) const {
         else {
 
             // if alignment overlaps left bound position
-            if ( alignment.GetEndPosition() > m_region.LeftPosition )
+            if ( endPosition > m_region.LeftPosition )
                 return OverlapsRegion;
             else
                 return BeforeRegion;
@@ -105,18 +134,18 @@ BamRandomAccessController::AlignmentState(const BamAlignment& alignment) const {
         if ( m_region.isRightBoundSpecified() ) {
 
             // alignment is on any reference between boundaries
-            if ( alignment.RefID < m_region.RightRefID )
+            if ( refID < m_region.RightRefID )
                 return OverlapsRegion;
 
             // alignment is on any reference after right boundary
-            else if ( alignment.RefID > m_region.RightRefID )
+            else if ( refID > m_region.RightRefID )
                 return AfterRegion;
 
             // alignment is on right bound reference
             else {
 
                 // if alignment starts before right bound position
-                if ( alignment.Position < m_region.RightPosition )
+                if ( position < m_region.RightPosition )
                     return OverlapsRegion;
                 else
                     return AfterRegion;
@@ -143,25 +172,24 @@ void BamRandomAccessController::ClearIndex(void) {
 void BamRandomAccessController::ClearRegion(void) {
     m_region.clear();
     m_hasAlignmentsInRegion = true;
+    m_regionChunks.clear();
+    m_currentChunk = 0;
+    m_isChunkSeekPending = false;
+    m_hasMultipleRegions = false;
+    m_intervals.clear();
+    m_firstLiveInterval = 0;
+    m_overlappingRegions.clear();
 }
 
-bool BamRandomAccessController::CreateIndex(BamReaderPrivate* reader,
-                                            const BamIndex::IndexType& type)
-{
+// builds index data for reader's BAM file, storing index on success
+bool BamRandomAccessController::BuildIndex(BamReaderPrivate* reader, BamIndex* newIndex) {
+
     // skip if reader is invalid
     assert(reader);
     if ( !reader->IsOpen() ) {
         SetErrorString("BamRandomAccessController::CreateIndex",
                        "cannot create index for unopened reader");
-        return false;
-    }
-
-    // create new index of requested type
-    BamIndex* newIndex = BamIndexFactory::CreateIndexOfType(type, reader);
-    if ( newIndex == 0 ) {
-        stringstream s("");
-        s << "could not create index of type: " << type;
-        SetErrorString("BamRandomAccessController::CreateIndex", s.str());
+        delete newIndex;
         return false;
     }
 
@@ -170,6 +198,7 @@ bool BamRandomAccessController::CreateIndex(BamReaderPrivate* reader,
         const string indexError = newIndex->GetErrorString();
         const string message = "could not create index: \n\t" + indexError;
         SetErrorString("BamRandomAccessController::CreateIndex", message);
+        delete newIndex;
         return false;
     }
 
@@ -178,6 +207,44 @@ bool BamRandomAccessController::CreateIndex(BamReaderPrivate* reader,
     return true;
 }
 
+// returns false if no index is loaded, or if it cannot count these alignments exactly
+// (only built-in index types count, not any set by client - see BamReader::SetIndex())
+bool BamRandomAccessController::CountIndexAlignments(const int& refId,
+                                                     const int& begin,
+                                                     const int& end,
+                                                     uint64_t& count)
+{
+    IBamIndexCounter* counter = dynamic_cast<IBamIndexCounter*>(m_index);
+    return ( counter != 0 && counter->CountAlignments(refId, begin, end, count) );
+}
+
+bool BamRandomAccessController::CountIndexUnplacedAlignments(uint64_t& count) {
+    IBamIndexCounter* counter = dynamic_cast<IBamIndexCounter*>(m_index);
+    return ( counter != 0 && counter->CountUnplacedAlignments(count) );
+}
+
+bool BamRandomAccessController::CreateCsiIndex(BamReaderPrivate* reader,
+                                               const int& minShift,
+                                               const int& depth)
+{
+    return BuildIndex(reader, BamIndexFactory::CreateCsiIndex(reader, minShift, depth));
+}
+
+bool BamRandomAccessController::CreateIndex(BamReaderPrivate* reader,
+                                            const BamIndex::IndexType& type)
+{
+    // create new index of requested type
+    BamIndex* newIndex = BamIndexFactory::CreateIndexOfType(type, reader);
+    if ( newIndex == 0 ) {
+        stringstream s("");
+        s << "could not create index of type: " << type;
+        SetErrorString("BamRandomAccessController::CreateIndex", s.str());
+        return false;
+    }
+
+    return BuildIndex(reader, newIndex);
+}
+
 string BamRandomAccessController::GetErrorString(void) const {
     return m_errorString;
 }
@@ -186,14 +253,68 @@ bool BamRandomAccessController::HasIndex(void) const {
     return ( m_index != 0 );
 }
 
+bool BamRandomAccessController::HasMultipleRegions(void) const {
+    return m_hasMultipleRegions;
+}
+
 bool BamRandomAccessController::HasRegion(void) const  {
-    return ( !m_region.isNull() );
+    return ( !m_region.isNull() || m_hasMultipleRegions );
+}
+
+bool BamRandomAccessController::HasRegionChunks(void) const {
+    return ( !m_regionChunks.empty() );
 }
 
 bool BamRandomAccessController::IndexHasAlignmentsForReference(const int& refId) {
     return m_index->HasAlignments(refId);
 }
 
+// returns "RegionState" of alignment against all regions from SetRegions(),
+// storing the indexes of any overlapped regions
+//
+// alignments are expected in coordinate order, so intervals that end at/before the
+// current alignment are never checked again
+BamRandomAccessController::RegionState
+BamRandomAccessController::IntervalState(const int refID,
+                                         const int position,
+                                         const int endPosition)
+{
+    m_overlappingRegions.clear();
+
+    // handle unmapped reads - return AFTER regions to halt processing
+    if ( refID == -1 )
+        return AfterRegion;
+
+    // move past any intervals that end before this alignment
+    const size_t numIntervals = m_intervals.size();
+    while ( m_firstLiveInterval < numIntervals ) {
+        const BamRegionInterval& interval = m_intervals[m_firstLiveInterval];
+        if ( interval.RefID > refID || (interval.RefID == refID && interval.End > position) )
+            break;
+        ++m_firstLiveInterval;
+    }
+    if ( m_firstLiveInterval == numIntervals )
+        return AfterRegion;
+
+    // check each interval that begins before alignment ends
+    const int scanEnd = std::max(endPosition, position + 1);
+    for ( size_t i = m_firstLiveInterval; i < numIntervals; ++i ) {
+        const BamRegionInterval& interval = m_intervals[i];
+        if ( interval.RefID > refID || interval.Begin >= scanEnd )
+            break;
+        if ( interval.RefID == refID && position < interval.End &&
+             (position >= interval.Begin || endPosition > interval.Begin) )
+        {
+            m_overlappingRegions.push_back(interval.RegionIndex);
+        }
+    }
+
+    if ( m_overlappingRegions.empty() )
+        return BeforeRegion;
+    sort( m_overlappingRegions.begin(), m_overlappingRegions.end() );
+    return OverlapsRegion;
+}
+
 bool BamRandomAccessController::LocateIndex(BamReaderPrivate* reader,
                                             const BamIndex::IndexType& preferredType)
 {
@@ -236,6 +357,39 @@ bool BamRandomAccessController::OpenIndex(const string& indexFilename, BamReader
     return true;
 }
 
+// given current file offset, updates offset to where reading should continue
+// (skipping over any data between region chunks)
+// returns false if all of the region's chunks have been read
+bool BamRandomAccessController::NextRegionOffset(int64_t& offset) {
+
+    // first call after chunks were set, start at first chunk regardless of current offset
+    const size_t numChunks = m_regionChunks.size();
+    if ( m_isChunkSeekPending ) {
+        m_isChunkSeekPending = false;
+        if ( numChunks == 0 )
+            return false;
+        offset = m_regionChunks.front().Start;
+        return true;
+    }
+
+    // move past any chunks that end at/before offset
+    while ( m_currentChunk < numChunks && offset >= m_regionChunks[m_currentChunk].Stop )
+        ++m_currentChunk;
+    if ( m_currentChunk == numChunks )
+        return false;
+
+    // jump forward to current chunk's start, if necessary
+    const BamRegionChunk& chunk = m_regionChunks[m_currentChunk];
+    if ( offset < chunk.Start )
+        offset = chunk.Start;
+    return true;
+}
+
+// returns indexes of the regions (from SetRegions) overlapped by the last alignment checked
+const vector<int>& BamRandomAccessController::OverlappingRegions(void) const {
+    return m_overlappingRegions;
+}
+
 bool BamRandomAccessController::RegionHasAlignments(void) const {
     return m_hasAlignmentsInRegion;
 }
@@ -244,6 +398,13 @@ void BamRandomAccessController::SetErrorString(const string& where, const string
     m_errorString = where + ": " + what;
 }
 
+// stores list of chunks to be read for current region (must be sorted & non-overlapping)
+void BamRandomAccessController::SetRegionChunks(const BamRegionChunkVector& chunks) {
+    m_regionChunks = chunks;
+    m_currentChunk = 0;
+    m_isChunkSeekPending = false;
+}
+
 void BamRandomAccessController::SetIndex(BamIndex* index) {
     if ( m_index )
         ClearIndex();
@@ -252,7 +413,8 @@ void BamRandomAccessController::SetIndex(BamIndex* index) {
 
 bool BamRandomAccessController::SetRegion(const BamRegion& region, const int& referenceCount) {
 
-    // store region
+    // store region (any chunks or regions from a previous call are discarded)
+    ClearRegion();
     m_region = region;
 
     // cannot jump when no index is available
@@ -287,3 +449,125 @@ bool BamRandomAccessController::SetRegion(const BamRegion& region, const int& re
     else
         return true;
 }
+
+// sets multiple regions of interest
+//
+// regions are split into per-reference intervals, which are sorted & merged so that the
+// union of their index chunks is read only once, in file order. Each alignment read
+// afterwards is checked against the (unmerged) intervals, to report which regions it overlaps.
+bool BamRandomAccessController::SetRegions(const vector<BamRegion>& regions,
+                                           const RefVector& references)
+{
+    // discard any previous region data
+    ClearRegion();
+    m_hasMultipleRegions = true;
+
+    // cannot jump when no index is available
+    if ( !HasIndex() ) {
+        SetErrorString("BamRandomAccessController", "cannot jump if no index data available");
+        return false;
+    }
+
+    // split regions into per-reference intervals
+    const int numReferences = static_cast<int>(references.size());
+    for ( size_t i = 0; i < regions.size(); ++i ) {
+        const BamRegion& region = regions.at(i);
+        if ( region.LeftRefID < 0 || region.LeftRefID >= numReferences )
+            continue;
+
+        const bool hasRightBound = region.isRightBoundSpecified();
+        const int lastRefId = ( hasRightBound ? std::min(region.RightRefID, numReferences - 1)
+                                              : numReferences - 1 );
+        for ( int refId = region.LeftRefID; refId <= lastRefId; ++refId ) {
+            const int begin = ( refId == region.LeftRefID ? std::max(region.LeftPosition, 0) : 0 );
+            const int end = ( hasRightBound && refId == region.RightRefID ? region.RightPosition
+                                                                          : INT_MAX );
+            if ( begin < end && begin < references.at(refId).RefLength )
+                m_intervals.push_back( BamRegionInterval(refId, begin, end, static_cast<int>(i)) );
+        }
+    }
+    sort( m_intervals.begin(), m_intervals.end() );
+
+    // merge overlapping intervals, keeping only those on references that have data
+    vector<BamRegionInterval> merged;
+    vector<BamRegionInterval>::const_iterator intervalIter = m_intervals.begin();
+    vector<BamRegionInterval>::const_iterator intervalEnd  = m_intervals.end();
+    for ( ; intervalIter != intervalEnd; ++intervalIter ) {
+        const BamRegionInterval& interval = (*intervalIter);
+        if ( !merged.empty() &&
+             merged.back().RefID == interval.RefID &&
+             merged.back().End >= interval.Begin )
+        {
+            merged.back().End = std::max(merged.back().End, interval.End);
+        }
+        else if ( m_index->HasAlignments(interval.RefID) )
+            merged.push_back(interval);
+    }
+
+    // collect index chunks for each merged interval
+    m_hasAlignmentsInRegion = false;
+    bool hasAllChunks = true;
+    BamRegion firstRegion;
+    BamRegionChunkVector chunks;
+    vector<BamRegionInterval>::const_iterator mergedIter = merged.begin();
+    vector<BamRegionInterval>::const_iterator mergedEnd  = merged.end();
+    for ( ; mergedIter != mergedEnd; ++mergedIter ) {
+        const BamRegionInterval& interval = (*mergedIter);
+        const int end = std::min(interval.End, references.at(interval.RefID).RefLength);
+        const BamRegion region(interval.RefID, interval.Begin, interval.RefID, end);
+
+        m_regionChunks.clear();
+        bool hasAlignments = false;
+        if ( !m_index->Jump(region, &hasAlignments) ) {
+            const string indexError = m_index->GetErrorString();
+            const string message = string("could not set regions\n\t") + indexError;
+            SetErrorString("BamRandomAccessController::SetRegions", message);
+            return false;
+        }
+        if ( !hasAlignments )
+            continue;
+
+        if ( !m_hasAlignmentsInRegion ) {
+            firstRegion = region;
+            m_hasAlignmentsInRegion = true;
+        }
+        if ( m_regionChunks.empty() )
+            hasAllChunks = false;
+        else
+            chunks.insert(chunks.end(), m_regionChunks.begin(), m_regionChunks.end());
+    }
+
+    if ( !m_hasAlignmentsInRegion ) {
+        m_regionChunks.clear();
+        return true;
+    }
+
+    // if index does not provide chunks, jump to first region & filter sequentially from there
+    if ( !hasAllChunks ) {
+        m_regionChunks.clear();
+        bool hasAlignments = false;
+        if ( !m_index->Jump(firstRegion, &hasAlignments) ) {
+            const string indexError = m_index->GetErrorString();
+            const string message = string("could not set regions\n\t") + indexError;
+            SetErrorString("BamRandomAccessController::SetRegions", message);
+            return false;
+        }
+        m_regionChunks.clear();
+        return true;
+    }
+
+    // otherwise, read union of all chunks (each only once, in file order)
+    sort( chunks.begin(), chunks.end() );
+    BamRegionChunkVector mergedChunks;
+    BamRegionChunkVector::const_iterator chunkIter = chunks.begin();
+    BamRegionChunkVector::const_iterator chunkEnd  = chunks.end();
+    for ( ; chunkIter != chunkEnd; ++chunkIter ) {
+        if ( !mergedChunks.empty() && chunkIter->Start <= mergedChunks.back().Stop )
+            mergedChunks.back().Stop = std::max(mergedChunks.back().Stop, chunkIter->Stop);
+        else
+            mergedChunks.push_back(*chunkIter);
+    }
+    SetRegionChunks(mergedChunks);
+    m_isChunkSeekPending = true;
+    return true;
+}
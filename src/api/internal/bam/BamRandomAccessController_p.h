@@ -2,7 +2,7 @@
 // BamRandomAccessController_p.h (c) 2011 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 10 October 2011(DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Manages random access operations in a BAM file
 // ***************************************************************************
@@ -22,6 +22,7 @@
 
 #include "api/BamAux.h"
 #include "api/BamIndex.h"
+#include <vector>
 
 namespace BamTools {
 
@@ -31,6 +32,59 @@ namespace Internal {
 
 class BamReaderPrivate;
 
+// contiguous range of BAM data, as virtual file offsets [Start, Stop),
+// that may contain alignments overlapping the current region
+struct BamRegionChunk {
+
+    // data members
+    int64_t Start;
+    int64_t Stop;
+
+    // constructor
+    BamRegionChunk(const int64_t& start = 0,
+                   const int64_t& stop = 0)
+        : Start(start)
+        , Stop(stop)
+    { }
+};
+
+// comparison operator (for sorting)
+inline
+bool operator<(const BamRegionChunk& lhs, const BamRegionChunk& rhs) {
+    return lhs.Start < rhs.Start;
+}
+
+// convenience typedef for a (sorted, non-overlapping) list of region chunks
+typedef std::vector<BamRegionChunk> BamRegionChunkVector;
+
+// the part of a region (from SetRegions) that lies on a single reference, [Begin, End)
+struct BamRegionInterval {
+
+    // data members
+    int RefID;
+    int Begin;
+    int End;
+    int RegionIndex;
+
+    // constructor
+    BamRegionInterval(const int& refId = -1,
+                      const int& begin = 0,
+                      const int& end = 0,
+                      const int& regionIndex = -1)
+        : RefID(refId)
+        , Begin(begin)
+        , End(end)
+        , RegionIndex(regionIndex)
+    { }
+};
+
+// comparison operator (for sorting)
+inline
+bool operator<(const BamRegionInterval& lhs, const BamRegionInterval& rhs) {
+    if ( lhs.RefID != rhs.RefID ) return lhs.RefID < rhs.RefID;
+    return lhs.Begin < rhs.Begin;
+}
+
 class BamRandomAccessController {
 
     // enums
@@ -49,6 +103,9 @@ class BamRandomAccessController {
 
         // index methods
         void ClearIndex(void);
+        bool CountIndexAlignments(const int& refId, const int& begin, const int& end, uint64_t& count);
+        bool CountIndexUnplacedAlignments(uint64_t& count);
+        bool CreateCsiIndex(BamReaderPrivate* reader, const int& minShift, const int& depth);
         bool CreateIndex(BamReaderPrivate* reader, const BamIndex::IndexType& type);
         bool HasIndex(void) const;
         bool IndexHasAlignmentsForReference(const int& refId);
@@ -59,10 +116,21 @@ class BamRandomAccessController {
         // region methods
         void ClearRegion(void);
         bool HasRegion(void) const;
-        RegionState AlignmentState(const BamAlignment& alignment) const;
+        RegionState AlignmentState(const BamAlignment& alignment);
+        RegionState AlignmentState(const int refID, const int position, const int endPosition);
         bool RegionHasAlignments(void) const;
         bool SetRegion(const BamRegion& region, const int& referenceCount);
 
+        // multiple-region methods
+        bool HasMultipleRegions(void) const;
+        const std::vector<int>& OverlappingRegions(void) const;
+        bool SetRegions(const std::vector<BamRegion>& regions, const RefVector& references);
+
+        // region chunk methods (set by index on jump, if supported)
+        bool HasRegionChunks(void) const;
+        bool NextRegionOffset(int64_t& offset);
+        void SetRegionChunks(const BamRegionChunkVector& chunks);
+
         // general methods
         void Close(void);
         std::string GetErrorString(void) const;
@@ -71,6 +139,10 @@ class BamRandomAccessController {
     private:
         // adjusts requested region if necessary (depending on where data actually begins)
         void AdjustRegion(const int& referenceCount);
+        // builds index data for reader's BAM file, storing index on success
+        bool BuildIndex(BamReaderPrivate* reader, BamIndex* newIndex);
+        // returns "RegionState" of alignment against all regions from SetRegions()
+        RegionState IntervalState(const int refID, const int position, const int endPosition);
         // error-string handling
         void SetErrorString(const std::string& where, const std::string& what);
 
@@ -83,6 +155,15 @@ class BamRandomAccessController {
         // region data
         BamRegion m_region;
         bool m_hasAlignmentsInRegion;
+        BamRegionChunkVector m_regionChunks;
+        size_t m_currentChunk;
+        bool m_isChunkSeekPending;
+
+        // multiple-region data
+        bool m_hasMultipleRegions;
+        std::vector<BamRegionInterval> m_intervals;
+        size_t m_firstLiveInterval;
+        std::vector<int> m_overlappingRegions;
 
         // general data
         std::string m_errorString;
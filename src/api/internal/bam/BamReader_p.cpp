@@ -2,9 +2,9 @@
 // BamReader_p.cpp (c) 2009 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 18 November 2012 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
-// Provides the basic functionality for reading BAM files
+// Provides the basic functionality for reading BAM (or SAM text) files
 // ***************************************************************************
 
 #include "api/BamConstants.h"
@@ -16,21 +16,57 @@
 #include "api/internal/index/BamStandardIndex_p.h"
 #include "api/internal/index/BamToolsIndex_p.h"
 #include "api/internal/io/BamDeviceFactory_p.h"
+#include "api/internal/io/BamMappedFile_p.h"
+#include "api/internal/io/ILocalIODevice_p.h"
 #include "api/internal/utils/BamException_p.h"
+#include "shared/bamtools_raw_record.h"
 using namespace BamTools;
 using namespace BamTools::Internal;
 
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <iostream>
 #include <iterator>
 #include <vector>
 using namespace std;
 
+namespace BamTools {
+namespace Internal {
+
+// -----------------
+// utility methods
+// -----------------
+
+// returns true if device holds SAM text, rather than BGZF-compressed BAM data
+// (looks at first byte, without consuming it)
+static
+bool isSamInput(IBamIODevice* device) {
+
+    char firstByte = 0;
+    bool hasData = false;
+    if ( ILocalIODevice* localDevice = dynamic_cast<ILocalIODevice*>(device) )
+        hasData = localDevice->Peek(firstByte);
+    else if ( BamMappedFile* mappedFile = dynamic_cast<BamMappedFile*>(device) )
+        hasData = mappedFile->Peek(firstByte);
+    else if ( device->IsRandomAccess() ) {
+        const int64_t position = device->Tell();
+        hasData = ( device->Read(&firstByte, 1) == 1 );
+        device->Seek(position);
+    }
+
+    // anything that isn't a BGZF block is read as text
+    return ( hasData && firstByte != Constants::GZIP_ID1 );
+}
+
+} // namespace Internal
+} // namespace BamTools
+
 // constructor
 BamReaderPrivate::BamReaderPrivate(BamReader* parent)
     : m_alignmentsBeginOffset(0)
     , m_parent(parent)
+    , m_samReader(0)
 {
     m_isBigEndian = BamTools::SystemIsBigEndian();
 }
@@ -53,6 +89,10 @@ bool BamReaderPrivate::Close(void) {
     // close random access controller
     m_randomAccessController.Close();
 
+    // stop reading SAM text, before its device is closed
+    delete m_samReader;
+    m_samReader = 0;
+
     // if stream is open, attempt close
     if ( IsOpen() ) {
         try {
@@ -69,7 +109,142 @@ bool BamReaderPrivate::Close(void) {
     return true;
 }
 
+// counts alignments in region (all alignments in file, if region has no left bound),
+// i.e. the alignments that would be returned after a SetRegion(region) call
+//
+// index statistics are used where possible, so that little or no alignment data has
+// to be read. the reader's region is cleared & its file position is undefined afterwards.
+bool BamReaderPrivate::CountAlignments(const BamRegion& region, uint64_t& count) {
+
+    count = 0;
+
+    // skip if BAM file not open
+    if ( !IsOpen() ) {
+        SetErrorString("BamReader::CountAlignments", "cannot count alignments on unopened BAM file");
+        return false;
+    }
+
+    try {
+
+        // count entire file
+        if ( !region.isLeftBoundSpecified() ) {
+
+            // sum up index statistics, if available for all references
+            bool isIndexCountOk = true;
+            const int numReferences = m_references.size();
+            for ( int refId = 0; refId < numReferences && isIndexCountOk; ++refId ) {
+                uint64_t refCount = 0;
+                isIndexCountOk = m_randomAccessController.CountIndexAlignments(refId, 0, -1, refCount);
+                count += refCount;
+            }
+            uint64_t unplacedCount = 0;
+            if ( isIndexCountOk && m_randomAccessController.CountIndexUnplacedAlignments(unplacedCount) ) {
+                count += unplacedCount;
+                m_randomAccessController.ClearRegion();
+                return true;
+            }
+
+            // otherwise read through all alignments, rewinding only if reader has moved on
+            // (streamed input can't be rewound, so is counted from its current position)
+            count = 0;
+            m_randomAccessController.ClearRegion();
+            if ( !IsAtFirstAlignment() && m_stream.m_device->IsRandomAccess() && !Rewind() )
+                return false;
+            while ( LoadNextRawAlignmentCore(m_record) )
+                ++count;
+            return true;
+        }
+
+        // otherwise, region can only be located through index data
+        if ( !HasIndex() ) {
+            SetErrorString("BamReader::CountAlignments", "cannot count alignments in region if no index data available");
+            return false;
+        }
+        const int numReferences = m_references.size();
+        const int lastRefId = ( region.isRightBoundSpecified() ? region.RightRefID : numReferences - 1 );
+        if ( region.LeftRefID >= numReferences || lastRefId >= numReferences ) {
+            SetErrorString("BamReader::CountAlignments", "invalid region requested");
+            return false;
+        }
+
+        // count region's part on each reference separately
+        for ( int refId = region.LeftRefID; refId <= lastRefId; ++refId ) {
+            const int begin = ( refId == region.LeftRefID ? region.LeftPosition : 0 );
+            const int end   = ( (region.isRightBoundSpecified() && refId == region.RightRefID) ? region.RightPosition : -1 );
+            count += CountReferenceAlignments(refId, begin, end);
+        }
+        m_randomAccessController.ClearRegion();
+        return true;
+
+    } catch ( BamException& e ) {
+        const string streamError = e.what();
+        const string message = string("could not count alignments: \n\t") + streamError;
+        SetErrorString("BamReader::CountAlignments", message);
+        m_randomAccessController.ClearRegion();
+        return false;
+    }
+}
+
+// returns number of alignments on reference that overlap [begin, end) (end < 0 means up
+// to end of reference), from index statistics if possible or by reading them
+uint64_t BamReaderPrivate::CountReferenceAlignments(const int& refId, const int& begin, const int& end) {
+
+    // see if index can answer this itself
+    uint64_t count = 0;
+    if ( m_randomAccessController.CountIndexAlignments(refId, begin, end, count) )
+        return count;
+
+    // otherwise jump to region
+    const BamRegion region = ( end >= 0 ? BamRegion(refId, begin, refId, end) : BamRegion(refId, begin) );
+    if ( !m_randomAccessController.SetRegion(region, m_references.size()) )
+        throw BamException("BamReader::CountAlignments", m_randomAccessController.GetErrorString());
+    if ( !m_randomAccessController.RegionHasAlignments() )
+        return 0;
+
+    // & check each alignment on reference (only core data is needed)
+    while ( SkipToRegionChunk() && LoadNextRawAlignmentCore(m_record) ) {
+        const char* record = m_record.data();
+
+        // stop at unplaced reads, or once past reference (index may have skipped ahead, if reference is empty)
+        const int32_t alignmentRefId = RawRecord::RefID(record);
+        if ( alignmentRefId < 0 || alignmentRefId > refId )
+            break;
+        if ( alignmentRefId < refId )
+            continue;
+
+        // alignment starts after region, no need to keep reading
+        const int32_t position = RawRecord::Position(record);
+        if ( end >= 0 && position >= end )
+            break;
+
+        if ( position >= begin || RawRecord::EndPosition(record) > begin )
+            ++count;
+    }
+    return count;
+}
+
 // creates an index file of requested type on current BAM file
+bool BamReaderPrivate::CreateCsiIndex(const int& minShift, const int& depth) {
+
+    // skip if BAM file not open
+    if ( !IsOpen() ) {
+        SetErrorString("BamReader::CreateCsiIndex", "cannot create index on unopened BAM file");
+        return false;
+    }
+    if ( RejectSamInput("BamReader::CreateCsiIndex") )
+        return false;
+
+    // attempt to create index
+    if ( m_randomAccessController.CreateCsiIndex(this, minShift, depth) )
+        return true;
+    else {
+        const string bracError = m_randomAccessController.GetErrorString();
+        const string message = string("could not create index: \n\t") + bracError;
+        SetErrorString("BamReader::CreateCsiIndex", message);
+        return false;
+    }
+}
+
 bool BamReaderPrivate::CreateIndex(const BamIndex::IndexType& type) {
 
     // skip if BAM file not open
@@ -77,6 +252,8 @@ bool BamReaderPrivate::CreateIndex(const BamIndex::IndexType& type) {
         SetErrorString("BamReader::CreateIndex", "cannot create index on unopened BAM file");
         return false;
     }
+    if ( RejectSamInput("BamReader::CreateIndex") )
+        return false;
 
     // attempt to create index
     if ( m_randomAccessController.CreateIndex(this, type) )
@@ -94,10 +271,23 @@ const string BamReaderPrivate::Filename(void) const {
     return m_filename;
 }
 
+uint64_t BamReaderPrivate::GetBlockCacheHits(void) const {
+    return m_stream.NumBlockCacheHits();
+}
+
+uint64_t BamReaderPrivate::GetBlockCacheMisses(void) const {
+    return m_stream.NumBlockCacheMisses();
+}
+
 const SamHeader& BamReaderPrivate::GetConstSamHeader(void) const {
     return m_header.ToConstSamHeader();
 }
 
+// returns indexes of the regions (from SetRegions) overlapped by last alignment returned
+const vector<int>& BamReaderPrivate::GetCurrentRegionIndexes(void) const {
+    return m_currentRegionIndexes;
+}
+
 string BamReaderPrivate::GetErrorString(void) const {
     return m_errorString;
 }
@@ -146,6 +336,9 @@ bool BamReaderPrivate::GetNextAlignmentCore(BamAlignment& alignment) {
     if ( !m_stream.IsOpen() )
         return false;
 
+    // any error reported from here on is this read's
+    m_errorString.clear();
+
     try {
 
         // skip if region is set but has no alignments
@@ -156,7 +349,7 @@ bool BamReaderPrivate::GetNextAlignmentCore(BamAlignment& alignment) {
         }
 
         // if can't read next alignment
-        if ( !LoadNextAlignment(alignment) )
+        if ( !SkipToRegionChunk() || !LoadNextAlignment(alignment) )
             return false;
 
         // check alignment's region-overlap state
@@ -170,7 +363,7 @@ bool BamReaderPrivate::GetNextAlignmentCore(BamAlignment& alignment) {
         while ( state != BamRandomAccessController::OverlapsRegion ) {
 
             // if can't read next alignment
-            if ( !LoadNextAlignment(alignment) )
+            if ( !SkipToRegionChunk() || !LoadNextAlignment(alignment) )
                 return false;
 
             // check alignment's region-overlap state
@@ -183,6 +376,7 @@ bool BamReaderPrivate::GetNextAlignmentCore(BamAlignment& alignment) {
 
         // if we get here, we found the next 'valid' alignment
         // (e.g. overlaps current region if one was set, simply the next alignment if not)
+        StoreCurrentRegionIndexes();
         alignment.SupportData.HasCoreOnly = true;
         return true;
 
@@ -194,6 +388,60 @@ bool BamReaderPrivate::GetNextAlignmentCore(BamAlignment& alignment) {
     }
 }
 
+// retrieves next available alignment as a raw BAM record (returns success/fail)
+// ** DOES NOT populate any BamAlignment at all, the record bytes are stored
+//    exactly as found in the BAM stream (block length, core data, char data)
+// useful for operations that only need to move records around (sort, merge, etc)
+bool BamReaderPrivate::GetNextRawAlignment(std::string& data) {
+
+    // skip if stream not opened
+    if ( !m_stream.IsOpen() )
+        return false;
+
+    // any error reported from here on is this read's
+    m_errorString.clear();
+
+    try {
+
+        // skip if region is set but has no alignments
+        if ( m_randomAccessController.HasRegion() &&
+             !m_randomAccessController.RegionHasAlignments() )
+        {
+            return false;
+        }
+
+        // read until overlap is found
+        while ( SkipToRegionChunk() && LoadNextRawAlignment(data) ) {
+
+            // check record's region-overlap state
+            const char* record = data.data();
+            const BamRandomAccessController::RegionState state =
+                m_randomAccessController.AlignmentState(RawRecord::RefID(record),
+                                                        RawRecord::Position(record),
+                                                        RawRecord::EndPosition(record));
+
+            // if alignment starts after region, no need to keep reading
+            if ( state == BamRandomAccessController::AfterRegion )
+                return false;
+
+            // found the next 'valid' alignment
+            if ( state == BamRandomAccessController::OverlapsRegion ) {
+                StoreCurrentRegionIndexes();
+                return true;
+            }
+        }
+
+        // no more alignments
+        return false;
+
+    } catch ( BamException& e ) {
+        const string streamError = e.what();
+        const string message = string("encountered error reading BAM alignment: \n\t") + streamError;
+        SetErrorString("BamReader::GetNextRawAlignment", message);
+        return false;
+    }
+}
+
 int BamReaderPrivate::GetReferenceCount(void) const {
     return m_references.size();
 }
@@ -222,6 +470,13 @@ bool BamReaderPrivate::HasIndex(void) const {
     return m_randomAccessController.HasIndex();
 }
 
+// returns true if no alignments have been read (or skipped) since Open() or Rewind()
+bool BamReaderPrivate::IsAtFirstAlignment(void) const {
+    if ( m_samReader )
+        return m_samReader->IsAtFirstAlignment();
+    return ( m_stream.Tell() == m_alignmentsBeginOffset );
+}
+
 bool BamReaderPrivate::IsOpen(void) const {
     return m_stream.IsOpen();
 }
@@ -234,84 +489,124 @@ void BamReaderPrivate::LoadHeaderData(void) {
 // populates BamAlignment with alignment data under file pointer, returns success/fail
 bool BamReaderPrivate::LoadNextAlignment(BamAlignment& alignment) {
 
-    // read in the 'block length' value, make sure it's not zero
-    char buffer[sizeof(uint32_t)];
-    fill_n(buffer, sizeof(uint32_t), 0);
-    m_stream.Read(buffer, sizeof(uint32_t));
-    alignment.SupportData.BlockLength = BamTools::UnpackUnsignedInt(buffer);
-    if ( m_isBigEndian ) BamTools::SwapEndian_32(alignment.SupportData.BlockLength);
-    if ( alignment.SupportData.BlockLength == 0 )
+    // read whole record, make sure its name & CIGAR fit in it
+    if ( !LoadNextRawAlignment(m_record) )
         return false;
-
-    // read in core alignment data, make sure the right size of data was read
-    char x[Constants::BAM_CORE_SIZE];
-    if ( m_stream.Read(x, Constants::BAM_CORE_SIZE) != Constants::BAM_CORE_SIZE )
+    const char* record = m_record.data();
+    const uint32_t blockLength = RawRecord::ReadUInt32(record);
+    const unsigned int dataLength = blockLength - Constants::BAM_CORE_SIZE;
+    const unsigned int cigarDataOffset = RawRecord::NameLength(record);
+    const unsigned int numCigarOps = RawRecord::NumCigarOperations(record);
+    if ( cigarDataOffset + numCigarOps*Constants::BAM_SIZEOF_INT > dataLength )
         return false;
 
-    // swap core endian-ness if necessary
-    if ( m_isBigEndian ) {
-        for ( unsigned int i = 0; i < Constants::BAM_CORE_SIZE; i+=sizeof(uint32_t) )
-            BamTools::SwapEndian_32p(&x[i]);
-    }
-
     // set BamAlignment 'core' and 'support' data
-    alignment.RefID    = BamTools::UnpackSignedInt(&x[0]);
-    alignment.Position = BamTools::UnpackSignedInt(&x[4]);
-
-    unsigned int tempValue = BamTools::UnpackUnsignedInt(&x[8]);
-    alignment.Bin        = tempValue >> 16;
-    alignment.MapQuality = tempValue >> 8 & 0xff;
-    alignment.SupportData.QueryNameLength = tempValue & 0xff;
-
-    tempValue = BamTools::UnpackUnsignedInt(&x[12]);
-    alignment.AlignmentFlag = tempValue >> 16;
-    alignment.SupportData.NumCigarOperations = tempValue & 0xffff;
-
-    alignment.SupportData.QuerySequenceLength = BamTools::UnpackUnsignedInt(&x[16]);
-    alignment.MateRefID    = BamTools::UnpackSignedInt(&x[20]);
-    alignment.MatePosition = BamTools::UnpackSignedInt(&x[24]);
-    alignment.InsertSize   = BamTools::UnpackSignedInt(&x[28]);
+    alignment.SupportData.BlockLength = blockLength;
+    alignment.RefID      = RawRecord::RefID(record);
+    alignment.Position   = RawRecord::Position(record);
+    alignment.Bin        = RawRecord::Bin(record);
+    alignment.MapQuality = RawRecord::MapQuality(record);
+    alignment.SupportData.QueryNameLength = cigarDataOffset;
+    alignment.AlignmentFlag = RawRecord::AlignmentFlag(record);
+    alignment.SupportData.NumCigarOperations = numCigarOps;
+    alignment.SupportData.QuerySequenceLength = RawRecord::ReadUInt32(record + RawRecord::SeqLengthOffset);
+    alignment.MateRefID    = RawRecord::ReadInt32(record + RawRecord::MateRefIdOffset);
+    alignment.MatePosition = RawRecord::ReadInt32(record + RawRecord::MatePositionOffset);
+    alignment.InsertSize   = RawRecord::ReadInt32(record + RawRecord::InsertSizeOffset);
 
     // set BamAlignment length
     alignment.Length = alignment.SupportData.QuerySequenceLength;
 
-    // read in character data - make sure proper data size was read
-    bool readCharDataOK = false;
-    const unsigned int dataLength = alignment.SupportData.BlockLength - Constants::BAM_CORE_SIZE;
-    RaiiBuffer allCharData(dataLength);
+    // store 'allCharData' in supportData structure
+    const char* allCharData = record + RawRecord::NameOffset;
+    alignment.SupportData.AllCharData.assign(allCharData, dataLength);
+
+    // save CIGAR ops
+    // need to calculate this here so that  BamAlignment::GetEndPosition() performs correctly,
+    // even when GetNextAlignmentCore() is called
+    const char* cigarData = allCharData + cigarDataOffset;
+    CigarOp op;
+    alignment.CigarData.clear();
+    alignment.CigarData.reserve(numCigarOps);
+    for ( unsigned int i = 0; i < numCigarOps; ++i ) {
+
+        // build CigarOp structure
+        const uint32_t cigarValue = RawRecord::ReadUInt32(cigarData + i*Constants::BAM_SIZEOF_INT);
+        op.Length = (cigarValue >> Constants::BAM_CIGAR_SHIFT);
+        op.Type   = Constants::BAM_CIGAR_LOOKUP[ (cigarValue & Constants::BAM_CIGAR_MASK) ];
+
+        // save CigarOp
+        alignment.CigarData.push_back(op);
+    }
 
-    if ( m_stream.Read(allCharData.Buffer, dataLength) == dataLength ) {
+    // return success
+    return true;
+}
 
-        // store 'allCharData' in supportData structure
-        alignment.SupportData.AllCharData.assign((const char*)allCharData.Buffer, dataLength);
+// reads raw BAM record under file pointer into data, returns success/fail
+bool BamReaderPrivate::LoadNextRawAlignment(std::string& data) {
 
-        // set success flag
-        readCharDataOK = true;
+    // SAM text is converted line by line
+    if ( m_samReader )
+        return m_samReader->ReadRecord(data);
 
-        // save CIGAR ops
-        // need to calculate this here so that  BamAlignment::GetEndPosition() performs correctly,
-        // even when GetNextAlignmentCore() is called
-        const unsigned int cigarDataOffset = alignment.SupportData.QueryNameLength;
-        uint32_t* cigarData = (uint32_t*)(allCharData.Buffer + cigarDataOffset);
-        CigarOp op;
-        alignment.CigarData.clear();
-        alignment.CigarData.reserve(alignment.SupportData.NumCigarOperations);
-        for ( unsigned int i = 0; i < alignment.SupportData.NumCigarOperations; ++i ) {
+    // read in the 'block length' value, make sure it's not zero
+    char buffer[sizeof(uint32_t)];
+    fill_n(buffer, sizeof(uint32_t), 0);
+    m_stream.Read(buffer, sizeof(uint32_t));
+    uint32_t blockLength = BamTools::UnpackUnsignedInt(buffer);
+    if ( m_isBigEndian ) BamTools::SwapEndian_32(blockLength);
+    if ( blockLength < Constants::BAM_CORE_SIZE )
+        return false;
 
-            // swap endian-ness if necessary
-            if ( m_isBigEndian ) BamTools::SwapEndian_32(cigarData[i]);
+    // read remainder of record directly behind the block length
+    data.resize(blockLength + Constants::BAM_SIZEOF_INT);
+    char* record = (char*)data.data();
+    memcpy(record, buffer, sizeof(uint32_t));
+    return ( m_stream.Read(record + Constants::BAM_SIZEOF_INT, blockLength) == blockLength );
+}
 
-            // build CigarOp structure
-            op.Length = (cigarData[i] >> Constants::BAM_CIGAR_SHIFT);
-            op.Type   = Constants::BAM_CIGAR_LOOKUP[ (cigarData[i] & Constants::BAM_CIGAR_MASK) ];
+// retrieves leading part of raw BAM record under file pointer (block length, core
+// data, name & CIGAR) into data, skipping over sequence, qualities & tags
+//
+// this is all that is needed to calculate an alignment's position & bin, without
+// copying out the (much larger) character data
+bool BamReaderPrivate::LoadNextRawAlignmentCore(std::string& data) {
 
-            // save CigarOp
-            alignment.CigarData.push_back(op);
-        }
+    // SAM text has to be converted in full anyway, then trimmed
+    if ( m_samReader ) {
+        if ( !m_samReader->ReadRecord(data) )
+            return false;
+        const char* record = data.data();
+        data.resize( Constants::BAM_SIZEOF_INT + Constants::BAM_CORE_SIZE +
+                     RawRecord::NameLength(record) +
+                     RawRecord::NumCigarOperations(record) * Constants::BAM_SIZEOF_INT );
+        return true;
     }
 
-    // return success/failure
-    return readCharDataOK;
+    // read in the 'block length' value & core data
+    const size_t coreLength = Constants::BAM_SIZEOF_INT + Constants::BAM_CORE_SIZE;
+    char buffer[Constants::BAM_SIZEOF_INT + Constants::BAM_CORE_SIZE];
+    if ( m_stream.Read(buffer, coreLength) != coreLength )
+        return false;
+    const uint32_t blockLength = RawRecord::ReadUInt32(buffer);
+    if ( blockLength < Constants::BAM_CORE_SIZE )
+        return false;
+
+    // read name & CIGAR behind core data
+    const size_t prefixLength = RawRecord::NameLength(buffer) +
+                                RawRecord::NumCigarOperations(buffer) * Constants::BAM_SIZEOF_INT;
+    if ( prefixLength > blockLength - Constants::BAM_CORE_SIZE )
+        return false;
+    data.resize(coreLength + prefixLength);
+    char* record = (char*)data.data();
+    memcpy(record, buffer, coreLength);
+    if ( m_stream.Read(record + coreLength, prefixLength) != prefixLength )
+        return false;
+
+    // skip remainder of record
+    const size_t remaining = blockLength - Constants::BAM_CORE_SIZE - prefixLength;
+    return ( m_stream.Skip(remaining) == remaining );
 }
 
 // loads reference data from BAM file
@@ -352,6 +647,9 @@ bool BamReaderPrivate::LoadReferenceData(void) {
 
 bool BamReaderPrivate::LocateIndex(const BamIndex::IndexType& preferredType) {
 
+    if ( RejectSamInput("BamReader::LocateIndex") )
+        return false;
+
     if ( m_randomAccessController.LocateIndex(this, preferredType) )
         return true;
     else {
@@ -373,9 +671,19 @@ bool BamReaderPrivate::Open(const string& filename) {
         // open BgzfStream
         m_stream.Open(filename, IBamIODevice::ReadOnly);
 
-        // load BAM metadata
-        LoadHeaderData();
-        LoadReferenceData();
+        // SAM text is read straight from the stream's device
+        if ( isSamInput(m_stream.m_device) ) {
+            m_samReader = new SamReader;
+            m_samReader->Open(m_stream.m_device, m_stream.m_numThreads);
+            m_header.SetHeaderText(m_samReader->HeaderText());
+            m_references = m_samReader->References();
+        }
+
+        // otherwise load BAM metadata
+        else {
+            LoadHeaderData();
+            LoadReferenceData();
+        }
 
         // store filename & offset of first alignment
         m_filename = filename;
@@ -395,6 +703,9 @@ bool BamReaderPrivate::Open(const string& filename) {
 
 bool BamReaderPrivate::OpenIndex(const std::string& indexFilename) {
 
+    if ( RejectSamInput("BamReader::OpenIndex") )
+        return false;
+
     if ( m_randomAccessController.OpenIndex(indexFilename, this) )
         return true;
     else {
@@ -411,6 +722,19 @@ bool BamReaderPrivate::Rewind(void) {
     // reset region
     m_randomAccessController.ClearRegion();
 
+    // SAM text is re-read from its first alignment line
+    if ( m_samReader ) {
+        try {
+            m_samReader->Rewind();
+            return true;
+        } catch ( BamException& e ) {
+            const string samError = e.what();
+            const string message = string("could not rewind: \n\t") + samError;
+            SetErrorString("BamReader::Rewind", message);
+            return false;
+        }
+    }
+
     // return status of seeking back to first alignment
     if ( Seek(m_alignmentsBeginOffset) )
         return true;
@@ -422,6 +746,14 @@ bool BamReaderPrivate::Rewind(void) {
     }
 }
 
+// sets error & returns true if input is SAM text (which can't be indexed)
+bool BamReaderPrivate::RejectSamInput(const string& where) {
+    if ( m_samReader == 0 )
+        return false;
+    SetErrorString(where, "index operations are not supported on SAM input");
+    return true;
+}
+
 bool BamReaderPrivate::Seek(const int64_t& position) {
 
     // skip if BAM file not open
@@ -447,10 +779,26 @@ void BamReaderPrivate::SetErrorString(const string& where, const string& what) {
     m_errorString = where + SEPARATOR + what;
 }
 
+void BamReaderPrivate::SetAsyncIO(bool ok) {
+    // only applies to files opened afterwards
+    if ( !IsOpen() )
+        m_stream.SetAsyncIO(ok);
+}
+
+void BamReaderPrivate::SetBlockCacheSize(const unsigned int megabytes) {
+    m_stream.SetBlockCacheSize( static_cast<size_t>(megabytes) * 1024 * 1024 );
+}
+
 void BamReaderPrivate::SetIndex(BamIndex* index) {
     m_randomAccessController.SetIndex(index);
 }
 
+void BamReaderPrivate::SetNumThreads(const unsigned int numThreads) {
+    // modifying thread count is not allowed if BAM file is open
+    if ( !IsOpen() )
+        m_stream.SetNumThreads(numThreads);
+}
+
 // sets current region & attempts to jump to it
 // returns success/failure
 bool BamReaderPrivate::SetRegion(const BamRegion& region) {
@@ -465,6 +813,47 @@ bool BamReaderPrivate::SetRegion(const BamRegion& region) {
     }
 }
 
+// sets multiple regions & attempts to jump to the first one
+// returns success/failure
+bool BamReaderPrivate::SetRegions(const std::vector<BamRegion>& regions) {
+
+    if ( m_randomAccessController.SetRegions(regions, m_references) )
+        return true;
+    else {
+        const string bracError = m_randomAccessController.GetErrorString();
+        const string message = string("could not set regions: \n\t") + bracError;
+        SetErrorString("BamReader::SetRegions", message);
+        return false;
+    }
+}
+
+void BamReaderPrivate::SetRegionChunks(const BamRegionChunkVector& chunks) {
+    m_randomAccessController.SetRegionChunks(chunks);
+}
+
+// skips any data between region chunks, returns false if all chunks have been read
+// (no-op if current region has no chunk list)
+bool BamReaderPrivate::SkipToRegionChunk(void) {
+
+    if ( !m_randomAccessController.HasRegionChunks() )
+        return true;
+
+    const int64_t currentOffset = m_stream.Tell();
+    int64_t nextOffset = currentOffset;
+    if ( !m_randomAccessController.NextRegionOffset(nextOffset) )
+        return false;
+    if ( nextOffset != currentOffset )
+        m_stream.Seek(nextOffset);
+    return true;
+}
+
+void BamReaderPrivate::StoreCurrentRegionIndexes(void) {
+    if ( m_randomAccessController.HasMultipleRegions() )
+        m_currentRegionIndexes = m_randomAccessController.OverlappingRegions();
+    else
+        m_currentRegionIndexes.clear();
+}
+
 int64_t BamReaderPrivate::Tell(void) const {
     return m_stream.Tell();
 }
@@ -2,9 +2,9 @@
 // BamReader_p.h (c) 2010 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 18 November 2012 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
-// Provides the basic functionality for reading BAM files
+// Provides the basic functionality for reading BAM (or SAM text) files
 // ***************************************************************************
 
 #ifndef BAMREADER_P_H
@@ -27,6 +27,7 @@
 #include "api/internal/bam/BamHeader_p.h"
 #include "api/internal/bam/BamRandomAccessController_p.h"
 #include "api/internal/io/BgzfStream_p.h"
+#include "api/internal/sam/SamReader_p.h"
 #include <string>
 
 namespace BamTools {
@@ -49,10 +50,21 @@ class BamReaderPrivate {
         bool Open(const std::string& filename);
         bool Rewind(void);
         bool SetRegion(const BamRegion& region);
+        bool SetRegions(const std::vector<BamRegion>& regions);
+        void SetAsyncIO(bool ok);
+        void SetNumThreads(const unsigned int numThreads);
 
         // access alignment data
+        bool CountAlignments(const BamRegion& region, uint64_t& count);
         bool GetNextAlignment(BamAlignment& alignment);
         bool GetNextAlignmentCore(BamAlignment& alignment);
+        bool GetNextRawAlignment(std::string& data);
+        const std::vector<int>& GetCurrentRegionIndexes(void) const;
+
+        // decompressed block cache
+        uint64_t GetBlockCacheHits(void) const;
+        uint64_t GetBlockCacheMisses(void) const;
+        void SetBlockCacheSize(const unsigned int megabytes);
 
         // access auxiliary data
         std::string GetHeaderText(void) const;
@@ -63,6 +75,7 @@ class BamReaderPrivate {
         int GetReferenceID(const std::string& refName) const;
 
         // index operations
+        bool CreateCsiIndex(const int& minShift, const int& depth);
         bool CreateIndex(const BamIndex::IndexType& type);
         bool HasIndex(void) const;
         bool LocateIndex(const BamIndex::IndexType& preferredType);
@@ -83,13 +96,35 @@ class BamReaderPrivate {
         // retrieves BAM alignment under file pointer
         // (does no overlap checking or character data parsing)
         bool LoadNextAlignment(BamAlignment& alignment);
+        // retrieves raw BAM record under file pointer
+        // (does no overlap checking or parsing of any kind)
+        bool LoadNextRawAlignment(std::string& data);
+        // retrieves leading part of raw BAM record under file pointer (block length,
+        // core data, name & CIGAR), skipping over sequence, qualities & tags
+        bool LoadNextRawAlignmentCore(std::string& data);
         // builds reference data structure from BAM file
         bool LoadReferenceData(void);
         // seek reader to file position
         bool Seek(const int64_t& position);
+        // restricts reading in current region to these chunks (used by index on jump)
+        void SetRegionChunks(const BamRegionChunkVector& chunks);
         // return reader's file position
         int64_t Tell(void) const;
 
+    // internal methods
+    private:
+        // returns number of alignments on reference that overlap [begin, end) (end < 0 means
+        // up to end of reference), from index statistics if possible or by reading them
+        uint64_t CountReferenceAlignments(const int& refId, const int& begin, const int& end);
+        // returns true if no alignments have been read (or skipped) since Open() or Rewind()
+        bool IsAtFirstAlignment(void) const;
+        // sets error & returns true if input is SAM text (which can't be indexed)
+        bool RejectSamInput(const std::string& where);
+        // skips any data between region chunks, returns false if all chunks have been read
+        bool SkipToRegionChunk(void);
+        // stores which regions (from SetRegions) the alignment just found overlaps
+        void StoreCurrentRegionIndexes(void);
+
     // data members
     public:
 
@@ -108,6 +143,13 @@ class BamReaderPrivate {
         BamHeader m_header;
         BamRandomAccessController m_randomAccessController;
         BgzfStream m_stream;
+        SamReader* m_samReader;     // only set if input is SAM text, reads from m_stream's device
+
+        // record buffer, reused between alignments
+        std::string m_record;
+
+        // regions (from SetRegions) overlapped by last alignment returned
+        std::vector<int> m_currentRegionIndexes;
 
         // error handling
         std::string m_errorString;
@@ -2,7 +2,7 @@
 // BamWriter_p.cpp (c) 2010 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 18 November 2012 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Provides the basic functionality for producing BAM files
 // ***************************************************************************
@@ -10,8 +10,10 @@
 #include "api/BamAlignment.h"
 #include "api/BamConstants.h"
 #include "api/IBamIODevice.h"
+#include "api/internal/bam/BamHeader_p.h"
 #include "api/internal/bam/BamWriter_p.h"
 #include "api/internal/utils/BamException_p.h"
+#include "shared/bamtools_raw_record.h"
 using namespace BamTools;
 using namespace BamTools::Internal;
 
@@ -54,6 +56,45 @@ void BamWriterPrivate::Close(void) {
     }
 }
 
+// copies all alignments of another BAM file to the alignment archive, mostly without
+// decompressing them (caller must make sure that file uses the same references)
+bool BamWriterPrivate::CopyAlignments(const string& filename) {
+
+    try {
+
+        // open source file & skip its header ('magic number', SAM header text & references)
+        BgzfStream source;
+        source.Open(filename, IBamIODevice::ReadOnly);
+        BamHeader header;
+        header.Load(&source);
+
+        char buffer[sizeof(uint32_t)];
+        if ( source.Read(buffer, sizeof(uint32_t)) != sizeof(uint32_t) )
+            throw BamException("BamWriter::CopyAlignments", "could not read reference data from " + filename);
+        uint32_t numReferences = BamTools::UnpackUnsignedInt(buffer);
+        if ( m_isBigEndian ) BamTools::SwapEndian_32(numReferences);
+
+        for ( uint32_t i = 0; i < numReferences; ++i ) {
+            if ( source.Read(buffer, sizeof(uint32_t)) != sizeof(uint32_t) )
+                throw BamException("BamWriter::CopyAlignments", "could not read reference data from " + filename);
+            uint32_t nameLength = BamTools::UnpackUnsignedInt(buffer);
+            if ( m_isBigEndian ) BamTools::SwapEndian_32(nameLength);
+            const size_t entryLength = nameLength + Constants::BAM_SIZEOF_INT;
+            if ( source.Skip(entryLength) != entryLength )
+                throw BamException("BamWriter::CopyAlignments", "could not read reference data from " + filename);
+        }
+
+        // append all alignment data that follows
+        m_stream.CopyFrom(source);
+        source.Close();
+        return true;
+
+    } catch ( BamException& e ) {
+        m_errorString = e.what();
+        return false;
+    }
+}
+
 // creates a cigar string from the supplied alignment
 void BamWriterPrivate::CreatePackedCigar(const vector<CigarOp>& cigarOperations, string& packedCigar) {
 
@@ -176,6 +217,119 @@ bool BamWriterPrivate::Open(const string& filename,
     }
 }
 
+// opens an existing alignment archive, positioned to write after its current data
+bool BamWriterPrivate::OpenForAppend(const string& filename) {
+
+    try {
+        const IBamIODevice::OpenMode mode =
+            static_cast<IBamIODevice::OpenMode>(IBamIODevice::WriteOnly | IBamIODevice::Append);
+        m_stream.Open(filename, mode);
+        return true;
+    } catch ( BamException& e ) {
+        m_errorString = e.what();
+        return false;
+    }
+}
+
+// returns true if alignment's name, CIGAR, bases & qualities still match its raw char data
+// (i.e. writing raw bytes gives the same record as re-encoding those fields would)
+bool BamWriterPrivate::HasUnmodifiedSequenceData(const BamAlignment& al) const {
+
+    // raw char data is stored in BAM (little-endian) byte order, but tags are swapped in place
+    // by BamAlignment::BuildCharData() on big-endian systems - always re-encode there
+    if ( m_isBigEndian )
+        return false;
+
+    // make sure raw char data is available & complete
+    const string& rawData = al.SupportData.AllCharData;
+    const unsigned int nameLength     = al.SupportData.QueryNameLength;
+    const unsigned int numCigarOps    = al.SupportData.NumCigarOperations;
+    const unsigned int sequenceLength = al.SupportData.QuerySequenceLength;
+    const unsigned int seqDataOffset  = nameLength + numCigarOps*Constants::BAM_SIZEOF_INT;
+    const unsigned int qualDataOffset = seqDataOffset + (sequenceLength+1)/2;
+    const unsigned int tagDataOffset  = qualDataOffset + sequenceLength;
+    if ( al.SupportData.BlockLength < Constants::BAM_CORE_SIZE ||
+         rawData.size() != al.SupportData.BlockLength - Constants::BAM_CORE_SIZE ||
+         rawData.size() < tagDataOffset )
+    {
+        return false;
+    }
+    const char* pRawData = rawData.data();
+
+    // check name (including null terminator)
+    if ( al.Name.size() + 1 != nameLength ||
+         memcmp(al.Name.c_str(), pRawData, nameLength) != 0 )
+    {
+        return false;
+    }
+
+    // check CIGAR operations
+    if ( al.CigarData.size() != numCigarOps )
+        return false;
+    for ( unsigned int i = 0; i < numCigarOps; ++i ) {
+        const uint32_t packedOp = RawRecord::ReadUInt32(pRawData + nameLength + i*Constants::BAM_SIZEOF_INT);
+        const uint32_t opCode   = packedOp & Constants::BAM_CIGAR_MASK;
+        const CigarOp& op = al.CigarData[i];
+        if ( opCode > Constants::BAM_CIGAR_MISMATCH ||
+             Constants::BAM_CIGAR_LOOKUP[opCode] != op.Type ||
+             (packedOp >> Constants::BAM_CIGAR_SHIFT) != op.Length )
+        {
+            return false;
+        }
+    }
+
+    // check query bases
+    const unsigned int queryLength = ( (al.QueryBases == "*") ? 0 : al.QueryBases.size() );
+    if ( queryLength != sequenceLength )
+        return false;
+    const char* seqData = pRawData + seqDataOffset;
+    for ( unsigned int i = 0; i < sequenceLength; ++i ) {
+        const char base = Constants::BAM_DNA_LOOKUP[ ( (seqData[(i/2)] >> (4*(1-(i%2)))) & 0xf ) ];
+        if ( al.QueryBases[i] != base )
+            return false;
+    }
+
+    // check qualities (sequence of 0xFF stands for 'no qualities stored')
+    if ( sequenceLength > 0 ) {
+        const char* qualData = pRawData + qualDataOffset;
+        if ( qualData[0] == (char)0xFF ) {
+            if ( al.Qualities.empty() || al.Qualities[0] != (char)0xFF )
+                return false;
+        } else {
+            if ( al.Qualities.size() != sequenceLength )
+                return false;
+            for ( unsigned int i = 0; i < sequenceLength; ++i ) {
+                if ( al.Qualities[i] != (char)(qualData[i]+33) )
+                    return false;
+            }
+        }
+    }
+
+    // all sequence data unchanged
+    return true;
+}
+
+// returns true if alignment's tag data still matches its raw char data
+// (only meaningful if HasUnmodifiedSequenceData() is true)
+bool BamWriterPrivate::HasUnmodifiedTagData(const BamAlignment& al) const {
+
+    // compare against raw tags (TagData may have been modified through tag methods, or assigned directly)
+    const string& rawData = al.SupportData.AllCharData;
+    const size_t tagDataOffset = RawTagDataOffset(al);
+    const size_t tagDataLength = rawData.size() - tagDataOffset;
+    return ( al.TagData.size() == tagDataLength &&
+             memcmp(al.TagData.data(), rawData.data() + tagDataOffset, tagDataLength) == 0 );
+}
+
+// returns offset of tag data within alignment's raw char data
+size_t BamWriterPrivate::RawTagDataOffset(const BamAlignment& al) const {
+    const unsigned int sequenceLength = al.SupportData.QuerySequenceLength;
+    return al.SupportData.QueryNameLength +
+           al.SupportData.NumCigarOperations*Constants::BAM_SIZEOF_INT +
+           (sequenceLength+1)/2 +
+           sequenceLength;
+}
+
 // saves the alignment to the alignment archive
 bool BamWriterPrivate::SaveAlignment(const BamAlignment& al) {
 
@@ -186,6 +340,16 @@ bool BamWriterPrivate::SaveAlignment(const BamAlignment& al) {
         if ( al.SupportData.HasCoreOnly )
             WriteCoreAlignment(al);
 
+        // if BamAlignment's char data was populated from a raw buffer that still matches it
+        // (as a result of BamReader::GetNextAlignment(), with no modifications since),
+        // copy the raw data instead of re-encoding - re-writing only the tags if those changed
+        else if ( HasUnmodifiedSequenceData(al) ) {
+            if ( HasUnmodifiedTagData(al) )
+                WriteCoreAlignment(al);
+            else
+                WriteRawSequenceAlignment(al);
+        }
+
         // otherwise, BamAlignment should contain character in the standard fields: Name, QueryBases, etc
         // (resulting from BamReader::GetNextAlignment() *OR* being generated directly by client code)
         else WriteAlignment(al);
@@ -199,6 +363,34 @@ bool BamWriterPrivate::SaveAlignment(const BamAlignment& al) {
     }
 }
 
+// saves a raw BAM record (block length + core + char data) to the alignment archive
+bool BamWriterPrivate::SaveRawAlignment(const char* data, const size_t length) {
+
+    try {
+
+        // make sure record is complete (stored block length must match)
+        if ( length < static_cast<size_t>(Constants::BAM_SIZEOF_INT + Constants::BAM_CORE_SIZE) ||
+             RawRecord::Size(data) != length )
+        {
+            throw BamException("BamWriter::SaveRawAlignment", "invalid raw alignment record");
+        }
+
+        // record is already in BAM byte order, write it as-is
+        m_stream.Write(data, length);
+        return true;
+
+    } catch ( BamException& e ) {
+        m_errorString = e.what();
+        return false;
+    }
+}
+
+void BamWriterPrivate::SetNumThreads(const unsigned int numThreads) {
+    // modifying thread count is not allowed if BAM file is open
+    if ( !IsOpen() )
+        m_stream.SetNumThreads(numThreads);
+}
+
 void BamWriterPrivate::SetWriteCompressed(bool ok) {
     // modifying compression is not allowed if BAM file is open
     if ( !IsOpen() )
@@ -395,8 +587,18 @@ void BamWriterPrivate::WriteAlignment(const BamAlignment& al) {
 
 void BamWriterPrivate::WriteCoreAlignment(const BamAlignment& al) {
 
+    // write the block size & BAM core
+    WriteCoreData(al, al.SupportData.BlockLength);
+
+    // write the raw char data
+    m_stream.Write((char*)al.SupportData.AllCharData.data(),
+                   al.SupportData.BlockLength-Constants::BAM_CORE_SIZE);
+}
+
+void BamWriterPrivate::WriteCoreData(const BamAlignment& al, const uint32_t blockLength) {
+
     // write the block size
-    unsigned int blockSize = al.SupportData.BlockLength;
+    unsigned int blockSize = blockLength;
     if ( m_isBigEndian ) BamTools::SwapEndian_32(blockSize);
     m_stream.Write((char*)&blockSize, Constants::BAM_SIZEOF_INT);
 
@@ -422,10 +624,21 @@ void BamWriterPrivate::WriteCoreAlignment(const BamAlignment& al) {
 
     // write the BAM core
     m_stream.Write((char*)&buffer, Constants::BAM_CORE_SIZE);
+}
 
-    // write the raw char data
-    m_stream.Write((char*)al.SupportData.AllCharData.data(),
-                   al.SupportData.BlockLength-Constants::BAM_CORE_SIZE);
+void BamWriterPrivate::WriteRawSequenceAlignment(const BamAlignment& al) {
+
+    // only used on little-endian systems (see HasUnmodifiedSequenceData()),
+    // so TagData is already in BAM byte order
+    const size_t tagDataOffset = RawTagDataOffset(al);
+    const size_t tagDataLength = al.TagData.size();
+
+    // write the block size & BAM core
+    WriteCoreData(al, Constants::BAM_CORE_SIZE + tagDataOffset + tagDataLength);
+
+    // write the raw name, cigar, bases & qualities, followed by the current tag data
+    m_stream.Write(al.SupportData.AllCharData.data(), tagDataOffset);
+    m_stream.Write(al.TagData.data(), tagDataLength);
 }
 
 void BamWriterPrivate::WriteMagicNumber(void) {
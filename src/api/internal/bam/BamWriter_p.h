@@ -2,7 +2,7 @@
 // BamWriter_p.h (c) 2010 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 25 October 2011 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Provides the basic functionality for producing BAM files
 // ***************************************************************************
@@ -41,12 +41,16 @@ class BamWriterPrivate {
     // interface methods
     public:
         void Close(void);
+        bool CopyAlignments(const std::string& filename);
         std::string GetErrorString(void) const;
         bool IsOpen(void) const;
         bool Open(const std::string& filename,
                   const std::string& samHeaderText,
                   const BamTools::RefVector& referenceSequences);
+        bool OpenForAppend(const std::string& filename);
         bool SaveAlignment(const BamAlignment& al);
+        bool SaveRawAlignment(const char* data, const size_t length);
+        void SetNumThreads(const unsigned int numThreads);
         void SetWriteCompressed(bool ok);
 
     // 'internal' methods
@@ -54,9 +58,14 @@ class BamWriterPrivate {
         uint32_t CalculateMinimumBin(const int begin, int end) const;
         void CreatePackedCigar(const std::vector<BamTools::CigarOp>& cigarOperations, std::string& packedCigar);
         void EncodeQuerySequence(const std::string& query, std::string& encodedQuery);
+        bool HasUnmodifiedSequenceData(const BamAlignment& al) const;
+        bool HasUnmodifiedTagData(const BamAlignment& al) const;
+        size_t RawTagDataOffset(const BamAlignment& al) const;
         void WriteAlignment(const BamAlignment& al);
         void WriteCoreAlignment(const BamAlignment& al);
+        void WriteCoreData(const BamAlignment& al, const uint32_t blockLength);
         void WriteMagicNumber(void);
+        void WriteRawSequenceAlignment(const BamAlignment& al);
         void WriteReferences(const BamTools::RefVector& referenceSequences);
         void WriteSamHeaderText(const std::string& samHeaderText);
 
@@ -0,0 +1,800 @@
+// ***************************************************************************
+// BamCsiIndex_p.cpp (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides index operations for the coordinate-sorted index format (".csi")
+// ***************************************************************************
+
+#include "api/BamConstants.h"
+#include "api/internal/bam/BamReader_p.h"
+#include "api/internal/index/BamCsiIndex_p.h"
+#include "api/internal/utils/BamException_p.h"
+#include "shared/bamtools_raw_record.h"
+using namespace BamTools;
+using namespace BamTools::Internal;
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <utility>
+using namespace std;
+
+// -----------------------------------
+// static BamCsiIndex constants
+// -----------------------------------
+
+const int BamCsiIndex::DEFAULT_MIN_SHIFT    = 14;     // same bins as BAI
+const int BamCsiIndex::DEFAULT_DEPTH        = 5;
+const int BamCsiIndex::MAX_DEPTH            = 10;     // keeps bin IDs within 32 bits
+const int BamCsiIndex::SMALLEST_MIN_SHIFT   = 10;     // bounds per-window offsets kept while building
+const string BamCsiIndex::CSI_EXTENSION     = ".csi";
+const char* const BamCsiIndex::CSI_MAGIC    = "CSI\1";
+
+// ----------------------------
+// BamCsiIndex implementation
+// ----------------------------
+
+// ctor
+BamCsiIndex::BamCsiIndex(Internal::BamReaderPrivate* reader,
+                         const int minShift,
+                         const int depth)
+    : BamIndex(reader)
+    , m_minShift(minShift)
+    , m_depth(depth)
+    , m_numUnplaced(0)
+    , m_hasUnplacedCount(false)
+{
+    m_isBigEndian = BamTools::SystemIsBigEndian();
+}
+
+// dtor
+BamCsiIndex::~BamCsiIndex(void) {
+    if ( m_stream.IsOpen() )
+        m_stream.Close();
+}
+
+void BamCsiIndex::AdjustRegion(const BamRegion& region, int64_t& begin, int64_t& end) {
+
+    // retrieve references from reader
+    const RefVector& references = m_reader->GetReferenceData();
+
+    // LeftPosition cannot be greater than or equal to reference length
+    if ( region.LeftPosition >= references.at(region.LeftRefID).RefLength )
+        throw BamException("BamCsiIndex::AdjustRegion", "invalid region requested");
+
+    // set region 'begin'
+    begin = max(region.LeftPosition, 0);
+
+    // if right bound specified AND left&right bounds are on same reference
+    // OK to use right bound position as region 'end'
+    if ( region.isRightBoundSpecified() && ( region.LeftRefID == region.RightRefID ) )
+        end = region.RightPosition;
+
+    // otherwise, set region 'end' to last reference base
+    else end = references.at(region.LeftRefID).RefLength;
+}
+
+// returns the smallest bin that contains [begin, end)
+uint32_t BamCsiIndex::CalculateBin(int64_t begin, int64_t end) const {
+
+    if ( end <= begin )
+        end = begin + 1;
+    --end;
+
+    int shift = m_minShift;
+    for ( int level = m_depth; level > 0; --level, shift += 3 ) {
+        if ( (begin >> shift) == (end >> shift) )
+            return FirstBinOnLevel(level) + (uint32_t)(begin >> shift);
+    }
+    return 0;
+}
+
+// [begin, end)
+void BamCsiIndex::CalculateCandidateBins(const int64_t& begin,
+                                         const int64_t& end,
+                                         vector<uint32_t>& candidateBins) const
+{
+    candidateBins.clear();
+    const int64_t last = ( end > begin ? end - 1 : begin );
+
+    // get all bins, on each level, that contain this region (in ascending order)
+    int shift = m_minShift + 3*m_depth;
+    for ( int level = 0; level <= m_depth; ++level, shift -= 3 ) {
+        const uint32_t firstBin = FirstBinOnLevel(level);
+        for ( int64_t k = (begin >> shift); k <= (last >> shift); ++k )
+            candidateBins.push_back( firstBin + (uint32_t)k );
+    }
+}
+
+// uses the smallest existing bin containing 'begin' to find the minimum offset
+// at which alignments overlapping 'begin' can be found
+uint64_t BamCsiIndex::CalculateMinOffset(const CsiReferenceIndex& refIndex,
+                                         const int64_t& begin) const
+{
+    const vector<uint32_t>& binIds = refIndex.BinIds;
+    uint32_t bin = CalculateBin(begin, begin + 1);
+    while ( true ) {
+        vector<uint32_t>::const_iterator binIter = lower_bound(binIds.begin(), binIds.end(), bin);
+        if ( binIter != binIds.end() && *binIter == bin )
+            return refIndex.BinOffsets[ binIter - binIds.begin() ];
+        if ( bin == 0 )
+            return 0;
+        bin = (bin - 1) >> 3;
+    }
+}
+
+// appends the alignment chunks, on a single reference, that may overlap [begin, end)
+void BamCsiIndex::CalculateReferenceChunks(const int& refId,
+                                           const int64_t& begin,
+                                           const int64_t& end,
+                                           BaiAlignmentChunkVector& chunks)
+{
+    const CsiReferenceIndex& refIndex = m_indexData.at(refId);
+    if ( refIndex.BinIds.empty() )
+        return;
+
+    // retrieve all candidate bin IDs for region
+    CalculateCandidateBins(begin, end, m_candidateBins);
+
+    // use bins' offsets to calculate the minimum offset that must be considered to find overlap
+    const uint64_t minOffset = CalculateMinOffset(refIndex, begin);
+
+    // walk candidate & stored bins together (both are sorted)
+    vector<uint32_t>::const_iterator binFirst = refIndex.BinIds.begin();
+    vector<uint32_t>::const_iterator binIter  = binFirst;
+    vector<uint32_t>::const_iterator binEnd   = refIndex.BinIds.end();
+    vector<uint32_t>::const_iterator candidateIter = m_candidateBins.begin();
+    vector<uint32_t>::const_iterator candidateEnd  = m_candidateBins.end();
+    for ( ; candidateIter != candidateEnd; ++candidateIter ) {
+
+        // find candidate bin in index data, skip if not present
+        binIter = lower_bound(binIter, binEnd, *candidateIter);
+        if ( binIter == binEnd )
+            break;
+        if ( *binIter != *candidateIter )
+            continue;
+
+        // keep bin's chunks that end after minOffset (trimming any data before it)
+        const size_t binIndex = binIter - binFirst;
+        const uint32_t chunkBegin = refIndex.ChunkStarts[binIndex];
+        const uint32_t chunkEnd   = refIndex.ChunkStarts[binIndex+1];
+        for ( uint32_t i = chunkBegin; i < chunkEnd; ++i ) {
+            const BaiAlignmentChunk& chunk = refIndex.Chunks[i];
+            if ( chunk.Stop > minOffset )
+                chunks.push_back( BaiAlignmentChunk(max(chunk.Start, minOffset), chunk.Stop) );
+        }
+    }
+}
+
+// calculates sorted, merged list of alignment chunks that may overlap region
+void BamCsiIndex::CalculateRegionChunks(const BamRegion& region, BaiAlignmentChunkVector& chunks) {
+
+    chunks.clear();
+
+    // cannot calculate chunks if unknown/invalid reference ID requested
+    const int numReferences = m_indexData.size();
+    if ( region.LeftRefID < 0 || region.LeftRefID >= numReferences )
+        throw BamException("BamCsiIndex::CalculateRegionChunks", "invalid reference ID requested");
+
+    // set up region boundaries on left bound reference, based on actual BamReader data
+    int64_t begin;
+    int64_t end;
+    AdjustRegion(region, begin, end);
+    CalculateReferenceChunks(region.LeftRefID, begin, end, chunks);
+
+    // if region continues beyond left bound reference, add data from any references up to
+    // & including the right bound reference (or up to the last reference, if none given)
+    const RefVector& references = m_reader->GetReferenceData();
+    const int lastRefId = ( region.isRightBoundSpecified() ? min(region.RightRefID, numReferences-1)
+                                                           : numReferences-1 );
+    for ( int refId = region.LeftRefID + 1; refId <= lastRefId; ++refId ) {
+        const int64_t refEnd = references.at(refId).RefLength;
+        const int64_t refRegionEnd = ( (region.isRightBoundSpecified() && refId == region.RightRefID)
+                                       ? min((int64_t)region.RightPosition, refEnd) : refEnd );
+        CalculateReferenceChunks(refId, 0, refRegionEnd, chunks);
+    }
+
+    // sort chunks & merge any that overlap
+    if ( chunks.empty() )
+        return;
+    sort( chunks.begin(), chunks.end() );
+    size_t numMerged = 0;
+    for ( size_t i = 1; i < chunks.size(); ++i ) {
+        BaiAlignmentChunk& lastMerged = chunks[numMerged];
+        const BaiAlignmentChunk& chunk = chunks[i];
+        if ( chunk.Start <= lastMerged.Stop )
+            lastMerged.Stop = max(lastMerged.Stop, chunk.Stop);
+        else
+            chunks[++numMerged] = chunk;
+    }
+    chunks.resize(numMerged+1);
+}
+
+// stores number of alignments on reference that overlap [begin, end) in @count
+// (end < 0 means up to end of reference), returns false if index cannot tell
+//
+// chunks do not record how many alignments they hold, so only whole references
+// can be counted (from the pseudo-bin metadata)
+bool BamCsiIndex::CountAlignments(const int& referenceID,
+                                  const int& begin,
+                                  const int& end,
+                                  uint64_t& count)
+{
+    if ( referenceID < 0 || referenceID >= (int)m_indexData.size() )
+        return false;
+    const CsiReferenceIndex& refIndex = m_indexData.at(referenceID);
+
+    // reference has no alignments at all
+    if ( refIndex.BinIds.empty() ) {
+        count = 0;
+        return true;
+    }
+
+    // otherwise, region must cover entire reference
+    const int32_t refLength = m_reader->GetReferenceData().at(referenceID).RefLength;
+    if ( !refIndex.Metadata.IsPresent || begin > 0 || (end >= 0 && end < refLength) )
+        return false;
+    count = refIndex.Metadata.NumMapped + refIndex.Metadata.NumUnmapped;
+    return true;
+}
+
+// stores number of alignments without a reference position in @count
+bool BamCsiIndex::CountUnplacedAlignments(uint64_t& count) {
+    if ( !m_hasUnplacedCount )
+        return false;
+    count = m_numUnplaced;
+    return true;
+}
+
+// builds index from associated BAM file & writes out to index file
+bool BamCsiIndex::Create(void) {
+
+    // skip if BamReader is invalid or not open
+    if ( m_reader == 0 || !m_reader->IsOpen() ) {
+        SetErrorString("BamCsiIndex::Create", "could not create index: reader is not open");
+        return false;
+    }
+
+    // validate bin scheme (same limits as when loading, plus a floor on min shift, as
+    // building keeps an offset per 2^minShift window of each reference)
+    if ( m_minShift < SMALLEST_MIN_SHIFT || m_depth < 0 || m_depth > MAX_DEPTH ||
+         m_minShift + 3*m_depth > 62 )
+    {
+        stringstream s("");
+        s << "invalid bin scheme - min shift: " << m_minShift << ", depth: " << m_depth
+          << " (min shift must be at least " << SMALLEST_MIN_SHIFT << ", depth at most "
+          << MAX_DEPTH << ", & min shift + 3*depth at most 62)";
+        SetErrorString("BamCsiIndex::Create", s.str());
+        return false;
+    }
+
+    // make sure bins can hold the longest reference (adding levels as needed)
+    const RefVector& references = m_reader->GetReferenceData();
+    int64_t maxLength = 0;
+    RefVector::const_iterator refIter = references.begin();
+    RefVector::const_iterator refEnd  = references.end();
+    for ( ; refIter != refEnd; ++refIter )
+        maxLength = max(maxLength, (int64_t)(*refIter).RefLength);
+    while ( (((int64_t)1) << (m_minShift + 3*m_depth)) < maxLength && m_depth < MAX_DEPTH )
+        ++m_depth;
+    if ( (((int64_t)1) << (m_minShift + 3*m_depth)) < maxLength ) {
+        SetErrorString("BamCsiIndex::Create", "min shift is too small to index the longest reference");
+        return false;
+    }
+
+    // rewind BamReader
+    if ( !m_reader->Rewind() ) {
+        const string readerError = m_reader->GetErrorString();
+        const string message = "could not create index: \n\t" + readerError;
+        SetErrorString("BamCsiIndex::Create", message);
+        return false;
+    }
+
+    try {
+
+        // initialize in-memory index data with number of references
+        m_indexData.clear();
+        m_indexData.assign( references.size(), CsiReferenceIndex() );
+        m_numUnplaced = 0;
+        m_hasUnplacedCount = true;
+
+        // set up bin, ID, offset, & coordinate markers
+        const uint32_t noBin = 0xffffffffu;
+        uint32_t currentBin    = noBin;
+        int32_t  currentRefID  = -2;    // no alignments read yet
+        int32_t  lastPosition  = -1;
+        uint64_t binOffset     = 0;
+        uint64_t lastOffset    = (uint64_t)m_reader->Tell();
+
+        // iterate through alignments in BAM file
+        // (only each record's core data, name & CIGAR are read)
+        string record;
+        CsiReferenceEntry refEntry;
+        while ( m_reader->LoadNextRawAlignmentCore(record) ) {
+
+            const char* data = record.data();
+            const int32_t refId    = RawRecord::RefID(data);
+            const int32_t position = RawRecord::Position(data);
+            const uint64_t currentOffset = (uint64_t)m_reader->Tell();
+
+            // make sure that current file pointer is beyond lastOffset
+            if ( currentOffset <= lastOffset ) {
+                SetErrorString("BamCsiIndex::Create", "calculating offsets failed");
+                return false;
+            }
+
+            // changed to new reference
+            if ( refId != currentRefID ) {
+
+                // file must be sorted on reference, with unplaced reads last
+                if ( currentRefID == -1 || (refId >= 0 && refId < currentRefID) ) {
+                    SetErrorString("BamCsiIndex::Create", "BAM file is not properly sorted by coordinate");
+                    return false;
+                }
+
+                // save previous reference data
+                if ( currentRefID >= 0 ) {
+                    SaveAlignmentChunk(refEntry, currentBin, binOffset, lastOffset);
+                    SaveReferenceIndex(currentRefID, refEntry);
+                }
+
+                // reset markers
+                refEntry = CsiReferenceEntry();
+                refEntry.Metadata.StartOffset = lastOffset;
+                refEntry.Metadata.IsPresent = true;
+                currentRefID = refId;
+                currentBin   = noBin;
+                lastPosition = -1;
+            }
+
+            // if lastPosition greater than current alignment position - file not sorted properly
+            else if ( refId >= 0 && lastPosition > position ) {
+                stringstream s("");
+                s << "BAM file is not properly sorted by coordinate" << endl
+                  << "Current alignment position: " << position
+                  << " < previous alignment position: " << lastPosition
+                  << " on reference ID: " << refId << endl;
+                SetErrorString("BamCsiIndex::Create", s.str());
+                return false;
+            }
+
+            // unplaced reads are only counted
+            if ( refId < 0 )
+                ++m_numUnplaced;
+
+            else {
+
+                // calculate bin for this alignment
+                const bool isMapped = ( (RawRecord::AlignmentFlag(data) & Constants::BAM_ALIGNMENT_UNMAPPED) == 0 );
+                const int64_t begin = position;
+                const int64_t end = ( isMapped ? (int64_t)RawRecord::EndPosition(data) : begin + 1 );
+                const uint32_t bin = CalculateBin(begin, end);
+
+                // changed to new bin, save previous bin's chunk
+                if ( bin != currentBin ) {
+                    if ( currentBin != noBin )
+                        SaveAlignmentChunk(refEntry, currentBin, binOffset, lastOffset);
+                    currentBin = bin;
+                    binOffset  = lastOffset;
+                }
+
+                SaveAlignment(refEntry, begin, end, isMapped, lastOffset, currentOffset);
+                lastPosition = position;
+            }
+
+            // update lastOffset
+            lastOffset = currentOffset;
+        }
+
+        // save last reference with data
+        if ( currentRefID >= 0 ) {
+            SaveAlignmentChunk(refEntry, currentBin, binOffset, lastOffset);
+            SaveReferenceIndex(currentRefID, refEntry);
+        }
+
+        // write index file
+        const string indexFilename = m_reader->Filename() + Extension();
+        m_stream.Open(indexFilename, IBamIODevice::WriteOnly);
+        WriteIndexData();
+        m_stream.Close();
+
+    } catch ( BamException& e ) {
+        if ( m_stream.IsOpen() )
+            m_stream.Close();
+        m_errorString = e.what();
+        return false;
+    }
+
+    // rewind BamReader
+    if ( !m_reader->Rewind() ) {
+        const string readerError = m_reader->GetErrorString();
+        const string message = "could not create index: \n\t" + readerError;
+        SetErrorString("BamCsiIndex::Create", message);
+        return false;
+    }
+
+    // return success
+    return true;
+}
+
+// returns format's file extension
+const string BamCsiIndex::Extension(void) {
+    return BamCsiIndex::CSI_EXTENSION;
+}
+
+// returns ID of first bin on level (level 0 is the single bin covering everything)
+uint32_t BamCsiIndex::FirstBinOnLevel(const int level) const {
+    return ( (((uint32_t)1) << (3*level)) - 1 ) / 7;
+}
+
+// returns whether reference has alignments or no
+bool BamCsiIndex::HasAlignments(const int& referenceID) const {
+    if ( referenceID < 0 || referenceID >= (int)m_indexData.size() )
+        return false;
+    const CsiReferenceIndex& refIndex = m_indexData.at(referenceID);
+    return ( !refIndex.BinIds.empty() );
+}
+
+// attempts to use index data to jump to @region, returns success/fail
+// a "successful" jump indicates no error, but not whether this region has data
+//   * thus, the method sets a flag to indicate whether there are alignments
+//     available after the jump position
+bool BamCsiIndex::Jump(const BamRegion& region, bool* hasAlignmentsInRegion) {
+
+    // clear out flag
+    *hasAlignmentsInRegion = false;
+
+    // skip if invalid reader or not open
+    if ( m_reader == 0 || !m_reader->IsOpen() ) {
+        SetErrorString("BamCsiIndex::Jump", "could not jump: reader is not open");
+        return false;
+    }
+
+    // calculate the chunks of data that may hold alignments in region
+    BaiAlignmentChunkVector chunks;
+    try {
+        CalculateRegionChunks(region, chunks);
+    } catch ( BamException& e ) {
+        m_errorString = e.what();
+        return false;
+    }
+
+    // if region has no data, simply return true (but hasAlignmentsInRegion flag is false)
+    if ( chunks.empty() )
+        return true;
+
+    // hand chunks to reader (so it only visits these) & seek to first one
+    BamRegionChunkVector regionChunks;
+    regionChunks.reserve(chunks.size());
+    BaiAlignmentChunkVector::const_iterator chunkIter = chunks.begin();
+    BaiAlignmentChunkVector::const_iterator chunkEnd  = chunks.end();
+    for ( ; chunkIter != chunkEnd; ++chunkIter )
+        regionChunks.push_back( BamRegionChunk((*chunkIter).Start, (*chunkIter).Stop) );
+    m_reader->SetRegionChunks(regionChunks);
+
+    *hasAlignmentsInRegion = true;
+    return m_reader->Seek(chunks.front().Start);
+}
+
+// loads existing data from file into memory
+bool BamCsiIndex::Load(const std::string& filename) {
+
+    try {
+
+        // attempt to open file (read-only)
+        m_stream.Open(filename, IBamIODevice::ReadOnly);
+
+        // validate format
+        char magic[4];
+        ReadData(magic, sizeof(magic));
+        if ( strncmp(magic, BamCsiIndex::CSI_MAGIC, 4) != 0 )
+            throw BamException("BamCsiIndex::Load", "invalid CSI magic number");
+
+        // load all index data into memory, file is no longer needed after this
+        LoadIndexData();
+        m_stream.Close();
+
+        // return success
+        return true;
+
+    } catch ( BamException& e ) {
+        if ( m_stream.IsOpen() )
+            m_stream.Close();
+        m_errorString = e.what();
+        return false;
+    }
+}
+
+// loads bin scheme & all references' bins into memory
+void BamCsiIndex::LoadIndexData(void) {
+
+    // load bin scheme
+    m_minShift = ReadInt32();
+    m_depth    = ReadInt32();
+    if ( m_minShift < 0 || m_depth < 0 || m_depth > MAX_DEPTH || m_minShift + 3*m_depth > 62 )
+        throw BamException("BamCsiIndex::LoadIndexData", "invalid CSI bin scheme");
+
+    // skip auxiliary data
+    const int32_t auxLength = ReadInt32();
+    if ( auxLength < 0 )
+        throw BamException("BamCsiIndex::LoadIndexData", "invalid CSI auxiliary data length");
+    string aux(auxLength, '\0');
+    if ( auxLength > 0 )
+        ReadData(&aux[0], auxLength);
+
+    // load references
+    const int32_t numReferences = ReadInt32();
+    if ( numReferences < 0 )
+        throw BamException("BamCsiIndex::LoadIndexData", "invalid reference count");
+    m_indexData.clear();
+    m_indexData.assign( numReferences, CsiReferenceIndex() );
+    CsiIndexData::iterator refIter = m_indexData.begin();
+    CsiIndexData::iterator refEnd  = m_indexData.end();
+    for ( ; refIter != refEnd; ++refIter )
+        LoadReference(*refIter);
+
+    // number of unplaced reads is optional
+    uint64_t numUnplaced = 0;
+    if ( m_stream.Read((char*)&numUnplaced, sizeof(numUnplaced)) == sizeof(numUnplaced) ) {
+        if ( m_isBigEndian ) SwapEndian_64(numUnplaced);
+        m_numUnplaced = numUnplaced;
+        m_hasUnplacedCount = true;
+    } else {
+        m_numUnplaced = 0;
+        m_hasUnplacedCount = false;
+    }
+}
+
+void BamCsiIndex::LoadReference(CsiReferenceIndex& refIndex) {
+
+    // load number of bins
+    const int32_t numBins = ReadInt32();
+    if ( numBins < 0 )
+        throw BamException("BamCsiIndex::LoadReference", "invalid bin count");
+
+    // read all bins' chunks (bins are not necessarily stored in sorted order)
+    const uint32_t pseudoBin = PseudoBin();
+    vector< pair<BaiBinLocation, uint64_t> > binLocations;    // location => bin offset
+    binLocations.reserve(numBins);
+    BaiAlignmentChunkVector chunks;
+    for ( int i = 0; i < numBins; ++i ) {
+
+        const uint32_t binId      = ReadUInt32();
+        const uint64_t binOffset  = ReadUInt64();
+        const int32_t  numChunks  = ReadInt32();
+        if ( numChunks < 0 )
+            throw BamException("BamCsiIndex::LoadReference", "invalid chunk count");
+
+        // pseudo-bin holds reference metadata, not alignment chunks
+        if ( binId == pseudoBin ) {
+            if ( numChunks != 2 )
+                throw BamException("BamCsiIndex::LoadReference", "invalid CSI pseudo-bin");
+            refIndex.Metadata.StartOffset = ReadUInt64();
+            refIndex.Metadata.EndOffset   = ReadUInt64();
+            refIndex.Metadata.NumMapped   = ReadUInt64();
+            refIndex.Metadata.NumUnmapped = ReadUInt64();
+            refIndex.Metadata.IsPresent   = true;
+            continue;
+        }
+
+        BaiBinLocation location;
+        location.ID = binId;
+        location.FirstChunk = chunks.size();
+        location.NumChunks  = numChunks;
+        binLocations.push_back( make_pair(location, binOffset) );
+
+        // iterate over alignment chunks
+        for ( int j = 0; j < numChunks; ++j ) {
+            const uint64_t chunkStart = ReadUInt64();
+            const uint64_t chunkStop  = ReadUInt64();
+            chunks.push_back( BaiAlignmentChunk(chunkStart, chunkStop) );
+        }
+    }
+
+    // store bins, sorted on ID
+    sort( binLocations.begin(), binLocations.end() );
+    refIndex.BinIds.reserve(binLocations.size());
+    refIndex.BinOffsets.reserve(binLocations.size());
+    refIndex.ChunkStarts.reserve(binLocations.size()+1);
+    refIndex.Chunks.reserve(chunks.size());
+    vector< pair<BaiBinLocation, uint64_t> >::const_iterator locationIter = binLocations.begin();
+    vector< pair<BaiBinLocation, uint64_t> >::const_iterator locationEnd  = binLocations.end();
+    for ( ; locationIter != locationEnd; ++locationIter ) {
+        const BaiBinLocation& location = (*locationIter).first;
+        refIndex.BinIds.push_back(location.ID);
+        refIndex.BinOffsets.push_back((*locationIter).second);
+        refIndex.ChunkStarts.push_back(refIndex.Chunks.size());
+        refIndex.Chunks.insert(refIndex.Chunks.end(),
+                               chunks.begin() + location.FirstChunk,
+                               chunks.begin() + location.FirstChunk + location.NumChunks);
+    }
+    refIndex.ChunkStarts.push_back(refIndex.Chunks.size());
+}
+
+// returns ID of the pseudo-bin that holds reference metadata
+uint32_t BamCsiIndex::PseudoBin(void) const {
+    return FirstBinOnLevel(m_depth + 1) + 1;
+}
+
+void BamCsiIndex::ReadData(char* data, const size_t dataLength) {
+    const size_t numBytesRead = m_stream.Read(data, dataLength);
+    if ( numBytesRead != dataLength ) {
+        stringstream s("");
+        s << "expected to read: " << dataLength << " bytes, "
+          << "but instead read: " << numBytesRead;
+        throw BamException("BamCsiIndex::ReadData", s.str());
+    }
+}
+
+int32_t BamCsiIndex::ReadInt32(void) {
+    int32_t value;
+    ReadData((char*)&value, sizeof(value));
+    if ( m_isBigEndian ) SwapEndian_32(value);
+    return value;
+}
+
+uint32_t BamCsiIndex::ReadUInt32(void) {
+    uint32_t value;
+    ReadData((char*)&value, sizeof(value));
+    if ( m_isBigEndian ) SwapEndian_32(value);
+    return value;
+}
+
+uint64_t BamCsiIndex::ReadUInt64(void) {
+    uint64_t value;
+    ReadData((char*)&value, sizeof(value));
+    if ( m_isBigEndian ) SwapEndian_64(value);
+    return value;
+}
+
+// updates reference's linear offsets & metadata for an alignment stored at [startOffset, endOffset)
+void BamCsiIndex::SaveAlignment(CsiReferenceEntry& refEntry,
+                                const int64_t& begin,
+                                const int64_t& end,
+                                const bool isMapped,
+                                const uint64_t& startOffset,
+                                const uint64_t& endOffset)
+{
+    // record alignment offset for any windows that don't have one yet
+    const size_t firstWindow = (size_t)(begin >> m_minShift);
+    const size_t lastWindow  = (size_t)((max(end, begin + 1) - 1) >> m_minShift);
+    BaiLinearOffsetVector& offsets = refEntry.LinearOffsets;
+    if ( offsets.size() <= lastWindow )
+        offsets.resize(lastWindow + 1, 0);
+    for ( size_t i = firstWindow; i <= lastWindow; ++i ) {
+        if ( offsets[i] == 0 )
+            offsets[i] = startOffset;
+    }
+
+    // update metadata
+    refEntry.Metadata.EndOffset = endOffset;
+    if ( isMapped )
+        ++refEntry.Metadata.NumMapped;
+    else
+        ++refEntry.Metadata.NumUnmapped;
+}
+
+// appends chunk to bin, merging with bin's previous chunk if they share a BGZF block
+void BamCsiIndex::SaveAlignmentChunk(CsiReferenceEntry& refEntry,
+                                     const uint32_t& bin,
+                                     const uint64_t& startOffset,
+                                     const uint64_t& endOffset)
+{
+    BaiAlignmentChunkVector& binChunks = refEntry.Bins[bin];
+    if ( !binChunks.empty() && (binChunks.back().Stop >> 16) == (startOffset >> 16) )
+        binChunks.back().Stop = endOffset;
+    else
+        binChunks.push_back( BaiAlignmentChunk(startOffset, endOffset) );
+}
+
+// stores reference entry in in-memory index data (entry's linear offsets are modified)
+void BamCsiIndex::SaveReferenceIndex(const int& refId, CsiReferenceEntry& refEntry) {
+
+    CsiReferenceIndex& refIndex = m_indexData.at(refId);
+    refIndex = CsiReferenceIndex();
+    refIndex.Metadata = refEntry.Metadata;
+
+    // windows without alignments use the offset of the next window that has some
+    BaiLinearOffsetVector& offsets = refEntry.LinearOffsets;
+    for ( size_t i = offsets.size(); i > 1; --i ) {
+        if ( offsets[i-2] == 0 )
+            offsets[i-2] = offsets[i-1];
+    }
+
+    // bin map is already sorted on ID
+    BaiBinMap::const_iterator binIter = refEntry.Bins.begin();
+    BaiBinMap::const_iterator binEnd  = refEntry.Bins.end();
+    for ( ; binIter != binEnd; ++binIter ) {
+        const uint32_t binId = (*binIter).first;
+        const BaiAlignmentChunkVector& binChunks = (*binIter).second;
+
+        // bin's offset is the linear offset of its first window
+        int level = 0;
+        while ( level < m_depth && binId >= FirstBinOnLevel(level + 1) )
+            ++level;
+        const int64_t binBegin = ((int64_t)(binId - FirstBinOnLevel(level))) << (m_minShift + 3*(m_depth - level));
+        const size_t window = (size_t)(binBegin >> m_minShift);
+        const uint64_t binOffset = ( window < offsets.size() ? offsets[window] : 0 );
+
+        refIndex.BinIds.push_back(binId);
+        refIndex.BinOffsets.push_back(binOffset);
+        refIndex.ChunkStarts.push_back( refIndex.Chunks.size() );
+        refIndex.Chunks.insert( refIndex.Chunks.end(), binChunks.begin(), binChunks.end() );
+    }
+    refIndex.ChunkStarts.push_back( refIndex.Chunks.size() );
+}
+
+void BamCsiIndex::WriteData(const char* data, const size_t dataLength) {
+    const size_t numBytesWritten = m_stream.Write(data, dataLength);
+    if ( numBytesWritten != dataLength )
+        throw BamException("BamCsiIndex::WriteData", "could not write CSI data");
+}
+
+// writes header, all references & number of unplaced reads
+void BamCsiIndex::WriteIndexData(void) {
+
+    // write magic number & bin scheme (no auxiliary data)
+    WriteData(BamCsiIndex::CSI_MAGIC, 4);
+    WriteInt32(m_minShift);
+    WriteInt32(m_depth);
+    WriteInt32(0);
+
+    // write references
+    WriteInt32( (int32_t)m_indexData.size() );
+    CsiIndexData::const_iterator refIter = m_indexData.begin();
+    CsiIndexData::const_iterator refEnd  = m_indexData.end();
+    for ( ; refIter != refEnd; ++refIter )
+        WriteReference(*refIter);
+
+    // write number of unplaced reads
+    WriteUInt64(m_numUnplaced);
+}
+
+void BamCsiIndex::WriteInt32(int32_t value) {
+    if ( m_isBigEndian ) SwapEndian_32(value);
+    WriteData((const char*)&value, sizeof(value));
+}
+
+void BamCsiIndex::WriteReference(const CsiReferenceIndex& refIndex) {
+
+    // write number of bins (including pseudo-bin, if reference has data)
+    const bool hasData = !refIndex.BinIds.empty();
+    const size_t numBins = refIndex.BinIds.size();
+    WriteInt32( (int32_t)( hasData ? numBins + 1 : 0 ) );
+
+    // write bins
+    for ( size_t i = 0; i < numBins; ++i ) {
+        const uint32_t chunkBegin = refIndex.ChunkStarts[i];
+        const uint32_t chunkEnd   = refIndex.ChunkStarts[i+1];
+        WriteUInt32(refIndex.BinIds[i]);
+        WriteUInt64(refIndex.BinOffsets[i]);
+        WriteInt32( (int32_t)(chunkEnd - chunkBegin) );
+        for ( uint32_t j = chunkBegin; j < chunkEnd; ++j ) {
+            WriteUInt64(refIndex.Chunks[j].Start);
+            WriteUInt64(refIndex.Chunks[j].Stop);
+        }
+    }
+
+    // write pseudo-bin
+    if ( hasData ) {
+        WriteUInt32( PseudoBin() );
+        WriteUInt64(0);
+        WriteInt32(2);
+        WriteUInt64(refIndex.Metadata.StartOffset);
+        WriteUInt64(refIndex.Metadata.EndOffset);
+        WriteUInt64(refIndex.Metadata.NumMapped);
+        WriteUInt64(refIndex.Metadata.NumUnmapped);
+    }
+}
+
+void BamCsiIndex::WriteUInt32(uint32_t value) {
+    if ( m_isBigEndian ) SwapEndian_32(value);
+    WriteData((const char*)&value, sizeof(value));
+}
+
+void BamCsiIndex::WriteUInt64(uint64_t value) {
+    if ( m_isBigEndian ) SwapEndian_64(value);
+    WriteData((const char*)&value, sizeof(value));
+}
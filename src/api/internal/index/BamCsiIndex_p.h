@@ -0,0 +1,183 @@
+// ***************************************************************************
+// BamCsiIndex_p.h (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides index operations for the coordinate-sorted index format (".csi")
+// ***************************************************************************
+
+#ifndef BAM_CSI_INDEX_FORMAT_H
+#define BAM_CSI_INDEX_FORMAT_H
+
+//  -------------
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the BamTools API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+
+#include "api/BamAux.h"
+#include "api/BamIndex.h"
+#include "api/internal/index/BamStandardIndex_p.h"
+#include "api/internal/index/IBamIndexCounter_p.h"
+#include "api/internal/io/BgzfStream_p.h"
+#include <string>
+#include <vector>
+
+namespace BamTools {
+namespace Internal {
+
+// -----------------------------------------------------------------------------
+// BamCsiIndex data structures
+
+// per-reference summary, stored in the CSI 'pseudo-bin' (same layout as in BAI files)
+typedef BaiReferenceMetadata CsiReferenceMetadata;
+
+// contains all fields necessary for building CSI index data for a single reference
+//
+// LinearOffsets holds, for each 2^minShift window, the offset of the first alignment
+// overlapping it (0 if none). CSI files do not store these, they are only used to
+// calculate each bin's 'loffset' when the reference is complete.
+struct CsiReferenceEntry {
+
+    // data members
+    BaiBinMap Bins;
+    BaiLinearOffsetVector LinearOffsets;
+    CsiReferenceMetadata Metadata;
+};
+
+// fully loaded (in-memory) CSI data for a single reference
+//
+// bins are stored flat: BinIds is sorted, bin BinIds[i] owns the alignment chunks
+// Chunks[ ChunkStarts[i], ChunkStarts[i+1] ), and BinOffsets[i] is the smallest offset
+// of any alignment that overlaps the bin's first window
+struct CsiReferenceIndex {
+
+    // data members
+    std::vector<uint32_t> BinIds;
+    std::vector<uint32_t> ChunkStarts;
+    std::vector<uint64_t> BinOffsets;
+    BaiAlignmentChunkVector Chunks;
+    CsiReferenceMetadata Metadata;
+};
+
+// convenience typedef for describing full, in-memory CSI index data
+typedef std::vector<CsiReferenceIndex> CsiIndexData;
+
+// end BamCsiIndex data structures
+// -----------------------------------------------------------------------------
+
+class BamCsiIndex : public BamIndex, public IBamIndexCounter {
+
+    // ctor & dtor
+    public:
+        BamCsiIndex(Internal::BamReaderPrivate* reader,
+                    const int minShift = BamCsiIndex::DEFAULT_MIN_SHIFT,
+                    const int depth = BamCsiIndex::DEFAULT_DEPTH);
+        ~BamCsiIndex(void);
+
+    // IBamIndexCounter implementation
+    public:
+        // stores number of alignments on reference that overlap [begin, end) in @count
+        // (only possible for whole references, from pseudo-bin metadata)
+        bool CountAlignments(const int& referenceID, const int& begin, const int& end, uint64_t& count);
+        // stores number of alignments without a reference position in @count
+        bool CountUnplacedAlignments(uint64_t& count);
+
+    // BamIndex implementation
+    public:
+        // builds index from associated BAM file & writes out to index file
+        bool Create(void);
+        // returns whether reference has alignments or no
+        bool HasAlignments(const int& referenceID) const;
+        // attempts to use index data to jump to @region, returns success/fail
+        // a "successful" jump indicates no error, but not whether this region has data
+        //   * thus, the method sets a flag to indicate whether there are alignments
+        //     available after the jump position
+        bool Jump(const BamTools::BamRegion& region, bool* hasAlignmentsInRegion);
+        // loads existing data from file into memory
+        bool Load(const std::string& filename);
+        BamIndex::IndexType Type(void) const { return BamIndex::CSI; }
+    public:
+        // returns format's file extension
+        static const std::string Extension(void);
+
+    // internal methods
+    private:
+
+        // bin scheme methods
+        uint32_t CalculateBin(int64_t begin, int64_t end) const;
+        void CalculateCandidateBins(const int64_t& begin,
+                                    const int64_t& end,
+                                    std::vector<uint32_t>& candidateBins) const;
+        uint32_t FirstBinOnLevel(const int level) const;
+        uint32_t PseudoBin(void) const;
+
+        // CSI index building methods
+        void SaveAlignment(CsiReferenceEntry& refEntry,
+                           const int64_t& begin,
+                           const int64_t& end,
+                           const bool isMapped,
+                           const uint64_t& startOffset,
+                           const uint64_t& endOffset);
+        void SaveAlignmentChunk(CsiReferenceEntry& refEntry,
+                                const uint32_t& bin,
+                                const uint64_t& startOffset,
+                                const uint64_t& endOffset);
+        void SaveReferenceIndex(const int& refId, CsiReferenceEntry& refEntry);
+
+        // random-access methods
+        void AdjustRegion(const BamRegion& region, int64_t& begin, int64_t& end);
+        uint64_t CalculateMinOffset(const CsiReferenceIndex& refIndex, const int64_t& begin) const;
+        void CalculateReferenceChunks(const int& refId,
+                                      const int64_t& begin,
+                                      const int64_t& end,
+                                      BaiAlignmentChunkVector& chunks);
+        void CalculateRegionChunks(const BamRegion& region, BaiAlignmentChunkVector& chunks);
+
+        // CSI file input methods
+        void LoadIndexData(void);
+        void LoadReference(CsiReferenceIndex& refIndex);
+        void ReadData(char* data, const size_t dataLength);
+        int32_t ReadInt32(void);
+        uint32_t ReadUInt32(void);
+        uint64_t ReadUInt64(void);
+
+        // CSI file output methods
+        void WriteData(const char* data, const size_t dataLength);
+        void WriteIndexData(void);
+        void WriteInt32(int32_t value);
+        void WriteReference(const CsiReferenceIndex& refIndex);
+        void WriteUInt32(uint32_t value);
+        void WriteUInt64(uint64_t value);
+
+    // data members
+    private:
+        bool m_isBigEndian;
+        int m_minShift;
+        int m_depth;
+        uint64_t m_numUnplaced;
+        bool m_hasUnplacedCount;    // number of unplaced reads is optional in CSI files
+        CsiIndexData m_indexData;
+        std::vector<uint32_t> m_candidateBins;
+        BgzfStream m_stream;
+
+    // static constants
+    public:
+        static const int DEFAULT_MIN_SHIFT;
+        static const int DEFAULT_DEPTH;
+    private:
+        static const int MAX_DEPTH;
+        static const int SMALLEST_MIN_SHIFT;
+        static const std::string CSI_EXTENSION;
+        static const char* const CSI_MAGIC;
+};
+
+} // namespace Internal
+} // namespace BamTools
+
+#endif // BAM_CSI_INDEX_FORMAT_H
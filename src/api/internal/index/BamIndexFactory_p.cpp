@@ -2,11 +2,13 @@
 // BamIndexFactory_p.cpp (c) 2011 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 10 November 2011 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Provides interface for generating BamIndex implementations
 // ***************************************************************************
 
+#include "api/BamAux.h"
+#include "api/internal/index/BamCsiIndex_p.h"
 #include "api/internal/index/BamIndexFactory_p.h"
 #include "api/internal/index/BamStandardIndex_p.h"
 #include "api/internal/index/BamToolsIndex_p.h"
@@ -22,6 +24,7 @@ const string BamIndexFactory::CreateIndexFilename(const string& bamFilename,
     switch ( type ) {
         case ( BamIndex::STANDARD ) : return ( bamFilename + BamStandardIndex::Extension() );
         case ( BamIndex::BAMTOOLS ) : return ( bamFilename + BamToolsIndex::Extension() );
+        case ( BamIndex::CSI )      : return ( bamFilename + BamCsiIndex::Extension() );
         default :
             return string();
     }
@@ -39,6 +42,7 @@ BamIndex* BamIndexFactory::CreateIndexFromFilename(const string& indexFilename,
     // create index based on extension
     if      ( extension == BamStandardIndex::Extension() ) return new BamStandardIndex(reader);
     else if ( extension == BamToolsIndex::Extension()    ) return new BamToolsIndex(reader);
+    else if ( extension == BamCsiIndex::Extension()      ) return new BamCsiIndex(reader);
     else
         return 0;
 }
@@ -50,11 +54,20 @@ BamIndex* BamIndexFactory::CreateIndexOfType(const BamIndex::IndexType& type,
     switch ( type ) {
         case ( BamIndex::STANDARD ) : return new BamStandardIndex(reader);
         case ( BamIndex::BAMTOOLS ) : return new BamToolsIndex(reader);
+        case ( BamIndex::CSI )      : return new BamCsiIndex(reader);
         default :
             return 0;
     }
 }
 
+// creates a new CSI index object, using the requested bin scheme
+BamIndex* BamIndexFactory::CreateCsiIndex(BamReaderPrivate* reader,
+                                          const int& minShift,
+                                          const int& depth)
+{
+    return new BamCsiIndex(reader, minShift, depth);
+}
+
 // retrieves file extension (including '.')
 const string BamIndexFactory::FileExtension(const string& filename) {
 
@@ -85,22 +98,33 @@ const string BamIndexFactory::FindIndexFilename(const string& bamFilename,
 
     // try to find index of preferred type first
     // return index filename if found
-    string indexFilename = CreateIndexFilename(bamFilename, preferredType);
-    if ( !indexFilename.empty() )
-        return indexFilename;
+    const string preferredFilename = CreateIndexFilename(bamFilename, preferredType);
+    if ( !preferredFilename.empty() && FileExists(preferredFilename) )
+        return preferredFilename;
 
     // couldn't find preferred type, try the other supported types
     // return index filename if found
+    string indexFilename;
     if ( preferredType != BamIndex::STANDARD ) {
         indexFilename = CreateIndexFilename(bamFilename, BamIndex::STANDARD);
-        if ( !indexFilename.empty() )
+        if ( !indexFilename.empty() && FileExists(indexFilename) )
             return indexFilename;
     }
     if ( preferredType != BamIndex::BAMTOOLS ) {
         indexFilename = CreateIndexFilename(bamFilename, BamIndex::BAMTOOLS);
-        if ( !indexFilename.empty() )
+        if ( !indexFilename.empty() && FileExists(indexFilename) )
             return indexFilename;
     }
+    if ( preferredType != BamIndex::CSI ) {
+        indexFilename = CreateIndexFilename(bamFilename, BamIndex::CSI);
+        if ( !indexFilename.empty() && FileExists(indexFilename) )
+            return indexFilename;
+    }
+
+    // none found locally - fall back to preferred type's name, so that an index
+    // next to a remote BAM file can still be tried
+    if ( !preferredFilename.empty() )
+        return preferredFilename;
 
     // otherwise couldn't find any index matching this filename
     return string();
@@ -20,6 +20,10 @@ class BamIndexFactory {
 
     // static interface methods
     public:
+        // creates a new CSI index object, using the requested bin scheme
+        static BamIndex* CreateCsiIndex(BamReaderPrivate* reader,
+                                        const int& minShift,
+                                        const int& depth);
         // creates a new BamIndex object, depending on extension of @indexFilename
         static BamIndex* CreateIndexFromFilename(const std::string& indexFilename,
                                                  BamReaderPrivate* reader);
@@ -2,16 +2,16 @@
 // BamStandardIndex.cpp (c) 2010 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 25 May 2012 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Provides index operations for the standardized BAM index format (".bai")
 // ***************************************************************************
 
-#include "api/BamAlignment.h"
 #include "api/internal/bam/BamReader_p.h"
 #include "api/internal/index/BamStandardIndex_p.h"
 #include "api/internal/io/BamDeviceFactory_p.h"
 #include "api/internal/utils/BamException_p.h"
+#include "shared/bamtools_raw_record.h"
 using namespace BamTools;
 using namespace BamTools::Internal;
 
@@ -64,6 +64,8 @@ BamStandardIndex::RaiiWrapper::~RaiiWrapper(void) {
 // ctor
 BamStandardIndex::BamStandardIndex(Internal::BamReaderPrivate* reader)
     : BamIndex(reader)
+    , m_numUnplaced(0)
+    , m_hasUnplacedCount(false)
     , m_bufferLength(0)
 {
      m_isBigEndian = BamTools::SystemIsBigEndian();
@@ -98,96 +100,124 @@ void BamStandardIndex::AdjustRegion(const BamRegion& region, uint32_t& begin, ui
 // [begin, end)
 void BamStandardIndex::CalculateCandidateBins(const uint32_t& begin,
                                               const uint32_t& end,
-                                              set<uint16_t>& candidateBins)
+                                              vector<uint32_t>& candidateBins)
 {
     // initialize list, bin '0' is always a valid bin
-    candidateBins.insert(0);
+    candidateBins.clear();
+    candidateBins.push_back(0);
 
-    // get rest of bins that contain this region
+    // get rest of bins that contain this region (in ascending order)
     unsigned int k;
-    for (k =    1 + (begin>>26); k <=    1 + (end>>26); ++k) { candidateBins.insert(k); }
-    for (k =    9 + (begin>>23); k <=    9 + (end>>23); ++k) { candidateBins.insert(k); }
-    for (k =   73 + (begin>>20); k <=   73 + (end>>20); ++k) { candidateBins.insert(k); }
-    for (k =  585 + (begin>>17); k <=  585 + (end>>17); ++k) { candidateBins.insert(k); }
-    for (k = 4681 + (begin>>14); k <= 4681 + (end>>14); ++k) { candidateBins.insert(k); }
+    for (k =    1 + (begin>>26); k <=    1 + (end>>26); ++k) { candidateBins.push_back(k); }
+    for (k =    9 + (begin>>23); k <=    9 + (end>>23); ++k) { candidateBins.push_back(k); }
+    for (k =   73 + (begin>>20); k <=   73 + (end>>20); ++k) { candidateBins.push_back(k); }
+    for (k =  585 + (begin>>17); k <=  585 + (end>>17); ++k) { candidateBins.push_back(k); }
+    for (k = 4681 + (begin>>14); k <= 4681 + (end>>14); ++k) { candidateBins.push_back(k); }
 }
 
-void BamStandardIndex::CalculateCandidateOffsets(const BaiReferenceSummary& refSummary,
-                                                 const uint64_t& minOffset,
-                                                 set<uint16_t>& candidateBins,
-                                                 vector<int64_t>& offsets)
+uint64_t BamStandardIndex::CalculateMinOffset(const BaiReferenceIndex& refIndex,
+                                              const uint32_t& begin)
 {
-    // seek to first bin
-    Seek(refSummary.FirstBinFilePosition, SEEK_SET);
+    // if no linear offsets exist, return 0
+    const BaiLinearOffsetVector& linearOffsets = refIndex.LinearOffsets;
+    if ( linearOffsets.empty() )
+        return 0;
 
-    // iterate over reference bins
-    uint32_t binId;
-    int32_t numAlignmentChunks;
-    set<uint16_t>::iterator candidateBinIter;
-    for ( int i = 0; i < refSummary.NumBins; ++i ) {
+    // if 'begin' starts beyond last linear offset, use the last linear offset as minimum
+    // else use the offset corresponding to the requested start position
+    const size_t shiftedBegin = begin>>BamStandardIndex::BAM_LIDX_SHIFT;
+    if ( shiftedBegin >= linearOffsets.size() )
+        return linearOffsets.back();
+    else
+        return linearOffsets[shiftedBegin];
+}
 
-        // read bin contents (if successful, alignment chunks are now in m_buffer)
-        ReadBinIntoBuffer(binId, numAlignmentChunks);
+// appends the alignment chunks, on a single reference, that may overlap [begin, end)
+void BamStandardIndex::CalculateReferenceChunks(const int& refId,
+                                                const uint32_t& begin,
+                                                const uint32_t& end,
+                                                BaiAlignmentChunkVector& chunks)
+{
+    const BaiReferenceIndex& refIndex = m_indexData.at(refId);
+    if ( refIndex.BinIds.empty() )
+        return;
 
-        // see if bin is a 'candidate bin'
-        candidateBinIter = candidateBins.find(binId);
+    // retrieve all candidate bin IDs for region
+    CalculateCandidateBins(begin, end, m_candidateBins);
 
-        // if not, move on to next bin
-        if ( candidateBinIter == candidateBins.end() )
+    // use reference's linear offsets to calculate the minimum offset
+    // that must be considered to find overlap
+    const uint64_t minOffset = CalculateMinOffset(refIndex, begin);
+
+    // walk candidate & stored bins together (both are sorted)
+    vector<uint32_t>::const_iterator binFirst = refIndex.BinIds.begin();
+    vector<uint32_t>::const_iterator binIter  = binFirst;
+    vector<uint32_t>::const_iterator binEnd   = refIndex.BinIds.end();
+    vector<uint32_t>::const_iterator candidateIter = m_candidateBins.begin();
+    vector<uint32_t>::const_iterator candidateEnd  = m_candidateBins.end();
+    for ( ; candidateIter != candidateEnd; ++candidateIter ) {
+
+        // find candidate bin in index data, skip if not present
+        binIter = lower_bound(binIter, binEnd, *candidateIter);
+        if ( binIter == binEnd )
+            break;
+        if ( *binIter != *candidateIter )
             continue;
 
-        // otherwise, check bin's contents against for overlap
-        else {
-
-            size_t offset = 0;
-            uint64_t chunkStart;
-            uint64_t chunkStop;
-
-            // iterate over alignment chunks
-            for ( int j = 0; j < numAlignmentChunks; ++j ) {
+        // keep bin's chunks that end after minOffset (trimming any data before it)
+        const size_t binIndex = binIter - binFirst;
+        const uint32_t chunkBegin = refIndex.ChunkStarts[binIndex];
+        const uint32_t chunkEnd   = refIndex.ChunkStarts[binIndex+1];
+        for ( uint32_t i = chunkBegin; i < chunkEnd; ++i ) {
+            const BaiAlignmentChunk& chunk = refIndex.Chunks[i];
+            if ( chunk.Stop > minOffset )
+                chunks.push_back( BaiAlignmentChunk(max(chunk.Start, minOffset), chunk.Stop) );
+        }
+    }
+}
 
-                // read chunk start & stop from buffer
-                memcpy((char*)&chunkStart, m_resources.Buffer+offset, sizeof(uint64_t));
-                offset += sizeof(uint64_t);
-                memcpy((char*)&chunkStop, m_resources.Buffer+offset, sizeof(uint64_t));
-                offset += sizeof(uint64_t);
+// calculates sorted, merged list of alignment chunks that may overlap region
+void BamStandardIndex::CalculateRegionChunks(const BamRegion& region, BaiAlignmentChunkVector& chunks) {
 
-                // swap endian-ness if necessary
-                if ( m_isBigEndian ) {
-                    SwapEndian_64(chunkStart);
-                    SwapEndian_64(chunkStop);
-                }
+    chunks.clear();
 
-                // store alignment chunk's start offset
-                // if its stop offset is larger than our 'minOffset'
-                if ( chunkStop >= minOffset )
-                    offsets.push_back(chunkStart);
-            }
+    // cannot calculate chunks if unknown/invalid reference ID requested
+    const int numReferences = m_indexData.size();
+    if ( region.LeftRefID < 0 || region.LeftRefID >= numReferences )
+        throw BamException("BamStandardIndex::CalculateRegionChunks", "invalid reference ID requested");
 
-            // 'pop' bin ID from candidate bins set
-            candidateBins.erase(candidateBinIter);
+    // set up region boundaries on left bound reference, based on actual BamReader data
+    uint32_t begin;
+    uint32_t end;
+    AdjustRegion(region, begin, end);
+    CalculateReferenceChunks(region.LeftRefID, begin, end, chunks);
 
-            // quit if no more candidates
-            if ( candidateBins.empty() )
-                break;
-        }
+    // if region continues beyond left bound reference, add data from any references up to
+    // & including the right bound reference (or up to the last reference, if none given)
+    const RefVector& references = m_reader->GetReferenceData();
+    const int lastRefId = ( region.isRightBoundSpecified() ? min(region.RightRefID, numReferences-1)
+                                                           : numReferences-1 );
+    for ( int refId = region.LeftRefID + 1; refId <= lastRefId; ++refId ) {
+        const uint32_t refEnd = (uint32_t)references.at(refId).RefLength;
+        const uint32_t refRegionEnd = ( (region.isRightBoundSpecified() && refId == region.RightRefID)
+                                        ? min((uint32_t)region.RightPosition, refEnd) : refEnd );
+        CalculateReferenceChunks(refId, 0, refRegionEnd, chunks);
     }
-}
-
-uint64_t BamStandardIndex::CalculateMinOffset(const BaiReferenceSummary& refSummary,
-                                              const uint32_t& begin)
-{
-    // if no linear offsets exist, return 0
-    if ( refSummary.NumLinearOffsets == 0 )
-        return 0;
 
-    // if 'begin' starts beyond last linear offset, use the last linear offset as minimum
-    // else use the offset corresponding to the requested start position
-    const int shiftedBegin = begin>>BamStandardIndex::BAM_LIDX_SHIFT;
-    if ( shiftedBegin >= refSummary.NumLinearOffsets )
-        return LookupLinearOffset( refSummary, refSummary.NumLinearOffsets-1 );
-    else
-        return LookupLinearOffset( refSummary, shiftedBegin );
+    // sort chunks & merge any that overlap
+    if ( chunks.empty() )
+        return;
+    sort( chunks.begin(), chunks.end() );
+    size_t numMerged = 0;
+    for ( size_t i = 1; i < chunks.size(); ++i ) {
+        BaiAlignmentChunk& lastMerged = chunks[numMerged];
+        const BaiAlignmentChunk& chunk = chunks[i];
+        if ( chunk.Start <= lastMerged.Stop )
+            lastMerged.Stop = max(lastMerged.Stop, chunk.Stop);
+        else
+            chunks[++numMerged] = chunk;
+    }
+    chunks.resize(numMerged+1);
 }
 
 void BamStandardIndex::CheckBufferSize(char*& buffer,
@@ -241,6 +271,7 @@ void BamStandardIndex::ClearReferenceEntry(BaiReferenceEntry& refEntry) {
     refEntry.ID = -1;
     refEntry.Bins.clear();
     refEntry.LinearOffsets.clear();
+    refEntry.Metadata = BaiReferenceMetadata();
 }
 
 void BamStandardIndex::CloseFile(void) {
@@ -252,15 +283,48 @@ void BamStandardIndex::CloseFile(void) {
         m_resources.Device = 0;
     }
 
-    // clear index file summary data
-    m_indexFileSummary.clear();
-
     // clean up I/O buffer
     delete[] m_resources.Buffer;
     m_resources.Buffer = 0;
     m_bufferLength = 0;
 }
 
+// stores number of alignments on reference that overlap [begin, end) in @count
+// (end < 0 means up to end of reference), returns false if index cannot tell
+//
+// chunks do not record how many alignments they hold, so only whole references
+// can be counted (from the pseudo-bin metadata)
+bool BamStandardIndex::CountAlignments(const int& referenceID,
+                                       const int& begin,
+                                       const int& end,
+                                       uint64_t& count)
+{
+    if ( referenceID < 0 || referenceID >= (int)m_indexData.size() )
+        return false;
+    const BaiReferenceIndex& refIndex = m_indexData.at(referenceID);
+
+    // reference has no alignments at all
+    if ( refIndex.BinIds.empty() ) {
+        count = 0;
+        return true;
+    }
+
+    // otherwise, region must cover entire reference
+    const int32_t refLength = m_reader->GetReferenceData().at(referenceID).RefLength;
+    if ( !refIndex.Metadata.IsPresent || begin > 0 || (end >= 0 && end < refLength) )
+        return false;
+    count = refIndex.Metadata.NumMapped + refIndex.Metadata.NumUnmapped;
+    return true;
+}
+
+// stores number of alignments without a reference position in @count
+bool BamStandardIndex::CountUnplacedAlignments(uint64_t& count) {
+    if ( !m_hasUnplacedCount )
+        return false;
+    count = m_numUnplaced;
+    return true;
+}
+
 // builds index from associated BAM file & writes out to index file
 bool BamStandardIndex::Create(void) {
 
@@ -284,9 +348,11 @@ bool BamStandardIndex::Create(void) {
         string indexFilename = m_reader->Filename() + Extension();
         OpenFile(indexFilename, IBamIODevice::ReadWrite);
 
-        // initialize BaiFileSummary with number of references
+        // initialize in-memory index data with number of references
         const int& numReferences = m_reader->GetReferenceCount();
-        ReserveForSummary(numReferences);
+        ReserveForIndexData(numReferences);
+        m_numUnplaced = 0;
+        m_hasUnplacedCount = false;
 
         // initialize output file
         WriteHeader();
@@ -302,12 +368,28 @@ bool BamStandardIndex::Create(void) {
         int32_t  lastPosition  = defaultValue;
 
         // iterate through alignments in BAM file
-        BamAlignment al;
+        // (only each record's core data, name & CIGAR are read)
+        string record;
         BaiReferenceEntry refEntry;
-        while ( m_reader->LoadNextAlignment(al) ) {
+        while ( m_reader->LoadNextRawAlignmentCore(record) ) {
+
+            const char* data = record.data();
+            const int32_t  refId    = RawRecord::RefID(data);
+            const int32_t  position = RawRecord::Position(data);
+            const uint32_t bin      = RawRecord::Bin(data);
+
+            // unplaced reads (only allowed at end of file) are only counted
+            if ( refId < 0 ) {
+                ++m_numUnplaced;
+                continue;
+            }
+            else if ( m_numUnplaced > 0 ) {
+                SetErrorString("BamStandardIndex::Create", "BAM file is not properly sorted by coordinate");
+                return false;
+            }
 
             // changed to new reference
-            if ( lastRefID != al.RefID ) {
+            if ( lastRefID != refId ) {
 
                 // if not first reference, save previous reference data
                 if ( lastRefID != (int32_t)defaultValue ) {
@@ -316,51 +398,53 @@ bool BamStandardIndex::Create(void) {
                     WriteReferenceEntry(refEntry);
                     ClearReferenceEntry(refEntry);
 
-                    // write any empty references between (but *NOT* including) lastRefID & al.RefID
-                    for ( int i = lastRefID+1; i < al.RefID; ++i ) {
+                    // write any empty references between (but *NOT* including) lastRefID & refId
+                    for ( int i = lastRefID+1; i < refId; ++i ) {
                         BaiReferenceEntry emptyEntry(i);
                         WriteReferenceEntry(emptyEntry);
                     }
 
                     // update bin markers
                     currentOffset = lastOffset;
-                    currentBin    = al.Bin;
-                    lastBin       = al.Bin;
-                    currentRefID  = al.RefID;
+                    currentBin    = bin;
+                    lastBin       = bin;
+                    currentRefID  = refId;
                 }
 
                 // otherwise, this is first pass
                 // be sure to write any empty references up to (but *NOT* including) current RefID
                 else {
-                    for ( int i = 0; i < al.RefID; ++i ) {
+                    for ( int i = 0; i < refId; ++i ) {
                         BaiReferenceEntry emptyEntry(i);
                         WriteReferenceEntry(emptyEntry);
                     }
                 }
 
                 // update reference markers
-                refEntry.ID = al.RefID;
-                lastRefID   = al.RefID;
+                refEntry.ID = refId;
+                refEntry.Metadata.StartOffset = lastOffset;
+                refEntry.Metadata.IsPresent = true;
+                lastRefID   = refId;
                 lastBin     = defaultValue;
             }
 
             // if lastPosition greater than current alignment position - file not sorted properly
-            else if ( lastPosition > al.Position ) {
+            else if ( lastPosition > position ) {
                 stringstream s("");
                 s << "BAM file is not properly sorted by coordinate" << endl
-                  << "Current alignment position: " << al.Position
+                  << "Current alignment position: " << position
                   << " < previous alignment position: " << lastPosition
-                  << " on reference ID: " << al.RefID << endl;
+                  << " on reference ID: " << refId << endl;
                 SetErrorString("BamStandardIndex::Create", s.str());
                 return false;
             }
 
             // if alignment's ref ID is valid & its bin is not a 'leaf'
-            if ( (al.RefID >= 0) && (al.Bin < 4681) )
-                SaveLinearOffsetEntry(refEntry.LinearOffsets, al.Position, al.GetEndPosition(), lastOffset);
+            if ( (refId >= 0) && (bin < 4681) )
+                SaveLinearOffsetEntry(refEntry.LinearOffsets, position, RawRecord::EndPosition(data), lastOffset);
 
             // changed to new BAI bin
-            if ( al.Bin != lastBin ) {
+            if ( bin != lastBin ) {
 
                 // if not first bin on reference, save previous bin data
                 if ( currentBin != defaultValue )
@@ -368,13 +452,9 @@ bool BamStandardIndex::Create(void) {
 
                 // update markers
                 currentOffset = lastOffset;
-                currentBin    = al.Bin;
-                lastBin       = al.Bin;
-                currentRefID  = al.RefID;
-
-                // if invalid RefID, break out
-                if ( currentRefID < 0 )
-                    break;
+                currentBin    = bin;
+                lastBin       = bin;
+                currentRefID  = refId;
             }
 
             // make sure that current file pointer is beyond lastOffset
@@ -385,7 +465,14 @@ bool BamStandardIndex::Create(void) {
 
             // update lastOffset & lastPosition
             lastOffset   = m_reader->Tell();
-            lastPosition = al.Position;
+            lastPosition = position;
+
+            // update reference summary
+            refEntry.Metadata.EndOffset = lastOffset;
+            if ( RawRecord::AlignmentFlag(data) & Constants::BAM_ALIGNMENT_UNMAPPED )
+                ++refEntry.Metadata.NumUnmapped;
+            else
+                ++refEntry.Metadata.NumMapped;
         }
 
         // after finishing alignments, if any data was read, check:
@@ -402,6 +489,12 @@ bool BamStandardIndex::Create(void) {
             WriteReferenceEntry(emptyEntry);
         }
 
+        // finally, write number of unplaced reads
+        WriteUnplacedCount();
+
+        // index file is complete, all further queries use in-memory data
+        CloseFile();
+
     } catch ( BamException& e) {
         m_errorString = e.what();
         return false;
@@ -424,81 +517,12 @@ const string BamStandardIndex::Extension(void) {
     return BamStandardIndex::BAI_EXTENSION;
 }
 
-void BamStandardIndex::GetOffset(const BamRegion& region, int64_t& offset, bool* hasAlignmentsInRegion) {
-
-    // cannot calculate offsets if unknown/invalid reference ID requested
-    if ( region.LeftRefID < 0 || region.LeftRefID >= (int)m_indexFileSummary.size() )
-        throw BamException("BamStandardIndex::GetOffset", "invalid reference ID requested");
-
-    // retrieve index summary for left bound reference
-    const BaiReferenceSummary& refSummary = m_indexFileSummary.at(region.LeftRefID);
-
-    // set up region boundaries based on actual BamReader data
-    uint32_t begin;
-    uint32_t end;
-    AdjustRegion(region, begin, end);
-
-    // retrieve all candidate bin IDs for region
-    set<uint16_t> candidateBins;
-    CalculateCandidateBins(begin, end, candidateBins);
-
-    // use reference's linear offsets to calculate the minimum offset
-    // that must be considered to find overlap
-    const uint64_t& minOffset = CalculateMinOffset(refSummary, begin);
-
-    // attempt to use reference summary, minOffset, & candidateBins to calculate offsets
-    // no data should not be error, just bail
-    vector<int64_t> offsets;
-    CalculateCandidateOffsets(refSummary, minOffset, candidateBins, offsets);
-    if ( offsets.empty() )
-        return;
-    
-    // ensure that offsets are sorted before processing
-    sort( offsets.begin(), offsets.end() );
-
-    // binary search for an overlapping block (may not be first one though)
-    BamAlignment al;
-    typedef vector<int64_t>::const_iterator OffsetConstIterator;
-    OffsetConstIterator offsetFirst = offsets.begin();
-    OffsetConstIterator offsetIter  = offsetFirst;
-    OffsetConstIterator offsetLast  = offsets.end();
-    iterator_traits<OffsetConstIterator>::difference_type count = distance(offsetFirst, offsetLast);
-    iterator_traits<OffsetConstIterator>::difference_type step;
-    while ( count > 0 ) {
-        offsetIter = offsetFirst;
-        step = count/2;
-        advance(offsetIter, step);
-
-        // attempt seek to candidate offset
-        const int64_t& candidateOffset = (*offsetIter);
-        if ( !m_reader->Seek(candidateOffset) ) {
-            const string readerError = m_reader->GetErrorString();
-            const string message = "could not seek in BAM file: \n\t" + readerError;
-            throw BamException("BamToolsIndex::GetOffset", message);
-        }
-
-        // load first available alignment, setting flag to true if data exists
-        *hasAlignmentsInRegion = m_reader->LoadNextAlignment(al);
-
-        // check alignment against region
-        if ( al.GetEndPosition() <= region.LeftPosition ) {
-            offsetFirst = ++offsetIter;
-            count -= step+1;
-        } else count = step;
-    }
-
-    // step back to the offset before the 'current offset' (to make sure we cover overlaps)
-    if ( offsetIter != offsets.begin() )
-        --offsetIter;
-    offset = (*offsetIter);
-}
-
 // returns whether reference has alignments or no
 bool BamStandardIndex::HasAlignments(const int& referenceID) const {
-    if ( referenceID < 0 || referenceID >= (int)m_indexFileSummary.size() )
+    if ( referenceID < 0 || referenceID >= (int)m_indexData.size() )
         return false;
-    const BaiReferenceSummary& refSummary = m_indexFileSummary.at(referenceID);
-    return ( refSummary.NumBins > 0 );
+    const BaiReferenceIndex& refIndex = m_indexData.at(referenceID);
+    return ( !refIndex.BinIds.empty() );
 }
 
 bool BamStandardIndex::IsDeviceOpen(void) const {
@@ -522,22 +546,31 @@ bool BamStandardIndex::Jump(const BamRegion& region, bool* hasAlignmentsInRegion
         return false;
     }
 
-    // calculate nearest offset to jump to
-    int64_t offset;
+    // calculate the chunks of data that may hold alignments in region
+    BaiAlignmentChunkVector chunks;
     try {
-        GetOffset(region, offset, hasAlignmentsInRegion);
+        CalculateRegionChunks(region, chunks);
     } catch ( BamException& e ) {
         m_errorString = e.what();
         return false;
     }
 
-    // if region has alignments, return success/fail of seeking there
-    if ( *hasAlignmentsInRegion )
-        return m_reader->Seek(offset);
-
-    // otherwise, simply return true (but hasAlignmentsInRegion flag has been set to false)
+    // if region has no data, simply return true (but hasAlignmentsInRegion flag is false)
     // (this is OK, BamReader will check this flag before trying to load data)
-    return true;
+    if ( chunks.empty() )
+        return true;
+
+    // hand chunks to reader (so it only visits these) & seek to first one
+    BamRegionChunkVector regionChunks;
+    regionChunks.reserve(chunks.size());
+    BaiAlignmentChunkVector::const_iterator chunkIter = chunks.begin();
+    BaiAlignmentChunkVector::const_iterator chunkEnd  = chunks.end();
+    for ( ; chunkIter != chunkEnd; ++chunkIter )
+        regionChunks.push_back( BamRegionChunk((*chunkIter).Start, (*chunkIter).Stop) );
+    m_reader->SetRegionChunks(regionChunks);
+
+    *hasAlignmentsInRegion = true;
+    return m_reader->Seek(chunks.front().Start);
 }
 
 // loads existing data from file into memory
@@ -551,8 +584,9 @@ bool BamStandardIndex::Load(const std::string& filename) {
         // validate format
         CheckMagicNumber();
 
-        // load in-memory summary of index data
-        SummarizeIndexFile();
+        // load all index data into memory, file is no longer needed after this
+        LoadIndexData();
+        CloseFile();
 
         // return success
         return true;
@@ -563,17 +597,105 @@ bool BamStandardIndex::Load(const std::string& filename) {
     }
 }
 
-uint64_t BamStandardIndex::LookupLinearOffset(const BaiReferenceSummary& refSummary, const int& index) {
+// loads all references' bins & linear offsets into memory
+void BamStandardIndex::LoadIndexData(void) {
 
-    // attempt seek to proper index file position
-    const int64_t linearOffsetFilePosition = (int64_t)refSummary.FirstLinearOffsetFilePosition +
-                                             index*BamStandardIndex::SIZEOF_LINEAROFFSET;
-    Seek(linearOffsetFilePosition, SEEK_SET);
+    // load number of reference sequences
+    int numReferences;
+    ReadNumReferences(numReferences);
+
+    // initialize index data
+    ReserveForIndexData(numReferences);
+
+    // iterate over reference entries
+    BaiIndexData::iterator refIter = m_indexData.begin();
+    BaiIndexData::iterator refEnd  = m_indexData.end();
+    for ( ; refIter != refEnd; ++refIter )
+        LoadReference(*refIter);
+
+    // number of unplaced reads is optional
+    ReadUnplacedCount();
+}
+
+void BamStandardIndex::LoadReference(BaiReferenceIndex& refIndex) {
+
+    // load number of bins
+    int numBins;
+    ReadNumBins(numBins);
+
+    // read all bins' chunks (bins are not necessarily stored in sorted order)
+    vector<BaiBinLocation> binLocations;
+    binLocations.reserve(numBins);
+    BaiAlignmentChunkVector chunks;
+    for ( int i = 0; i < numBins; ++i ) {
+
+        // read bin contents (if successful, alignment chunks are now in m_buffer)
+        uint32_t binId;
+        int32_t numAlignmentChunks;
+        ReadBinIntoBuffer(binId, numAlignmentChunks);
+
+        // pseudo-bin holds reference metadata, not alignment chunks
+        if ( binId == (uint32_t)BamStandardIndex::MAX_BIN ) {
+            ReadPseudoBin(refIndex.Metadata, numAlignmentChunks);
+            continue;
+        }
+
+        BaiBinLocation location;
+        location.ID = binId;
+        location.FirstChunk = chunks.size();
+        location.NumChunks  = numAlignmentChunks;
+        binLocations.push_back(location);
+
+        // iterate over alignment chunks
+        size_t offset = 0;
+        uint64_t chunkStart;
+        uint64_t chunkStop;
+        for ( int j = 0; j < numAlignmentChunks; ++j ) {
+
+            // read chunk start & stop from buffer
+            memcpy((char*)&chunkStart, m_resources.Buffer+offset, sizeof(uint64_t));
+            offset += sizeof(uint64_t);
+            memcpy((char*)&chunkStop, m_resources.Buffer+offset, sizeof(uint64_t));
+            offset += sizeof(uint64_t);
+
+            // swap endian-ness if necessary
+            if ( m_isBigEndian ) {
+                SwapEndian_64(chunkStart);
+                SwapEndian_64(chunkStop);
+            }
+
+            chunks.push_back( BaiAlignmentChunk(chunkStart, chunkStop) );
+        }
+    }
+
+    // store bins, sorted on ID
+    sort( binLocations.begin(), binLocations.end() );
+    refIndex.BinIds.reserve(numBins);
+    refIndex.ChunkStarts.reserve(numBins+1);
+    refIndex.Chunks.reserve(chunks.size());
+    vector<BaiBinLocation>::const_iterator locationIter = binLocations.begin();
+    vector<BaiBinLocation>::const_iterator locationEnd  = binLocations.end();
+    for ( ; locationIter != locationEnd; ++locationIter ) {
+        const BaiBinLocation& location = (*locationIter);
+        refIndex.BinIds.push_back(location.ID);
+        refIndex.ChunkStarts.push_back(refIndex.Chunks.size());
+        refIndex.Chunks.insert(refIndex.Chunks.end(),
+                               chunks.begin() + location.FirstChunk,
+                               chunks.begin() + location.FirstChunk + location.NumChunks);
+    }
+    refIndex.ChunkStarts.push_back(refIndex.Chunks.size());
 
-    // read linear offset from BAI file
-    uint64_t linearOffset;
-    ReadLinearOffset(linearOffset);
-    return linearOffset;
+    // load linear offsets
+    int numLinearOffsets;
+    ReadNumLinearOffsets(numLinearOffsets);
+    ReadIntoBuffer(numLinearOffsets*BamStandardIndex::SIZEOF_LINEAROFFSET);
+    refIndex.LinearOffsets.resize(numLinearOffsets);
+    if ( numLinearOffsets > 0 )
+        memcpy((char*)&refIndex.LinearOffsets[0], m_resources.Buffer, numLinearOffsets*BamStandardIndex::SIZEOF_LINEAROFFSET);
+    if ( m_isBigEndian ) {
+        for ( int i = 0; i < numLinearOffsets; ++i )
+            SwapEndian_64(refIndex.LinearOffsets[i]);
+    }
 }
 
 void BamStandardIndex::MergeAlignmentChunks(BaiAlignmentChunkVector& chunks) {
@@ -622,7 +744,7 @@ void BamStandardIndex::OpenFile(const std::string& filename, IBamIODevice::OpenM
     // make sure any previous index file is closed
     CloseFile();
 
-    m_resources.Device = BamDeviceFactory::CreateDevice(filename);
+    m_resources.Device = BamDeviceFactory::CreateDevice(filename, mode);
     if ( m_resources.Device == 0 ) {
         const string message = string("could not open file: ") + filename;
         throw BamException("BamStandardIndex::OpenFile", message);
@@ -669,13 +791,6 @@ void BamStandardIndex::ReadIntoBuffer(const unsigned int& bytesRequested) {
     }
 }
 
-void BamStandardIndex::ReadLinearOffset(uint64_t& linearOffset) {
-    const int64_t numBytesRead = m_resources.Device->Read((char*)&linearOffset, sizeof(linearOffset));
-    if ( m_isBigEndian ) SwapEndian_64(linearOffset);
-    if ( numBytesRead != sizeof(linearOffset) )
-        throw BamException("BamStandardIndex::ReadLinearOffset", "could not read BAI linear offset");
-}
-
 void BamStandardIndex::ReadNumAlignmentChunks(int& numAlignmentChunks) {
     const int64_t numBytesRead = m_resources.Device->Read((char*)&numAlignmentChunks, sizeof(numAlignmentChunks));
     if ( m_isBigEndian ) SwapEndian_32(numAlignmentChunks);
@@ -704,9 +819,37 @@ void BamStandardIndex::ReadNumReferences(int& numReferences) {
         throw BamException("BamStandardIndex::ReadNumReferences", "could not read reference count");
 }
 
-void BamStandardIndex::ReserveForSummary(const int& numReferences) {
-    m_indexFileSummary.clear();
-    m_indexFileSummary.assign( numReferences, BaiReferenceSummary() );
+// reads reference metadata from pseudo-bin contents (already in buffer)
+void BamStandardIndex::ReadPseudoBin(BaiReferenceMetadata& metadata, const int32_t& numAlignmentChunks) {
+
+    if ( numAlignmentChunks != 2 )
+        throw BamException("BamStandardIndex::ReadPseudoBin", "invalid BAI pseudo-bin");
+
+    uint64_t values[4];
+    memcpy((char*)values, m_resources.Buffer, sizeof(values));
+    if ( m_isBigEndian ) {
+        for ( int i = 0; i < 4; ++i )
+            SwapEndian_64(values[i]);
+    }
+
+    metadata.StartOffset = values[0];
+    metadata.EndOffset   = values[1];
+    metadata.NumMapped   = values[2];
+    metadata.NumUnmapped = values[3];
+    metadata.IsPresent   = true;
+}
+
+// reads number of unplaced reads, if present (written after all reference entries)
+void BamStandardIndex::ReadUnplacedCount(void) {
+    uint64_t numUnplaced = 0;
+    m_hasUnplacedCount = ( m_resources.Device->Read((char*)&numUnplaced, sizeof(numUnplaced)) == sizeof(numUnplaced) );
+    if ( m_isBigEndian ) SwapEndian_64(numUnplaced);
+    m_numUnplaced = ( m_hasUnplacedCount ? numUnplaced : 0 );
+}
+
+void BamStandardIndex::ReserveForIndexData(const int& numReferences) {
+    m_indexData.clear();
+    m_indexData.assign( numReferences, BaiReferenceIndex() );
 }
 
 void BamStandardIndex::SaveAlignmentChunkToBin(BaiBinMap& binMap,
@@ -732,12 +875,6 @@ void BamStandardIndex::SaveAlignmentChunkToBin(BaiBinMap& binMap,
     }
 }
 
-void BamStandardIndex::SaveBinsSummary(const int& refId, const int& numBins) {
-    BaiReferenceSummary& refSummary = m_indexFileSummary.at(refId);
-    refSummary.NumBins = numBins;
-    refSummary.FirstBinFilePosition = Tell();
-}
-
 void BamStandardIndex::SaveLinearOffsetEntry(BaiLinearOffsetVector& offsets,
                                              const int& alignmentStartPosition,
                                              const int& alignmentStopPosition,
@@ -760,88 +897,32 @@ void BamStandardIndex::SaveLinearOffsetEntry(BaiLinearOffsetVector& offsets,
     }
 }
 
-void BamStandardIndex::SaveLinearOffsetsSummary(const int& refId, const int& numLinearOffsets) {
-    BaiReferenceSummary& refSummary = m_indexFileSummary.at(refId);
-    refSummary.NumLinearOffsets = numLinearOffsets;
-    refSummary.FirstLinearOffsetFilePosition = Tell();
-}
-
-// seek to position in index file stream
-void BamStandardIndex::Seek(const int64_t& position, const int origin) {
-    if ( !m_resources.Device->Seek(position, origin) )
-        throw BamException("BamStandardIndex::Seek", "could not seek in BAI file");
-}
-
-void BamStandardIndex::SkipBins(const int& numBins) {
-    uint32_t binId;
-    int32_t numAlignmentChunks;
-    for (int i = 0; i < numBins; ++i)
-        ReadBinIntoBuffer(binId, numAlignmentChunks); // results & buffer ignored
-}
-
-void BamStandardIndex::SkipLinearOffsets(const int& numLinearOffsets) {
-    const unsigned int bytesRequested = numLinearOffsets*BamStandardIndex::SIZEOF_LINEAROFFSET;
-    ReadIntoBuffer(bytesRequested);
+// stores (merged & sorted) reference entry in in-memory index data
+void BamStandardIndex::SaveReferenceIndex(const BaiReferenceEntry& refEntry) {
+
+    BaiReferenceIndex& refIndex = m_indexData.at(refEntry.ID);
+    refIndex.BinIds.clear();
+    refIndex.ChunkStarts.clear();
+    refIndex.Chunks.clear();
+
+    // bin map is already sorted on ID
+    BaiBinMap::const_iterator binIter = refEntry.Bins.begin();
+    BaiBinMap::const_iterator binEnd  = refEntry.Bins.end();
+    for ( ; binIter != binEnd; ++binIter ) {
+        const BaiAlignmentChunkVector& binChunks = (*binIter).second;
+        refIndex.BinIds.push_back( (*binIter).first );
+        refIndex.ChunkStarts.push_back( refIndex.Chunks.size() );
+        refIndex.Chunks.insert( refIndex.Chunks.end(), binChunks.begin(), binChunks.end() );
+    }
+    refIndex.ChunkStarts.push_back( refIndex.Chunks.size() );
+    refIndex.LinearOffsets = refEntry.LinearOffsets;
+    refIndex.Metadata = refEntry.Metadata;
 }
 
 void BamStandardIndex::SortLinearOffsets(BaiLinearOffsetVector& linearOffsets) {
     sort( linearOffsets.begin(), linearOffsets.end() );
 }
 
-void BamStandardIndex::SummarizeBins(BaiReferenceSummary& refSummary) {
-
-    // load number of bins
-    int numBins;
-    ReadNumBins(numBins);
-
-    // store bins summary for this reference
-    refSummary.NumBins = numBins;
-    refSummary.FirstBinFilePosition = Tell();
-
-    // skip this reference's bins
-    SkipBins(numBins);
-}
-
-void BamStandardIndex::SummarizeIndexFile(void) {
-
-    // load number of reference sequences
-    int numReferences;
-    ReadNumReferences(numReferences);
-
-    // initialize file summary data
-    ReserveForSummary(numReferences);
-
-    // iterate over reference entries
-    BaiFileSummary::iterator summaryIter = m_indexFileSummary.begin();
-    BaiFileSummary::iterator summaryEnd  = m_indexFileSummary.end();
-    for ( int i = 0; summaryIter != summaryEnd; ++summaryIter, ++i )
-        SummarizeReference(*summaryIter);
-}
-
-void BamStandardIndex::SummarizeLinearOffsets(BaiReferenceSummary& refSummary) {
-
-    // load number of linear offsets
-    int numLinearOffsets;
-    ReadNumLinearOffsets(numLinearOffsets);
-
-    // store bin summary data for this reference
-    refSummary.NumLinearOffsets = numLinearOffsets;
-    refSummary.FirstLinearOffsetFilePosition = Tell();
-
-    // skip linear offsets in index file
-    SkipLinearOffsets(numLinearOffsets);
-}
-
-void BamStandardIndex::SummarizeReference(BaiReferenceSummary& refSummary) {
-    SummarizeBins(refSummary);
-    SummarizeLinearOffsets(refSummary);
-}
-
-// return position of file pointer in index file stream
-int64_t BamStandardIndex::Tell(void) const {
-    return m_resources.Device->Tell();
-}
-
 void BamStandardIndex::WriteAlignmentChunk(const BaiAlignmentChunk& chunk) {
 
     // localize alignment chunk offsets
@@ -894,23 +975,24 @@ void BamStandardIndex::WriteBin(const uint32_t& binId, BaiAlignmentChunkVector&
     WriteAlignmentChunks(chunks);
 }
 
-void BamStandardIndex::WriteBins(const int& refId, BaiBinMap& bins) {
+void BamStandardIndex::WriteBins(const int& refId, BaiBinMap& bins, const BaiReferenceMetadata& metadata) {
 
-    // write number of bins
-    int32_t binCount = bins.size();
+    // write number of bins (including pseudo-bin, if reference has data)
+    int32_t binCount = ( bins.empty() ? 0 : bins.size() + 1 );
     if ( m_isBigEndian ) SwapEndian_32(binCount);
     const int64_t numBytesWritten = m_resources.Device->Write((const char*)&binCount, sizeof(binCount));
     if ( numBytesWritten != sizeof(binCount) )
         throw BamException("BamStandardIndex::WriteBins", "could not write bin count");
 
-    // save summary for reference's bins
-    SaveBinsSummary(refId, bins.size());
-
     // iterate over bins
     BaiBinMap::iterator binIter = bins.begin();
     BaiBinMap::iterator binEnd  = bins.end();
     for ( ; binIter != binEnd; ++binIter )
         WriteBin( (*binIter).first, (*binIter).second );
+
+    // write pseudo-bin
+    if ( !bins.empty() )
+        WritePseudoBin(metadata);
 }
 
 void BamStandardIndex::WriteHeader(void) {
@@ -921,7 +1003,7 @@ void BamStandardIndex::WriteHeader(void) {
     numBytesWritten += m_resources.Device->Write(BamStandardIndex::BAI_MAGIC, 4);
 
     // write number of reference sequences
-    int32_t numReferences = m_indexFileSummary.size();
+    int32_t numReferences = m_indexData.size();
     if ( m_isBigEndian ) SwapEndian_32(numReferences);
     numBytesWritten += m_resources.Device->Write((const char*)&numReferences, sizeof(numReferences));
 
@@ -941,9 +1023,6 @@ void BamStandardIndex::WriteLinearOffsets(const int& refId, BaiLinearOffsetVecto
     if ( m_isBigEndian ) SwapEndian_32(offsetCount);
     numBytesWritten += m_resources.Device->Write((const char*)&offsetCount, sizeof(offsetCount));
 
-    // save summary for reference's linear offsets
-    SaveLinearOffsetsSummary(refId, linearOffsets.size());
-
     // iterate over linear offsets
     BaiLinearOffsetVector::const_iterator offsetIter = linearOffsets.begin();
     BaiLinearOffsetVector::const_iterator offsetEnd  = linearOffsets.end();
@@ -959,7 +1038,36 @@ void BamStandardIndex::WriteLinearOffsets(const int& refId, BaiLinearOffsetVecto
         throw BamException("BamStandardIndex::WriteLinearOffsets", "could not write BAI linear offsets");
 }
 
+// writes reference metadata as the 2 'chunks' of the pseudo-bin
+void BamStandardIndex::WritePseudoBin(const BaiReferenceMetadata& metadata) {
+
+    uint32_t binKey = BamStandardIndex::MAX_BIN;
+    int32_t chunkCount = 2;
+    if ( m_isBigEndian ) {
+        SwapEndian_32(binKey);
+        SwapEndian_32(chunkCount);
+    }
+    int64_t numBytesWritten = 0;
+    numBytesWritten += m_resources.Device->Write((const char*)&binKey, sizeof(binKey));
+    numBytesWritten += m_resources.Device->Write((const char*)&chunkCount, sizeof(chunkCount));
+    if ( numBytesWritten != (sizeof(binKey)+sizeof(chunkCount)) )
+        throw BamException("BamStandardIndex::WritePseudoBin", "could not write BAI pseudo-bin");
+
+    WriteAlignmentChunk( BaiAlignmentChunk(metadata.StartOffset, metadata.EndOffset) );
+    WriteAlignmentChunk( BaiAlignmentChunk(metadata.NumMapped, metadata.NumUnmapped) );
+}
+
 void BamStandardIndex::WriteReferenceEntry(BaiReferenceEntry& refEntry) {
-    WriteBins(refEntry.ID, refEntry.Bins);
+    WriteBins(refEntry.ID, refEntry.Bins, refEntry.Metadata);
     WriteLinearOffsets(refEntry.ID, refEntry.LinearOffsets);
+    SaveReferenceIndex(refEntry);
+}
+
+void BamStandardIndex::WriteUnplacedCount(void) {
+    uint64_t numUnplaced = m_numUnplaced;
+    if ( m_isBigEndian ) SwapEndian_64(numUnplaced);
+    const int64_t numBytesWritten = m_resources.Device->Write((const char*)&numUnplaced, sizeof(numUnplaced));
+    if ( numBytesWritten != sizeof(numUnplaced) )
+        throw BamException("BamStandardIndex::WriteUnplacedCount", "could not write number of unplaced reads");
+    m_hasUnplacedCount = true;
 }
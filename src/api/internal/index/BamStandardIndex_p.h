@@ -2,7 +2,7 @@
 // BamStandardIndex.h (c) 2010 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 10 November 2011 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Provides index operations for the standardized BAM index format (".bai")
 // ***************************************************************************
@@ -23,8 +23,8 @@
 #include "api/BamAux.h"
 #include "api/BamIndex.h"
 #include "api/IBamIODevice.h"
+#include "api/internal/index/IBamIndexCounter_p.h"
 #include <map>
-#include <set>
 #include <string>
 #include <vector>
 
@@ -64,6 +64,26 @@ typedef std::map<uint32_t, BaiAlignmentChunkVector> BaiBinMap;
 // convenience typedef for a list of all 'linear offsets' in a reference
 typedef std::vector<uint64_t> BaiLinearOffsetVector;
 
+// per-reference summary, stored in the BAI (or CSI) 'pseudo-bin'
+struct BaiReferenceMetadata {
+
+    // data members
+    uint64_t StartOffset;   // offset of reference's first alignment
+    uint64_t EndOffset;     // offset just past reference's last alignment
+    uint64_t NumMapped;
+    uint64_t NumUnmapped;   // placed on reference, but flagged as unmapped
+    bool IsPresent;         // false if index file had no pseudo-bin for reference
+
+    // ctor
+    BaiReferenceMetadata(void)
+        : StartOffset(0)
+        , EndOffset(0)
+        , NumMapped(0)
+        , NumUnmapped(0)
+        , IsPresent(false)
+    { }
+};
+
 // contains all fields necessary for building, loading, & writing
 // full BAI index data for a single reference
 struct BaiReferenceEntry {
@@ -72,6 +92,7 @@ struct BaiReferenceEntry {
     int32_t ID;
     BaiBinMap Bins;
     BaiLinearOffsetVector LinearOffsets;
+    BaiReferenceMetadata Metadata;
 
     // ctor
     BaiReferenceEntry(const int32_t& id = -1)
@@ -79,37 +100,56 @@ struct BaiReferenceEntry {
     { }
 };
 
-// provides (persistent) summary of BaiReferenceEntry's index data
-struct BaiReferenceSummary {
+// fully loaded (in-memory) BAI data for a single reference
+//
+// bins are stored flat: BinIds is sorted, and bin BinIds[i] owns the alignment
+// chunks Chunks[ ChunkStarts[i], ChunkStarts[i+1] )
+struct BaiReferenceIndex {
 
     // data members
-    int NumBins;
-    int NumLinearOffsets;
-    uint64_t FirstBinFilePosition;
-    uint64_t FirstLinearOffsetFilePosition;
+    std::vector<uint32_t> BinIds;
+    std::vector<uint32_t> ChunkStarts;
+    BaiAlignmentChunkVector Chunks;
+    BaiLinearOffsetVector LinearOffsets;
+    BaiReferenceMetadata Metadata;
+};
 
-    // ctor
-    BaiReferenceSummary(void)
-        : NumBins(0)
-        , NumLinearOffsets(0)
-        , FirstBinFilePosition(0)
-        , FirstLinearOffsetFilePosition(0)
-    { }
+// convenience typedef for describing full, in-memory BAI index data
+typedef std::vector<BaiReferenceIndex> BaiIndexData;
+
+// location of a bin's chunks, used for sorting bins on ID while loading
+struct BaiBinLocation {
+
+    // data members
+    uint32_t ID;
+    uint32_t FirstChunk;
+    uint32_t NumChunks;
 };
 
-// convenience typedef for describing a full BAI index file summary
-typedef std::vector<BaiReferenceSummary> BaiFileSummary;
+// comparison operator (for sorting)
+inline
+bool operator<(const BaiBinLocation& lhs, const BaiBinLocation& rhs) {
+    return lhs.ID < rhs.ID;
+}
 
 // end BamStandardIndex data structures
 // -----------------------------------------------------------------------------
 
-class BamStandardIndex : public BamIndex {
+class BamStandardIndex : public BamIndex, public IBamIndexCounter {
 
     // ctor & dtor
     public:
         BamStandardIndex(Internal::BamReaderPrivate* reader);
         ~BamStandardIndex(void);
 
+    // IBamIndexCounter implementation
+    public:
+        // stores number of alignments on reference that overlap [begin, end) in @count
+        // (only possible for whole references, from pseudo-bin metadata)
+        bool CountAlignments(const int& referenceID, const int& begin, const int& end, uint64_t& count);
+        // stores number of alignments without a reference position in @count
+        bool CountUnplacedAlignments(uint64_t& count);
+
     // BamIndex implementation
     public:
         // builds index from associated BAM file & writes out to index file
@@ -136,8 +176,6 @@ class BamStandardIndex : public BamIndex {
         void CloseFile(void);
         bool IsDeviceOpen(void) const;
         void OpenFile(const std::string& filename, IBamIODevice::OpenMode mode);
-        void Seek(const int64_t& position, const int origin);
-        int64_t Tell(void) const;
 
         // BAI index building methods
         void ClearReferenceEntry(BaiReferenceEntry& refEntry);
@@ -154,35 +192,30 @@ class BamStandardIndex : public BamIndex {
         void AdjustRegion(const BamRegion& region, uint32_t& begin, uint32_t& end);
         void CalculateCandidateBins(const uint32_t& begin,
                                     const uint32_t& end,
-                                    std::set<uint16_t>& candidateBins);
-        void CalculateCandidateOffsets(const BaiReferenceSummary& refSummary,
-                                       const uint64_t& minOffset,
-                                       std::set<uint16_t>& candidateBins,
-                                       std::vector<int64_t>& offsets);
-        uint64_t CalculateMinOffset(const BaiReferenceSummary& refSummary, const uint32_t& begin);
-        void GetOffset(const BamRegion& region, int64_t& offset, bool* hasAlignmentsInRegion);
-        uint64_t LookupLinearOffset(const BaiReferenceSummary& refSummary, const int& index);
-
-        // BAI summary (create/load) methods
-        void ReserveForSummary(const int& numReferences);
-        void SaveBinsSummary(const int& refId, const int& numBins);
-        void SaveLinearOffsetsSummary(const int& refId, const int& numLinearOffsets);
-        void SkipBins(const int& numBins);
-        void SkipLinearOffsets(const int& numLinearOffsets);
-        void SummarizeBins(BaiReferenceSummary& refSummary);
-        void SummarizeIndexFile(void);
-        void SummarizeLinearOffsets(BaiReferenceSummary& refSummary);
-        void SummarizeReference(BaiReferenceSummary& refSummary);
+                                    std::vector<uint32_t>& candidateBins);
+        uint64_t CalculateMinOffset(const BaiReferenceIndex& refIndex, const uint32_t& begin);
+        void CalculateReferenceChunks(const int& refId,
+                                      const uint32_t& begin,
+                                      const uint32_t& end,
+                                      BaiAlignmentChunkVector& chunks);
+        void CalculateRegionChunks(const BamRegion& region, BaiAlignmentChunkVector& chunks);
+
+        // BAI in-memory data (create/load) methods
+        void LoadIndexData(void);
+        void LoadReference(BaiReferenceIndex& refIndex);
+        void ReserveForIndexData(const int& numReferences);
+        void SaveReferenceIndex(const BaiReferenceEntry& refEntry);
 
         // BAI full index input methods
         void ReadBinID(uint32_t& binId);
         void ReadBinIntoBuffer(uint32_t& binId, int32_t& numAlignmentChunks);
         void ReadIntoBuffer(const unsigned int& bytesRequested);
-        void ReadLinearOffset(uint64_t& linearOffset);
         void ReadNumAlignmentChunks(int& numAlignmentChunks);
         void ReadNumBins(int& numBins);
         void ReadNumLinearOffsets(int& numLinearOffsets);
         void ReadNumReferences(int& numReferences);
+        void ReadPseudoBin(BaiReferenceMetadata& metadata, const int32_t& numAlignmentChunks);
+        void ReadUnplacedCount(void);
 
         // BAI full index output methods
         void MergeAlignmentChunks(BaiAlignmentChunkVector& chunks);
@@ -190,15 +223,20 @@ class BamStandardIndex : public BamIndex {
         void WriteAlignmentChunk(const BaiAlignmentChunk& chunk);
         void WriteAlignmentChunks(BaiAlignmentChunkVector& chunks);
         void WriteBin(const uint32_t& binId, BaiAlignmentChunkVector& chunks);
-        void WriteBins(const int& refId, BaiBinMap& bins);
+        void WriteBins(const int& refId, BaiBinMap& bins, const BaiReferenceMetadata& metadata);
         void WriteHeader(void);
         void WriteLinearOffsets(const int& refId, BaiLinearOffsetVector& linearOffsets);
+        void WritePseudoBin(const BaiReferenceMetadata& metadata);
         void WriteReferenceEntry(BaiReferenceEntry& refEntry);
+        void WriteUnplacedCount(void);
 
     // data members
     private:
         bool m_isBigEndian;
-        BaiFileSummary m_indexFileSummary;
+        BaiIndexData m_indexData;
+        std::vector<uint32_t> m_candidateBins;
+        uint64_t m_numUnplaced;
+        bool m_hasUnplacedCount;    // older index files do not store number of unplaced reads
 
         // our input buffer
         unsigned int m_bufferLength;
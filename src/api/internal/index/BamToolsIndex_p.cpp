@@ -2,17 +2,17 @@
 // BamToolsIndex.cpp (c) 2010 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 10 November 2011 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Provides index operations for the BamTools index format (".bti")
 // ***************************************************************************
 
-#include "api/BamAlignment.h"
 #include "api/internal/bam/BamReader_p.h"
 #include "api/internal/index/BamToolsIndex_p.h"
 #include "api/internal/io/BamDeviceFactory_p.h"
 #include "api/internal/io/BgzfStream_p.h"
 #include "api/internal/utils/BamException_p.h"
+#include "shared/bamtools_raw_record.h"
 using namespace BamTools;
 using namespace BamTools::Internal;
 
@@ -130,6 +130,135 @@ void BamToolsIndex::CloseFile(void) {
     m_indexFileSummary.clear();
 }
 
+// stores number of alignments on reference that overlap [begin, end) in @count
+// (end < 0 means up to end of reference), returns false if index cannot tell
+//
+// every block but the last on a reference holds exactly m_blockSize alignments, so
+// blocks that lie entirely inside (or outside) the region are counted without reading
+// any alignment data. only blocks straddling a region boundary are actually read.
+bool BamToolsIndex::CountAlignments(const int& referenceID,
+                                    const int& begin,
+                                    const int& end,
+                                    uint64_t& count)
+{
+    if ( referenceID < 0 || referenceID >= (int)m_indexFileSummary.size() )
+        return false;
+
+    try {
+
+        // retrieve reference's blocks
+        BtiReferenceEntry refEntry(referenceID);
+        ReadReferenceEntry(refEntry);
+        const BtiBlockVector& blocks = refEntry.Blocks;
+        const size_t numBlocks = blocks.size();
+
+        count = 0;
+        for ( size_t i = 0; i < numBlocks; ++i ) {
+            const BtiBlock& block = blocks[i];
+            const bool isFullBlock = ( i+1 < numBlocks );
+
+            // blocks are sorted on start position, so none of the rest can overlap region
+            if ( end >= 0 && block.StartPosition >= end )
+                break;
+
+            // all alignments in a full block start between its own & the next block's start position
+            if ( isFullBlock ) {
+                const int32_t nextStartPosition = blocks[i+1].StartPosition;
+
+                // every alignment in block overlaps region
+                if ( block.StartPosition >= begin && (end < 0 || nextStartPosition < end) ) {
+                    count += m_blockSize;
+                    continue;
+                }
+
+                // no alignment in block overlaps region
+                if ( nextStartPosition < begin && block.MaxEndPosition <= begin )
+                    continue;
+            }
+
+            // otherwise, block's alignments have to be checked one by one
+            count += CountBlockAlignments(referenceID, block, ( isFullBlock ? m_blockSize : 0 ), begin, end);
+        }
+        return true;
+
+    } catch ( BamException& e ) {
+        m_errorString = e.what();
+        return false;
+    }
+}
+
+// reads alignments from start of block, returning the number on reference that overlap [begin, end)
+// (stops after @maxAlignments, if not 0, or at first alignment that is not on reference)
+uint64_t BamToolsIndex::CountBlockAlignments(const int& refId,
+                                             const BtiBlock& block,
+                                             const uint32_t& maxAlignments,
+                                             const int& begin,
+                                             const int& end)
+{
+    if ( !m_reader->Seek(block.StartOffset) )
+        throw BamException("BamToolsIndex::CountBlockAlignments", m_reader->GetErrorString());
+
+    uint64_t count = 0;
+    uint32_t numAlignments = 0;
+    string record;
+    while ( (maxAlignments == 0 || numAlignments < maxAlignments) &&
+            m_reader->LoadNextRawAlignmentCore(record) )
+    {
+        const char* data = record.data();
+        if ( RawRecord::RefID(data) != refId )
+            break;
+        ++numAlignments;
+
+        // alignment starts after region, no need to keep reading
+        const int32_t position = RawRecord::Position(data);
+        if ( end >= 0 && position >= end )
+            break;
+
+        if ( position >= begin || RawRecord::EndPosition(data) > begin )
+            ++count;
+    }
+    return count;
+}
+
+// stores number of alignments without a reference position in @count
+//
+// unplaced reads follow the alignments of the last reference with data, so reading
+// starts at that reference's last block
+bool BamToolsIndex::CountUnplacedAlignments(uint64_t& count) {
+
+    try {
+
+        // find last reference with alignments
+        int refId = (int)m_indexFileSummary.size() - 1;
+        while ( refId >= 0 && m_indexFileSummary.at(refId).NumBlocks == 0 )
+            --refId;
+
+        // jump to its last block (or to first alignment, if no reference has any)
+        bool isJumpOk = false;
+        if ( refId >= 0 ) {
+            BtiReferenceEntry refEntry(refId);
+            ReadReferenceEntry(refEntry);
+            isJumpOk = m_reader->Seek(refEntry.Blocks.back().StartOffset);
+        } else
+            isJumpOk = m_reader->Rewind();
+        if ( !isJumpOk )
+            throw BamException("BamToolsIndex::CountUnplacedAlignments", m_reader->GetErrorString());
+
+        // count remaining alignments that have no reference
+        count = 0;
+        string record;
+        while ( m_reader->LoadNextRawAlignmentCore(record) ) {
+            if ( RawRecord::RefID(record.data()) < 0 )
+                ++count;
+        }
+        return true;
+
+    } catch ( BamException& e ) {
+        m_errorString = e.what();
+        return false;
+    }
+}
+
 // builds index from associated BAM file & writes out to index file
 bool BamToolsIndex::Create(void) {
 
@@ -168,58 +297,63 @@ bool BamToolsIndex::Create(void) {
         int32_t blockStartPosition      = -1;
 
         // plow through alignments, storing index entries
-        BamAlignment al;
+        // (only each record's core data, name & CIGAR are read)
+        string record;
         BtiReferenceEntry refEntry;
-        while ( m_reader->LoadNextAlignment(al) ) {
+        while ( m_reader->LoadNextRawAlignmentCore(record) ) {
 
-            // if moved to new reference
-            if ( al.RefID != blockRefId ) {
+            const char* data = record.data();
+            const int32_t refId    = RawRecord::RefID(data);
+            const int32_t position = RawRecord::Position(data);
+            const int32_t alignmentEndPosition = RawRecord::EndPosition(data);
 
-                // if first pass, check:
-                if ( currentBlockCount == 0 ) {
+            // unplaced reads (only found at end of a sorted file) are not indexed
+            if ( refId < 0 )
+                break;
 
-                    // write any empty references up to (but not including) al.RefID
-                    for ( int i = 0; i < al.RefID; ++i )
-                        WriteReferenceEntry( BtiReferenceEntry(i) );
-                }
+            // if moved to new reference
+            if ( refId != blockRefId ) {
 
-                // not first pass:
-                else {
+                // if not first pass, finish previous reference
+                // (its last block may have been filled exactly, & already stored)
+                if ( blockRefId >= 0 ) {
 
-                    // store previous BTI block data in reference entry
-                    const BtiBlock block(blockMaxEndPosition, blockStartOffset, blockStartPosition);
-                    refEntry.Blocks.push_back(block);
+                    // store any partial BTI block data in reference entry
+                    if ( currentBlockCount > 0 ) {
+                        const BtiBlock block(blockMaxEndPosition, blockStartOffset, blockStartPosition);
+                        refEntry.Blocks.push_back(block);
+                    }
 
                     // write reference entry, then clear
                     WriteReferenceEntry(refEntry);
                     ClearReferenceEntry(refEntry);
 
-                    // write any empty references between (but not including)
-                    // the last blockRefID and current al.RefID
-                    for ( int i = blockRefId+1; i < al.RefID; ++i )
-                        WriteReferenceEntry( BtiReferenceEntry(i) );
-
                     // reset block count
                     currentBlockCount = 0;
                 }
 
+                // write any empty references between (but not including)
+                // the last blockRefID and current refId
+                for ( int i = blockRefId+1; i < refId; ++i )
+                    WriteReferenceEntry( BtiReferenceEntry(i) );
+
                 // set ID for new reference entry
-                refEntry.ID = al.RefID;
+                refEntry.ID = refId;
+                blockRefId  = refId;
             }
 
             // if beginning of block, update counters
             if ( currentBlockCount == 0 ) {
-                blockRefId          = al.RefID;
+                blockRefId          = refId;
                 blockStartOffset    = currentAlignmentOffset;
-                blockStartPosition  = al.Position;
-                blockMaxEndPosition = al.GetEndPosition();
+                blockStartPosition  = position;
+                blockMaxEndPosition = alignmentEndPosition;
             }
 
             // increment block counter
             ++currentBlockCount;
 
             // check end position
-            const int32_t alignmentEndPosition = al.GetEndPosition();
             if ( alignmentEndPosition > blockMaxEndPosition )
                 blockMaxEndPosition = alignmentEndPosition;
 
@@ -244,19 +378,21 @@ bool BamToolsIndex::Create(void) {
         // after finishing alignments, if any data was read, check:
         if ( blockRefId >= 0 ) {
 
-            // store last BTI block data in reference entry
-            const BtiBlock block(blockMaxEndPosition, blockStartOffset, blockStartPosition);
-            refEntry.Blocks.push_back(block);
+            // store any partial BTI block data in reference entry
+            if ( currentBlockCount > 0 ) {
+                const BtiBlock block(blockMaxEndPosition, blockStartOffset, blockStartPosition);
+                refEntry.Blocks.push_back(block);
+            }
 
             // write last reference entry, then clear
             WriteReferenceEntry(refEntry);
             ClearReferenceEntry(refEntry);
-
-            // then write any empty references remaining at end of file
-            for ( int i = blockRefId+1; i < numReferences; ++i )
-                WriteReferenceEntry( BtiReferenceEntry(i) );
         }
 
+        // then write any empty references remaining at end of file
+        for ( int i = blockRefId+1; i < numReferences; ++i )
+            WriteReferenceEntry( BtiReferenceEntry(i) );
+
     } catch ( BamException& e ) {
         m_errorString = e.what();
         return false;
@@ -484,7 +620,7 @@ void BamToolsIndex::OpenFile(const std::string& filename, IBamIODevice::OpenMode
     // make sure any previous index file is closed
     CloseFile();
 
-    m_resources.Device = BamDeviceFactory::CreateDevice(filename);
+    m_resources.Device = BamDeviceFactory::CreateDevice(filename, mode);
     if ( m_resources.Device == 0 ) {
         const string message = string("could not open file: ") + filename;
         throw BamException("BamStandardIndex::OpenFile", message);
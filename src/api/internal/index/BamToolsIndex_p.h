@@ -2,7 +2,7 @@
 // BamToolsIndex.h (c) 2010 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 10 November 2011 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Provides index operations for the BamTools index format (".bti")
 // ***************************************************************************
@@ -23,6 +23,7 @@
 #include "api/BamAux.h"
 #include "api/BamIndex.h"
 #include "api/IBamIODevice.h"
+#include "api/internal/index/IBamIndexCounter_p.h"
 #include <map>
 #include <string>
 #include <vector>
@@ -82,7 +83,7 @@ struct BtiReferenceSummary {
 // convenience typedef for describing a full BTI index file summary
 typedef std::vector<BtiReferenceSummary> BtiFileSummary;
 
-class BamToolsIndex : public BamIndex {
+class BamToolsIndex : public BamIndex, public IBamIndexCounter {
 
     // keep a list of any supported versions here
     // (might be useful later to handle any 'legacy' versions if the format changes)
@@ -105,6 +106,14 @@ class BamToolsIndex : public BamIndex {
         BamToolsIndex(Internal::BamReaderPrivate* reader);
         ~BamToolsIndex(void);
 
+    // IBamIndexCounter implementation
+    public:
+        // stores number of alignments on reference that overlap [begin, end) in @count
+        // (only blocks straddling a region boundary are read)
+        bool CountAlignments(const int& referenceID, const int& begin, const int& end, uint64_t& count);
+        // stores number of alignments without a reference position in @count
+        bool CountUnplacedAlignments(uint64_t& count);
+
     // BamIndex implementation
     public:
         // builds index from associated BAM file & writes out to index file
@@ -143,6 +152,11 @@ class BamToolsIndex : public BamIndex {
         void WriteReferenceEntry(const BtiReferenceEntry& refEntry);
 
         // random-access methods
+        uint64_t CountBlockAlignments(const int& refId,
+                                      const BtiBlock& block,
+                                      const uint32_t& maxAlignments,
+                                      const int& begin,
+                                      const int& end);
         void GetOffset(const BamRegion& region, int64_t& offset, bool* hasAlignmentsInRegion);
         void ReadBlock(BtiBlock& block);
         void ReadBlocks(const BtiReferenceSummary& refSummary, BtiBlockVector& blocks);
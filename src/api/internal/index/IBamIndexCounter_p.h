@@ -0,0 +1,51 @@
+// ***************************************************************************
+// IBamIndexCounter_p.h (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides interface for counting alignments from index statistics
+// ***************************************************************************
+
+#ifndef IBAMINDEXCOUNTER_P_H
+#define IBAMINDEXCOUNTER_P_H
+
+//  -------------
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the BamTools API.  It exists purely as an
+// implementation detail. This header file may change from version to version
+// without notice, or even be removed.
+//
+// We mean it.
+
+#include "api/api_global.h"
+
+namespace BamTools {
+namespace Internal {
+
+// implemented alongside BamIndex by the built-in index types (kept out of the public
+// BamIndex class, so that its layout stays compatible with existing clients)
+class IBamIndexCounter {
+
+    // ctor & dtor
+    public:
+        virtual ~IBamIndexCounter(void) { }
+
+    // IBamIndexCounter interface
+    public:
+        // stores number of alignments on reference that overlap [begin, end) in @count
+        // (end < 0 means up to end of reference), using index statistics & decoding as
+        // little alignment data as possible
+        // returns false if the index cannot give an exact count
+        virtual bool CountAlignments(const int& referenceID, const int& begin, const int& end, uint64_t& count) =0;
+        // stores number of alignments without a reference position in @count
+        // returns false if the index cannot give an exact count
+        virtual bool CountUnplacedAlignments(uint64_t& count) =0;
+};
+
+} // namespace Internal
+} // namespace BamTools
+
+#endif // IBAMINDEXCOUNTER_P_H
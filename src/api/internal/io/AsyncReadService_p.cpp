@@ -0,0 +1,405 @@
+// ***************************************************************************
+// AsyncReadService_p.cpp (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides a process-wide service that performs file reads asynchronously,
+// using io_uring where available & a pool of reader threads otherwise
+// ***************************************************************************
+
+#include "api/internal/io/AsyncReadService_p.h"
+using namespace BamTools;
+using namespace BamTools::Internal;
+
+#ifndef _WIN32
+#  include <errno.h>
+#  include <unistd.h>
+#endif
+
+#ifdef HAVE_IO_URING
+#  include <linux/io_uring.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#endif
+
+#include <cstring>
+#include <algorithm>
+using namespace std;
+
+namespace BamTools {
+namespace Internal {
+
+// -----------
+// constants
+// -----------
+
+// reads kept in flight through io_uring (further reads are queued until slots free up)
+static const unsigned int ASYNC_RING_ENTRIES = 256;
+
+// reader threads used if io_uring is not available
+static const unsigned int ASYNC_NUM_THREADS = 8;
+
+// -----------------
+// utility methods
+// -----------------
+
+// reads remainder of @read on calling thread
+static
+void readNow(AsyncRead* read) {
+#ifndef _WIN32
+    while ( read->Result < static_cast<int64_t>(read->Length) ) {
+        const ssize_t numBytesRead = pread(read->FileDescriptor,
+                                           &read->Data[read->Result],
+                                           read->Length - read->Result,
+                                           read->Offset + read->Result);
+        if ( numBytesRead < 0 ) {
+            if ( errno == EINTR )
+                continue;
+            read->Result = -errno;
+            return;
+        }
+        if ( numBytesRead == 0 ) // EOF
+            return;
+        read->Result += numBytesRead;
+    }
+#else
+    read->Result = -1;
+#endif
+}
+
+} // namespace Internal
+} // namespace BamTools
+
+// ---------------------------------
+// AsyncReadService implementation
+// ---------------------------------
+
+AsyncReadService::AsyncReadService(void)
+    : m_isStopping(false)
+    , m_isUsingIoUring(false)
+    , m_ringFd(-1)
+    , m_ringEntries(0)
+    , m_numInFlight(0)
+    , m_sqRing(0)
+    , m_sqRingSize(0)
+    , m_cqRing(0)
+    , m_cqRingSize(0)
+    , m_sqes(0)
+    , m_sqesSize(0)
+    , m_sqTail(0)
+    , m_sqMask(0)
+    , m_sqArray(0)
+    , m_cqHead(0)
+    , m_cqTail(0)
+    , m_cqMask(0)
+    , m_cqes(0)
+{
+    // with io_uring, a single thread reaps completions
+    if ( InitializeRing() ) {
+        Worker* worker = new Worker(this);
+        if ( worker->Start() ) {
+            m_workers.push_back(worker);
+            return;
+        }
+        delete worker;
+        ShutdownRing();
+    }
+
+    // otherwise start reader threads
+    for ( unsigned int i = 0; i < ASYNC_NUM_THREADS; ++i ) {
+        Worker* worker = new Worker(this);
+        if ( !worker->Start() ) {
+            delete worker;
+            break;
+        }
+        m_workers.push_back(worker);
+    }
+}
+
+AsyncReadService::~AsyncReadService(void) {
+
+    // signal workers to quit & wait for them
+    m_mutex.Lock();
+    m_isStopping = true;
+    if ( m_isUsingIoUring )
+        SubmitToRing(0);
+    m_readQueued.WakeAll();
+    m_mutex.Unlock();
+
+    vector<Worker*>::iterator workerIter = m_workers.begin();
+    vector<Worker*>::iterator workerEnd  = m_workers.end();
+    for ( ; workerIter != workerEnd; ++workerIter ) {
+        (*workerIter)->Wait();
+        delete (*workerIter);
+    }
+    m_workers.clear();
+
+    ShutdownRing();
+}
+
+// gives up on a submitted read (deleted now, or by service once complete)
+void AsyncReadService::Abandon(AsyncRead* read) {
+    BamMutexLocker locker(m_mutex);
+    if ( read->IsDone )
+        delete read;
+    else
+        read->IsAbandoned = true;
+}
+
+// hands back finished read (mutex must be held)
+void AsyncReadService::Complete(AsyncRead* read) {
+    if ( read->IsAbandoned )
+        delete read;
+    else {
+        read->IsDone = true;
+        m_readDone.WakeAll();
+    }
+}
+
+// sets up submission & completion rings, returns false if io_uring is not available
+bool AsyncReadService::InitializeRing(void) {
+
+#ifdef HAVE_IO_URING
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    m_ringFd = static_cast<int>( syscall(__NR_io_uring_setup, ASYNC_RING_ENTRIES, &params) );
+    if ( m_ringFd < 0 )
+        return false;
+
+    // map rings (single mapping, if kernel supports it)
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    m_cqRingSize = params.cq_off.cqes  + params.cq_entries * sizeof(struct io_uring_cqe);
+    const bool isSingleMapping = ( (params.features & IORING_FEAT_SINGLE_MMAP) != 0 );
+    if ( isSingleMapping )
+        m_sqRingSize = m_cqRingSize = max(m_sqRingSize, m_cqRingSize);
+
+    m_sqRing = mmap(0, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    m_ringFd, IORING_OFF_SQ_RING);
+    if ( m_sqRing == MAP_FAILED ) {
+        m_sqRing = 0;
+        ShutdownRing();
+        return false;
+    }
+
+    if ( isSingleMapping )
+        m_cqRing = m_sqRing;
+    else {
+        m_cqRing = mmap(0, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        m_ringFd, IORING_OFF_CQ_RING);
+        if ( m_cqRing == MAP_FAILED ) {
+            m_cqRing = 0;
+            ShutdownRing();
+            return false;
+        }
+    }
+
+    m_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    m_sqes = mmap(0, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                  m_ringFd, IORING_OFF_SQES);
+    if ( m_sqes == MAP_FAILED ) {
+        m_sqes = 0;
+        ShutdownRing();
+        return false;
+    }
+
+    char* sqRing = static_cast<char*>(m_sqRing);
+    char* cqRing = static_cast<char*>(m_cqRing);
+    m_sqTail  = reinterpret_cast<unsigned int*>(sqRing + params.sq_off.tail);
+    m_sqMask  = reinterpret_cast<unsigned int*>(sqRing + params.sq_off.ring_mask);
+    m_sqArray = reinterpret_cast<unsigned int*>(sqRing + params.sq_off.array);
+    m_cqHead  = reinterpret_cast<unsigned int*>(cqRing + params.cq_off.head);
+    m_cqTail  = reinterpret_cast<unsigned int*>(cqRing + params.cq_off.tail);
+    m_cqMask  = reinterpret_cast<unsigned int*>(cqRing + params.cq_off.ring_mask);
+    m_cqes    = cqRing + params.cq_off.cqes;
+
+    m_ringEntries = params.sq_entries;
+    m_isUsingIoUring = true;
+    return true;
+
+#else
+    return false;
+#endif // HAVE_IO_URING
+}
+
+// returns the service shared by all asynchronous devices
+AsyncReadService* AsyncReadService::Instance(void) {
+    static AsyncReadService service;
+    return &service;
+}
+
+// returns true if reads are submitted through io_uring
+bool AsyncReadService::IsUsingIoUring(void) const {
+    return m_isUsingIoUring;
+}
+
+// io_uring completion loop - hands back finished reads until stopped
+void AsyncReadService::ReapCompletions(void) {
+
+#ifdef HAVE_IO_URING
+
+    while ( true ) {
+
+        // wait for at least one completion
+        const long result = syscall(__NR_io_uring_enter, m_ringFd, 0, 1, IORING_ENTER_GETEVENTS, 0, 0);
+        if ( result < 0 && errno != EINTR )
+            return;
+
+        BamMutexLocker locker(m_mutex);
+
+        // process completion queue
+        bool isStopRequested = false;
+        unsigned int head = *m_cqHead;
+        const unsigned int tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+        for ( ; head != tail; ++head ) {
+            const struct io_uring_cqe* cqe = static_cast<struct io_uring_cqe*>(m_cqes) + (head & *m_cqMask);
+            AsyncRead* read = reinterpret_cast<AsyncRead*>( static_cast<uintptr_t>(cqe->user_data) );
+            --m_numInFlight;
+
+            // null read marks shutdown
+            if ( read == 0 ) {
+                isStopRequested = true;
+                continue;
+            }
+
+            // finish read, unless it was cut short (then request the rest)
+            if ( cqe->res < 0 )
+                read->Result = cqe->res;
+            else {
+                read->Result += cqe->res;
+                if ( cqe->res > 0 && read->Result < static_cast<int64_t>(read->Length) ) {
+                    m_queued.push_front(read);
+                    continue;
+                }
+            }
+            Complete(read);
+        }
+        __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+
+        // submit reads that were waiting for a free slot
+        while ( !m_queued.empty() && m_numInFlight < m_ringEntries ) {
+            AsyncRead* read = m_queued.front();
+            m_queued.pop_front();
+            SubmitToRing(read);
+        }
+
+        if ( isStopRequested )
+            return;
+    }
+
+#endif // HAVE_IO_URING
+}
+
+// worker thread loop - reaps io_uring completions, or performs queued reads until stopped
+void AsyncReadService::RunWorker(void) {
+
+    if ( m_isUsingIoUring ) {
+        ReapCompletions();
+        return;
+    }
+
+    while ( true ) {
+
+        // wait for read
+        m_mutex.Lock();
+        while ( m_queued.empty() && !m_isStopping )
+            m_readQueued.Wait(m_mutex);
+        if ( m_queued.empty() ) {
+            m_mutex.Unlock();
+            return;
+        }
+        AsyncRead* read = m_queued.front();
+        m_queued.pop_front();
+        m_mutex.Unlock();
+
+        // read outside of lock (read is not touched by submitter until marked done)
+        readNow(read);
+
+        // hand back result
+        m_mutex.Lock();
+        Complete(read);
+        m_mutex.Unlock();
+    }
+}
+
+// releases io_uring resources
+void AsyncReadService::ShutdownRing(void) {
+
+#ifdef HAVE_IO_URING
+    if ( m_sqes )
+        munmap(m_sqes, m_sqesSize);
+    if ( m_cqRing && m_cqRing != m_sqRing )
+        munmap(m_cqRing, m_cqRingSize);
+    if ( m_sqRing )
+        munmap(m_sqRing, m_sqRingSize);
+    if ( m_ringFd >= 0 )
+        close(m_ringFd);
+#endif // HAVE_IO_URING
+
+    m_sqes = 0;
+    m_cqRing = 0;
+    m_sqRing = 0;
+    m_ringFd = -1;
+    m_isUsingIoUring = false;
+}
+
+// starts a read, returns immediately
+void AsyncReadService::Submit(AsyncRead* read) {
+
+    // no workers could be started, read on the calling thread
+    if ( m_workers.empty() ) {
+        readNow(read);
+        read->IsDone = true;
+        return;
+    }
+
+    BamMutexLocker locker(m_mutex);
+    if ( m_isUsingIoUring && m_numInFlight < m_ringEntries )
+        SubmitToRing(read);
+    else {
+        m_queued.push_back(read);
+        m_readQueued.WakeOne();
+    }
+}
+
+// queues (remainder of) @read on submission ring & submits it, a null read wakes up
+// the completion loop to stop it (mutex must be held)
+void AsyncReadService::SubmitToRing(AsyncRead* read) {
+
+#ifdef HAVE_IO_URING
+
+    const unsigned int tail  = *m_sqTail;
+    const unsigned int index = tail & *m_sqMask;
+    struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(m_sqes) + index;
+    memset(sqe, 0, sizeof(*sqe));
+
+    if ( read == 0 )
+        sqe->opcode = IORING_OP_NOP;
+    else {
+        read->IoVector.iov_base = &read->Data[read->Result];
+        read->IoVector.iov_len  = read->Length - read->Result;
+        sqe->opcode    = IORING_OP_READV;
+        sqe->fd        = read->FileDescriptor;
+        sqe->off       = read->Offset + read->Result;
+        sqe->addr      = reinterpret_cast<uintptr_t>(&read->IoVector);
+        sqe->len       = 1;
+        sqe->user_data = reinterpret_cast<uintptr_t>(read);
+    }
+
+    m_sqArray[index] = index;
+    __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+    ++m_numInFlight;
+    syscall(__NR_io_uring_enter, m_ringFd, 1, 0, 0, 0, 0);
+
+#else
+    (void)read;
+#endif // HAVE_IO_URING
+}
+
+// blocks until read has completed
+void AsyncReadService::Wait(AsyncRead* read) {
+    BamMutexLocker locker(m_mutex);
+    while ( !read->IsDone )
+        m_readDone.Wait(m_mutex);
+}
@@ -0,0 +1,140 @@
+// ***************************************************************************
+// AsyncReadService_p.h (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides a process-wide service that performs file reads asynchronously,
+// using io_uring where available & a pool of reader threads otherwise
+// ***************************************************************************
+
+#ifndef ASYNCREADSERVICE_P_H
+#define ASYNCREADSERVICE_P_H
+
+//  -------------
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the BamTools API.  It exists purely as an
+// implementation detail. This header file may change from version to version
+// without notice, or even be removed.
+//
+// We mean it.
+
+#include "api/api_global.h"
+#include "shared/bamtools_thread.h"
+#include <deque>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_IO_URING
+#  include <sys/uio.h>
+#endif
+
+namespace BamTools {
+namespace Internal {
+
+// a single read of [Offset, Offset+Length) from a file descriptor
+struct AsyncRead {
+
+    // data members
+    int FileDescriptor;
+    int64_t Offset;
+    size_t Length;
+    std::string Data;
+    int64_t Result;         // bytes read (may be short at EOF), or -errno
+    bool IsDone;
+    bool IsAbandoned;       // submitter lost interest, service deletes it once complete
+#ifdef HAVE_IO_URING
+    struct iovec IoVector;
+#endif
+
+    // ctor
+    AsyncRead(const int fd, const int64_t& offset, const size_t length)
+        : FileDescriptor(fd)
+        , Offset(offset)
+        , Length(length)
+        , Data(length, '\0')
+        , Result(0)
+        , IsDone(false)
+        , IsAbandoned(false)
+    { }
+};
+
+class AsyncReadService {
+
+    // ctor & dtor
+    private:
+        AsyncReadService(void);
+    public:
+        ~AsyncReadService(void);
+
+    // AsyncReadService interface
+    public:
+        // returns the service shared by all asynchronous devices
+        static AsyncReadService* Instance(void);
+    public:
+        // gives up on a submitted read (deleted now, or by service once complete)
+        void Abandon(AsyncRead* read);
+        // returns true if reads are submitted through io_uring
+        bool IsUsingIoUring(void) const;
+        // starts a read, returns immediately
+        void Submit(AsyncRead* read);
+        // blocks until read has completed
+        void Wait(AsyncRead* read);
+
+    // internal types
+    private:
+        class Worker : public BamThread {
+            public:
+                explicit Worker(AsyncReadService* service) : m_service(service) { }
+            protected:
+                void Run(void) { m_service->RunWorker(); }
+            private:
+                AsyncReadService* m_service;
+        };
+
+    // internal methods
+    private:
+        void Complete(AsyncRead* read);
+        void RunWorker(void);
+        // io_uring backend
+        bool InitializeRing(void);
+        void ReapCompletions(void);
+        void ShutdownRing(void);
+        void SubmitToRing(AsyncRead* read);
+
+    // data members
+    private:
+        bool m_isStopping;
+        std::vector<Worker*> m_workers;
+        std::deque<AsyncRead*> m_queued;    // reads waiting for a worker (or a free ring slot)
+
+        BamMutex m_mutex;
+        BamWaitCondition m_readQueued;
+        BamWaitCondition m_readDone;
+
+        // io_uring state (only used if ring could be set up)
+        bool m_isUsingIoUring;
+        int m_ringFd;
+        unsigned int m_ringEntries;
+        unsigned int m_numInFlight;
+        void* m_sqRing;
+        size_t m_sqRingSize;
+        void* m_cqRing;
+        size_t m_cqRingSize;
+        void* m_sqes;
+        size_t m_sqesSize;
+        unsigned int* m_sqTail;
+        unsigned int* m_sqMask;
+        unsigned int* m_sqArray;
+        unsigned int* m_cqHead;
+        unsigned int* m_cqTail;
+        unsigned int* m_cqMask;
+        void* m_cqes;
+};
+
+} // namespace Internal
+} // namespace BamTools
+
+#endif // ASYNCREADSERVICE_P_H
@@ -0,0 +1,236 @@
+// ***************************************************************************
+// BamAsyncFile_p.cpp (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides read-only access to local files, keeping several reads ahead of the
+// current position in flight asynchronously
+// ***************************************************************************
+
+#include "api/BamAux.h"
+#include "api/internal/io/AsyncReadService_p.h"
+#include "api/internal/io/BamAsyncFile_p.h"
+using namespace BamTools;
+using namespace BamTools::Internal;
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#include <cstring>
+#include <algorithm>
+using namespace std;
+
+namespace BamTools {
+namespace Internal {
+
+// -----------
+// constants
+// -----------
+
+// file is read in pieces of this size; after a seek a single piece is in flight, doubling
+// (up to max) each time one is used up
+static const size_t ASYNC_READ_SIZE       = 0x40000; // 256 KB
+static const size_t ASYNC_MAX_READ_AHEAD  = 16;
+
+} // namespace Internal
+} // namespace BamTools
+
+// -----------------------------
+// BamAsyncFile implementation
+// -----------------------------
+
+BamAsyncFile::BamAsyncFile(const string& filename)
+    : IBamIODevice()
+    , m_filename(filename)
+    , m_fd(-1)
+    , m_fileSize(0)
+    , m_position(0)
+    , m_readsEnd(0)
+    , m_readAheadDepth(1)
+{ }
+
+BamAsyncFile::~BamAsyncFile(void) {
+    Close();
+}
+
+// abandons all reads in flight
+void BamAsyncFile::ClearReads(void) {
+    deque<AsyncRead*>::iterator readIter = m_reads.begin();
+    deque<AsyncRead*>::iterator readEnd  = m_reads.end();
+    for ( ; readIter != readEnd; ++readIter )
+        AsyncReadService::Instance()->Abandon(*readIter);
+    m_reads.clear();
+}
+
+void BamAsyncFile::Close(void) {
+
+    // reads may still be in progress, so hand them to service before closing descriptor
+    // (any that start afterwards simply fail)
+    ClearReads();
+#ifndef _WIN32
+    if ( m_fd >= 0 )
+        close(m_fd);
+#endif
+    m_fd = -1;
+    m_fileSize = 0;
+    m_position = 0;
+    m_readsEnd = 0;
+    m_readAheadDepth = 1;
+    m_mode = IBamIODevice::NotOpen;
+}
+
+bool BamAsyncFile::IsRandomAccess(void) const {
+    return true;
+}
+
+// returns true if asynchronous reads can be used for @filename & @mode
+bool BamAsyncFile::IsSupported(const string& filename, const IBamIODevice::OpenMode mode) {
+#ifndef _WIN32
+    struct stat fileStats;
+    return ( mode == IBamIODevice::ReadOnly &&
+             stat(filename.c_str(), &fileStats) == 0 &&
+             S_ISREG(fileStats.st_mode) );
+#else
+    (void)filename;
+    (void)mode;
+    return false;
+#endif
+}
+
+bool BamAsyncFile::Open(const IBamIODevice::OpenMode mode) {
+
+    // make sure we're starting with a fresh file
+    Close();
+
+    // asynchronous files are read-only
+    if ( mode != IBamIODevice::ReadOnly ) {
+        SetErrorString("BamAsyncFile::Open", "writing on this device is not supported");
+        return false;
+    }
+
+#ifndef _WIN32
+
+    // open file & get its size
+    m_fd = open(m_filename.c_str(), O_RDONLY);
+    struct stat fileStats;
+    if ( m_fd < 0 || fstat(m_fd, &fileStats) != 0 ) {
+        Close();
+        const string message_base = string("could not open file handle for ");
+        const string message = message_base + ( (m_filename.empty()) ? "empty filename" : m_filename );
+        SetErrorString("BamAsyncFile::Open", message);
+        return false;
+    }
+    m_fileSize = static_cast<int64_t>(fileStats.st_size);
+
+    // store current IO mode & return success
+    m_mode = mode;
+    return true;
+
+#else
+    SetErrorString("BamAsyncFile::Open", "asynchronous reads are not supported on this platform");
+    return false;
+#endif // _WIN32
+}
+
+int64_t BamAsyncFile::Read(char* data, const unsigned int numBytes) {
+
+    if ( !IsOpen() )
+        return -1;
+
+    // copy from reads in flight, in order, until hit desired @numBytes (or EOF)
+    AsyncReadService* service = AsyncReadService::Instance();
+    int64_t bytesReadSoFar = 0;
+    while ( bytesReadSoFar < numBytes && m_position < m_fileSize ) {
+
+        // make sure data is on its way
+        SubmitReads();
+        AsyncRead* read = m_reads.front();
+        service->Wait(read);
+        if ( read->Result < 0 ) {
+            SetErrorString("BamAsyncFile::Read", strerror( static_cast<int>(-read->Result) ));
+            return -1;
+        }
+
+        // copy data
+        const int64_t readOffset = m_position - read->Offset;
+        const int64_t available  = read->Result - readOffset;
+        if ( available <= 0 ) // file shrunk?
+            break;
+        const int64_t numBytesCopied = min(available, static_cast<int64_t>(numBytes) - bytesReadSoFar);
+        memcpy(data + bytesReadSoFar, &read->Data[readOffset], numBytesCopied);
+        bytesReadSoFar += numBytesCopied;
+        m_position += numBytesCopied;
+
+        // when read is used up, discard it & keep more in flight
+        if ( m_position >= read->Offset + static_cast<int64_t>(read->Length) ) {
+            m_reads.pop_front();
+            delete read;
+            m_readAheadDepth = min(m_readAheadDepth * 2, ASYNC_MAX_READ_AHEAD);
+        }
+    }
+
+    // return actual number bytes successfully read
+    return bytesReadSoFar;
+}
+
+bool BamAsyncFile::Seek(const int64_t& position, const int origin) {
+
+    // determine target position
+    int64_t targetPosition = 0;
+    if ( origin == SEEK_SET )
+        targetPosition = position;
+    else if ( origin == SEEK_CUR )
+        targetPosition = m_position + position;
+    else if ( origin == SEEK_END )
+        targetPosition = m_fileSize + position;
+    else
+        return false;
+    if ( !IsOpen() || targetPosition < 0 )
+        return false;
+
+    // if target is within reads in flight, just drop the ones before it
+    if ( !m_reads.empty() && targetPosition >= m_reads.front()->Offset && targetPosition < m_readsEnd ) {
+        while ( targetPosition >= m_reads.front()->Offset + static_cast<int64_t>(m_reads.front()->Length) ) {
+            AsyncReadService::Instance()->Abandon(m_reads.front());
+            m_reads.pop_front();
+        }
+    }
+
+    // otherwise start over at target
+    else {
+        ClearReads();
+        m_readsEnd = targetPosition;
+        m_readAheadDepth = 1;
+    }
+
+    m_position = targetPosition;
+    return true;
+}
+
+// submits reads following the current ones, up to read-ahead depth
+void BamAsyncFile::SubmitReads(void) {
+    AsyncReadService* service = AsyncReadService::Instance();
+    while ( m_reads.size() < m_readAheadDepth && m_readsEnd < m_fileSize ) {
+        const size_t length = static_cast<size_t>( min(static_cast<int64_t>(ASYNC_READ_SIZE), m_fileSize - m_readsEnd) );
+        AsyncRead* read = new AsyncRead(m_fd, m_readsEnd, length);
+        service->Submit(read);
+        m_reads.push_back(read);
+        m_readsEnd += length;
+    }
+}
+
+int64_t BamAsyncFile::Tell(void) const {
+    return ( IsOpen() ? m_position : -1 );
+}
+
+int64_t BamAsyncFile::Write(const char* data, const unsigned int numBytes) {
+    (void)data;
+    (void)numBytes;
+    BT_ASSERT_X(false, "BamAsyncFile::Write : write-mode not supported on this device");
+    SetErrorString("BamAsyncFile::Write", "write-mode not supported on this device");
+    return -1;
+}
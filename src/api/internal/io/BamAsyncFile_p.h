@@ -0,0 +1,76 @@
+// ***************************************************************************
+// BamAsyncFile_p.h (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides read-only access to local files, keeping several reads ahead of the
+// current position in flight asynchronously
+// ***************************************************************************
+
+#ifndef BAMASYNCFILE_P_H
+#define BAMASYNCFILE_P_H
+
+//  -------------
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the BamTools API.  It exists purely as an
+// implementation detail. This header file may change from version to version
+// without notice, or even be removed.
+//
+// We mean it.
+
+#include "api/IBamIODevice.h"
+#include <deque>
+#include <string>
+
+namespace BamTools {
+namespace Internal {
+
+struct AsyncRead;
+
+class BamAsyncFile : public IBamIODevice {
+
+    // ctor & dtor
+    public:
+        BamAsyncFile(const std::string& filename);
+        ~BamAsyncFile(void);
+
+    // IBamIODevice implementation
+    public:
+        void Close(void);
+        bool IsRandomAccess(void) const;
+        bool Open(const IBamIODevice::OpenMode mode);
+        int64_t Read(char* data, const unsigned int numBytes);
+        bool Seek(const int64_t& position, const int origin = SEEK_SET);
+        int64_t Tell(void) const;
+        int64_t Write(const char* data, const unsigned int numBytes);
+
+    // BamAsyncFile interface
+    public:
+        // returns true if asynchronous reads can be used for @filename & @mode
+        static bool IsSupported(const std::string& filename, const IBamIODevice::OpenMode mode);
+
+    // internal methods
+    private:
+        // abandons all reads in flight
+        void ClearReads(void);
+        // submits reads following the current ones, up to read-ahead depth
+        void SubmitReads(void);
+
+    // data members
+    private:
+        std::string m_filename;
+        int m_fd;
+        int64_t m_fileSize;
+        int64_t m_position;
+        std::deque<AsyncRead*> m_reads;     // reads in flight, contiguous & in file order
+        int64_t m_readsEnd;                 // end of last read submitted
+        size_t m_readAheadDepth;            // number of reads kept in flight
+};
+
+} // namespace Internal
+} // namespace BamTools
+
+#endif // BAMASYNCFILE_P_H
@@ -7,10 +7,12 @@
 // Creates built-in concrete implementations of IBamIODevices
 // ***************************************************************************
 
+#include "api/internal/io/BamAsyncFile_p.h"
 #include "api/internal/io/BamDeviceFactory_p.h"
 #include "api/internal/io/BamFile_p.h"
 #include "api/internal/io/BamFtp_p.h"
 #include "api/internal/io/BamHttp_p.h"
+#include "api/internal/io/BamMappedFile_p.h"
 #include "api/internal/io/BamPipe_p.h"
 using namespace BamTools;
 using namespace BamTools::Internal;
@@ -18,7 +20,10 @@ using namespace BamTools::Internal;
 #include <iostream>
 using namespace std;
 
-IBamIODevice* BamDeviceFactory::CreateDevice(const string& source) {
+IBamIODevice* BamDeviceFactory::CreateDevice(const string& source,
+                                             const IBamIODevice::OpenMode mode,
+                                             const bool isAsyncIO)
+{
 
     // check for requested pipe
     if ( source == "-" || source == "stdin" || source == "stdout" )
@@ -32,6 +37,14 @@ IBamIODevice* BamDeviceFactory::CreateDevice(const string& source) {
     if ( source.find("ftp://") == 0 )
         return new BamFtp(source);
 
+    // read regular files asynchronously, if requested
+    if ( isAsyncIO && BamAsyncFile::IsSupported(source, mode) )
+        return new BamAsyncFile(source);
+
+    // map regular files that are only read from
+    if ( BamMappedFile::IsSupported(source, mode) )
+        return new BamMappedFile(source);
+
     // otherwise assume a "normal" file
     return new BamFile(source);
 }
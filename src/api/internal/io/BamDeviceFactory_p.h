@@ -28,7 +28,9 @@ namespace Internal {
 
 class BamDeviceFactory {
     public:
-        static IBamIODevice* CreateDevice(const std::string& source);
+        static IBamIODevice* CreateDevice(const std::string& source,
+                                          const IBamIODevice::OpenMode mode,
+                                          const bool isAsyncIO = false);
 };
 
 } // namespace Internal
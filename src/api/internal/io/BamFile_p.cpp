@@ -2,15 +2,17 @@
 // BamFile_p.cpp (c) 2011 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 10 November 2011 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Provides BAM file-specific IO behavior
 // ***************************************************************************
 
+#include "api/BamConstants.h"
 #include "api/internal/io/BamFile_p.h"
 using namespace BamTools;
 using namespace BamTools::Internal;
 
+#include <cerrno>
 #include <cstdio>
 #include <iostream>
 using namespace std;
@@ -45,6 +47,13 @@ bool BamFile::Open(const IBamIODevice::OpenMode mode) {
         m_stream = fopen(m_filename.c_str(), "wb");
     else if ( mode == IBamIODevice::ReadWrite )
         m_stream = fopen(m_filename.c_str(), "w+b");
+    else if ( mode == (IBamIODevice::WriteOnly | IBamIODevice::Append) ) {
+        m_stream = fopen(m_filename.c_str(), "r+b");
+        if ( m_stream != 0 )
+            SeekToAppendPosition();
+        else if ( errno == ENOENT )
+            m_stream = fopen(m_filename.c_str(), "wb");
+    }
     else {
         SetErrorString("BamFile::Open", "unknown open mode requested");
         return false;
@@ -59,7 +68,8 @@ bool BamFile::Open(const IBamIODevice::OpenMode mode) {
     }
 
     // store current IO mode & return success
-    m_mode = mode;
+    // (once positioned, appending is no different from writing)
+    m_mode = ( (mode & IBamIODevice::Append) ? IBamIODevice::WriteOnly : mode );
     return true;
 }
 
@@ -67,3 +77,34 @@ bool BamFile::Seek(const int64_t& position, const int origin) {
     BT_ASSERT_X( m_stream, "BamFile::Seek() - null stream" );
     return ( fseek64(m_stream, position, origin) == 0 );
 }
+
+// moves to end of file, or onto its trailing EOF marker block (so it gets overwritten)
+void BamFile::SeekToAppendPosition(void) {
+
+    // an EOF marker is an empty BGZF block: 28 bytes, with BSIZE 27 & ISIZE 0
+    static const int64_t EOF_MARKER_LENGTH = 28;
+
+    fseek64(m_stream, 0, SEEK_END);
+    const int64_t fileSize = ftell64(m_stream);
+    if ( fileSize >= EOF_MARKER_LENGTH ) {
+        char buffer[EOF_MARKER_LENGTH];
+        fseek64(m_stream, fileSize - EOF_MARKER_LENGTH, SEEK_SET);
+        if ( fread(buffer, 1, EOF_MARKER_LENGTH, m_stream) == (size_t)EOF_MARKER_LENGTH ) {
+            const unsigned char* block = reinterpret_cast<const unsigned char*>(buffer);
+            const bool isEofMarker = ( block[0]  == (unsigned char)Constants::GZIP_ID1 &&
+                                       block[1]  == (unsigned char)Constants::GZIP_ID2 &&
+                                       block[2]  == (unsigned char)Constants::CM_DEFLATE &&
+                                       (block[3] & Constants::FLG_FEXTRA) != 0 &&
+                                       block[12] == (unsigned char)Constants::BGZF_ID1 &&
+                                       block[13] == (unsigned char)Constants::BGZF_ID2 &&
+                                       block[16] == EOF_MARKER_LENGTH - 1 && block[17] == 0 &&  // BSIZE
+                                       block[24] == 0 && block[25] == 0 &&                       // ISIZE
+                                       block[26] == 0 && block[27] == 0 );
+            if ( isEofMarker ) {
+                fseek64(m_stream, fileSize - EOF_MARKER_LENGTH, SEEK_SET);
+                return;
+            }
+        }
+    }
+    fseek64(m_stream, 0, SEEK_END);
+}
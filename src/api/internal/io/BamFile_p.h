@@ -2,7 +2,7 @@
 // BamFile_p.h (c) 2011 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 10 November 2011 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Provides BAM file-specific IO behavior
 // ***************************************************************************
@@ -40,6 +40,11 @@ class BamFile : public ILocalIODevice {
         bool Open(const IBamIODevice::OpenMode mode);
         bool Seek(const int64_t& position, const int origin = SEEK_SET);
 
+    // internal methods
+    private:
+        // moves to end of file, or onto its trailing EOF marker block (so it gets overwritten)
+        void SeekToAppendPosition(void);
+
     // data members
     private:
         std::string m_filename;
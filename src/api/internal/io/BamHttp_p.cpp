@@ -10,12 +10,14 @@
 #include "api/BamAux.h"
 #include "api/internal/io/BamHttp_p.h"
 #include "api/internal/io/HttpHeader_p.h"
+#include "api/internal/io/HttpRangeFetcher_p.h"
 #include "api/internal/io/TcpSocket_p.h"
 using namespace BamTools;
 using namespace BamTools::Internal;
 
 #include <cassert>
 #include <cctype>
+#include <cstdlib>
 #include <algorithm>
 #include <sstream>
 using namespace std;
@@ -38,8 +40,27 @@ static const string HOST_HEADER  = "Host";
 static const string RANGE_HEADER = "Range";
 static const string BYTES_PREFIX = "bytes=";
 
+static const string CONNECTION_HEADER     = "Connection";
+static const string CONTENT_LENGTH_HEADER = "Content-Length";
+static const string CONTENT_RANGE_HEADER  = "Content-Range";
+static const string CLOSE_VALUE           = "close";
+static const string KEEP_ALIVE_VALUE      = "keep-alive";
+
 static const char HOST_SEPARATOR  = '/';
 static const char PROXY_SEPARATOR = ':';
+static const char RANGE_SEPARATOR = '/';
+
+// read-ahead: each range request asks for at least this much data, starting small
+// after a seek & doubling (up to max) for as long as reads stay sequential
+static const size_t HTTP_MIN_READ_AHEAD = 0x20000;   // 128 KB
+static const size_t HTTP_MAX_READ_AHEAD = 0x800000;  //   8 MB
+
+static const size_t HTTP_BUFFER_GROWTH = 0x10000;
+
+// once sequential reads have grown read-ahead this far, further ranges are downloaded
+// concurrently over this many extra connections
+static const size_t       HTTP_PREFETCH_MIN_READ_AHEAD = 0x100000; // 1 MB
+static const unsigned int HTTP_PREFETCH_CONNECTIONS    = 4;
 
 // -----------------
 // utility methods
@@ -47,19 +68,28 @@ static const char PROXY_SEPARATOR = ':';
 
 static inline
 bool endsWith(const string& source, const string& pattern) {
-    return ( source.find(pattern) == (source.length() - pattern.length()) );
+    if ( source.length() < pattern.length() )
+        return false;
+    return ( source.compare(source.length() - pattern.length(), pattern.length(), pattern) == 0 );
 }
 
 static inline
 string toLower(const string& s) {
-    string out;
+    string out(s);
     const size_t sSize = s.size();
-    out.reserve(sSize);
     for ( size_t i = 0; i < sSize; ++i )
         out[i] = tolower(s[i]);
     return out;
 }
 
+// header field names are case-insensitive, check the usual spellings
+static inline
+string fieldValue(HttpResponseHeader* response, const string& key) {
+    if ( response->ContainsKey(key) )
+        return response->GetValue(key);
+    return response->GetValue( toLower(key) );
+}
+
 } // namespace Internal
 } // namespace BamTools
 
@@ -74,8 +104,13 @@ BamHttp::BamHttp(const string& url)
     , m_request(0)
     , m_response(0)
     , m_isUrlParsed(false)
+    , m_isStreaming(false)
     , m_filePosition(-1)
     , m_endRangeFilePosition(-1)
+    , m_fileSize(-1)
+    , m_buffer(HTTP_BUFFER_GROWTH)
+    , m_readAheadSize(HTTP_MIN_READ_AHEAD)
+    , m_fetcher(0)
 {
     ParseUrl(url);
 }
@@ -90,8 +125,12 @@ BamHttp::~BamHttp(void) {
 
 void BamHttp::Close(void) {
 
-    // disconnect socket
+    // disconnect socket(s)
     m_socket->DisconnectFromHost();
+    if ( m_fetcher ) {
+        delete m_fetcher;
+        m_fetcher = 0;
+    }
 
     // clean up request & response
     if ( m_request )  {
@@ -105,8 +144,12 @@ void BamHttp::Close(void) {
 
     // reset state - necessary??
     m_isUrlParsed = false;
+    m_isStreaming = false;
     m_filePosition = -1;
     m_endRangeFilePosition = -1;
+    m_fileSize = -1;
+    m_buffer.Clear();
+    m_readAheadSize = HTTP_MIN_READ_AHEAD;
 }
 
 bool BamHttp::ConnectSocket(void) {
@@ -119,22 +162,6 @@ bool BamHttp::ConnectSocket(void) {
         return false;
     }
 
-    // attempt initial request
-    m_filePosition = 0;
-    m_endRangeFilePosition = -1;
-    if ( !SendRequest() ) {
-        // TODO: set error string
-        Close();
-        return false;
-    }
-
-    // wait for response from server
-    if ( !ReceiveResponse() ) {
-        // TODO: set error string
-        Close();
-        return false;
-    }
-
     // return success
     return true;
 }
@@ -145,6 +172,74 @@ bool BamHttp::EnsureSocketConnection(void) {
     else return ConnectSocket();
 }
 
+// requests the range of data starting at the current file position, sized at least
+// @numBytes (usually more, see read-ahead), & stages it in our buffer
+bool BamHttp::FetchRange(const size_t numBytes) {
+
+    // grow read-ahead while reads pick up where the last range ended, start over otherwise
+    const bool isSequential = ( m_filePosition == m_endRangeFilePosition );
+    if ( isSequential )
+        m_readAheadSize = std::min(m_readAheadSize * 2, HTTP_MAX_READ_AHEAD);
+    else
+        m_readAheadSize = HTTP_MIN_READ_AHEAD;
+
+    // if next range was already requested on another connection, use that
+    if ( m_fetcher && m_fetcher->NumPending() > 0 ) {
+        if ( m_fetcher->PendingStart() == m_filePosition && m_fetcher->TakeNext(m_buffer) ) {
+            m_endRangeFilePosition = m_filePosition + m_buffer.Size();
+            FetchRangesAhead();
+            return true;
+        }
+        m_fetcher->Clear();
+    }
+
+    // don't ask for data past end of file (if known)
+    size_t rangeLength = std::max(numBytes, m_readAheadSize);
+    if ( m_fileSize >= 0 ) {
+        if ( m_filePosition >= m_fileSize ) {
+            m_endRangeFilePosition = m_filePosition;
+            return true;
+        }
+        rangeLength = static_cast<size_t>( std::min(static_cast<int64_t>(rangeLength),
+                                                    m_fileSize - m_filePosition) );
+    }
+
+    // send request on our (kept-alive) connection
+    // if that fails, the server may have dropped the connection while idle, so retry once on a new one
+    if ( !(SendRequest(rangeLength) && ReceiveResponse()) ) {
+        m_socket->DisconnectFromHost();
+        if ( !(SendRequest(rangeLength) && ReceiveResponse()) )
+            return false;
+    }
+
+    // keep other connections busy with the ranges that follow
+    if ( isSequential )
+        FetchRangesAhead();
+    return true;
+}
+
+// during sequential reads, requests the ranges following m_endRangeFilePosition on
+// extra connections, so they download while the current one is being consumed
+void BamHttp::FetchRangesAhead(void) {
+
+    // only once reads look like a long sequential scan of a file with known size
+    if ( m_isStreaming || m_fileSize < 0 || m_readAheadSize < HTTP_PREFETCH_MIN_READ_AHEAD )
+        return;
+
+    // start up connections on first use
+    if ( m_fetcher == 0 )
+        m_fetcher = new HttpRangeFetcher(m_hostname, m_port, m_filename, HTTP_PREFETCH_CONNECTIONS);
+
+    // keep one range in flight per connection
+    int64_t position = ( m_fetcher->NumPending() > 0 ? m_fetcher->PendingEnd() : m_endRangeFilePosition );
+    while ( m_fetcher->NumPending() < m_fetcher->NumConnections() && position < m_fileSize ) {
+        const size_t rangeLength = static_cast<size_t>( std::min(static_cast<int64_t>(m_readAheadSize),
+                                                                 m_fileSize - position) );
+        m_fetcher->Fetch(position, rangeLength);
+        position += rangeLength;
+    }
+}
+
 bool BamHttp::IsOpen(void) const {
     return IBamIODevice::IsOpen() && m_isUrlParsed;
 }
@@ -168,6 +263,15 @@ bool BamHttp::Open(const IBamIODevice::OpenMode mode) {
         return false;
     }
 
+    // fetch initial range (also checks that the file is actually available)
+    m_filePosition = 0;
+    m_endRangeFilePosition = -1;
+    if ( !FetchRange(0) ) {
+        SetErrorString("BamHttp::Open", "could not retrieve data from server");
+        Close();
+        return false;
+    }
+
     // return success
     return true;
 }
@@ -178,30 +282,31 @@ void BamHttp::ParseUrl(const string& url) {
     m_isUrlParsed = false;
 
     // make sure url starts with "http://", case-insensitive
-    string tempUrl(url);
-    toLower(tempUrl);
+    const string tempUrl = toLower(url);
     const size_t prefixFound = tempUrl.find(HTTP_PREFIX);
-    if ( prefixFound == string::npos )
+    if ( prefixFound != 0 )
         return;
 
     // find end of host name portion (first '/' hit after the prefix)
     const size_t firstSlashFound = tempUrl.find(HOST_SEPARATOR, HTTP_PREFIX_LENGTH);
-    if ( firstSlashFound == string::npos ) {
-        ;  // no slash found... no filename given along with host?
-    }
+    if ( firstSlashFound == string::npos )
+        return;  // no filename given along with host
 
-    // fetch hostname (check for proxy port)
-    string hostname = tempUrl.substr(HTTP_PREFIX_LENGTH, (firstSlashFound - HTTP_PREFIX_LENGTH));
+    // fetch hostname (check for port)
+    const string hostname = tempUrl.substr(HTTP_PREFIX_LENGTH, (firstSlashFound - HTTP_PREFIX_LENGTH));
     const size_t colonFound = hostname.find(PROXY_SEPARATOR);
     if ( colonFound != string::npos ) {
-        ; // TODO: handle proxy port (later, just skip for now)
+        m_hostname = hostname.substr(0, colonFound);
+        m_port = hostname.substr(colonFound+1);
+        if ( m_hostname.empty() || m_port.empty() )
+            return;
     } else {
         m_hostname = hostname;
         m_port = HTTP_PORT;
     }
 
-    // store remainder of URL as filename (must be non-empty)
-    string filename = tempUrl.substr(firstSlashFound);
+    // store remainder of URL as filename (case preserved, must be non-empty)
+    const string filename = url.substr(firstSlashFound);
     if ( filename.empty() )
         return;
     m_filename = filename;
@@ -225,7 +330,7 @@ int64_t BamHttp::Read(char* data, const unsigned int numBytes) {
 
         // if socket has access to entire file contents
         // i.e. we received response with full data (status code == 200)
-        if ( m_endRangeFilePosition < 0 ) {
+        if ( m_isStreaming ) {
 
             // try to read 'remainingBytes' from socket
             const int64_t socketBytesRead = ReadFromSocket(data+bytesReadSoFar, remainingBytes);
@@ -237,36 +342,25 @@ int64_t BamHttp::Read(char* data, const unsigned int numBytes) {
             m_filePosition += socketBytesRead;
         }
 
-        // socket has access to a range of data (might already be in buffer)
-        // i.e. we received response with partial data (status code == 206)
+        // otherwise copy from staged range data
+        else if ( !m_buffer.IsEmpty() ) {
+            const size_t bufferBytesRead = m_buffer.Read(data+bytesReadSoFar, remainingBytes);
+            bytesReadSoFar += bufferBytesRead;
+            m_filePosition += bufferBytesRead;
+        }
+
+        // this is a 1st-time read or we already used everything from the last request
         else {
 
-            // there is data left from last request
-            if ( m_endRangeFilePosition > m_filePosition ) {
-
-                // try to read either the total 'remainingBytes' or
-                // whatever we have remaining from last request range
-                const size_t rangeRemainingBytes = m_endRangeFilePosition - m_filePosition;
-                const size_t bytesToRead = std::min(remainingBytes, rangeRemainingBytes);
-                const int64_t socketBytesRead = ReadFromSocket(data+bytesReadSoFar, bytesToRead);
-                if ( socketBytesRead < 0 ) // error
-                    return -1;
-                else if ( socketBytesRead == 0 ) // EOF
-                    return bytesReadSoFar;
-                bytesReadSoFar += socketBytesRead;
-                m_filePosition += socketBytesRead;
+            // request next range
+            if ( !FetchRange(remainingBytes) ) {
+                Close();
+                return -1;
             }
 
-            // otherwise, this is a 1st-time read or
-            // we already read everything from the last GET request
-            else {
-
-                // request for next range
-                if ( !SendRequest(remainingBytes) || !ReceiveResponse() ) {
-                    Close();
-                    return -1;
-                }
-            }
+            // EOF
+            if ( m_buffer.IsEmpty() && !m_isStreaming )
+                return bytesReadSoFar;
         }
     }
 
@@ -281,8 +375,10 @@ int64_t BamHttp::ReadFromSocket(char* data, const unsigned int maxNumBytes) {
 bool BamHttp::ReceiveResponse(void) {
 
     // clear any prior response
-    if ( m_response )
+    if ( m_response ) {
         delete m_response;
+        m_response = 0;
+    }
 
     // make sure we're connected
     if ( !EnsureSocketConnection() )
@@ -291,8 +387,10 @@ bool BamHttp::ReceiveResponse(void) {
     // fetch header, up until double new line
     string responseHeader;
     do {
-        // read line & append to full header
+        // read line & append to full header (stop if connection was closed)
         const string headerLine = m_socket->ReadLine();
+        if ( headerLine.empty() )
+            break;
         responseHeader += headerLine;
 
     } while ( !endsWith(responseHeader, DOUBLE_NEWLINE) );
@@ -300,7 +398,6 @@ bool BamHttp::ReceiveResponse(void) {
     // sanity check
     if ( responseHeader.empty() ) {
         // TODO: set error string
-        Close();
         return false;
     }
 
@@ -308,43 +405,91 @@ bool BamHttp::ReceiveResponse(void) {
     m_response = new HttpResponseHeader(responseHeader);
     if ( !m_response->IsValid() ) {
         // TODO: set error string
-        Close();
         return false;
     }
 
-    // if we got range response as requested
-    if ( m_response->GetStatusCode() == 206 )
-        return true;
+    // (if we ever get a response without a length, it ends when the server closes the connection)
+    const string contentLength = fieldValue(m_response, CONTENT_LENGTH_HEADER);
+    const int64_t numBodyBytes = ( contentLength.empty() ? -1 : atoll(contentLength.c_str()) );
+    const bool isClosing = ( toLower(fieldValue(m_response, CONNECTION_HEADER)) == CLOSE_VALUE ||
+                             numBodyBytes < 0 );
+
+    // store total file size, if server sent it
+    const string contentRange = fieldValue(m_response, CONTENT_RANGE_HEADER);
+    const size_t separatorFound = contentRange.find(RANGE_SEPARATOR);
+    if ( separatorFound != string::npos && contentRange.at(separatorFound+1) != '*' )
+        m_fileSize = atoll(contentRange.c_str() + separatorFound + 1);
+
+    const int statusCode = m_response->GetStatusCode();
+
+    // if we got range response as requested, stage its data
+    if ( statusCode == 206 && numBodyBytes >= 0 ) {
+        m_isStreaming = false;
+        if ( !ReceiveResponseBody(numBodyBytes, true) )
+            return false;
+        m_endRangeFilePosition = m_filePosition + numBodyBytes;
+    }
 
-    // if we got the full file contents instead of range
-    else if ( m_response->GetStatusCode() == 200 ) {
+    // if requested range starts at (or beyond) end of file, there's no data left
+    else if ( statusCode == 416 ) {
+        m_isStreaming = false;
+        if ( m_fileSize < 0 )
+            m_fileSize = m_filePosition;
+        m_endRangeFilePosition = m_filePosition;
+        if ( !isClosing && !ReceiveResponseBody(numBodyBytes, false) )
+            return false;
+    }
 
-        // skip up to current file position
-        RaiiBuffer tmp(0x8000);
-        int64_t numBytesRead = 0;
-        while ( numBytesRead < m_filePosition ) {
+    // if we got the full file contents instead of range, skip up to current file
+    // position & read the remainder straight from socket from now on
+    else if ( statusCode == 200 ) {
+        m_isStreaming = true;
+        if ( numBodyBytes >= 0 )
+            m_fileSize = numBodyBytes;
+        m_endRangeFilePosition = -1;
+        return ReceiveResponseBody(m_filePosition, false);
+    }
 
-            const int64_t remaining = m_filePosition - numBytesRead;
-            const size_t bytesToRead = static_cast<size_t>( (remaining > 0x8000) ? 0x8000 : remaining );
-            const int64_t socketBytesRead = ReadFromSocket(tmp.Buffer, bytesToRead);
-            if ( socketBytesRead < 0 ) { // error
-                Close();
-                return false;
-            }
-            else if ( socketBytesRead == 0 ) // EOF
-                break;
+    // on any other reponse status
+    else {
+        // TODO: set error string
+        return false;
+    }
 
-            numBytesRead += socketBytesRead;
-        }
+    // server won't accept any more requests on this connection
+    if ( isClosing )
+        m_socket->DisconnectFromHost();
+
+    // return success
+    return true;
+}
+
+// reads @numBytes of the current response's body, either staged in our buffer or discarded
+bool BamHttp::ReceiveResponseBody(const int64_t& numBytes, const bool isKept) {
 
-        // return success
-        return ( numBytesRead == m_filePosition);
+    if ( numBytes <= 0 )
+        return true;
+
+    RaiiBuffer tmp( isKept ? 0 : 0x8000 );
+    char* dest = ( isKept ? m_buffer.Reserve(static_cast<size_t>(numBytes)) : tmp.Buffer );
+
+    int64_t numBytesRead = 0;
+    while ( numBytesRead < numBytes ) {
+
+        const int64_t remaining = numBytes - numBytesRead;
+        const int64_t maxBytes  = ( isKept ? std::min(remaining, static_cast<int64_t>(0x7fffffff))
+                                           : std::min(remaining, static_cast<int64_t>(0x8000)) );
+        char* writePosition = ( isKept ? dest + numBytesRead : dest );
+        const int64_t socketBytesRead = ReadFromSocket(writePosition, static_cast<unsigned int>(maxBytes));
+        if ( socketBytesRead <= 0 ) // error or EOF
+            break;
+        numBytesRead += socketBytesRead;
     }
 
-    // on any other reponse status
-    // TODO: set error string
-    Close();
-    return false;
+    // drop any space reserved for data that never came
+    if ( isKept && numBytesRead < numBytes )
+        m_buffer.Chop( static_cast<size_t>(numBytes - numBytesRead) );
+    return ( numBytesRead == numBytes );
 }
 
 bool BamHttp::Seek(const int64_t& position, const int origin) {
@@ -355,18 +500,37 @@ bool BamHttp::Seek(const int64_t& position, const int origin) {
         return false;
     }
 
-    // discard socket's buffer contents, update positions, & return success
-    m_socket->ClearBuffer();
-
+    // determine target position
+    int64_t targetPosition = 0;
     if ( origin == SEEK_CUR )
-        m_filePosition += position;
+        targetPosition = m_filePosition + position;
     else if ( origin == SEEK_SET )
-        m_filePosition = position;
+        targetPosition = position;
     else {
         // TODO: set error string
         return false;
     }
-    m_endRangeFilePosition = m_filePosition;
+
+    // nothing to do if already there
+    if ( targetPosition == m_filePosition )
+        return true;
+
+    // if target is within data already received, just skip ahead to it
+    const int64_t bufferSize = static_cast<int64_t>(m_buffer.Size());
+    if ( !m_isStreaming && targetPosition > m_filePosition && targetPosition < m_filePosition + bufferSize ) {
+        m_buffer.Free( static_cast<size_t>(targetPosition - m_filePosition) );
+        m_filePosition = targetPosition;
+        return true;
+    }
+
+    // otherwise discard it, next read will request a new range
+    // (if receiving the entire file, remainder of response is unwanted, so drop connection)
+    m_buffer.Clear();
+    if ( m_isStreaming ) {
+        m_socket->DisconnectFromHost();
+        m_isStreaming = false;
+    }
+    m_filePosition = targetPosition;
     return true;
 }
 
@@ -376,10 +540,12 @@ bool BamHttp::SendRequest(const size_t numBytes) {
     if ( m_request )
         delete m_request;
 
-    // create range string
-    m_endRangeFilePosition = m_filePosition + numBytes;
+    // create range string (last byte position is inclusive)
     stringstream range("");
-    range << BYTES_PREFIX << m_filePosition << '-' << m_endRangeFilePosition;
+    range << BYTES_PREFIX << m_filePosition << '-' << ( m_filePosition + std::max(numBytes, (size_t)1) - 1 );
+
+    // create host string
+    const string host = ( m_port == HTTP_PORT ? m_hostname : m_hostname + PROXY_SEPARATOR + m_port );
 
     // make sure we're connected
     if ( !EnsureSocketConnection() )
@@ -387,13 +553,14 @@ bool BamHttp::SendRequest(const size_t numBytes) {
 
     // create request
     m_request = new HttpRequestHeader(GET_METHOD, m_filename);
-    m_request->SetField(HOST_HEADER,  m_hostname);
+    m_request->SetField(HOST_HEADER,  host);
     m_request->SetField(RANGE_HEADER, range.str());
+    m_request->SetField(CONNECTION_HEADER, KEEP_ALIVE_VALUE);
 
     // write request to socket
     const string requestHeader = m_request->ToString();
     const size_t headerSize    = requestHeader.size();
-    return ( WriteToSocket(requestHeader.c_str(), headerSize) == headerSize );
+    return ( WriteToSocket(requestHeader.c_str(), headerSize) == static_cast<int64_t>(headerSize) );
 }
 
 int64_t BamHttp::Tell(void) const {
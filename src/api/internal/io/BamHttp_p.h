@@ -21,11 +21,13 @@
 // We mean it.
 
 #include "api/IBamIODevice.h"
+#include "api/internal/io/RollingBuffer_p.h"
 #include <string>
 
 namespace BamTools {
 namespace Internal {
 
+class HttpRangeFetcher;
 class HttpRequestHeader;
 class HttpResponseHeader;
 class TcpSocket;
@@ -52,10 +54,13 @@ class BamHttp : public IBamIODevice {
     private:
         bool ConnectSocket(void);
         bool EnsureSocketConnection(void);
+        bool FetchRange(const size_t numBytes);
+        void FetchRangesAhead(void);
         void ParseUrl(const std::string& url);
         int64_t ReadFromSocket(char* data, const unsigned int numBytes);
         bool ReceiveResponse(void);
-        bool SendRequest(const size_t numBytes = 0);
+        bool ReceiveResponseBody(const int64_t& numBytes, const bool isKept);
+        bool SendRequest(const size_t numBytes);
         int64_t WriteToSocket(const char* data, const unsigned int numBytes);
 
     // data members
@@ -75,10 +80,19 @@ class BamHttp : public IBamIODevice {
 
         // internal state flags
         bool m_isUrlParsed;
+        bool m_isStreaming;     // server ignored range request, socket delivers whole file
 
         // file position
         int64_t m_filePosition;
-        int64_t m_endRangeFilePosition;
+        int64_t m_endRangeFilePosition;     // end of last range requested
+        int64_t m_fileSize;                 // -1 if not (yet) known
+
+        // data received ahead of file position (front of buffer is at m_filePosition)
+        RollingBuffer m_buffer;
+        size_t m_readAheadSize;
+
+        // extra connections, downloading ranges beyond m_endRangeFilePosition during sequential reads
+        HttpRangeFetcher* m_fetcher;
 };
 
 } // namespace Internal
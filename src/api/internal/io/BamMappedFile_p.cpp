@@ -0,0 +1,256 @@
+// ***************************************************************************
+// BamMappedFile_p.cpp (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides read-only access to local files through a memory mapping
+// ***************************************************************************
+
+#include "api/BamAux.h"
+#include "api/internal/io/BamMappedFile_p.h"
+using namespace BamTools;
+using namespace BamTools::Internal;
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#include <cstring>
+#include <algorithm>
+using namespace std;
+
+namespace BamTools {
+namespace Internal {
+
+// -----------
+// constants
+// -----------
+
+// amount of data requested ahead of the read position, depending on access pattern
+static const int64_t MAPPED_SEQUENTIAL_PREFETCH = 0x800000; // 8 MB
+static const int64_t MAPPED_RANDOM_PREFETCH     = 0x40000;  // 256 KB
+
+#ifndef _WIN32
+
+// -----------------
+// utility methods
+// -----------------
+
+static inline
+void adviseRange(char* data, const int64_t& begin, const int64_t& end, const int advice) {
+    static const int64_t pageSize = sysconf(_SC_PAGESIZE);
+    const int64_t alignedBegin = begin - (begin % pageSize);
+    if ( end > alignedBegin )
+        madvise(data + alignedBegin, static_cast<size_t>(end - alignedBegin), advice);
+}
+
+#endif // _WIN32
+
+} // namespace Internal
+} // namespace BamTools
+
+// ------------------------------
+// BamMappedFile implementation
+// ------------------------------
+
+BamMappedFile::BamMappedFile(const string& filename)
+    : IBamIODevice()
+    , m_filename(filename)
+    , m_data(0)
+    , m_fileSize(0)
+    , m_position(0)
+    , m_isRandomAccess(false)
+    , m_prefetchEnd(0)
+{ }
+
+BamMappedFile::~BamMappedFile(void) {
+    Close();
+}
+
+void BamMappedFile::Close(void) {
+#ifndef _WIN32
+    if ( m_data )
+        munmap(m_data, static_cast<size_t>(m_fileSize));
+#endif
+    m_data = 0;
+    m_fileSize = 0;
+    m_position = 0;
+    m_isRandomAccess = false;
+    m_prefetchEnd = 0;
+    m_mode = IBamIODevice::NotOpen;
+}
+
+bool BamMappedFile::IsRandomAccess(void) const {
+    return true;
+}
+
+// returns true if memory-mapped files can be used for @filename & @mode
+bool BamMappedFile::IsSupported(const string& filename, const IBamIODevice::OpenMode mode) {
+#ifndef _WIN32
+    struct stat fileStats;
+    return ( mode == IBamIODevice::ReadOnly &&
+             stat(filename.c_str(), &fileStats) == 0 &&
+             S_ISREG(fileStats.st_mode) );
+#else
+    (void)filename;
+    (void)mode;
+    return false;
+#endif
+}
+
+bool BamMappedFile::Open(const IBamIODevice::OpenMode mode) {
+
+    // make sure we're starting with a fresh mapping
+    Close();
+
+    // mapped files are read-only
+    if ( mode != IBamIODevice::ReadOnly ) {
+        SetErrorString("BamMappedFile::Open", "writing on this device is not supported");
+        return false;
+    }
+
+#ifndef _WIN32
+
+    // open file & get its size
+    const string message_base = string("could not open file handle for ");
+    const string message = message_base + ( (m_filename.empty()) ? "empty filename" : m_filename );
+    const int fd = open(m_filename.c_str(), O_RDONLY);
+    if ( fd < 0 ) {
+        SetErrorString("BamMappedFile::Open", message);
+        return false;
+    }
+    struct stat fileStats;
+    if ( fstat(fd, &fileStats) != 0 ) {
+        close(fd);
+        SetErrorString("BamMappedFile::Open", message);
+        return false;
+    }
+    m_fileSize = static_cast<int64_t>(fileStats.st_size);
+
+    // map entire file (mapping stays valid after descriptor is closed)
+    // an empty file can't be mapped, but is simply read as EOF
+    if ( m_fileSize > 0 ) {
+        void* data = mmap(0, static_cast<size_t>(m_fileSize), PROT_READ, MAP_PRIVATE, fd, 0);
+        if ( data == MAP_FAILED ) {
+            close(fd);
+            m_fileSize = 0;
+            SetErrorString("BamMappedFile::Open", string("could not map file: ") + m_filename);
+            return false;
+        }
+        m_data = static_cast<char*>(data);
+
+        // assume file will be streamed through, until a seek says otherwise
+        adviseRange(m_data, 0, m_fileSize, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    // store current IO mode & return success
+    m_mode = mode;
+    return true;
+
+#else
+    SetErrorString("BamMappedFile::Open", "memory-mapped files are not supported on this platform");
+    return false;
+#endif // _WIN32
+}
+
+// reads next byte into @c without consuming it, returns false at EOF
+bool BamMappedFile::Peek(char& c) const {
+    if ( !IsOpen() || m_position >= m_fileSize )
+        return false;
+    c = m_data[m_position];
+    return true;
+}
+
+// asks OS to start loading the pages following the current position, if not done yet
+void BamMappedFile::PrefetchAhead(void) {
+
+#ifndef _WIN32
+
+    // request next window once we're halfway through the previous one
+    const int64_t windowSize = ( m_isRandomAccess ? MAPPED_RANDOM_PREFETCH : MAPPED_SEQUENTIAL_PREFETCH );
+    if ( m_data == 0 || m_position + windowSize/2 < m_prefetchEnd )
+        return;
+
+    const int64_t begin = max(m_position, m_prefetchEnd);
+    const int64_t end   = min(m_position + windowSize, m_fileSize);
+    adviseRange(m_data, begin, end, MADV_WILLNEED);
+    m_prefetchEnd = end;
+
+#endif // _WIN32
+}
+
+int64_t BamMappedFile::Read(char* data, const unsigned int numBytes) {
+    const char* source = 0;
+    const int64_t numBytesRead = ReadInPlace(source, numBytes);
+    if ( numBytesRead > 0 )
+        memcpy(data, source, static_cast<size_t>(numBytesRead));
+    return numBytesRead;
+}
+
+// like Read(), but points @data at the mapped bytes instead of copying them
+// (valid until device is closed)
+int64_t BamMappedFile::ReadInPlace(const char*& data, const unsigned int numBytes) {
+
+    if ( !IsOpen() )
+        return -1;
+
+    PrefetchAhead();
+
+    const int64_t numBytesRead = min(static_cast<int64_t>(numBytes), m_fileSize - m_position);
+    data = m_data + m_position;
+    m_position += numBytesRead;
+    return numBytesRead;
+}
+
+bool BamMappedFile::Seek(const int64_t& position, const int origin) {
+
+    // determine target position
+    int64_t targetPosition = 0;
+    if ( origin == SEEK_SET )
+        targetPosition = position;
+    else if ( origin == SEEK_CUR )
+        targetPosition = m_position + position;
+    else if ( origin == SEEK_END )
+        targetPosition = m_fileSize + position;
+    else
+        return false;
+    if ( !IsOpen() || targetPosition < 0 || targetPosition > m_fileSize )
+        return false;
+
+    // nothing to do if already there
+    if ( targetPosition == m_position )
+        return true;
+
+#ifndef _WIN32
+
+    // any jump means region access - stop OS from reading far ahead of us
+    if ( !m_isRandomAccess && m_data ) {
+        adviseRange(m_data, 0, m_fileSize, MADV_RANDOM);
+        m_isRandomAccess = true;
+    }
+
+#endif // _WIN32
+
+    // start loading data at new position
+    m_position = targetPosition;
+    m_prefetchEnd = m_position;
+    PrefetchAhead();
+    return true;
+}
+
+int64_t BamMappedFile::Tell(void) const {
+    return ( IsOpen() ? m_position : -1 );
+}
+
+int64_t BamMappedFile::Write(const char* data, const unsigned int numBytes) {
+    (void)data;
+    (void)numBytes;
+    BT_ASSERT_X(false, "BamMappedFile::Write : write-mode not supported on this device");
+    SetErrorString("BamMappedFile::Write", "write-mode not supported on this device");
+    return -1;
+}
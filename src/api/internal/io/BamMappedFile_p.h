@@ -0,0 +1,74 @@
+// ***************************************************************************
+// BamMappedFile_p.h (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides read-only access to local files through a memory mapping
+// ***************************************************************************
+
+#ifndef BAMMAPPEDFILE_P_H
+#define BAMMAPPEDFILE_P_H
+
+//  -------------
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the BamTools API.  It exists purely as an
+// implementation detail. This header file may change from version to version
+// without notice, or even be removed.
+//
+// We mean it.
+
+#include "api/IBamIODevice.h"
+#include <string>
+
+namespace BamTools {
+namespace Internal {
+
+class BamMappedFile : public IBamIODevice {
+
+    // ctor & dtor
+    public:
+        BamMappedFile(const std::string& filename);
+        ~BamMappedFile(void);
+
+    // IBamIODevice implementation
+    public:
+        void Close(void);
+        bool IsRandomAccess(void) const;
+        bool Open(const IBamIODevice::OpenMode mode);
+        int64_t Read(char* data, const unsigned int numBytes);
+        bool Seek(const int64_t& position, const int origin = SEEK_SET);
+        int64_t Tell(void) const;
+        int64_t Write(const char* data, const unsigned int numBytes);
+
+    // BamMappedFile interface
+    public:
+        // reads next byte into @c without consuming it, returns false at EOF
+        bool Peek(char& c) const;
+        // like Read(), but points @data at the mapped bytes instead of copying them
+        // (valid until device is closed)
+        int64_t ReadInPlace(const char*& data, const unsigned int numBytes);
+        // returns true if memory-mapped files can be used for @filename & @mode
+        static bool IsSupported(const std::string& filename, const IBamIODevice::OpenMode mode);
+
+    // internal methods
+    private:
+        // asks OS to start loading the pages following the current position, if not done yet
+        void PrefetchAhead(void);
+
+    // data members
+    private:
+        std::string m_filename;
+        char* m_data;
+        int64_t m_fileSize;
+        int64_t m_position;
+        bool m_isRandomAccess;      // reads have jumped around, instead of streaming through file
+        int64_t m_prefetchEnd;      // end of pages already requested from OS
+};
+
+} // namespace Internal
+} // namespace BamTools
+
+#endif // BAMMAPPEDFILE_P_H
@@ -0,0 +1,112 @@
+// ***************************************************************************
+// BgzfBlockCache_p.cpp (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides a size-bounded, least-recently-used cache of decompressed BGZF
+// blocks, keyed by each block's compressed file offset
+// ***************************************************************************
+
+#include "api/internal/io/BgzfBlockCache_p.h"
+using namespace BamTools;
+using namespace BamTools::Internal;
+
+#include <cstring>
+using namespace std;
+
+// -------------------------------
+// BgzfBlockCache implementation
+// -------------------------------
+
+BgzfBlockCache::BgzfBlockCache(void)
+    : m_size(0)
+    , m_maxSize(0)
+    , m_numHits(0)
+    , m_numMisses(0)
+{ }
+
+BgzfBlockCache::~BgzfBlockCache(void) { }
+
+// drops all cached blocks (hit/miss counters are kept)
+void BgzfBlockCache::Clear(void) {
+    m_entries.clear();
+    m_lru.clear();
+    m_size = 0;
+}
+
+// looks up block at blockAddress, copying its data into output on a hit
+bool BgzfBlockCache::Find(const int64_t& blockAddress,
+                          char* output,
+                          size_t& blockLength,
+                          int64_t& nextBlockAddress)
+{
+    EntryMap::iterator entryIter = m_entries.find(blockAddress);
+    if ( entryIter == m_entries.end() ) {
+        ++m_numMisses;
+        return false;
+    }
+    ++m_numHits;
+
+    // move block to front of LRU list
+    Entry& entry = (*entryIter).second;
+    m_lru.splice(m_lru.begin(), m_lru, entry.LruPosition);
+
+    blockLength = entry.Data.size();
+    nextBlockAddress = entry.NextBlockAddress;
+    memcpy(output, entry.Data.data(), blockLength);
+    return true;
+}
+
+// stores a block's decompressed data, evicting least-recently-used blocks as needed
+void BgzfBlockCache::Insert(const int64_t& blockAddress,
+                            const char* data,
+                            const size_t blockLength,
+                            const int64_t& nextBlockAddress)
+{
+    // skip if block can never fit, or is already stored
+    if ( blockLength > m_maxSize || m_entries.find(blockAddress) != m_entries.end() )
+        return;
+
+    // make room for block
+    Shrink(m_maxSize - blockLength);
+
+    // store block as most recently used
+    m_lru.push_front(blockAddress);
+    Entry& entry = m_entries[blockAddress];
+    entry.Data.assign(data, blockLength);
+    entry.NextBlockAddress = nextBlockAddress;
+    entry.LruPosition = m_lru.begin();
+    m_size += blockLength;
+}
+
+// returns true if cache may hold any data
+bool BgzfBlockCache::IsEnabled(void) const {
+    return ( m_maxSize > 0 );
+}
+
+// returns number of lookups that found their block
+uint64_t BgzfBlockCache::NumHits(void) const {
+    return m_numHits;
+}
+
+// returns number of lookups that did not find their block
+uint64_t BgzfBlockCache::NumMisses(void) const {
+    return m_numMisses;
+}
+
+// sets maximum number of bytes of decompressed data held (0 disables cache)
+void BgzfBlockCache::SetMaxSize(const size_t maxSize) {
+    m_maxSize = maxSize;
+    Shrink(m_maxSize);
+}
+
+// evicts least-recently-used blocks until cache fits within maxSize
+void BgzfBlockCache::Shrink(const size_t maxSize) {
+    while ( m_size > maxSize && !m_lru.empty() ) {
+        EntryMap::iterator entryIter = m_entries.find(m_lru.back());
+        m_size -= (*entryIter).second.Data.size();
+        m_entries.erase(entryIter);
+        m_lru.pop_back();
+    }
+}
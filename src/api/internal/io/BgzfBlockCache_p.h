@@ -0,0 +1,89 @@
+// ***************************************************************************
+// BgzfBlockCache_p.h (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides a size-bounded, least-recently-used cache of decompressed BGZF
+// blocks, keyed by each block's compressed file offset
+// ***************************************************************************
+
+#ifndef BGZFBLOCKCACHE_P_H
+#define BGZFBLOCKCACHE_P_H
+
+//  -------------
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the BamTools API.  It exists purely as an
+// implementation detail. This header file may change from version to version
+// without notice, or even be removed.
+//
+// We mean it.
+
+#include "api/api_global.h"
+#include <list>
+#include <map>
+#include <string>
+
+namespace BamTools {
+namespace Internal {
+
+class BgzfBlockCache {
+
+    // ctor & dtor
+    public:
+        BgzfBlockCache(void);
+        ~BgzfBlockCache(void);
+
+    // BgzfBlockCache interface
+    public:
+        // drops all cached blocks (hit/miss counters are kept)
+        void Clear(void);
+        // looks up block at blockAddress, copying its data into output on a hit
+        bool Find(const int64_t& blockAddress,
+                  char* output,
+                  size_t& blockLength,
+                  int64_t& nextBlockAddress);
+        // stores a block's decompressed data, evicting least-recently-used blocks as needed
+        void Insert(const int64_t& blockAddress,
+                    const char* data,
+                    const size_t blockLength,
+                    const int64_t& nextBlockAddress);
+        // returns true if cache may hold any data
+        bool IsEnabled(void) const;
+        // returns number of lookups that found their block
+        uint64_t NumHits(void) const;
+        // returns number of lookups that did not find their block
+        uint64_t NumMisses(void) const;
+        // sets maximum number of bytes of decompressed data held (0 disables cache)
+        void SetMaxSize(const size_t maxSize);
+
+    // internal types
+    private:
+        struct Entry {
+            std::string Data;
+            int64_t NextBlockAddress;
+            std::list<int64_t>::iterator LruPosition;
+        };
+        typedef std::map<int64_t, Entry> EntryMap;
+
+    // internal methods
+    private:
+        // evicts least-recently-used blocks until cache fits within maxSize
+        void Shrink(const size_t maxSize);
+
+    // data members
+    private:
+        EntryMap m_entries;
+        std::list<int64_t> m_lru;   // block addresses, most recently used first
+        size_t m_size;
+        size_t m_maxSize;
+        uint64_t m_numHits;
+        uint64_t m_numMisses;
+};
+
+} // namespace Internal
+} // namespace BamTools
+
+#endif // BGZFBLOCKCACHE_P_H
@@ -0,0 +1,133 @@
+// ***************************************************************************
+// BgzfBlockQueue_p.h (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides an ordered queue of BGZF block jobs, processed in parallel by a
+// pool of worker threads but handed back in submission order. The per-block
+// work (compression, decompression) is supplied by the owner.
+// ***************************************************************************
+
+#ifndef BGZFBLOCKQUEUE_P_H
+#define BGZFBLOCKQUEUE_P_H
+
+//  -------------
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the BamTools API.  It exists purely as an
+// implementation detail. This header file may change from version to version
+// without notice, or even be removed.
+//
+// We mean it.
+
+#include "api/api_global.h"
+#include "shared/bamtools_worker_pool.h"
+#include <deque>
+#include <vector>
+
+namespace BamTools {
+namespace Internal {
+
+// Job must have a 'bool IsDone' member (see BamWorkerPool), Operation must
+// provide 'void Process(Job& job)', called concurrently from worker threads
+template<typename Job, typename Operation>
+class BgzfBlockQueue {
+
+    // ctor & dtor
+    public:
+        BgzfBlockQueue(Operation& operation, const unsigned int numThreads);
+        ~BgzfBlockQueue(void);
+
+    // BgzfBlockQueue interface
+    public:
+        // discards all queued jobs (waiting for any that workers are busy with)
+        void Clear(void);
+        // returns true if the oldest queued job has been processed
+        bool IsNextReady(void);
+        // returns an unused job (recycled if possible), to be filled in & submitted
+        Job* NewJob(void);
+        // returns number of queued jobs not yet taken
+        size_t NumPending(void) const;
+        // queues job for processing, after all previously submitted jobs
+        void Submit(Job* job);
+        // waits for the oldest queued job & returns it
+        // (job stays valid until next call to NewJob())
+        Job* TakeNext(void);
+
+    // data members
+    private:
+        BamWorkerPool<Job, Operation> m_pool;
+        std::deque<Job*> m_pending;   // all jobs not yet taken (submission order)
+        std::vector<Job*> m_unused;   // recycled jobs
+};
+
+template<typename Job, typename Operation>
+BgzfBlockQueue<Job, Operation>::BgzfBlockQueue(Operation& operation, const unsigned int numThreads)
+    : m_pool(operation, numThreads)
+{ }
+
+template<typename Job, typename Operation>
+BgzfBlockQueue<Job, Operation>::~BgzfBlockQueue(void) {
+
+    // jobs may still be in workers' hands
+    Clear();
+
+    typename std::vector<Job*>::iterator unusedIter = m_unused.begin();
+    typename std::vector<Job*>::iterator unusedEnd  = m_unused.end();
+    for ( ; unusedIter != unusedEnd; ++unusedIter )
+        delete (*unusedIter);
+    m_unused.clear();
+}
+
+template<typename Job, typename Operation>
+void BgzfBlockQueue<Job, Operation>::Clear(void) {
+    while ( !m_pending.empty() ) {
+        Job* job = m_pending.front();
+        m_pool.Wait(job);
+        m_pending.pop_front();
+        m_unused.push_back(job);
+    }
+}
+
+template<typename Job, typename Operation>
+bool BgzfBlockQueue<Job, Operation>::IsNextReady(void) {
+    if ( m_pending.empty() )
+        return false;
+    return m_pool.IsDone(m_pending.front());
+}
+
+template<typename Job, typename Operation>
+Job* BgzfBlockQueue<Job, Operation>::NewJob(void) {
+    if ( m_unused.empty() )
+        return new Job;
+    Job* job = m_unused.back();
+    m_unused.pop_back();
+    return job;
+}
+
+template<typename Job, typename Operation>
+size_t BgzfBlockQueue<Job, Operation>::NumPending(void) const {
+    return m_pending.size();
+}
+
+template<typename Job, typename Operation>
+void BgzfBlockQueue<Job, Operation>::Submit(Job* job) {
+    m_pending.push_back(job);
+    m_pool.Submit(job);
+}
+
+template<typename Job, typename Operation>
+Job* BgzfBlockQueue<Job, Operation>::TakeNext(void) {
+    Job* job = m_pending.front();
+    m_pool.Wait(job);
+    m_pending.pop_front();
+    m_unused.push_back(job);
+    return job;
+}
+
+} // namespace Internal
+} // namespace BamTools
+
+#endif // BGZFBLOCKQUEUE_P_H
@@ -0,0 +1,81 @@
+// ***************************************************************************
+// BgzfCompressor_p.cpp (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides a pool of worker threads that compress BGZF blocks in parallel,
+// handing them back in submission order
+// ***************************************************************************
+
+#include "api/BamConstants.h"
+#include "api/internal/io/BgzfCompressor_p.h"
+#include "api/internal/io/BgzfStream_p.h"
+#include "api/internal/utils/BamException_p.h"
+using namespace BamTools;
+using namespace BamTools::Internal;
+
+#include <exception>
+using namespace std;
+
+// -------------------------------
+// BgzfCompressor implementation
+// -------------------------------
+
+BgzfCompressor::BgzfCompressor(const unsigned int numThreads, const int compressionLevel)
+    : m_compressionLevel(compressionLevel)
+    , m_queue(*this, numThreads)
+{ }
+
+BgzfCompressor::~BgzfCompressor(void) { }
+
+// queues a block of uncompressed data
+void BgzfCompressor::Compress(const char* data, const size_t dataLength) {
+    Job* job = m_queue.NewJob();
+    job->Input.assign(data, dataLength);
+    job->Output.clear();
+    job->ErrorString.clear();
+    m_queue.Submit(job);
+}
+
+// returns true if the oldest queued block has finished compressing
+bool BgzfCompressor::IsNextReady(void) {
+    return m_queue.IsNextReady();
+}
+
+// returns number of queued blocks not yet taken
+size_t BgzfCompressor::NumPending(void) const {
+    return m_queue.NumPending();
+}
+
+// compresses a job's input into one (or, if input does not compress, more) BGZF blocks
+void BgzfCompressor::Process(Job& job) const {
+
+    char buffer[Constants::BGZF_MAX_BLOCK_SIZE];
+    try {
+        size_t inputOffset = 0;
+        const size_t inputLength = job.Input.size();
+        while ( inputOffset < inputLength ) {
+            int32_t blockLength = static_cast<int32_t>(inputLength - inputOffset);
+            const size_t compressedLength = BgzfStream::DeflateBlock(job.Input.data() + inputOffset,
+                                                                     blockLength,
+                                                                     buffer,
+                                                                     m_compressionLevel);
+            job.Output.append(buffer, compressedLength);
+            inputOffset += blockLength;
+        }
+    } catch ( exception& e ) {
+        job.ErrorString = e.what();
+    }
+}
+
+// waits for the oldest queued block, stores its compressed BGZF data in output
+void BgzfCompressor::TakeNext(std::string& output) {
+
+    BT_ASSERT_X( (m_queue.NumPending() > 0), "BgzfCompressor::TakeNext() - no blocks pending" );
+
+    Job* job = m_queue.TakeNext();
+    output.swap(job->Output);
+    if ( !job->ErrorString.empty() )
+        throw BamException("BgzfCompressor::TakeNext", job->ErrorString);
+}
@@ -0,0 +1,72 @@
+// ***************************************************************************
+// BgzfCompressor_p.h (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides a pool of worker threads that compress BGZF blocks in parallel,
+// handing them back in submission order
+// ***************************************************************************
+
+#ifndef BGZFCOMPRESSOR_P_H
+#define BGZFCOMPRESSOR_P_H
+
+//  -------------
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the BamTools API.  It exists purely as an
+// implementation detail. This header file may change from version to version
+// without notice, or even be removed.
+//
+// We mean it.
+
+#include "api/api_global.h"
+#include "api/internal/io/BgzfBlockQueue_p.h"
+#include <string>
+
+namespace BamTools {
+namespace Internal {
+
+class BgzfCompressor {
+
+    // ctor & dtor
+    public:
+        BgzfCompressor(const unsigned int numThreads, const int compressionLevel);
+        ~BgzfCompressor(void);
+
+    // BgzfCompressor interface
+    public:
+        // queues a block of uncompressed data (at most BGZF_DEFAULT_BLOCK_SIZE bytes)
+        void Compress(const char* data, const size_t dataLength);
+        // returns true if the oldest queued block has finished compressing
+        bool IsNextReady(void);
+        // returns number of queued blocks not yet taken
+        size_t NumPending(void) const;
+        // waits for the oldest queued block, stores its compressed BGZF data in output
+        void TakeNext(std::string& output);
+
+    // internal types
+    public:
+        struct Job {
+            std::string Input;
+            std::string Output;
+            std::string ErrorString;
+            bool IsDone;
+        };
+
+    // BgzfBlockQueue operation
+    public:
+        // compresses job's input (called on worker threads)
+        void Process(Job& job) const;
+
+    // data members
+    private:
+        int m_compressionLevel;
+        BgzfBlockQueue<Job, const BgzfCompressor> m_queue;
+};
+
+} // namespace Internal
+} // namespace BamTools
+
+#endif // BGZFCOMPRESSOR_P_H
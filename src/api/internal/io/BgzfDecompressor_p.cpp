@@ -0,0 +1,80 @@
+// ***************************************************************************
+// BgzfDecompressor_p.cpp (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides a pool of worker threads that inflate BGZF blocks in parallel,
+// handing them back in the order they were read
+// ***************************************************************************
+
+#include "api/BamConstants.h"
+#include "api/internal/io/BgzfDecompressor_p.h"
+#include "api/internal/io/BgzfStream_p.h"
+#include "api/internal/utils/BamException_p.h"
+using namespace BamTools;
+using namespace BamTools::Internal;
+
+#include <cstring>
+#include <exception>
+using namespace std;
+
+// ---------------------------------
+// BgzfDecompressor implementation
+// ---------------------------------
+
+BgzfDecompressor::BgzfDecompressor(const unsigned int numThreads)
+    : m_queue(*this, numThreads)
+{ }
+
+BgzfDecompressor::~BgzfDecompressor(void) { }
+
+// discards all queued blocks (waiting for any that workers are busy with)
+void BgzfDecompressor::Clear(void) {
+    m_queue.Clear();
+}
+
+// queues a complete (compressed) BGZF block, read from blockAddress
+void BgzfDecompressor::Decompress(const char* data,
+                                  const size_t dataLength,
+                                  const int64_t& blockAddress)
+{
+    Job* job = m_queue.NewJob();
+    job->Input.assign(data, dataLength);
+    job->ErrorString.clear();
+    job->BlockAddress = blockAddress;
+    job->OutputLength = 0;
+    m_queue.Submit(job);
+}
+
+// returns number of queued blocks not yet taken
+size_t BgzfDecompressor::NumPending(void) const {
+    return m_queue.NumPending();
+}
+
+// inflates a job's input block
+void BgzfDecompressor::Process(Job& job) const {
+    job.Output.resize(Constants::BGZF_DEFAULT_BLOCK_SIZE);
+    try {
+        job.OutputLength = BgzfStream::InflateBlock(job.Input.data(),
+                                                    job.Input.size(),
+                                                    (char*)job.Output.data());
+    } catch ( exception& e ) {
+        job.ErrorString = e.what();
+    }
+}
+
+// waits for the oldest queued block, copies its inflated data into output
+size_t BgzfDecompressor::TakeNext(char* output, int64_t& blockAddress, int64_t& nextBlockAddress) {
+
+    BT_ASSERT_X( (m_queue.NumPending() > 0), "BgzfDecompressor::TakeNext() - no blocks pending" );
+
+    const Job* job = m_queue.TakeNext();
+    if ( !job->ErrorString.empty() )
+        throw BamException("BgzfDecompressor::TakeNext", job->ErrorString);
+
+    memcpy(output, job->Output.data(), job->OutputLength);
+    blockAddress     = job->BlockAddress;
+    nextBlockAddress = job->BlockAddress + job->Input.size();
+    return job->OutputLength;
+}
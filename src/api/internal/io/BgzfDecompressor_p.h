@@ -0,0 +1,74 @@
+// ***************************************************************************
+// BgzfDecompressor_p.h (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides a pool of worker threads that inflate BGZF blocks in parallel,
+// handing them back in the order they were read
+// ***************************************************************************
+
+#ifndef BGZFDECOMPRESSOR_P_H
+#define BGZFDECOMPRESSOR_P_H
+
+//  -------------
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the BamTools API.  It exists purely as an
+// implementation detail. This header file may change from version to version
+// without notice, or even be removed.
+//
+// We mean it.
+
+#include "api/api_global.h"
+#include "api/internal/io/BgzfBlockQueue_p.h"
+#include <string>
+
+namespace BamTools {
+namespace Internal {
+
+class BgzfDecompressor {
+
+    // ctor & dtor
+    public:
+        explicit BgzfDecompressor(const unsigned int numThreads);
+        ~BgzfDecompressor(void);
+
+    // BgzfDecompressor interface
+    public:
+        // discards all queued blocks
+        void Clear(void);
+        // queues a complete (compressed) BGZF block, read from blockAddress
+        void Decompress(const char* data, const size_t dataLength, const int64_t& blockAddress);
+        // returns number of queued blocks not yet taken
+        size_t NumPending(void) const;
+        // waits for the oldest queued block, copies its inflated data into output
+        // (at least BGZF_DEFAULT_BLOCK_SIZE bytes), returns inflated length
+        size_t TakeNext(char* output, int64_t& blockAddress, int64_t& nextBlockAddress);
+
+    // internal types
+    public:
+        struct Job {
+            std::string Input;
+            std::string Output;
+            std::string ErrorString;
+            int64_t BlockAddress;
+            size_t OutputLength;
+            bool IsDone;
+        };
+
+    // BgzfBlockQueue operation
+    public:
+        // inflates job's input block (called on worker threads)
+        void Process(Job& job) const;
+
+    // data members
+    private:
+        BgzfBlockQueue<Job, const BgzfDecompressor> m_queue;
+};
+
+} // namespace Internal
+} // namespace BamTools
+
+#endif // BGZFDECOMPRESSOR_P_H
@@ -2,7 +2,7 @@
 // BgzfStream_p.cpp (c) 2011 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 17 January 2012(DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Based on BGZF routines developed at the Broad Institute.
 // Provides the basic functionality for reading & writing BGZF files
@@ -12,6 +12,9 @@
 #include "api/BamAux.h"
 #include "api/BamConstants.h"
 #include "api/internal/io/BamDeviceFactory_p.h"
+#include "api/internal/io/BamMappedFile_p.h"
+#include "api/internal/io/BgzfCompressor_p.h"
+#include "api/internal/io/BgzfDecompressor_p.h"
 #include "api/internal/io/BgzfStream_p.h"
 #include "api/internal/utils/BamException_p.h"
 using namespace BamTools;
@@ -36,8 +39,15 @@ BgzfStream::BgzfStream(void)
   , m_blockAddress(0)
   , m_isWriteCompressed(true)
   , m_device(0)
+  , m_mappedFile(0)
   , m_uncompressedBlock(Constants::BGZF_DEFAULT_BLOCK_SIZE)
   , m_compressedBlock(Constants::BGZF_MAX_BLOCK_SIZE)
+  , m_numThreads(1)
+  , m_compressor(0)
+  , m_decompressor(0)
+  , m_nextBlockAddress(0)
+  , m_isReadAheadDone(false)
+  , m_isAsyncIO(false)
 { }
 
 // destructor
@@ -46,7 +56,7 @@ BgzfStream::~BgzfStream(void) {
 }
 
 // checks BGZF block header
-bool BgzfStream::CheckBlockHeader(char* header) {
+bool BgzfStream::CheckBlockHeader(const char* header) {
     return (header[0] == Constants::GZIP_ID1 &&
             header[1] == Constants::GZIP_ID2 &&
             header[2] == Z_DEFLATED &&
@@ -63,18 +73,33 @@ void BgzfStream::Close(void) {
     // skip if no device open
     if ( m_device == 0 ) return;
 
-    // if writing to file, flush the current BGZF block,
-    // then write an empty block (as EOF marker)
+    // if writing to file, flush the current BGZF block (and any blocks still
+    // being compressed), then write an empty block (as EOF marker)
     if ( m_device->IsOpen() && (m_device->Mode() == IBamIODevice::WriteOnly) ) {
         FlushBlock();
+        if ( m_compressor ) {
+            while ( m_compressor->NumPending() > 0 )
+                WriteNextCompressedBlock();
+        }
         const size_t blockLength = DeflateBlock(0);
         m_device->Write(m_compressedBlock.Buffer, blockLength);
     }
 
+    // shut down compression/decompression threads
+    delete m_compressor;
+    m_compressor = 0;
+    m_compressedData.clear();
+    delete m_decompressor;
+    m_decompressor = 0;
+
+    // cached blocks are only valid for this file
+    m_blockCache.Clear();
+
     // close device
     m_device->Close();
     delete m_device;
     m_device = 0;
+    m_mappedFile = 0;
 
     // ensure our buffers are cleared out
     m_uncompressedBlock.Clear();
@@ -84,14 +109,99 @@ void BgzfStream::Close(void) {
     m_blockLength = 0;
     m_blockOffset = 0;
     m_blockAddress = 0;
+    m_nextBlockAddress = 0;
+    m_isReadAheadDone = false;
     m_isWriteCompressed = true;
 }
 
+// appends all remaining data of @source (open for reading, on a single thread)
+//
+// the rest of source's current block is re-compressed. output is then flushed up to a
+// block boundary, so that all following source blocks can be copied without being
+// decompressed at all. empty blocks (such as source's EOF marker) are dropped.
+void BgzfStream::CopyFrom(BgzfStream& source) {
+
+    BT_ASSERT_X( m_device, "BgzfStream::CopyFrom() - trying to write to null IO device");
+    BT_ASSERT_X( (m_device->Mode() == IBamIODevice::WriteOnly),
+                 "BgzfStream::CopyFrom() - trying to write to non-writable IO device");
+    BT_ASSERT_X( (source.m_numThreads == 1 && !source.m_blockCache.IsEnabled()),
+                 "BgzfStream::CopyFrom() - source blocks must be read straight from its device");
+
+    // skip if either file is not open
+    if ( !IsOpen() || !source.IsOpen() )
+        return;
+
+    // load source's current block, if only its position is known (e.g. after a seek)
+    if ( source.m_blockLength == 0 && source.m_blockOffset > 0 )
+        source.ReadBlock();
+
+    // re-compress the rest of it
+    if ( source.m_blockLength > source.m_blockOffset )
+        Write(source.m_uncompressedBlock.Buffer + source.m_blockOffset,
+              source.m_blockLength - source.m_blockOffset);
+
+    // flush output to a block boundary (including any blocks still being compressed)
+    FlushBlock();
+    if ( m_compressor ) {
+        while ( m_compressor->NumPending() > 0 )
+            WriteNextCompressedBlock();
+    }
+
+    // copy source's remaining blocks, skipping empty ones (uncompressed size stored in last 4 bytes)
+    int64_t blockAddress = 0;
+    const char* blockData = 0;
+    size_t blockLength = 0;
+    while ( source.ReadCompressedBlock(blockAddress, blockData, blockLength) ) {
+        if ( BamTools::UnpackUnsignedInt(blockData + blockLength - Constants::BAM_SIZEOF_INT) != 0 )
+            WriteCompressedData(blockData, blockLength);
+    }
+
+    // source is at EOF now
+    source.m_blockLength = 0;
+    source.m_blockOffset = 0;
+    source.m_blockAddress = source.m_device->Tell();
+    source.m_nextBlockAddress = source.m_blockAddress;
+}
+
 // compresses the current block
 size_t BgzfStream::DeflateBlock(int32_t blockLength) {
 
+    // set compression level
+    const int compressionLevel = ( m_isWriteCompressed ? Z_DEFAULT_COMPRESSION : 0 );
+
+    // compress as much of the block as will fit
+    int32_t inputLength = blockLength;
+    const size_t compressedLength = DeflateBlock(m_uncompressedBlock.Buffer,
+                                                 inputLength,
+                                                 m_compressedBlock.Buffer,
+                                                 compressionLevel);
+
+    // ensure that we have less than a block of data left
+    int remaining = blockLength - inputLength;
+    if ( remaining > 0 ) {
+        if ( remaining > inputLength )
+            throw BamException("BgzfStream::DeflateBlock", "after deflate, remainder too large");
+        memcpy(m_uncompressedBlock.Buffer, m_uncompressedBlock.Buffer + inputLength, remaining);
+    }
+
+    // update block data
+    m_blockOffset = remaining;
+
+    // return result
+    return compressedLength;
+}
+
+// compresses input into a single BGZF block in output (at least BGZF_MAX_BLOCK_SIZE bytes)
+//
+// inputLength is reduced if the input does not compress enough to fit into one block,
+// the caller is responsible for the remaining data
+size_t BgzfStream::DeflateBlock(const char* input,
+                                int32_t& inputLength,
+                                char* output,
+                                const int compressionLevel)
+{
     // initialize the gzip header
-    char* buffer = m_compressedBlock.Buffer;
+    char* buffer = output;
     memset(buffer, 0, 18);
     buffer[0]  = Constants::GZIP_ID1;
     buffer[1]  = Constants::GZIP_ID2;
@@ -103,11 +213,7 @@ size_t BgzfStream::DeflateBlock(int32_t blockLength) {
     buffer[13] = Constants::BGZF_ID2;
     buffer[14] = Constants::BGZF_LEN;
 
-    // set compression level
-    const int compressionLevel = ( m_isWriteCompressed ? Z_DEFAULT_COMPRESSION : 0 );
-
     // loop to retry for blocks that do not compress enough
-    int inputLength = blockLength;
     size_t compressedLength = 0;
     const unsigned int bufferSize = Constants::BGZF_MAX_BLOCK_SIZE;
 
@@ -117,7 +223,7 @@ size_t BgzfStream::DeflateBlock(int32_t blockLength) {
         z_stream zs;
         zs.zalloc    = NULL;
         zs.zfree     = NULL;
-        zs.next_in   = (Bytef*)m_uncompressedBlock.Buffer;
+        zs.next_in   = (Bytef*)input;
         zs.avail_in  = inputLength;
         zs.next_out  = (Bytef*)&buffer[Constants::BGZF_BLOCK_HEADER_LENGTH];
         zs.avail_out = bufferSize -
@@ -175,21 +281,10 @@ size_t BgzfStream::DeflateBlock(int32_t blockLength) {
 
     // store the CRC32 checksum
     uint32_t crc = crc32(0, NULL, 0);
-    crc = crc32(crc, (Bytef*)m_uncompressedBlock.Buffer, inputLength);
+    crc = crc32(crc, (Bytef*)input, inputLength);
     BamTools::PackUnsignedInt(&buffer[compressedLength - 8], crc);
     BamTools::PackUnsignedInt(&buffer[compressedLength - 4], inputLength);
 
-    // ensure that we have less than a block of data left
-    int remaining = blockLength - inputLength;
-    if ( remaining > 0 ) {
-        if ( remaining > inputLength )
-            throw BamException("BgzfStream::DeflateBlock", "after deflate, remainder too large");
-        memcpy(m_uncompressedBlock.Buffer, m_uncompressedBlock.Buffer + inputLength, remaining);
-    }
-
-    // update block data
-    m_blockOffset = remaining;
-
     // return result
     return compressedLength;
 }
@@ -199,6 +294,24 @@ void BgzfStream::FlushBlock(void) {
 
     BT_ASSERT_X( m_device, "BgzfStream::FlushBlock() - attempting to flush to null device" );
 
+    // start compression threads on first flush, if requested
+    if ( m_compressor == 0 && m_numThreads > 1 && m_blockOffset > 0 ) {
+        const int compressionLevel = ( m_isWriteCompressed ? Z_DEFAULT_COMPRESSION : 0 );
+        m_compressor = new BgzfCompressor(m_numThreads, compressionLevel);
+    }
+
+    // if compressing in parallel, hand off block & write any finished blocks (in order)
+    if ( m_compressor ) {
+        if ( m_blockOffset > 0 ) {
+            m_compressor->Compress(m_uncompressedBlock.Buffer, m_blockOffset);
+            m_blockOffset = 0;
+        }
+        const size_t maxPending = m_numThreads * 4;
+        while ( m_compressor->NumPending() >= maxPending || m_compressor->IsNextReady() )
+            WriteNextCompressedBlock();
+        return;
+    }
+
     // flush all of the remaining blocks
     while ( m_blockOffset > 0 ) {
 
@@ -206,37 +319,21 @@ void BgzfStream::FlushBlock(void) {
         const size_t blockLength = DeflateBlock(m_blockOffset);
 
         // flush the data to our output device
-        const int64_t numBytesWritten = m_device->Write(m_compressedBlock.Buffer, blockLength);
-
-        // check for device error
-        if ( numBytesWritten < 0 ) {
-            const string message = string("device error: ") + m_device->GetErrorString();
-            throw BamException("BgzfStream::FlushBlock", message);
-        }
-
-        // check that we wrote expected numBytes
-        if ( numBytesWritten != static_cast<int64_t>(blockLength) ) {
-            stringstream s("");
-            s << "expected to write " << blockLength
-              << " bytes during flushing, but wrote " << numBytesWritten;
-            throw BamException("BgzfStream::FlushBlock", s.str());
-        }
-
-        // update block data
-        m_blockAddress += blockLength;
+        WriteCompressedData(m_compressedBlock.Buffer, blockLength);
     }
 }
 
-// decompresses the current block
-size_t BgzfStream::InflateBlock(const size_t& blockLength) {
+// decompresses a complete BGZF block (header included) from input into output
+// (at least BGZF_DEFAULT_BLOCK_SIZE bytes), returns uncompressed length
+size_t BgzfStream::InflateBlock(const char* input, const size_t blockLength, char* output) {
 
     // setup zlib stream object
     z_stream zs;
     zs.zalloc    = NULL;
     zs.zfree     = NULL;
-    zs.next_in   = (Bytef*)m_compressedBlock.Buffer + 18;
+    zs.next_in   = (Bytef*)input + 18;
     zs.avail_in  = blockLength - 16;
-    zs.next_out  = (Bytef*)m_uncompressedBlock.Buffer;
+    zs.next_out  = (Bytef*)output;
     zs.avail_out = Constants::BGZF_DEFAULT_BLOCK_SIZE;
 
     // initialize
@@ -268,6 +365,16 @@ bool BgzfStream::IsOpen(void) const {
     return m_device->IsOpen();
 }
 
+// returns number of blocks read from decompressed block cache
+uint64_t BgzfStream::NumBlockCacheHits(void) const {
+    return m_blockCache.NumHits();
+}
+
+// returns number of blocks not found in decompressed block cache (& read from device)
+uint64_t BgzfStream::NumBlockCacheMisses(void) const {
+    return m_blockCache.NumMisses();
+}
+
 void BgzfStream::Open(const string& filename, const IBamIODevice::OpenMode mode) {
 
     // close current device if necessary
@@ -275,7 +382,7 @@ void BgzfStream::Open(const string& filename, const IBamIODevice::OpenMode mode)
     BT_ASSERT_X( (m_device == 0), "BgzfStream::Open() - unable to properly close previous IO device" );
 
     // retrieve new IO device depending on filename
-    m_device = BamDeviceFactory::CreateDevice(filename);
+    m_device = BamDeviceFactory::CreateDevice(filename, mode, m_isAsyncIO);
     BT_ASSERT_X( m_device, "BgzfStream::Open() - unable to create IO device from filename" );
 
     // if device fails to open
@@ -284,6 +391,9 @@ void BgzfStream::Open(const string& filename, const IBamIODevice::OpenMode mode)
         const string message = string("could not open BGZF stream: \n\t") + deviceError;
         throw BamException("BgzfStream::Open", message);
     }
+
+    // compressed blocks can be inflated straight from a mapped file
+    m_mappedFile = dynamic_cast<BamMappedFile*>(m_device);
 }
 
 // reads BGZF data into a byte buffer
@@ -325,7 +435,7 @@ size_t BgzfStream::Read(char* data, const size_t dataLength) {
 
     // update block data
     if ( m_blockOffset == m_blockLength ) {
-        m_blockAddress = m_device->Tell();
+        m_blockAddress = m_nextBlockAddress;
         m_blockOffset  = 0;
         m_blockLength  = 0;
     }
@@ -339,12 +449,91 @@ void BgzfStream::ReadBlock(void) {
 
     BT_ASSERT_X( m_device, "BgzfStream::ReadBlock() - trying to read from null IO device");
 
+    int64_t blockAddress = 0;
+    size_t newBlockLength = 0;
+
+    // if decompressing in parallel, keep the worker queue topped up with the blocks
+    // that follow, then take the next one (in file order)
+    if ( m_numThreads > 1 ) {
+        if ( m_decompressor == 0 )
+            m_decompressor = new BgzfDecompressor(m_numThreads);
+        const size_t maxPending = m_numThreads * 4;
+        const char* blockData = 0;
+        size_t blockLength = 0;
+        while ( !m_isReadAheadDone && m_decompressor->NumPending() < maxPending ) {
+            if ( !ReadCompressedBlock(blockAddress, blockData, blockLength) )
+                m_isReadAheadDone = true;
+            else
+                m_decompressor->Decompress(blockData, blockLength, blockAddress);
+        }
+        if ( m_decompressor->NumPending() == 0 ) {
+            m_blockLength = 0;
+            return;
+        }
+        newBlockLength = m_decompressor->TakeNext(m_uncompressedBlock.Buffer,
+                                                  blockAddress,
+                                                  m_nextBlockAddress);
+    }
+
+    // otherwise use cached copy of block, if available
+    else {
+        const bool isCaching = ( m_blockCache.IsEnabled() && m_device->IsRandomAccess() );
+        int64_t nextBlockAddress = 0;
+        if ( isCaching && m_blockCache.Find(m_nextBlockAddress,
+                                            m_uncompressedBlock.Buffer,
+                                            newBlockLength,
+                                            nextBlockAddress) )
+        {
+            blockAddress = m_nextBlockAddress;
+        }
+
+        // or read & decompress the block here
+        else {
+
+            // device lags behind if previous block(s) came from cache
+            if ( isCaching && m_device->Tell() != m_nextBlockAddress ) {
+                if ( !m_device->Seek(m_nextBlockAddress) )
+                    throw BamException("BgzfStream::ReadBlock", "unable to seek to next block");
+            }
+
+            const char* blockData = 0;
+            size_t blockLength = 0;
+            if ( !ReadCompressedBlock(blockAddress, blockData, blockLength) ) {
+                m_nextBlockAddress = m_device->Tell();
+                m_blockLength = 0;
+                return;
+            }
+            newBlockLength = InflateBlock(blockData, blockLength, m_uncompressedBlock.Buffer);
+            nextBlockAddress = blockAddress + blockLength;
+
+            if ( isCaching )
+                m_blockCache.Insert(blockAddress, m_uncompressedBlock.Buffer, newBlockLength, nextBlockAddress);
+        }
+        m_nextBlockAddress = nextBlockAddress;
+    }
+
+    // update block data
+    if ( m_blockLength != 0 )
+        m_blockOffset = 0;
+    m_blockAddress = blockAddress;
+    m_blockLength  = newBlockLength;
+}
+
+// reads the next complete (compressed) BGZF block from device, pointing blockData
+// at it (in m_compressedBlock, or in place if device is memory-mapped),
+// returns false if no more blocks are available
+bool BgzfStream::ReadCompressedBlock(int64_t& blockAddress, const char*& blockData, size_t& blockLength) {
+
     // store block's starting address
-    const int64_t blockAddress = m_device->Tell();
+    blockAddress = m_device->Tell();
 
     // read block header from file
-    char header[Constants::BGZF_BLOCK_HEADER_LENGTH];
-    int64_t numBytesRead = m_device->Read(header, Constants::BGZF_BLOCK_HEADER_LENGTH);
+    const char* header = m_compressedBlock.Buffer;
+    int64_t numBytesRead = 0;
+    if ( m_mappedFile )
+        numBytesRead = m_mappedFile->ReadInPlace(header, Constants::BGZF_BLOCK_HEADER_LENGTH);
+    else
+        numBytesRead = m_device->Read(m_compressedBlock.Buffer, Constants::BGZF_BLOCK_HEADER_LENGTH);
 
     // check for device error
     if ( numBytesRead < 0 ) {
@@ -353,10 +542,8 @@ void BgzfStream::ReadBlock(void) {
     }
 
     // if block header empty
-    if ( numBytesRead == 0 ) {
-        m_blockLength = 0;
-        return;
-    }
+    if ( numBytesRead == 0 )
+        return false;
 
     // if block header invalid size
     if ( numBytesRead != static_cast<int8_t>(Constants::BGZF_BLOCK_HEADER_LENGTH) )
@@ -365,14 +552,16 @@ void BgzfStream::ReadBlock(void) {
     // validate block header contents
     if ( !BgzfStream::CheckBlockHeader(header) )
         throw BamException("BgzfStream::ReadBlock", "invalid block header contents");
+    blockLength = BamTools::UnpackUnsignedShort(&header[16]) + 1;
+    blockData = header;
 
-    // copy header contents to compressed buffer
-    const size_t blockLength = BamTools::UnpackUnsignedShort(&header[16]) + 1;
-    memcpy(m_compressedBlock.Buffer, header, Constants::BGZF_BLOCK_HEADER_LENGTH);
-
-    // read remainder of block
+    // read remainder of block (mapped data follows header contiguously)
     const size_t remaining = blockLength - Constants::BGZF_BLOCK_HEADER_LENGTH;
-    numBytesRead = m_device->Read(&m_compressedBlock.Buffer[Constants::BGZF_BLOCK_HEADER_LENGTH], remaining);
+    if ( m_mappedFile ) {
+        const char* remainder = 0;
+        numBytesRead = m_mappedFile->ReadInPlace(remainder, remaining);
+    } else
+        numBytesRead = m_device->Read(&m_compressedBlock.Buffer[Constants::BGZF_BLOCK_HEADER_LENGTH], remaining);
 
     // check for device error
     if ( numBytesRead < 0 ) {
@@ -384,14 +573,7 @@ void BgzfStream::ReadBlock(void) {
     if ( numBytesRead != static_cast<int64_t>(remaining) )
         throw BamException("BgzfStream::ReadBlock", "could not read data from block");
 
-    // decompress block data
-    const size_t newBlockLength = InflateBlock(blockLength);
-
-    // update block data
-    if ( m_blockLength != 0 )
-        m_blockOffset = 0;
-    m_blockAddress = blockAddress;
-    m_blockLength  = newBlockLength;
+    return true;
 }
 
 // seek to position in BGZF file
@@ -406,11 +588,23 @@ void BgzfStream::Seek(const int64_t& position) {
     int     blockOffset  = (position & 0xFFFF);
     int64_t blockAddress = (position >> 16) & 0xFFFFFFFFFFFFLL;
 
+    // if position is within currently loaded block, no need to re-read it
+    if ( m_blockLength > 0 && blockAddress == m_blockAddress && blockOffset <= m_blockLength ) {
+        m_blockOffset = blockOffset;
+        return;
+    }
+
     // attempt seek in file
     if ( m_device->IsRandomAccess() && m_device->Seek(blockAddress) ) {
 
+        // drop any blocks read ahead of the old position
+        if ( m_decompressor )
+            m_decompressor->Clear();
+        m_isReadAheadDone = false;
+
         // update block data & return success
         m_blockLength  = 0;
+        m_nextBlockAddress = blockAddress;
         m_blockAddress = blockAddress;
         m_blockOffset  = blockOffset;
     }
@@ -421,10 +615,76 @@ void BgzfStream::Seek(const int64_t& position) {
     }
 }
 
+// enables/disables asynchronous reads for local files opened afterwards
+//
+// while enabled, several reads ahead of the current position are kept in flight (through
+// io_uring, if available) - shared by all open files, so that the storage device is kept busy
+void BgzfStream::SetAsyncIO(bool ok) {
+    m_isAsyncIO = ok;
+}
+
+// sets maximum size (bytes) of decompressed block cache, 0 disables cache
+//
+// while enabled, decompressed blocks are kept (least-recently-used are dropped first)
+// so that reading them again after a seek - e.g. for adjacent or overlapping regions -
+// needs no device read or decompression. only used when reading on a single thread
+// from a random-access device.
+void BgzfStream::SetBlockCacheSize(const size_t cacheSize) {
+    m_blockCache.SetMaxSize(cacheSize);
+}
+
+// sets number of threads used to compress output (or decompress input) blocks
+void BgzfStream::SetNumThreads(const unsigned int numThreads) {
+    m_numThreads = ( numThreads == 0 ? 1 : numThreads );
+}
+
 void BgzfStream::SetWriteCompressed(bool ok) {
     m_isWriteCompressed = ok;
 }
 
+// skips over BGZF data, without copying it out
+size_t BgzfStream::Skip(const size_t dataLength) {
+
+    if ( dataLength == 0 )
+        return 0;
+
+    // if stream not open for reading
+    BT_ASSERT_X( m_device, "BgzfStream::Skip() - trying to read from null device");
+    if ( !m_device->IsOpen() || (m_device->Mode() != IBamIODevice::ReadOnly) )
+        return 0;
+
+    // read blocks as needed until desired data length is passed
+    size_t numBytesSkipped = 0;
+    while ( numBytesSkipped < dataLength ) {
+
+        // determine bytes available in current block
+        int bytesAvailable = m_blockLength - m_blockOffset;
+
+        // read (and decompress) next block if needed
+        if ( bytesAvailable <= 0 ) {
+            ReadBlock();
+            bytesAvailable = m_blockLength - m_blockOffset;
+            if ( bytesAvailable <= 0 )
+                break;
+        }
+
+        // update counters
+        const size_t skipLength = min( (dataLength-numBytesSkipped), (size_t)bytesAvailable );
+        m_blockOffset   += skipLength;
+        numBytesSkipped += skipLength;
+    }
+
+    // update block data
+    if ( m_blockOffset == m_blockLength ) {
+        m_blockAddress = m_nextBlockAddress;
+        m_blockOffset  = 0;
+        m_blockLength  = 0;
+    }
+
+    // return actual number of bytes skipped
+    return numBytesSkipped;
+}
+
 // get file position in BGZF file
 int64_t BgzfStream::Tell(void) const {
     if ( !IsOpen() )
@@ -467,3 +727,33 @@ size_t BgzfStream::Write(const char* data, const size_t dataLength) {
     // return actual number of bytes written
     return numBytesWritten;
 }
+
+// writes compressed data to device
+void BgzfStream::WriteCompressedData(const char* data, const size_t dataLength) {
+
+    // flush the data to our output device
+    const int64_t numBytesWritten = m_device->Write(data, dataLength);
+
+    // check for device error
+    if ( numBytesWritten < 0 ) {
+        const string message = string("device error: ") + m_device->GetErrorString();
+        throw BamException("BgzfStream::FlushBlock", message);
+    }
+
+    // check that we wrote expected numBytes
+    if ( numBytesWritten != static_cast<int64_t>(dataLength) ) {
+        stringstream s("");
+        s << "expected to write " << dataLength
+          << " bytes during flushing, but wrote " << numBytesWritten;
+        throw BamException("BgzfStream::FlushBlock", s.str());
+    }
+
+    // update block data
+    m_blockAddress += dataLength;
+}
+
+// writes the oldest block queued for parallel compression
+void BgzfStream::WriteNextCompressedBlock(void) {
+    m_compressor->TakeNext(m_compressedData);
+    WriteCompressedData(m_compressedData.data(), m_compressedData.size());
+}
@@ -25,11 +25,16 @@
 #include "api/api_global.h"
 #include "api/BamAux.h"
 #include "api/IBamIODevice.h"
+#include "api/internal/io/BgzfBlockCache_p.h"
 #include <string>
 
 namespace BamTools {
 namespace Internal {
 
+class BamMappedFile;
+class BgzfCompressor;
+class BgzfDecompressor;
+
 class BgzfStream {
 
     // constructor & destructor
@@ -41,18 +46,31 @@ class BgzfStream {
     public:
         // closes BGZF file
         void Close(void);
+        // appends all remaining data of source stream, copying its compressed blocks as they are
+        void CopyFrom(BgzfStream& source);
         // returns true if BgzfStream open for IO
         bool IsOpen(void) const;
+        // returns number of blocks read from (or not found in) decompressed block cache
+        uint64_t NumBlockCacheHits(void) const;
+        uint64_t NumBlockCacheMisses(void) const;
         // opens the BGZF file
         void Open(const std::string& filename, const IBamIODevice::OpenMode mode);
         // reads BGZF data into a byte buffer
         size_t Read(char* data, const size_t dataLength);
         // seek to position in BGZF file
         void Seek(const int64_t& position);
+        // enables/disables asynchronous reads for local files opened afterwards
+        void SetAsyncIO(bool ok);
+        // sets maximum size (bytes) of decompressed block cache, 0 disables cache
+        void SetBlockCacheSize(const size_t cacheSize);
         // sets IO device (closes previous, if any, but does not attempt to open)
         void SetIODevice(IBamIODevice* device);
+        // sets number of threads used to compress output (or decompress input) blocks
+        void SetNumThreads(const unsigned int numThreads);
         // enable/disable compressed output
         void SetWriteCompressed(bool ok);
+        // skips over BGZF data, without copying it out
+        size_t Skip(const size_t dataLength);
         // get file position in BGZF file
         int64_t Tell(void) const;
         // writes the supplied data into the BGZF buffer
@@ -64,15 +82,27 @@ class BgzfStream {
         size_t DeflateBlock(int32_t blockLength);
         // flushes the data in the BGZF block
         void FlushBlock(void);
-        // de-compresses the current block
-        size_t InflateBlock(const size_t& blockLength);
         // reads a BGZF block
         void ReadBlock(void);
+        // reads a BGZF block from device, without decompressing it
+        bool ReadCompressedBlock(int64_t& blockAddress, const char*& blockData, size_t& blockLength);
+        // writes compressed data to device
+        void WriteCompressedData(const char* data, const size_t dataLength);
+        // writes the oldest block queued for parallel compression
+        void WriteNextCompressedBlock(void);
 
     // static 'utility' methods
     public:
         // checks BGZF block header
-        static bool CheckBlockHeader(char* header);
+        static bool CheckBlockHeader(const char* header);
+        // compresses input into a single BGZF block in output, returns compressed length
+        // (inputLength is reduced if input does not fit into one block)
+        static size_t DeflateBlock(const char* input,
+                                   int32_t& inputLength,
+                                   char* output,
+                                   const int compressionLevel);
+        // decompresses a complete BGZF block from input into output, returns uncompressed length
+        static size_t InflateBlock(const char* input, const size_t blockLength, char* output);
 
     // data members
     public:
@@ -82,9 +112,21 @@ class BgzfStream {
 
         bool m_isWriteCompressed;
         IBamIODevice* m_device;
+        BamMappedFile* m_mappedFile;    // same as m_device, if that is a memory-mapped file
 
         RaiiBuffer m_uncompressedBlock;
         RaiiBuffer m_compressedBlock;
+
+        unsigned int m_numThreads;
+        BgzfCompressor* m_compressor;
+        std::string m_compressedData;
+
+        BgzfDecompressor* m_decompressor;
+        int64_t m_nextBlockAddress;
+        bool m_isReadAheadDone;
+        bool m_isAsyncIO;
+
+        BgzfBlockCache m_blockCache;
 };
 
 } // namespace Internal
@@ -0,0 +1,345 @@
+// ***************************************************************************
+// HttpRangeFetcher_p.cpp (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides a pool of worker threads, each with its own HTTP connection, that
+// download byte ranges of a remote file concurrently & hand them back in the
+// order they were requested
+// ***************************************************************************
+
+#include "api/BamAux.h"
+#include "api/internal/io/HttpHeader_p.h"
+#include "api/internal/io/HttpRangeFetcher_p.h"
+#include "api/internal/io/TcpSocket_p.h"
+using namespace BamTools;
+using namespace BamTools::Internal;
+
+#include <cstdlib>
+#include <algorithm>
+#include <sstream>
+using namespace std;
+
+namespace BamTools {
+namespace Internal {
+
+// -----------
+// constants
+// -----------
+
+static const string HTTP_PORT = "80";
+
+static const string DOUBLE_NEWLINE = "\n\n";
+
+static const string GET_METHOD   = "GET";
+static const string HOST_HEADER  = "Host";
+static const string RANGE_HEADER = "Range";
+static const string BYTES_PREFIX = "bytes=";
+
+static const string CONNECTION_HEADER     = "Connection";
+static const string CONTENT_LENGTH_HEADER = "Content-Length";
+static const string CLOSE_VALUE           = "close";
+static const string KEEP_ALIVE_VALUE      = "keep-alive";
+
+static const char PROXY_SEPARATOR = ':';
+
+// body is read in pieces of (at most) this size, checking for cancellation in between
+static const unsigned int HTTP_READ_PIECE_SIZE = 0x10000;
+
+// -----------------
+// utility methods
+// -----------------
+
+static inline
+bool endsWith(const string& source, const string& pattern) {
+    if ( source.length() < pattern.length() )
+        return false;
+    return ( source.compare(source.length() - pattern.length(), pattern.length(), pattern) == 0 );
+}
+
+static inline
+string toLower(const string& s) {
+    string out(s);
+    const size_t sSize = s.size();
+    for ( size_t i = 0; i < sSize; ++i )
+        out[i] = tolower(s[i]);
+    return out;
+}
+
+// header field names are case-insensitive, check the usual spellings
+static inline
+string fieldValue(HttpResponseHeader& response, const string& key) {
+    if ( response.ContainsKey(key) )
+        return response.GetValue(key);
+    return response.GetValue( toLower(key) );
+}
+
+} // namespace Internal
+} // namespace BamTools
+
+// ---------------------------------
+// HttpRangeFetcher implementation
+// ---------------------------------
+
+HttpRangeFetcher::HttpRangeFetcher(const string& hostname,
+                                   const string& port,
+                                   const string& filename,
+                                   const unsigned int numConnections)
+    : m_hostname(hostname)
+    , m_port(port)
+    , m_filename(filename)
+    , m_isStopping(false)
+{
+    for ( unsigned int i = 0; i < numConnections; ++i ) {
+        Worker* worker = new Worker(this);
+        if ( !worker->Start() ) {
+            delete worker;
+            break;
+        }
+        m_workers.push_back(worker);
+    }
+}
+
+HttpRangeFetcher::~HttpRangeFetcher(void) {
+
+    // drop remaining jobs
+    Clear();
+
+    // signal workers to quit & wait for them
+    m_mutex.Lock();
+    m_isStopping = true;
+    m_jobQueued.WakeAll();
+    m_mutex.Unlock();
+
+    vector<Worker*>::iterator workerIter = m_workers.begin();
+    vector<Worker*>::iterator workerEnd  = m_workers.end();
+    for ( ; workerIter != workerEnd; ++workerIter ) {
+        (*workerIter)->Wait();
+        delete (*workerIter);
+    }
+    m_workers.clear();
+}
+
+// discards all requested ranges (downloads in progress are abandoned, not waited for)
+void HttpRangeFetcher::Clear(void) {
+
+    BamMutexLocker locker(m_mutex);
+
+    // flag all jobs as unwanted
+    deque<Job*>::iterator pendingIter = m_pending.begin();
+    deque<Job*>::iterator pendingEnd  = m_pending.end();
+    for ( ; pendingIter != pendingEnd; ++pendingIter )
+        (*pendingIter)->IsCancelled = true;
+
+    // jobs still waiting for a worker, or already finished, can be deleted now
+    // jobs being downloaded will be deleted by their worker, once it notices
+    pendingIter = m_pending.begin();
+    for ( ; pendingIter != pendingEnd; ++pendingIter ) {
+        Job* job = (*pendingIter);
+        if ( job->IsDone || find(m_queued.begin(), m_queued.end(), job) != m_queued.end() )
+            delete job;
+    }
+    m_queued.clear();
+    m_pending.clear();
+}
+
+// queues download of [position, position+length)
+void HttpRangeFetcher::Fetch(const int64_t& position, const size_t length) {
+
+    BT_ASSERT_X( !m_workers.empty(), "HttpRangeFetcher::Fetch() - no connections available" );
+
+    Job* job = new Job;
+    job->Position = position;
+    job->Length = length;
+    job->IsOk = false;
+    job->IsDone = false;
+    job->IsCancelled = false;
+
+    BamMutexLocker locker(m_mutex);
+    m_pending.push_back(job);
+    m_queued.push_back(job);
+    m_jobQueued.WakeOne();
+}
+
+// returns true if caller no longer wants job's data
+bool HttpRangeFetcher::IsCancelled(Job* job) {
+    BamMutexLocker locker(m_mutex);
+    return job->IsCancelled;
+}
+
+// returns number of connections actually available
+size_t HttpRangeFetcher::NumConnections(void) const {
+    return m_workers.size();
+}
+
+// returns number of requested ranges not yet taken
+size_t HttpRangeFetcher::NumPending(void) const {
+    return m_pending.size();
+}
+
+// returns file position just past the last requested range (-1 if none pending)
+int64_t HttpRangeFetcher::PendingEnd(void) const {
+    if ( m_pending.empty() )
+        return -1;
+    const Job* job = m_pending.back();
+    return job->Position + job->Length;
+}
+
+// returns file position of the oldest requested range (-1 if none pending)
+int64_t HttpRangeFetcher::PendingStart(void) const {
+    if ( m_pending.empty() )
+        return -1;
+    return m_pending.front()->Position;
+}
+
+// worker thread loop - downloads queued ranges until stopped
+void HttpRangeFetcher::RunWorker(Worker* worker) {
+
+    while ( true ) {
+
+        // wait for job
+        m_mutex.Lock();
+        while ( m_queued.empty() && !m_isStopping )
+            m_jobQueued.Wait(m_mutex);
+        if ( m_queued.empty() ) {
+            m_mutex.Unlock();
+            return;
+        }
+        Job* job = m_queued.front();
+        m_queued.pop_front();
+        m_mutex.Unlock();
+
+        // download outside of lock (job is not touched by caller until marked done)
+        const bool ok = worker->DownloadJob(job);
+
+        // hand back result, or clean up if nobody wants it anymore
+        m_mutex.Lock();
+        if ( job->IsCancelled )
+            delete job;
+        else {
+            job->IsOk = ok;
+            job->IsDone = true;
+            m_jobDone.WakeAll();
+        }
+        m_mutex.Unlock();
+    }
+}
+
+// waits for the oldest requested range, appends its data to output
+// returns false if it could not be downloaded (range is discarded either way)
+bool HttpRangeFetcher::TakeNext(RollingBuffer& output) {
+
+    BT_ASSERT_X( !m_pending.empty(), "HttpRangeFetcher::TakeNext() - no ranges pending" );
+
+    Job* job = m_pending.front();
+    m_mutex.Lock();
+    while ( !job->IsDone )
+        m_jobDone.Wait(m_mutex);
+    m_pending.pop_front();
+    m_mutex.Unlock();
+
+    const bool ok = job->IsOk;
+    if ( ok )
+        output.Write(job->Data.data(), job->Data.size());
+    delete job;
+    return ok;
+}
+
+// ---------------------------------------
+// HttpRangeFetcher::Worker implementation
+// ---------------------------------------
+
+HttpRangeFetcher::Worker::Worker(HttpRangeFetcher* fetcher)
+    : m_fetcher(fetcher)
+    , m_socket(new TcpSocket)
+{ }
+
+HttpRangeFetcher::Worker::~Worker(void) {
+    m_socket->DisconnectFromHost();
+    delete m_socket;
+}
+
+// requests job's range on this worker's (kept-alive) connection & receives its data
+bool HttpRangeFetcher::Worker::DownloadJob(Job* job) {
+
+    // if that fails, the server may have dropped the connection while idle, so retry once on a new one
+    if ( SendRequest(job) && ReceiveResponse(job) )
+        return true;
+    m_socket->DisconnectFromHost();
+    if ( m_fetcher->IsCancelled(job) )
+        return false;
+    if ( SendRequest(job) && ReceiveResponse(job) )
+        return true;
+    m_socket->DisconnectFromHost();
+    return false;
+}
+
+bool HttpRangeFetcher::Worker::ReceiveResponse(Job* job) {
+
+    // fetch header, up until double new line
+    string responseHeader;
+    do {
+        const string headerLine = m_socket->ReadLine();
+        if ( headerLine.empty() )
+            return false;
+        responseHeader += headerLine;
+    } while ( !endsWith(responseHeader, DOUBLE_NEWLINE) );
+
+    // only accept exactly the range requested
+    HttpResponseHeader response(responseHeader);
+    if ( !response.IsValid() || response.GetStatusCode() != 206 )
+        return false;
+    const string contentLength = fieldValue(response, CONTENT_LENGTH_HEADER);
+    if ( contentLength.empty() || atoll(contentLength.c_str()) != static_cast<int64_t>(job->Length) )
+        return false;
+
+    // read body, giving up early if caller no longer wants it
+    job->Data.resize(job->Length);
+    size_t numBytesRead = 0;
+    while ( numBytesRead < job->Length ) {
+        if ( m_fetcher->IsCancelled(job) )
+            return false;
+        const unsigned int maxBytes = static_cast<unsigned int>( min(job->Length - numBytesRead,
+                                                                     static_cast<size_t>(HTTP_READ_PIECE_SIZE)) );
+        const int64_t socketBytesRead = m_socket->Read(&job->Data[numBytesRead], maxBytes);
+        if ( socketBytesRead <= 0 ) // error or EOF
+            return false;
+        numBytesRead += static_cast<size_t>(socketBytesRead);
+    }
+
+    // server won't accept any more requests on this connection
+    if ( toLower(fieldValue(response, CONNECTION_HEADER)) == CLOSE_VALUE )
+        m_socket->DisconnectFromHost();
+    return true;
+}
+
+bool HttpRangeFetcher::Worker::SendRequest(Job* job) {
+
+    // make sure we're connected
+    if ( !m_socket->IsConnected() ) {
+        if ( !m_socket->ConnectToHost(m_fetcher->m_hostname, m_fetcher->m_port, IBamIODevice::ReadOnly) )
+            return false;
+    }
+
+    // create range string (last byte position is inclusive)
+    stringstream range("");
+    range << BYTES_PREFIX << job->Position << '-' << ( job->Position + job->Length - 1 );
+
+    // create host string
+    const string& hostname = m_fetcher->m_hostname;
+    const string& port     = m_fetcher->m_port;
+    const string host = ( port == HTTP_PORT ? hostname : hostname + PROXY_SEPARATOR + port );
+
+    // create request
+    HttpRequestHeader request(GET_METHOD, m_fetcher->m_filename);
+    request.SetField(HOST_HEADER,  host);
+    request.SetField(RANGE_HEADER, range.str());
+    request.SetField(CONNECTION_HEADER, KEEP_ALIVE_VALUE);
+
+    // write request to socket
+    const string requestHeader = request.ToString();
+    const size_t headerSize    = requestHeader.size();
+    m_socket->ClearBuffer();
+    return ( m_socket->Write(requestHeader.c_str(), headerSize) == static_cast<int64_t>(headerSize) );
+}
@@ -0,0 +1,116 @@
+// ***************************************************************************
+// HttpRangeFetcher_p.h (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides a pool of worker threads, each with its own HTTP connection, that
+// download byte ranges of a remote file concurrently & hand them back in the
+// order they were requested
+// ***************************************************************************
+
+#ifndef HTTPRANGEFETCHER_P_H
+#define HTTPRANGEFETCHER_P_H
+
+//  -------------
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the BamTools API.  It exists purely as an
+// implementation detail. This header file may change from version to version
+// without notice, or even be removed.
+//
+// We mean it.
+
+#include "api/api_global.h"
+#include "api/internal/io/RollingBuffer_p.h"
+#include "shared/bamtools_thread.h"
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace BamTools {
+namespace Internal {
+
+class TcpSocket;
+
+class HttpRangeFetcher {
+
+    // ctor & dtor
+    public:
+        HttpRangeFetcher(const std::string& hostname,
+                         const std::string& port,
+                         const std::string& filename,
+                         const unsigned int numConnections);
+        ~HttpRangeFetcher(void);
+
+    // HttpRangeFetcher interface
+    public:
+        // discards all requested ranges (downloads in progress are abandoned, not waited for)
+        void Clear(void);
+        // queues download of [position, position+length)
+        void Fetch(const int64_t& position, const size_t length);
+        // returns number of connections actually available
+        size_t NumConnections(void) const;
+        // returns number of requested ranges not yet taken
+        size_t NumPending(void) const;
+        // returns file position just past the last requested range (-1 if none pending)
+        int64_t PendingEnd(void) const;
+        // returns file position of the oldest requested range (-1 if none pending)
+        int64_t PendingStart(void) const;
+        // waits for the oldest requested range, appends its data to output
+        // returns false if it could not be downloaded (range is discarded either way)
+        bool TakeNext(RollingBuffer& output);
+
+    // internal types
+    private:
+        struct Job {
+            int64_t Position;
+            size_t Length;
+            std::string Data;
+            bool IsOk;
+            bool IsDone;
+            bool IsCancelled;
+        };
+
+        class Worker : public BamThread {
+            public:
+                explicit Worker(HttpRangeFetcher* fetcher);
+                ~Worker(void);
+            public:
+                bool DownloadJob(Job* job);
+            protected:
+                void Run(void) { m_fetcher->RunWorker(this); }
+            private:
+                bool SendRequest(Job* job);
+                bool ReceiveResponse(Job* job);
+            private:
+                HttpRangeFetcher* m_fetcher;
+                TcpSocket* m_socket;
+        };
+
+    // internal methods
+    private:
+        bool IsCancelled(Job* job);
+        void RunWorker(Worker* worker);
+
+    // data members
+    private:
+        std::string m_hostname;
+        std::string m_port;
+        std::string m_filename;
+
+        bool m_isStopping;
+        std::vector<Worker*> m_workers;
+        std::deque<Job*> m_queued;   // jobs waiting for a worker
+        std::deque<Job*> m_pending;  // all jobs not yet taken (request order)
+
+        BamMutex m_mutex;
+        BamWaitCondition m_jobQueued;
+        BamWaitCondition m_jobDone;
+};
+
+} // namespace Internal
+} // namespace BamTools
+
+#endif // HTTPRANGEFETCHER_P_H
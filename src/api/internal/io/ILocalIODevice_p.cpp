@@ -2,7 +2,7 @@
 // ILocalIODevice_p.cpp (c) 2011 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 27 July 2012 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Provides shared behavior for files & pipes
 // ***************************************************************************
@@ -38,6 +38,17 @@ void ILocalIODevice::Close(void) {
     m_mode = IBamIODevice::NotOpen;
 }
 
+// reads next byte into @c without consuming it, returns false at EOF
+bool ILocalIODevice::Peek(char& c) {
+    BT_ASSERT_X( m_stream, "ILocalIODevice::Peek: trying to read from null stream" );
+    const int result = fgetc(m_stream);
+    if ( result == EOF )
+        return false;
+    ungetc(result, m_stream);
+    c = static_cast<char>(result);
+    return true;
+}
+
 int64_t ILocalIODevice::Read(char* data, const unsigned int numBytes) {
     BT_ASSERT_X( m_stream, "ILocalIODevice::Read: trying to read from null stream" );
     BT_ASSERT_X( (m_mode & IBamIODevice::ReadOnly), "ILocalIODevice::Read: device not in read-able mode");
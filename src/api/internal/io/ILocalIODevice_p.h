@@ -2,7 +2,7 @@
 // ILocalIODevice_p.h (c) 2011 Derek Barnett
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 10 October 2011 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Provides shared behavior for files & pipes
 // ***************************************************************************
@@ -39,6 +39,11 @@ class ILocalIODevice : public IBamIODevice {
         virtual int64_t Tell(void) const;
         virtual int64_t Write(const char* data, const unsigned int numBytes);
 
+    // ILocalIODevice interface
+    public:
+        // reads next byte into @c without consuming it, returns false at EOF
+        bool Peek(char& c);
+
     // data members
     protected:
         FILE* m_stream;
@@ -306,6 +306,10 @@ int64_t TcpSocket::ReadFromSocket(void) {
         m_errorString = "TcpSocket::ReadFromSocket - encountered error while reading bytes";
     }
 
+    // drop any reserved space that wasn't filled
+    if ( numBytesRead < bytesToRead )
+        m_readBuffer.Chop( static_cast<size_t>(bytesToRead - std::max(numBytesRead, (int64_t)0)) );
+
     // return number of bytes actually read
     return numBytesRead;
 }
@@ -395,7 +399,7 @@ bool TcpSocket::WaitForReadLine(void) {
 
     // wait until we can read a line (will return immediately if already capable)
     while ( !CanReadLine() ) {
-        if ( !ReadFromSocket() )
+        if ( ReadFromSocket() <= 0 )
             return false;
     }
 
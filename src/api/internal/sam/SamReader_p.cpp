@@ -0,0 +1,867 @@
+// ***************************************************************************
+// SamReader_p.cpp (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides functionality for reading SAM text input, converting each
+// alignment line into a raw BAM record
+// ***************************************************************************
+
+#include "api/BamConstants.h"
+#include "api/IBamIODevice.h"
+#include "api/SamHeader.h"
+#include "api/internal/sam/SamReader_p.h"
+#include "api/internal/utils/BamException_p.h"
+#include "shared/bamtools_raw_record.h"
+using namespace BamTools;
+using namespace BamTools::Internal;
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+using namespace std;
+
+namespace BamTools {
+namespace Internal {
+
+// -----------
+// constants
+// -----------
+
+// device data is read in blocks of this size
+static const size_t SAM_READ_SIZE = 0x100000; // 1 MB
+
+// lines are parsed in chunks of (roughly) this much text
+static const size_t SAM_CHUNK_SIZE = 0x100000; // 1 MB
+
+// number of chunks kept ahead of the caller, per parsing thread
+static const size_t SAM_CHUNKS_PER_THREAD = 2;
+
+// malformed lines are quoted in error messages up to this length
+static const size_t SAM_MAX_QUOTED_LENGTH = 100;
+
+static const char SAM_HEADER_PREFIX = '@';
+static const char SAM_FIELD_SEPARATOR = '\t';
+static const char SAM_ARRAY_SEPARATOR = ',';
+static const char SAM_TAG_SEPARATOR = ':';
+static const char SAM_NULL_FIELD = '*';
+static const char SAM_SAME_REFERENCE = '=';
+static const char SAM_QUALITY_OFFSET = 33;
+static const size_t SAM_MAX_NAME_LENGTH = 254;
+
+// maps SAM sequence characters to their 4-bit BAM code (0xff if invalid)
+struct SequenceCodeTable {
+    unsigned char Codes[256];
+    SequenceCodeTable(void) {
+        memset(Codes, 0xff, sizeof(Codes));
+        for ( unsigned char i = 0; i < 16; ++i ) {
+            const unsigned char base = Constants::BAM_DNA_LOOKUP[i];
+            Codes[base] = i;
+            Codes[static_cast<unsigned char>(tolower(base))] = i;
+        }
+    }
+};
+static const SequenceCodeTable SEQUENCE_CODES;
+
+// -----------------
+// utility methods
+// -----------------
+
+// calculates minimum bin for a BAM alignment interval [begin, end)
+// (same as BamWriter, so records match those written from a BamAlignment)
+static inline
+uint32_t calculateMinimumBin(const int begin, int end) {
+    --end;
+    if ( (begin >> 14) == (end >> 14) ) return 4681 + (begin >> 14);
+    if ( (begin >> 17) == (end >> 17) ) return  585 + (begin >> 17);
+    if ( (begin >> 20) == (end >> 20) ) return   73 + (begin >> 20);
+    if ( (begin >> 23) == (end >> 23) ) return    9 + (begin >> 23);
+    if ( (begin >> 26) == (end >> 26) ) return    1 + (begin >> 26);
+    return 0;
+}
+
+// stores little-endian values, independent of host byte order
+static inline
+void storeUInt16(char* data, const uint16_t value) {
+    data[0] = static_cast<char>(value & 0xff);
+    data[1] = static_cast<char>(value >> 8);
+}
+
+static inline
+void storeUInt32(char* data, const uint32_t value) {
+    data[0] = static_cast<char>(value & 0xff);
+    data[1] = static_cast<char>((value >> 8) & 0xff);
+    data[2] = static_cast<char>((value >> 16) & 0xff);
+    data[3] = static_cast<char>(value >> 24);
+}
+
+static inline
+void appendUInt32(string& data, const uint32_t value) {
+    char buffer[Constants::BAM_SIZEOF_INT];
+    storeUInt32(buffer, value);
+    data.append(buffer, Constants::BAM_SIZEOF_INT);
+}
+
+// splits next field off [p, end), returns false if there are no fields left
+static inline
+bool nextField(const char*& p, const char* end, const char*& fieldBegin, const char*& fieldEnd) {
+    if ( p > end )
+        return false;
+    fieldBegin = p;
+    fieldEnd = static_cast<const char*>( memchr(p, SAM_FIELD_SEPARATOR, end - p) );
+    if ( fieldEnd == 0 )
+        fieldEnd = end;
+    p = fieldEnd + 1;
+    return true;
+}
+
+// parses (optionally signed) decimal integer at p, leaves p just after its digits
+static inline
+bool parseInteger(const char*& p, const char* end, int64_t& value) {
+    bool isNegative = false;
+    if ( p != end && (*p == '-' || *p == '+') ) {
+        isNegative = ( *p == '-' );
+        ++p;
+    }
+    const char* digitsBegin = p;
+    uint64_t result = 0;
+    while ( p != end && *p >= '0' && *p <= '9' && p - digitsBegin < 18 ) {
+        result = result*10 + static_cast<uint64_t>(*p - '0');
+        ++p;
+    }
+    if ( p == digitsBegin )
+        return false;
+    value = ( isNegative ? -static_cast<int64_t>(result) : static_cast<int64_t>(result) );
+    return true;
+}
+
+// parses field [begin, end) as integer in [minimum, maximum]
+static inline
+bool parseIntegerField(const char* begin, const char* end,
+                       const int64_t& minimum, const int64_t& maximum, int64_t& value)
+{
+    return ( parseInteger(begin, end, value) && begin == end &&
+             value >= minimum && value <= maximum );
+}
+
+// parses floating-point value at p (text must be followed by a non-numeric character)
+static inline
+bool parseFloat(const char*& p, float& value) {
+    char* numberEnd = 0;
+    value = static_cast<float>( strtod(p, &numberEnd) );
+    if ( numberEnd == p )
+        return false;
+    p = numberEnd;
+    return true;
+}
+
+// returns true if value fits in BAM tag type
+static inline
+bool fitsTagType(const char type, const int64_t& value) {
+    switch ( type ) {
+        case ( Constants::BAM_TAG_TYPE_INT8 )   : return ( value >= -128 && value <= 127 );
+        case ( Constants::BAM_TAG_TYPE_UINT8 )  : return ( value >= 0 && value <= 255 );
+        case ( Constants::BAM_TAG_TYPE_INT16 )  : return ( value >= -32768 && value <= 32767 );
+        case ( Constants::BAM_TAG_TYPE_UINT16 ) : return ( value >= 0 && value <= 65535 );
+        case ( Constants::BAM_TAG_TYPE_INT32 )  : return ( value >= -2147483647LL-1 && value <= 2147483647LL );
+        case ( Constants::BAM_TAG_TYPE_UINT32 ) : return ( value >= 0 && value <= 4294967295LL );
+        default : return false;
+    }
+}
+
+// returns smallest BAM tag type that holds value
+static inline
+char smallestTagType(const int64_t& value) {
+    if ( value < 0 ) {
+        if ( value >= -128 )   return Constants::BAM_TAG_TYPE_INT8;
+        if ( value >= -32768 ) return Constants::BAM_TAG_TYPE_INT16;
+        return Constants::BAM_TAG_TYPE_INT32;
+    }
+    if ( value <= 255 )   return Constants::BAM_TAG_TYPE_UINT8;
+    if ( value <= 65535 ) return Constants::BAM_TAG_TYPE_UINT16;
+    return Constants::BAM_TAG_TYPE_UINT32;
+}
+
+// appends integer value, stored as BAM tag type
+static inline
+void appendTagInteger(string& data, const char type, const int64_t& value) {
+    char buffer[Constants::BAM_SIZEOF_INT];
+    switch ( type ) {
+        case ( Constants::BAM_TAG_TYPE_INT8 )  :
+        case ( Constants::BAM_TAG_TYPE_UINT8 ) :
+            data.push_back( static_cast<char>(value & 0xff) );
+            break;
+        case ( Constants::BAM_TAG_TYPE_INT16 )  :
+        case ( Constants::BAM_TAG_TYPE_UINT16 ) :
+            storeUInt16(buffer, static_cast<uint16_t>(value & 0xffff));
+            data.append(buffer, sizeof(uint16_t));
+            break;
+        default :
+            storeUInt32(buffer, static_cast<uint32_t>(value & 0xffffffff));
+            data.append(buffer, sizeof(uint32_t));
+            break;
+    }
+}
+
+static inline
+void appendTagFloat(string& data, const float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    appendUInt32(data, bits);
+}
+
+// appends tag field [begin, end) ("XX:T:value") to data in BAM layout
+static
+bool appendTag(const char* begin, const char* end, string& data) {
+
+    // check tag layout
+    if ( end - begin < 5 || begin[2] != SAM_TAG_SEPARATOR || begin[4] != SAM_TAG_SEPARATOR )
+        return false;
+    const char type = begin[3];
+    const char* value = begin + 5;
+    data.append(begin, Constants::BAM_TAG_TAGSIZE);
+
+    switch ( type ) {
+
+        case ( Constants::BAM_TAG_TYPE_ASCII ) :
+            if ( end - value != 1 )
+                return false;
+            data.push_back(type);
+            data.push_back(*value);
+            return true;
+
+        // SAM has a single integer type, store in smallest BAM type that fits
+        case ( Constants::BAM_TAG_TYPE_INT32 ) : {
+            int64_t number = 0;
+            if ( !parseIntegerField(value, end, -2147483647LL-1, 4294967295LL, number) )
+                return false;
+            const char bamType = smallestTagType(number);
+            data.push_back(bamType);
+            appendTagInteger(data, bamType, number);
+            return true;
+        }
+
+        case ( Constants::BAM_TAG_TYPE_FLOAT ) : {
+            float number = 0.0f;
+            if ( !parseFloat(value, number) || value != end )
+                return false;
+            data.push_back(type);
+            appendTagFloat(data, number);
+            return true;
+        }
+
+        case ( Constants::BAM_TAG_TYPE_STRING ) :
+        case ( Constants::BAM_TAG_TYPE_HEX )    :
+            data.push_back(type);
+            data.append(value, end - value);
+            data.push_back('\0');
+            return true;
+
+        // array: subtype, then comma-separated elements
+        case ( Constants::BAM_TAG_TYPE_ARRAY ) : {
+            if ( value == end )
+                return false;
+            const char subType = *value++;
+            data.push_back(type);
+            data.push_back(subType);
+            const size_t countOffset = data.size();
+            data.resize(countOffset + Constants::BAM_SIZEOF_INT);
+
+            uint32_t numElements = 0;
+            while ( value != end ) {
+                if ( *value++ != SAM_ARRAY_SEPARATOR )
+                    return false;
+                if ( subType == Constants::BAM_TAG_TYPE_FLOAT ) {
+                    float number = 0.0f;
+                    if ( !parseFloat(value, number) )
+                        return false;
+                    appendTagFloat(data, number);
+                } else {
+                    int64_t number = 0;
+                    if ( !parseInteger(value, end, number) || !fitsTagType(subType, number) )
+                        return false;
+                    appendTagInteger(data, subType, number);
+                }
+                ++numElements;
+            }
+            storeUInt32(&data[countOffset], numElements);
+            return true;
+        }
+
+        default :
+            return false;
+    }
+}
+
+// builds error message for malformed line
+static
+string lineError(const string& what, const char* begin, const char* end) {
+    const size_t lineLength = end - begin;
+    string message = string("malformed SAM line (") + what + "):\n\t";
+    message.append(begin, min(lineLength, SAM_MAX_QUOTED_LENGTH));
+    if ( lineLength > SAM_MAX_QUOTED_LENGTH )
+        message.append("...");
+    return message;
+}
+
+} // namespace Internal
+} // namespace BamTools
+
+// --------------------------
+// SamReader implementation
+// --------------------------
+
+SamReader::SamReader(void)
+    : m_device(0)
+    , m_bufferOffset(0)
+    , m_isEof(false)
+    , m_alignmentsBeginOffset(0)
+    , m_isAtFirstAlignment(false)
+    , m_current(0)
+    , m_pool(0)
+{ }
+
+SamReader::~SamReader(void) {
+    Close();
+}
+
+// discards all chunks (waiting for any being parsed) & buffered text
+void SamReader::ClearChunks(void) {
+
+    // pending chunks are (or will be) in a worker's hands
+    deque<Chunk*>::iterator pendingIter = m_pending.begin();
+    deque<Chunk*>::iterator pendingEnd  = m_pending.end();
+    for ( ; pendingIter != pendingEnd; ++pendingIter ) {
+        Chunk* chunk = (*pendingIter);
+        m_pool->Wait(chunk);
+        delete chunk;
+    }
+    m_pending.clear();
+
+    delete m_current;
+    m_current = 0;
+    m_buffer.clear();
+    m_bufferOffset = 0;
+    m_isEof = false;
+}
+
+// stops any parsing threads & releases device (device itself is not closed)
+void SamReader::Close(void) {
+
+    // drop remaining data, then stop workers
+    ClearChunks();
+    delete m_pool;
+    m_pool = 0;
+
+    m_headerText.clear();
+    m_references.clear();
+    m_referenceIds.clear();
+    m_alignmentsBeginOffset = 0;
+    m_isAtFirstAlignment = false;
+    m_device = 0;
+}
+
+// appends next block of device data to text buffer, returns false at EOF
+bool SamReader::FillBuffer(void) {
+
+    if ( m_isEof )
+        return false;
+
+    // drop text that has already been consumed
+    if ( m_bufferOffset > 0 ) {
+        m_buffer.erase(0, m_bufferOffset);
+        m_bufferOffset = 0;
+    }
+
+    const size_t oldSize = m_buffer.size();
+    m_buffer.resize(oldSize + SAM_READ_SIZE);
+    const int64_t numBytesRead = m_device->Read(&m_buffer[oldSize], SAM_READ_SIZE);
+    if ( numBytesRead <= 0 ) {
+        m_buffer.resize(oldSize);
+        m_isEof = true;
+        return false;
+    }
+    m_buffer.resize(oldSize + static_cast<size_t>(numBytesRead));
+    return true;
+}
+
+// looks up reference ID for name in [begin, end), returns false if unknown
+// (@refId is checked first, SAM lines tend to repeat the previous reference)
+bool SamReader::FindReferenceId(const char* begin, const char* end, int32_t& refId) const {
+
+    const size_t nameLength = end - begin;
+    if ( refId >= 0 && refId < static_cast<int32_t>(m_references.size()) ) {
+        const string& previousName = m_references[refId].RefName;
+        if ( previousName.size() == nameLength &&
+             memcmp(previousName.data(), begin, nameLength) == 0 )
+        {
+            return true;
+        }
+    }
+
+    map<string, int32_t>::const_iterator idIter = m_referenceIds.find( string(begin, nameLength) );
+    if ( idIter == m_referenceIds.end() )
+        return false;
+    refId = idIter->second;
+    return true;
+}
+
+// returns SAM header text (all leading '@' lines)
+const string& SamReader::HeaderText(void) const {
+    return m_headerText;
+}
+
+// cuts the next run of complete lines from text buffer (0 if no text left)
+SamReader::Chunk* SamReader::NextChunk(void) {
+
+    // make sure a full chunk of text is buffered, if available
+    while ( m_buffer.size() - m_bufferOffset < SAM_CHUNK_SIZE && FillBuffer() )
+        ;
+    size_t available = m_buffer.size() - m_bufferOffset;
+    if ( available == 0 )
+        return 0;
+
+    // cut just after last newline within chunk size
+    size_t length = min(available, SAM_CHUNK_SIZE);
+    const char* begin = m_buffer.data() + m_bufferOffset;
+    const char* cut = begin + length;
+    while ( cut != begin && *(cut-1) != '\n' )
+        --cut;
+
+    // no newline found - line is longer than chunk size, keep reading until its end
+    if ( cut == begin ) {
+        size_t searchOffset = length;
+        while ( true ) {
+            const char* newline = static_cast<const char*>( memchr(begin + searchOffset, '\n', available - searchOffset) );
+            if ( newline ) {
+                cut = newline + 1;
+                break;
+            }
+            searchOffset = available;
+            if ( !FillBuffer() ) {
+                begin = m_buffer.data() + m_bufferOffset;
+                cut = begin + available;
+                break;
+            }
+            begin = m_buffer.data() + m_bufferOffset;
+            available = m_buffer.size() - m_bufferOffset;
+        }
+    }
+    length = cut - begin;
+
+    Chunk* chunk = new Chunk;
+    chunk->Text.assign(begin, length);
+    chunk->RecordsOffset = 0;
+    chunk->IsDone = false;
+    m_bufferOffset += length;
+    return chunk;
+}
+
+// returns true if no alignment lines have been read since Open() or Rewind()
+bool SamReader::IsAtFirstAlignment(void) const {
+    return m_isAtFirstAlignment;
+}
+
+// reads SAM header from device (device must be open, is not owned by reader)
+// alignment lines are parsed by @numThreads threads, if more than 1
+void SamReader::Open(IBamIODevice* device, const unsigned int numThreads) {
+
+    Close();
+    m_device = device;
+
+    // load header text & build reference data from it
+    ReadHeader();
+    m_isAtFirstAlignment = true;
+    const SamHeader header(m_headerText);
+    SamSequenceConstIterator seqIter = header.Sequences.ConstBegin();
+    SamSequenceConstIterator seqEnd  = header.Sequences.ConstEnd();
+    for ( ; seqIter != seqEnd; ++seqIter ) {
+        const SamSequence& sequence = (*seqIter);
+        m_referenceIds.insert( make_pair(sequence.Name, static_cast<int32_t>(m_references.size())) );
+        m_references.push_back( RefData(sequence.Name, atoi(sequence.Length.c_str())) );
+    }
+
+    // start parsing threads, if requested (& if any could be started)
+    if ( numThreads > 1 ) {
+        m_pool = new BamWorkerPool<Chunk, const SamReader>(*this, numThreads);
+        if ( m_pool->NumWorkers() == 0 ) {
+            delete m_pool;
+            m_pool = 0;
+        }
+    }
+}
+
+// converts SAM line [begin, end) to a BAM record, appended to @records
+// returns false (& sets @errorString) if line is malformed
+bool SamReader::ParseLine(const char* begin,
+                          const char* end,
+                          int32_t& lastRefId,
+                          string& records,
+                          string& errorString) const
+{
+    const size_t recordOffset = records.size();
+    const char* p = begin;
+    const char* fieldBegin = 0;
+    const char* fieldEnd   = 0;
+    int64_t value = 0;
+
+    // reserve block length & core data, filled in once all fields are known
+    records.resize(recordOffset + Constants::BAM_SIZEOF_INT + Constants::BAM_CORE_SIZE);
+
+    // QNAME
+    if ( !nextField(p, end, fieldBegin, fieldEnd) ||
+         fieldBegin == fieldEnd ||
+         static_cast<size_t>(fieldEnd - fieldBegin) > SAM_MAX_NAME_LENGTH )
+    {
+        records.resize(recordOffset);
+        errorString = lineError("invalid QNAME", begin, end);
+        return false;
+    }
+    const uint32_t nameLength = static_cast<uint32_t>(fieldEnd - fieldBegin) + 1;
+    records.append(fieldBegin, fieldEnd - fieldBegin);
+    records.push_back('\0');
+
+    // FLAG
+    if ( !nextField(p, end, fieldBegin, fieldEnd) || !parseIntegerField(fieldBegin, fieldEnd, 0, 0xffff, value) ) {
+        records.resize(recordOffset);
+        errorString = lineError("invalid FLAG", begin, end);
+        return false;
+    }
+    const uint32_t flag = static_cast<uint32_t>(value);
+
+    // RNAME
+    int32_t refId = -1;
+    if ( !nextField(p, end, fieldBegin, fieldEnd) || fieldBegin == fieldEnd ) {
+        records.resize(recordOffset);
+        errorString = lineError("invalid RNAME", begin, end);
+        return false;
+    }
+    if ( !(fieldEnd - fieldBegin == 1 && *fieldBegin == SAM_NULL_FIELD) ) {
+        refId = lastRefId;
+        if ( !FindReferenceId(fieldBegin, fieldEnd, refId) ) {
+            records.resize(recordOffset);
+            errorString = lineError("RNAME not found in header", begin, end);
+            return false;
+        }
+        lastRefId = refId;
+    }
+
+    // POS
+    if ( !nextField(p, end, fieldBegin, fieldEnd) || !parseIntegerField(fieldBegin, fieldEnd, 0, 2147483647LL, value) ) {
+        records.resize(recordOffset);
+        errorString = lineError("invalid POS", begin, end);
+        return false;
+    }
+    const int32_t position = static_cast<int32_t>(value) - 1;
+
+    // MAPQ
+    if ( !nextField(p, end, fieldBegin, fieldEnd) || !parseIntegerField(fieldBegin, fieldEnd, 0, 255, value) ) {
+        records.resize(recordOffset);
+        errorString = lineError("invalid MAPQ", begin, end);
+        return false;
+    }
+    const uint32_t mapQuality = static_cast<uint32_t>(value);
+
+    // CIGAR - also tracks reference span, for bin calculation
+    if ( !nextField(p, end, fieldBegin, fieldEnd) || fieldBegin == fieldEnd ) {
+        records.resize(recordOffset);
+        errorString = lineError("invalid CIGAR", begin, end);
+        return false;
+    }
+    uint32_t numCigarOps = 0;
+    int32_t endPosition = position;
+    if ( !(fieldEnd - fieldBegin == 1 && *fieldBegin == SAM_NULL_FIELD) ) {
+        const char* c = fieldBegin;
+        while ( c != fieldEnd ) {
+            int64_t opLength = 0;
+            const char* opType = 0;
+            if ( *c < '0' || *c > '9' ||
+                 !parseInteger(c, fieldEnd, opLength) || c == fieldEnd ||
+                 opLength > 0x0fffffff ||
+                 (opType = strchr(Constants::BAM_CIGAR_LOOKUP, *c)) == 0 || *c == '\0' )
+            {
+                records.resize(recordOffset);
+                errorString = lineError("invalid CIGAR", begin, end);
+                return false;
+            }
+            const uint32_t op = static_cast<uint32_t>(opType - Constants::BAM_CIGAR_LOOKUP);
+            appendUInt32(records, static_cast<uint32_t>(opLength) << Constants::BAM_CIGAR_SHIFT | op);
+            switch ( op ) {
+                case ( Constants::BAM_CIGAR_MATCH )    :
+                case ( Constants::BAM_CIGAR_DEL )      :
+                case ( Constants::BAM_CIGAR_REFSKIP )  :
+                case ( Constants::BAM_CIGAR_SEQMATCH ) :
+                case ( Constants::BAM_CIGAR_MISMATCH ) :
+                    endPosition += static_cast<int32_t>(opLength);
+                    break;
+                default:
+                    break;
+            }
+            ++numCigarOps;
+            ++c;
+        }
+        if ( numCigarOps > 0xffff ) {
+            records.resize(recordOffset);
+            errorString = lineError("too many CIGAR operations", begin, end);
+            return false;
+        }
+    }
+
+    // RNEXT
+    int32_t mateRefId = -1;
+    if ( !nextField(p, end, fieldBegin, fieldEnd) || fieldBegin == fieldEnd ) {
+        records.resize(recordOffset);
+        errorString = lineError("invalid RNEXT", begin, end);
+        return false;
+    }
+    if ( fieldEnd - fieldBegin == 1 && *fieldBegin == SAM_SAME_REFERENCE )
+        mateRefId = refId;
+    else if ( !(fieldEnd - fieldBegin == 1 && *fieldBegin == SAM_NULL_FIELD) ) {
+        mateRefId = lastRefId;
+        if ( !FindReferenceId(fieldBegin, fieldEnd, mateRefId) ) {
+            records.resize(recordOffset);
+            errorString = lineError("RNEXT not found in header", begin, end);
+            return false;
+        }
+    }
+
+    // PNEXT
+    if ( !nextField(p, end, fieldBegin, fieldEnd) || !parseIntegerField(fieldBegin, fieldEnd, 0, 2147483647LL, value) ) {
+        records.resize(recordOffset);
+        errorString = lineError("invalid PNEXT", begin, end);
+        return false;
+    }
+    const int32_t matePosition = static_cast<int32_t>(value) - 1;
+
+    // TLEN
+    if ( !nextField(p, end, fieldBegin, fieldEnd) ||
+         !parseIntegerField(fieldBegin, fieldEnd, -2147483647LL-1, 2147483647LL, value) )
+    {
+        records.resize(recordOffset);
+        errorString = lineError("invalid TLEN", begin, end);
+        return false;
+    }
+    const int32_t insertSize = static_cast<int32_t>(value);
+
+    // SEQ - packed 2 bases per byte
+    if ( !nextField(p, end, fieldBegin, fieldEnd) || fieldBegin == fieldEnd ) {
+        records.resize(recordOffset);
+        errorString = lineError("invalid SEQ", begin, end);
+        return false;
+    }
+    uint32_t sequenceLength = 0;
+    if ( !(fieldEnd - fieldBegin == 1 && *fieldBegin == SAM_NULL_FIELD) ) {
+        sequenceLength = static_cast<uint32_t>(fieldEnd - fieldBegin);
+        const size_t sequenceOffset = records.size();
+        records.resize(sequenceOffset + (sequenceLength+1)/2);
+        unsigned char* packed = reinterpret_cast<unsigned char*>(&records[sequenceOffset]);
+        unsigned char invalid = 0;
+        for ( uint32_t i = 0; i < sequenceLength; i += 2 ) {
+            const unsigned char high = SEQUENCE_CODES.Codes[static_cast<unsigned char>(fieldBegin[i])];
+            const unsigned char low  = ( i+1 < sequenceLength )
+                                     ? SEQUENCE_CODES.Codes[static_cast<unsigned char>(fieldBegin[i+1])]
+                                     : 0;
+            invalid |= ( high | low );
+            packed[i/2] = static_cast<unsigned char>( (high << 4) | (low & 0x0f) );
+        }
+        if ( invalid & 0xf0 ) {
+            records.resize(recordOffset);
+            errorString = lineError("invalid base in SEQ", begin, end);
+            return false;
+        }
+    }
+
+    // QUAL - either missing ('*') or one quality per base
+    if ( !nextField(p, end, fieldBegin, fieldEnd) || fieldBegin == fieldEnd ) {
+        records.resize(recordOffset);
+        errorString = lineError("invalid QUAL", begin, end);
+        return false;
+    }
+    if ( fieldEnd - fieldBegin == 1 && *fieldBegin == SAM_NULL_FIELD )
+        records.append(sequenceLength, static_cast<char>(0xff));
+    else {
+        if ( static_cast<uint32_t>(fieldEnd - fieldBegin) != sequenceLength ) {
+            records.resize(recordOffset);
+            errorString = lineError("QUAL length does not match SEQ", begin, end);
+            return false;
+        }
+        const size_t qualityOffset = records.size();
+        records.resize(qualityOffset + sequenceLength);
+        char* qualities = &records[qualityOffset];
+        for ( uint32_t i = 0; i < sequenceLength; ++i )
+            qualities[i] = fieldBegin[i] - SAM_QUALITY_OFFSET;
+    }
+
+    // optional tags
+    while ( nextField(p, end, fieldBegin, fieldEnd) ) {
+        if ( !appendTag(fieldBegin, fieldEnd, records) ) {
+            records.resize(recordOffset);
+            errorString = lineError("invalid tag", begin, end);
+            return false;
+        }
+    }
+
+    // fill in block length & core data
+    const uint32_t bin = calculateMinimumBin(position, endPosition);
+    char* record = &records[recordOffset];
+    storeUInt32(record,      static_cast<uint32_t>(records.size() - recordOffset - Constants::BAM_SIZEOF_INT));
+    storeUInt32(record + 4,  static_cast<uint32_t>(refId));
+    storeUInt32(record + 8,  static_cast<uint32_t>(position));
+    storeUInt32(record + 12, (bin << 16) | (mapQuality << 8) | nameLength);
+    storeUInt32(record + 16, (flag << 16) | numCigarOps);
+    storeUInt32(record + 20, sequenceLength);
+    storeUInt32(record + 24, static_cast<uint32_t>(mateRefId));
+    storeUInt32(record + 28, static_cast<uint32_t>(matePosition));
+    storeUInt32(record + 32, static_cast<uint32_t>(insertSize));
+    return true;
+}
+
+// converts all lines of chunk to BAM records
+void SamReader::Process(Chunk& chunk) const {
+
+    // BAM records are usually a bit smaller than their SAM lines
+    chunk.Records.reserve(chunk.Text.size());
+
+    int32_t lastRefId = -1;
+    const char* p   = chunk.Text.data();
+    const char* end = p + chunk.Text.size();
+    while ( p != end ) {
+
+        // find end of line, ignoring any carriage return
+        const char* newline = static_cast<const char*>( memchr(p, '\n', end - p) );
+        const char* lineEnd = ( newline ? newline : end );
+        const char* next = ( newline ? newline + 1 : end );
+        if ( lineEnd != p && *(lineEnd-1) == '\r' )
+            --lineEnd;
+
+        // skip blank lines, stop at first malformed one
+        if ( lineEnd != p && !ParseLine(p, lineEnd, lastRefId, chunk.Records, chunk.ErrorString) )
+            break;
+        p = next;
+    }
+
+    // text no longer needed
+    string().swap(chunk.Text);
+}
+
+// reads header lines from start of text buffer
+void SamReader::ReadHeader(void) {
+
+    while ( true ) {
+
+        // stop at first line that isn't a header line
+        if ( m_bufferOffset == m_buffer.size() && !FillBuffer() )
+            break;
+        if ( m_buffer[m_bufferOffset] != SAM_HEADER_PREFIX )
+            break;
+
+        // find end of line
+        size_t searchOffset = m_bufferOffset;
+        const char* newline = 0;
+        while ( (newline = static_cast<const char*>( memchr(m_buffer.data() + searchOffset, '\n',
+                                                            m_buffer.size() - searchOffset) )) == 0 )
+        {
+            searchOffset = m_buffer.size() - m_bufferOffset;
+            if ( !FillBuffer() )
+                break;
+            searchOffset += m_bufferOffset;
+        }
+
+        // store line (header text always uses plain newlines)
+        const char* lineBegin = m_buffer.data() + m_bufferOffset;
+        const char* lineEnd = ( newline ? newline : m_buffer.data() + m_buffer.size() );
+        const size_t consumed = lineEnd - lineBegin + ( newline ? 1 : 0 );
+        if ( lineEnd != lineBegin && *(lineEnd-1) == '\r' )
+            --lineEnd;
+        m_headerText.append(lineBegin, lineEnd - lineBegin);
+        m_headerText.push_back('\n');
+        m_bufferOffset += consumed;
+    }
+
+    // remember where alignments start, for rewinding
+    if ( m_device->IsRandomAccess() )
+        m_alignmentsBeginOffset = m_device->Tell() - static_cast<int64_t>(m_buffer.size() - m_bufferOffset);
+}
+
+// reads next alignment line, stored in @record exactly as a record in a BAM stream
+// returns false if no alignments are left, throws BamException on malformed lines
+bool SamReader::ReadRecord(string& record) {
+
+    while ( true ) {
+
+        // hand out next record of current chunk
+        if ( m_current ) {
+            const size_t recordsSize = m_current->Records.size();
+            size_t& offset = m_current->RecordsOffset;
+            if ( offset < recordsSize ) {
+                const char* data = m_current->Records.data() + offset;
+                const size_t recordLength = RawRecord::Size(data);
+                record.assign(data, recordLength);
+                offset += recordLength;
+                return true;
+            }
+
+            // chunk used up - report why it stopped early, if it did
+            const string errorString = m_current->ErrorString;
+            delete m_current;
+            m_current = 0;
+            if ( !errorString.empty() )
+                throw BamException("SamReader::ReadRecord", errorString);
+        }
+
+        // move on to next chunk
+        m_isAtFirstAlignment = false;
+        m_current = TakeChunk();
+        if ( m_current == 0 )
+            return false;
+    }
+}
+
+// returns reference data, built from header's @SQ lines
+const RefVector& SamReader::References(void) const {
+    return m_references;
+}
+
+// returns reader to first alignment line (device must be random-access)
+void SamReader::Rewind(void) {
+
+    if ( m_device == 0 || !m_device->IsRandomAccess() )
+        throw BamException("SamReader::Rewind", "cannot rewind SAM input that is not random-access");
+
+    ClearChunks();
+    if ( !m_device->Seek(m_alignmentsBeginOffset) )
+        throw BamException("SamReader::Rewind", "could not seek to first alignment");
+    m_isAtFirstAlignment = true;
+}
+
+// returns next chunk of parsed records, in input order (0 if no records left)
+SamReader::Chunk* SamReader::TakeChunk(void) {
+
+    // no parsing threads - parse chunk right here
+    if ( m_pool == 0 ) {
+        Chunk* chunk = NextChunk();
+        if ( chunk )
+            Process(*chunk);
+        return chunk;
+    }
+
+    // keep workers busy, reading ahead of the oldest chunk
+    const size_t maxPending = m_pool->NumWorkers() * SAM_CHUNKS_PER_THREAD;
+    while ( m_pending.size() < maxPending ) {
+        Chunk* chunk = NextChunk();
+        if ( chunk == 0 )
+            break;
+        m_pending.push_back(chunk);
+        m_pool->Submit(chunk);
+    }
+    if ( m_pending.empty() )
+        return 0;
+
+    // wait for oldest chunk
+    Chunk* chunk = m_pending.front();
+    m_pool->Wait(chunk);
+    m_pending.pop_front();
+    return chunk;
+}
@@ -0,0 +1,122 @@
+// ***************************************************************************
+// SamReader_p.h (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides functionality for reading SAM text input, converting each
+// alignment line into a raw BAM record
+// ***************************************************************************
+
+#ifndef SAMREADER_P_H
+#define SAMREADER_P_H
+
+//  -------------
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the BamTools API.  It exists purely as an
+// implementation detail. This header file may change from version to version
+// without notice, or even be removed.
+//
+// We mean it.
+
+#include "api/BamAux.h"
+#include "shared/bamtools_worker_pool.h"
+#include <deque>
+#include <map>
+#include <string>
+
+namespace BamTools {
+
+class IBamIODevice;
+
+namespace Internal {
+
+class SamReader {
+
+    // ctor & dtor
+    public:
+        SamReader(void);
+        ~SamReader(void);
+
+    // SamReader interface
+    public:
+        // stops any parsing threads & releases device (device itself is not closed)
+        void Close(void);
+        // returns SAM header text (all leading '@' lines)
+        const std::string& HeaderText(void) const;
+        // returns true if no alignment lines have been read since Open() or Rewind()
+        bool IsAtFirstAlignment(void) const;
+        // reads SAM header from device (device must be open, is not owned by reader)
+        // alignment lines are parsed by @numThreads threads, if more than 1
+        void Open(IBamIODevice* device, const unsigned int numThreads);
+        // reads next alignment line, stored in @record exactly as a record in a BAM stream
+        // returns false if no alignments are left, throws BamException on malformed lines
+        bool ReadRecord(std::string& record);
+        // returns reference data, built from header's @SQ lines
+        const RefVector& References(void) const;
+        // returns reader to first alignment line (device must be random-access)
+        void Rewind(void);
+
+    // internal types
+    private:
+        // a run of complete lines & the BAM records parsed from them
+        struct Chunk {
+            std::string Text;
+            std::string Records;
+            size_t RecordsOffset;       // start of next record not yet handed out
+            std::string ErrorString;    // set if a line could not be parsed
+            bool IsDone;
+        };
+
+    // BamWorkerPool operation
+    public:
+        // converts all lines of chunk to BAM records (called on worker threads, if any)
+        void Process(Chunk& chunk) const;
+
+    // internal methods
+    private:
+        // discards all chunks (waiting for any being parsed) & buffered text
+        void ClearChunks(void);
+        // appends next block of device data to text buffer, returns false at EOF
+        bool FillBuffer(void);
+        // looks up reference ID for name in [begin, end), returns false if unknown
+        // (@refId is checked first, SAM lines tend to repeat the previous reference)
+        bool FindReferenceId(const char* begin, const char* end, int32_t& refId) const;
+        // cuts the next run of complete lines from text buffer (0 if no text left)
+        Chunk* NextChunk(void);
+        // converts SAM line [begin, end) to a BAM record, appended to @records
+        // returns false (& sets @errorString) if line is malformed
+        bool ParseLine(const char* begin, const char* end, int32_t& lastRefId,
+                       std::string& records, std::string& errorString) const;
+        // reads header lines from start of text buffer
+        void ReadHeader(void);
+        // returns next chunk of parsed records, in input order (0 if no records left)
+        Chunk* TakeChunk(void);
+
+    // data members
+    private:
+        IBamIODevice* m_device;
+        std::string m_headerText;
+        RefVector m_references;
+        std::map<std::string, int32_t> m_referenceIds;
+
+        // unparsed device data
+        std::string m_buffer;
+        size_t m_bufferOffset;
+        bool m_isEof;
+        int64_t m_alignmentsBeginOffset;   // device position of first alignment line
+        bool m_isAtFirstAlignment;
+
+        Chunk* m_current;
+
+        // parsing threads (if any)
+        BamWorkerPool<Chunk, const SamReader>* m_pool;
+        std::deque<Chunk*> m_pending;   // all chunks not yet taken (input order)
+};
+
+} // namespace Internal
+} // namespace BamTools
+
+#endif // SAMREADER_P_H
@@ -0,0 +1,181 @@
+// ***************************************************************************
+// bamtools_worker_pool.h (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides a pool of worker threads that process submitted jobs, shared by
+// the API & toolkit.
+//
+// BamWorkerPool does not know anything about the jobs themselves. It drives
+// a client-supplied 'Processor' object that provides:
+//
+//     void Process(Job& job);    does the actual work on a job
+//                                (called concurrently, from the worker threads)
+//
+// Job objects are owned by the client, & must have a 'bool IsDone' member,
+// which the pool clears on Submit() & sets once the job has been processed.
+// The client must not touch a submitted job until it is done.
+// ***************************************************************************
+
+#ifndef BAMTOOLS_WORKER_POOL_H
+#define BAMTOOLS_WORKER_POOL_H
+
+#include "shared/bamtools_thread.h"
+#include <deque>
+#include <vector>
+
+namespace BamTools {
+
+template<typename Job, typename Processor>
+class BamWorkerPool {
+
+    // ctor & dtor
+    public:
+        // starts up to @numThreads workers (jobs are processed on the submitting
+        // thread if none could be started)
+        BamWorkerPool(Processor& processor, const unsigned int numThreads);
+        // finishes any queued jobs, then stops workers
+        ~BamWorkerPool(void);
+
+    // BamWorkerPool interface
+    public:
+        // returns true if job has been processed
+        bool IsDone(const Job* job);
+        // returns number of worker threads
+        size_t NumWorkers(void) const;
+        // queues job for processing, returns immediately
+        void Submit(Job* job);
+        // blocks until job has been processed
+        void Wait(const Job* job);
+
+    // internal types
+    private:
+        class Worker : public BamThread {
+            public:
+                explicit Worker(BamWorkerPool* pool) : m_pool(pool) { }
+            protected:
+                void Run(void) { m_pool->RunWorker(); }
+            private:
+                BamWorkerPool* m_pool;
+        };
+
+    // internal methods
+    private:
+        void RunWorker(void);
+
+    // not copyable
+    private:
+        BamWorkerPool(const BamWorkerPool&);
+        BamWorkerPool& operator=(const BamWorkerPool&);
+
+    // data members
+    private:
+        Processor& m_processor;
+        bool m_isStopping;
+        std::vector<Worker*> m_workers;
+        std::deque<Job*> m_queued;      // jobs waiting for a worker
+
+        BamMutex m_mutex;
+        BamWaitCondition m_jobQueued;
+        BamWaitCondition m_jobDone;
+};
+
+template<typename Job, typename Processor>
+BamWorkerPool<Job, Processor>::BamWorkerPool(Processor& processor, const unsigned int numThreads)
+    : m_processor(processor)
+    , m_isStopping(false)
+{
+    for ( unsigned int i = 0; i < numThreads; ++i ) {
+        Worker* worker = new Worker(this);
+        if ( !worker->Start() ) {
+            delete worker;
+            break;
+        }
+        m_workers.push_back(worker);
+    }
+}
+
+template<typename Job, typename Processor>
+BamWorkerPool<Job, Processor>::~BamWorkerPool(void) {
+
+    // signal workers to quit (once queue is empty) & wait for them
+    m_mutex.Lock();
+    m_isStopping = true;
+    m_jobQueued.WakeAll();
+    m_mutex.Unlock();
+
+    typename std::vector<Worker*>::iterator workerIter = m_workers.begin();
+    typename std::vector<Worker*>::iterator workerEnd  = m_workers.end();
+    for ( ; workerIter != workerEnd; ++workerIter ) {
+        (*workerIter)->Wait();
+        delete (*workerIter);
+    }
+    m_workers.clear();
+}
+
+template<typename Job, typename Processor>
+bool BamWorkerPool<Job, Processor>::IsDone(const Job* job) {
+    BamMutexLocker locker(m_mutex);
+    return job->IsDone;
+}
+
+template<typename Job, typename Processor>
+size_t BamWorkerPool<Job, Processor>::NumWorkers(void) const {
+    return m_workers.size();
+}
+
+template<typename Job, typename Processor>
+void BamWorkerPool<Job, Processor>::RunWorker(void) {
+
+    while ( true ) {
+
+        // wait for job
+        m_mutex.Lock();
+        while ( m_queued.empty() && !m_isStopping )
+            m_jobQueued.Wait(m_mutex);
+        if ( m_queued.empty() ) {
+            m_mutex.Unlock();
+            return;
+        }
+        Job* job = m_queued.front();
+        m_queued.pop_front();
+        m_mutex.Unlock();
+
+        // process outside of lock (job is not touched by client until marked done)
+        m_processor.Process(*job);
+
+        // hand back result
+        m_mutex.Lock();
+        job->IsDone = true;
+        m_jobDone.WakeAll();
+        m_mutex.Unlock();
+    }
+}
+
+template<typename Job, typename Processor>
+void BamWorkerPool<Job, Processor>::Submit(Job* job) {
+
+    // no workers could be started, process on the calling thread
+    if ( m_workers.empty() ) {
+        m_processor.Process(*job);
+        job->IsDone = true;
+        return;
+    }
+
+    BamMutexLocker locker(m_mutex);
+    job->IsDone = false;
+    m_queued.push_back(job);
+    m_jobQueued.WakeOne();
+}
+
+template<typename Job, typename Processor>
+void BamWorkerPool<Job, Processor>::Wait(const Job* job) {
+    BamMutexLocker locker(m_mutex);
+    while ( !job->IsDone )
+        m_jobDone.Wait(m_mutex);
+}
+
+} // namespace BamTools
+
+#endif // BAMTOOLS_WORKER_POOL_H
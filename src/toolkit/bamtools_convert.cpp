@@ -2,7 +2,7 @@
 // bamtools_convert.cpp (c) 2010 Derek Barnett, Erik Garrison
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 10 December 2012
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Converts between BAM and a number of other formats
 // ***************************************************************************
@@ -11,12 +11,15 @@
 
 #include <api/BamConstants.h>
 #include <api/BamMultiReader.h>
+#include <shared/bamtools_raw_record.h>
+#include <utils/bamtools_batch_pipeline.h>
 #include <utils/bamtools_fasta.h>
 #include <utils/bamtools_options.h>
 #include <utils/bamtools_pileup_engine.h>
 #include <utils/bamtools_utilities.h>
 using namespace BamTools;
 
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -40,6 +43,178 @@ static const string FORMAT_YAML   = "yaml";
 
 // other constants
 static const unsigned int FASTA_LINE_MAX = 50;
+static const unsigned int CONVERT_DEFAULT_NUM_THREADS = 1;
+static const size_t CONVERT_BUFFER_SIZE = 0x100000; // output buffered before writing (1 MB)
+
+// ---------------------------------------------
+// text formatting helpers (stream-free, so batches can be formatted concurrently)
+
+static inline
+void AppendInteger(string& out, const int64_t& value) {
+    char buffer[24];
+    char* end = buffer + sizeof(buffer);
+    char* digits = end;
+    uint64_t magnitude = ( value < 0 ? -static_cast<uint64_t>(value) : static_cast<uint64_t>(value) );
+    do {
+        *--digits = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while ( magnitude != 0 );
+    if ( value < 0 )
+        *--digits = '-';
+    out.append(digits, end - digits);
+}
+
+// same text as ostream's default float formatting
+static inline
+void AppendFloat(string& out, const float value) {
+    char buffer[32];
+    const int length = snprintf(buffer, sizeof(buffer), "%g", value);
+    out.append(buffer, length);
+}
+
+static inline
+void AppendCigar(string& out, const vector<CigarOp>& cigarData, const char* separator) {
+    vector<CigarOp>::const_iterator cigarBegin = cigarData.begin();
+    vector<CigarOp>::const_iterator cigarIter  = cigarBegin;
+    vector<CigarOp>::const_iterator cigarEnd   = cigarData.end();
+    for ( ; cigarIter != cigarEnd; ++cigarIter ) {
+        const CigarOp& op = (*cigarIter);
+        if ( separator && cigarIter != cigarBegin )
+            out += separator;
+        if ( separator ) out += '"';
+        AppendInteger(out, op.Length);
+        out += op.Type;
+        if ( separator ) out += '"';
+    }
+}
+
+// appends a single numeric tag value, returns its size in bytes (0 if not numeric)
+static inline
+size_t AppendTagNumber(string& out, const char type, const char* value) {
+    switch ( type ) {
+        case (Constants::BAM_TAG_TYPE_INT8)   : AppendInteger(out, static_cast<int8_t>(*value));                 return sizeof(int8_t);
+        case (Constants::BAM_TAG_TYPE_UINT8)  : AppendInteger(out, static_cast<uint8_t>(*value));                return sizeof(uint8_t);
+        case (Constants::BAM_TAG_TYPE_INT16)  : AppendInteger(out, BamTools::UnpackSignedShort(value));   return sizeof(int16_t);
+        case (Constants::BAM_TAG_TYPE_UINT16) : AppendInteger(out, BamTools::UnpackUnsignedShort(value)); return sizeof(uint16_t);
+        case (Constants::BAM_TAG_TYPE_INT32)  : AppendInteger(out, BamTools::UnpackSignedInt(value));     return sizeof(int32_t);
+        case (Constants::BAM_TAG_TYPE_UINT32) : AppendInteger(out, BamTools::UnpackUnsignedInt(value));   return sizeof(uint32_t);
+        case (Constants::BAM_TAG_TYPE_FLOAT)  : AppendFloat(out, BamTools::UnpackFloat(value));           return sizeof(float);
+        default                               : return 0;
+    }
+}
+
+// appends array tag values (separated by commas), returns number of bytes used by array data
+static inline
+size_t AppendTagArray(string& out, const char* value, const size_t maxLength, const char* prefix) {
+
+    // array data starts with element type & count
+    if ( maxLength < RawRecord::TagArrayHeaderLength )
+        return maxLength;
+    const char elementType = value[0];
+    const uint32_t numElements = RawRecord::ReadUInt32(&value[Constants::BAM_TAG_TYPESIZE]);
+    size_t index = RawRecord::TagArrayHeaderLength;
+
+    if ( prefix ) {
+        out += prefix;
+        out += elementType;
+    }
+    for ( uint32_t i = 0; i < numElements && index < maxLength; ++i ) {
+        if ( prefix || i > 0 )
+            out += ',';
+        const size_t elementSize = AppendTagNumber(out, elementType, &value[index]);
+        if ( elementSize == 0 )
+            return maxLength;
+        index += elementSize;
+    }
+    return index;
+}
+
+// ---------------------------------------------
+// ConvertFormatter declaration
+
+// formats alignments as text, appending to a caller-supplied buffer
+class ConvertFormatter {
+
+    // typedefs
+    public:
+        typedef void (ConvertFormatter::*FormatFunction)(const BamAlignment& a, string& out) const;
+
+    // ctor
+    public:
+        ConvertFormatter(const RefVector& references)
+            : m_references(references)
+        { }
+
+    // ConvertFormatter interface
+    public:
+        // returns format method for a command-line format name (0 if not recognized)
+        static FormatFunction FunctionForFormat(const string& format);
+
+        void FormatBed(const BamAlignment& a, string& out) const;
+        void FormatFasta(const BamAlignment& a, string& out) const;
+        void FormatFastq(const BamAlignment& a, string& out) const;
+        void FormatJson(const BamAlignment& a, string& out) const;
+        void FormatSam(const BamAlignment& a, string& out) const;
+        void FormatYaml(const BamAlignment& a, string& out) const;
+
+    // data members
+    private:
+        const RefVector& m_references;
+};
+
+// batch of alignments & their formatted text, passed through the multi-threaded pipeline
+struct ConvertBatch : public AlignmentBatch {
+    string Text;
+
+    ConvertBatch(void) {
+        Text.reserve(CONVERT_BUFFER_SIZE);
+    }
+};
+
+// BatchPipeline stages for conversion with multiple threads:
+//   reader thread  : reads alignment core data
+//   worker threads : parse char data & format each batch into its own text buffer
+//   calling thread : writes text buffers, in input order
+class ConvertStages {
+
+    public:
+        ConvertStages(BamMultiReader& reader,
+                      const ConvertFormatter& formatter,
+                      const ConvertFormatter::FormatFunction formatFunction,
+                      const bool isNeedingFilenames,
+                      ostream& out)
+            : m_reader(reader)
+            , m_formatter(formatter)
+            , m_formatFunction(formatFunction)
+            , m_isNeedingFilenames(isNeedingFilenames)
+            , m_out(out)
+        { }
+
+        bool ReadBatch(ConvertBatch& batch) {
+            // (source filename is only set when char data is read)
+            return ReadAlignmentBatch(m_reader, batch, m_isNeedingFilenames);
+        }
+
+        void ProcessBatch(ConvertBatch& batch) {
+            batch.Text.clear();
+            for ( size_t i = 0; i < batch.Count; ++i ) {
+                BamAlignment& al = batch.Alignments[i];
+                al.BuildCharData();
+                (m_formatter.*m_formatFunction)(al, batch.Text);
+            }
+        }
+
+        void WriteBatch(ConvertBatch& batch) {
+            m_out.write(batch.Text.data(), batch.Text.size());
+        }
+
+    private:
+        BamMultiReader& m_reader;
+        const ConvertFormatter& m_formatter;
+        ConvertFormatter::FormatFunction m_formatFunction;
+        bool m_isNeedingFilenames;
+        ostream& m_out;
+};
 
 // ---------------------------------------------
 // ConvertPileupFormatVisitor declaration
@@ -80,6 +255,7 @@ struct ConvertTool::ConvertSettings {
     bool HasOutput;
     bool HasFormat;
     bool HasRegion;
+    bool HasNumThreads;
 
     // pileup flags
     bool HasFastaFilename;
@@ -92,6 +268,7 @@ struct ConvertTool::ConvertSettings {
     string OutputFilename;
     string Format;
     string Region;
+    unsigned int NumThreads;
     
     // pileup options
     string FastaFilename;
@@ -103,10 +280,12 @@ struct ConvertTool::ConvertSettings {
         , HasOutput(false)
         , HasFormat(false)
         , HasRegion(false)
+        , HasNumThreads(false)
         , HasFastaFilename(false)
         , IsOmittingSamHeader(false)
         , IsPrintingPileupMapQualities(false)
         , OutputFilename(Options::StandardOut())
+        , NumThreads(CONVERT_DEFAULT_NUM_THREADS)
         , FastaFilename("")
     { } 
 };    
@@ -131,13 +310,9 @@ struct ConvertTool::ConvertToolPrivate {
         
     // internal methods
     private:
-        void PrintBed(const BamAlignment& a);
-        void PrintFasta(const BamAlignment& a);
-        void PrintFastq(const BamAlignment& a);
-        void PrintJson(const BamAlignment& a);
-        void PrintSam(const BamAlignment& a);
-        void PrintYaml(const BamAlignment& a);
-        
+        // converts alignments one at a time, or in batches on worker threads
+        void RunFormatConversion(BamMultiReader& reader, const ConvertFormatter::FormatFunction formatFunction);
+
         // special case - uses the PileupEngine
         bool RunPileupConversion(BamMultiReader* reader);
         
@@ -240,39 +415,35 @@ bool ConvertTool::ConvertToolPrivate::Run(void) {
     // all other formats
     else {
     
-        bool formatError = false;
-        
         // set function pointer to proper conversion method
-        void (BamTools::ConvertTool::ConvertToolPrivate::*pFunction)(const BamAlignment&) = 0;
-        if      ( m_settings->Format == FORMAT_BED )   pFunction = &BamTools::ConvertTool::ConvertToolPrivate::PrintBed;
-        else if ( m_settings->Format == FORMAT_FASTA ) pFunction = &BamTools::ConvertTool::ConvertToolPrivate::PrintFasta;
-        else if ( m_settings->Format == FORMAT_FASTQ ) pFunction = &BamTools::ConvertTool::ConvertToolPrivate::PrintFastq;
-        else if ( m_settings->Format == FORMAT_JSON )  pFunction = &BamTools::ConvertTool::ConvertToolPrivate::PrintJson;
-        else if ( m_settings->Format == FORMAT_SAM )   pFunction = &BamTools::ConvertTool::ConvertToolPrivate::PrintSam;
-        else if ( m_settings->Format == FORMAT_YAML )  pFunction = &BamTools::ConvertTool::ConvertToolPrivate::PrintYaml;
-        else { 
+        const ConvertFormatter::FormatFunction formatFunction =
+            ConvertFormatter::FunctionForFormat(m_settings->Format);
+        if ( formatFunction == 0 ) {
             cerr << "bamtools convert ERROR: unrecognized format: " << m_settings->Format << endl;
             cerr << "Please see documentation for list of supported formats " << endl;
-            formatError = true;
             convertedOk = false;
         }
         
         // if format selected ok
-        if ( !formatError ) {
+        else {
         
             // if SAM format & not omitting header, print SAM header first
             if ( (m_settings->Format == FORMAT_SAM) && !m_settings->IsOmittingSamHeader ) 
                 m_out << reader.GetHeaderText();
             
             // iterate through file, doing conversion
-            BamAlignment a;
-            while ( reader.GetNextAlignment(a) )
-                (this->*pFunction)(a);
+            RunFormatConversion(reader, formatFunction);
             
             // set flag for successful conversion
             convertedOk = true;
         }
     }
+
+    // reading stops at input that can't be read (e.g. a malformed SAM line)
+    if ( convertedOk && !reader.GetErrorString().empty() ) {
+        cerr << "bamtools convert ERROR: could not read input: " << reader.GetErrorString() << endl;
+        convertedOk = false;
+    }
     
     // ------------------------
     // clean up & exit
@@ -282,27 +453,163 @@ bool ConvertTool::ConvertToolPrivate::Run(void) {
     return convertedOk;   
 }
 
-// ----------------------------------------------------------
-// Conversion/output methods
-// ----------------------------------------------------------
+void ConvertTool::ConvertToolPrivate::RunFormatConversion(BamMultiReader& reader,
+                                                          const ConvertFormatter::FormatFunction formatFunction)
+{
+    const ConvertFormatter formatter(m_references);
+    const bool isNeedingFilenames = ( m_settings->Format == FORMAT_JSON || m_settings->Format == FORMAT_YAML );
+
+    // if multiple threads requested, format alignments in batches on worker threads
+    if ( m_settings->NumThreads > 1 ) {
+        ConvertStages stages(reader, formatter, formatFunction, isNeedingFilenames, m_out);
+        BatchPipeline<ConvertBatch, ConvertStages> pipeline(stages, m_settings->NumThreads);
+        pipeline.Run();
+    }
+
+    // otherwise format alignments one at a time, writing out buffered text as it fills up
+    else {
+        string text;
+        text.reserve(CONVERT_BUFFER_SIZE);
+        BamAlignment a;
+        while ( reader.GetNextAlignment(a) ) {
+            (formatter.*formatFunction)(a, text);
+            if ( text.size() >= CONVERT_BUFFER_SIZE ) {
+                m_out.write(text.data(), text.size());
+                text.clear();
+            }
+        }
+        m_out.write(text.data(), text.size());
+    }
+    m_out.flush();
+}
+
+bool ConvertTool::ConvertToolPrivate::RunPileupConversion(BamMultiReader* reader) {
+  
+    // check for valid BamMultiReader
+    if ( reader == 0 ) return false;
+  
+    // set up our pileup format 'visitor'
+    ConvertPileupFormatVisitor* v = new ConvertPileupFormatVisitor(m_references, 
+                                                                   m_settings->FastaFilename,
+                                                                   m_settings->IsPrintingPileupMapQualities, 
+                                                                   &m_out);
+
+    // set up PileupEngine
+    PileupEngine pileup;
+    pileup.AddVisitor(v);
+    
+    // iterate through data
+    BamAlignment al;
+    while ( reader->GetNextAlignment(al) )
+        pileup.AddAlignment(al);
+    pileup.Flush();
+    
+    // clean up
+    delete v;
+    v = 0;
+    
+    // return success
+    return true;
+}       
+
+// ---------------------------------------------
+// ConvertTool implementation
+
+ConvertTool::ConvertTool(void)
+    : AbstractTool()
+    , m_settings(new ConvertSettings)
+    , m_impl(0)
+{
+    // set program details
+    Options::SetProgramInfo("bamtools convert", "converts BAM to a number of other formats",
+                            "-format <FORMAT> [-in <filename> -in <filename> ... | -list <filelist>] [-out <filename>] [-region <REGION>] [-threads <count>] [format-specific options]");
+    
+    // set up options 
+    OptionGroup* IO_Opts = Options::CreateOptionGroup("Input & Output");
+    Options::AddValueOption("-in",     "BAM filename", "the input BAM file(s)", "", m_settings->HasInput,   m_settings->InputFiles,     IO_Opts, Options::StandardIn());
+    Options::AddValueOption("-list",   "filename", "the input BAM file list, one line per file", "", m_settings->HasInputFilelist,  m_settings->InputFilelist, IO_Opts);
+    Options::AddValueOption("-out",    "BAM filename", "the output BAM file",   "", m_settings->HasOutput,  m_settings->OutputFilename, IO_Opts, Options::StandardOut());
+    Options::AddValueOption("-format", "FORMAT", "the output file format - see README for recognized formats", "", m_settings->HasFormat, m_settings->Format, IO_Opts);
+    Options::AddValueOption("-region", "REGION", "genomic region. Index file is recommended for better performance, and is used automatically if it exists. See \'bamtools help index\' for more details on creating one", "", m_settings->HasRegion, m_settings->Region, IO_Opts);
+    Options::AddValueOption("-threads", "count", "number of threads used to format alignments (not used for pileup)", "", m_settings->HasNumThreads, m_settings->NumThreads, IO_Opts, CONVERT_DEFAULT_NUM_THREADS);
+    
+    OptionGroup* PileupOpts = Options::CreateOptionGroup("Pileup Options");
+    Options::AddValueOption("-fasta", "FASTA filename", "FASTA reference file", "", m_settings->HasFastaFilename, m_settings->FastaFilename, PileupOpts);
+    Options::AddOption("-mapqual", "print the mapping qualities", m_settings->IsPrintingPileupMapQualities, PileupOpts);
+    
+    OptionGroup* SamOpts = Options::CreateOptionGroup("SAM Options");
+    Options::AddOption("-noheader", "omit the SAM header from output", m_settings->IsOmittingSamHeader, SamOpts);
+}
+
+ConvertTool::~ConvertTool(void) {
+
+    delete m_settings;
+    m_settings = 0;
+    
+    delete m_impl;
+    m_impl = 0;
+}
+
+int ConvertTool::Help(void) {
+    Options::DisplayHelp();
+    return 0;
+}
+
+int ConvertTool::Run(int argc, char* argv[]) {
+  
+    // parse command line arguments
+    Options::Parse(argc, argv, 1);
+    
+    // initialize ConvertTool with settings
+    m_impl = new ConvertToolPrivate(m_settings);
+    
+    // run ConvertTool, return success/fail
+    if ( m_impl->Run() ) 
+        return 0;
+    else 
+        return 1;
+}
+
+// ---------------------------------------------
+// ConvertFormatter implementation
+
+// returns format method for a command-line format name (0 if not recognized)
+ConvertFormatter::FormatFunction ConvertFormatter::FunctionForFormat(const string& format) {
+    if      ( format == FORMAT_BED )   return &ConvertFormatter::FormatBed;
+    else if ( format == FORMAT_FASTA ) return &ConvertFormatter::FormatFasta;
+    else if ( format == FORMAT_FASTQ ) return &ConvertFormatter::FormatFastq;
+    else if ( format == FORMAT_JSON )  return &ConvertFormatter::FormatJson;
+    else if ( format == FORMAT_SAM )   return &ConvertFormatter::FormatSam;
+    else if ( format == FORMAT_YAML )  return &ConvertFormatter::FormatYaml;
+    else return 0;
+}
 
-void ConvertTool::ConvertToolPrivate::PrintBed(const BamAlignment& a) { 
+void ConvertFormatter::FormatBed(const BamAlignment& a, string& out) const {
   
     // tab-delimited, 0-based half-open 
     // (e.g. a 50-base read aligned to pos 10 could have BED coordinates (10, 60) instead of BAM coordinates (10, 59) )
     // <chromName> <chromStart> <chromEnd> <readName> <score> <strand>
-
-    m_out << m_references.at(a.RefID).RefName << "\t"
-          << a.Position << "\t"
-          << a.GetEndPosition() << "\t"
-          << a.Name << "\t"
-          << a.MapQuality << "\t"
-          << (a.IsReverseStrand() ? "-" : "+") << endl;
+    //
+    // N.B. - alignments without a reference have no BED coordinates, and are skipped
+
+    if ( (a.RefID < 0) || (a.RefID >= (int)m_references.size()) )
+        return;
+
+    out += m_references[a.RefID].RefName;
+    out += '\t';
+    AppendInteger(out, a.Position);
+    out += '\t';
+    AppendInteger(out, a.GetEndPosition());
+    out += '\t';
+    out += a.Name;
+    out += '\t';
+    AppendInteger(out, a.MapQuality);
+    out += ( a.IsReverseStrand() ? "\t-\n" : "\t+\n" );
 }
 
-// print BamAlignment in FASTA format
+// format BamAlignment as FASTA
 // N.B. - uses QueryBases NOT AlignedBases
-void ConvertTool::ConvertToolPrivate::PrintFasta(const BamAlignment& a) { 
+void ConvertFormatter::FormatFasta(const BamAlignment& a, string& out) const {
     
     // >BamAlignment.Name
     // BamAlignment.QueryBases (up to FASTA_LINE_MAX bases per line)
@@ -310,38 +617,34 @@ void ConvertTool::ConvertToolPrivate::PrintFasta(const BamAlignment& a) {
     //
     // N.B. - QueryBases are reverse-complemented if aligned to reverse strand
   
-    // print header
-    m_out << ">" << a.Name << endl;
+    // write header
+    out += '>';
+    out += a.Name;
+    out += '\n';
     
     // handle reverse strand alignment - bases 
-    string sequence = a.QueryBases;
-    if ( a.IsReverseStrand() )
-        Utilities::ReverseComplement(sequence);
-    
-    // if sequence fits on single line
-    if ( sequence.length() <= FASTA_LINE_MAX )
-        m_out << sequence << endl;
+    string reversedSequence;
+    if ( a.IsReverseStrand() ) {
+        reversedSequence = a.QueryBases;
+        Utilities::ReverseComplement(reversedSequence);
+    }
+    const string& sequence = ( a.IsReverseStrand() ? reversedSequence : a.QueryBases );
     
-    // else split over multiple lines
-    else {
-      
-        size_t position = 0;
-        size_t seqLength = sequence.length(); // handle reverse strand alignment - bases & qualitiesth();
-        
-        // write subsequences to each line
-        while ( position < (seqLength - FASTA_LINE_MAX) ) {
-            m_out << sequence.substr(position, FASTA_LINE_MAX) << endl;
-            position += FASTA_LINE_MAX;
-        }
-        
-        // write final subsequence
-        m_out << sequence.substr(position) << endl;
+    // write sequence, up to FASTA_LINE_MAX bases per line
+    const size_t seqLength = sequence.length();
+    size_t position = 0;
+    while ( seqLength - position > FASTA_LINE_MAX ) {
+        out.append(sequence, position, FASTA_LINE_MAX);
+        out += '\n';
+        position += FASTA_LINE_MAX;
     }
+    out.append(sequence, position, string::npos);
+    out += '\n';
 }
 
-// print BamAlignment in FASTQ format
+// format BamAlignment as FASTQ
 // N.B. - uses QueryBases NOT AlignedBases
-void ConvertTool::ConvertToolPrivate::PrintFastq(const BamAlignment& a) { 
+void ConvertFormatter::FormatFastq(const BamAlignment& a, string& out) const {
   
     // @BamAlignment.Name
     // BamAlignment.QueryBases
@@ -352,422 +655,304 @@ void ConvertTool::ConvertToolPrivate::PrintFastq(const BamAlignment& a) {
     //        Name is appended "/1" or "/2" if paired-end, to reflect which mate this entry is.
   
     // handle paired-end alignments
-    string name = a.Name;
+    out += '@';
+    out += a.Name;
     if ( a.IsPaired() )
-        name.append( (a.IsFirstMate() ? "/1" : "/2") );
+        out += ( a.IsFirstMate() ? "/1" : "/2" );
+    out += '\n';
   
     // handle reverse strand alignment - bases & qualities
-    string qualities = a.Qualities;
-    string sequence  = a.QueryBases;
     if ( a.IsReverseStrand() ) {
-        Utilities::Reverse(qualities);
+        string sequence = a.QueryBases;
         Utilities::ReverseComplement(sequence);
+        out += sequence;
+        out += "\n+\n";
+        out.append(a.Qualities.rbegin(), a.Qualities.rend());
+    } else {
+        out += a.QueryBases;
+        out += "\n+\n";
+        out += a.Qualities;
     }
-  
-    // write to output stream
-    m_out << "@" << name << endl
-          << sequence    << endl
-          << "+"         << endl
-          << qualities   << endl;
+    out += '\n';
 }
 
-// print BamAlignment in JSON format
-void ConvertTool::ConvertToolPrivate::PrintJson(const BamAlignment& a) {
+// format BamAlignment as JSON
+void ConvertFormatter::FormatJson(const BamAlignment& a, string& out) const {
   
     // write name & alignment flag
-    m_out << "{\"name\":\"" << a.Name << "\",\"alignmentFlag\":\"" << a.AlignmentFlag << "\",";
+    out += "{\"name\":\"";
+    out += a.Name;
+    out += "\",\"alignmentFlag\":\"";
+    AppendInteger(out, a.AlignmentFlag);
+    out += "\",";
     
     // write reference name
-    if ( (a.RefID >= 0) && (a.RefID < (int)m_references.size()) ) 
-        m_out << "\"reference\":\"" << m_references[a.RefID].RefName << "\",";
+    if ( (a.RefID >= 0) && (a.RefID < (int)m_references.size()) ) {
+        out += "\"reference\":\"";
+        out += m_references[a.RefID].RefName;
+        out += "\",";
+    }
     
     // write position & map quality
-    m_out << "\"position\":" << a.Position+1 << ",\"mapQuality\":" << a.MapQuality << ",";
+    out += "\"position\":";
+    AppendInteger(out, a.Position+1);
+    out += ",\"mapQuality\":";
+    AppendInteger(out, a.MapQuality);
+    out += ',';
     
     // write CIGAR
-    const vector<CigarOp>& cigarData = a.CigarData;
-    if ( !cigarData.empty() ) {
-        m_out << "\"cigar\":[";
-        vector<CigarOp>::const_iterator cigarBegin = cigarData.begin();
-        vector<CigarOp>::const_iterator cigarIter  = cigarBegin;
-        vector<CigarOp>::const_iterator cigarEnd   = cigarData.end();
-        for ( ; cigarIter != cigarEnd; ++cigarIter ) {
-            const CigarOp& op = (*cigarIter);
-            if (cigarIter != cigarBegin)
-                m_out << ",";
-            m_out << "\"" << op.Length << op.Type << "\"";
-        }
-        m_out << "],";
+    if ( !a.CigarData.empty() ) {
+        out += "\"cigar\":[";
+        AppendCigar(out, a.CigarData, ",");
+        out += "],";
     }
     
     // write mate reference name, mate position, & insert size
     if ( a.IsPaired() && (a.MateRefID >= 0) && (a.MateRefID < (int)m_references.size()) ) {
-        m_out << "\"mate\":{"
-              << "\"reference\":\"" << m_references[a.MateRefID].RefName << "\","
-              << "\"position\":" << a.MatePosition+1
-              << ",\"insertSize\":" << a.InsertSize << "},";
+        out += "\"mate\":{\"reference\":\"";
+        out += m_references[a.MateRefID].RefName;
+        out += "\",\"position\":";
+        AppendInteger(out, a.MatePosition+1);
+        out += ",\"insertSize\":";
+        AppendInteger(out, a.InsertSize);
+        out += "},";
     }
     
     // write sequence
-    if ( !a.QueryBases.empty() ) 
-        m_out << "\"queryBases\":\"" << a.QueryBases << "\",";
+    if ( !a.QueryBases.empty() ) {
+        out += "\"queryBases\":\"";
+        out += a.QueryBases;
+        out += "\",";
+    }
     
     // write qualities
     if ( !a.Qualities.empty() && a.Qualities.at(0) != (char)0xFF ) {
+        out += "\"qualities\":[";
         string::const_iterator s = a.Qualities.begin();
-        m_out << "\"qualities\":[" << static_cast<short>(*s) - 33;
-        ++s;
-        for ( ; s != a.Qualities.end(); ++s )
-            m_out << "," << static_cast<short>(*s) - 33;
-        m_out << "],";
+        for ( ; s != a.Qualities.end(); ++s ) {
+            if ( s != a.Qualities.begin() )
+                out += ',';
+            AppendInteger(out, static_cast<short>(*s) - 33);
+        }
+        out += "],";
     }
     
     // write alignment's source BAM file
-    m_out << "\"filename\":" << a.Filename << ",";
+    out += "\"filename\":";
+    out += a.Filename;
+    out += ',';
 
     // write tag data
-    const char* tagData = a.TagData.c_str();
+    const char* tagData = a.TagData.data();
     const size_t tagDataLength = a.TagData.length();
     size_t index = 0;
     if ( index < tagDataLength ) {
 
-        m_out << "\"tags\":{";
+        out += "\"tags\":{";
         
-        while ( index < tagDataLength ) {
+        while ( index + Constants::BAM_TAG_TAGSIZE + Constants::BAM_TAG_TYPESIZE <= tagDataLength ) {
 
             if ( index > 0 )
-                m_out << ",";
+                out += ',';
             
             // write tag name
-            m_out << "\"" << a.TagData.substr(index, 2) << "\":";
-            index += 2;
+            out += '"';
+            out.append(&tagData[index], Constants::BAM_TAG_TAGSIZE);
+            out += "\":";
+            index += Constants::BAM_TAG_TAGSIZE;
             
             // get data type
-            char type = a.TagData.at(index);
+            const char type = tagData[index];
             ++index;
             switch ( type ) {
                 case (Constants::BAM_TAG_TYPE_ASCII) :
-                    m_out << "\"" << tagData[index] << "\"";
+                    out += '"';
+                    out += tagData[index];
+                    out += '"';
                     ++index; 
                     break;
                 
-                case (Constants::BAM_TAG_TYPE_INT8) :
-                    // force value into integer-type (instead of char value)
-                    m_out << static_cast<int16_t>(tagData[index]);
-                    ++index;
-                    break;
-
-                case (Constants::BAM_TAG_TYPE_UINT8) :
-                    // force value into integer-type (instead of char value)
-                    m_out << static_cast<uint16_t>(tagData[index]);
-                    ++index; 
-                    break;
-                
-                case (Constants::BAM_TAG_TYPE_INT16) :
-                    m_out << BamTools::UnpackSignedShort(&tagData[index]);
-                    index += sizeof(int16_t);
-                    break;
-
-                case (Constants::BAM_TAG_TYPE_UINT16) :
-                    m_out << BamTools::UnpackUnsignedShort(&tagData[index]);
-                    index += sizeof(uint16_t);
-                    break;
-                    
-                case (Constants::BAM_TAG_TYPE_INT32) :
-                    m_out << BamTools::UnpackSignedInt(&tagData[index]);
-                    index += sizeof(int32_t);
-                    break;
-
-                case (Constants::BAM_TAG_TYPE_UINT32) :
-                    m_out << BamTools::UnpackUnsignedInt(&tagData[index]);
-                    index += sizeof(uint32_t);
-                    break;
-
-                case (Constants::BAM_TAG_TYPE_FLOAT) :
-                    m_out << BamTools::UnpackFloat(&tagData[index]);
-                    index += sizeof(float);
-                    break;
-                
                 case (Constants::BAM_TAG_TYPE_HEX)    :
                 case (Constants::BAM_TAG_TYPE_STRING) :
-                    m_out << "\""; 
-                    while (tagData[index]) {
-                        if (tagData[index] == '\"')
-                            m_out << "\\\""; // escape for json
+                    out += '"';
+                    while ( index < tagDataLength && tagData[index] ) {
+                        if ( tagData[index] == '\"' )
+                            out += "\\\""; // escape for json
                         else
-                            m_out << tagData[index];
+                            out += tagData[index];
                         ++index;
                     }
-                    m_out << "\""; 
+                    out += '"';
                     ++index; 
                     break;      
+
+                case (Constants::BAM_TAG_TYPE_ARRAY) :
+                    out += '[';
+                    index += AppendTagArray(out, &tagData[index], tagDataLength - index, 0);
+                    out += ']';
+                    break;
+
+                default :
+                    index += AppendTagNumber(out, type, &tagData[index]);
+                    break;
             }
-            
-            if ( tagData[index] == '\0') 
-                break;
         }
 
-        m_out << "}";
+        out += '}';
     }
 
-    m_out << "}" << endl;
+    out += "}\n";
 }
 
-// print BamAlignment in SAM format
-void ConvertTool::ConvertToolPrivate::PrintSam(const BamAlignment& a) {
+// format BamAlignment as SAM
+void ConvertFormatter::FormatSam(const BamAlignment& a, string& out) const {
   
     // tab-delimited
     // <QNAME> <FLAG> <RNAME> <POS> <MAPQ> <CIGAR> <MRNM> <MPOS> <ISIZE> <SEQ> <QUAL> [ <TAG>:<VTYPE>:<VALUE> [...] ]
   
     // write name & alignment flag
-   m_out << a.Name << "\t" << a.AlignmentFlag << "\t";
+    out += a.Name;
+    out += '\t';
+    AppendInteger(out, a.AlignmentFlag);
+    out += '\t';
 
     // write reference name
     if ( (a.RefID >= 0) && (a.RefID < (int)m_references.size()) ) 
-        m_out << m_references[a.RefID].RefName << "\t";
+        out += m_references[a.RefID].RefName;
     else 
-        m_out << "*\t";
+        out += '*';
+    out += '\t';
     
     // write position & map quality
-    m_out << a.Position+1 << "\t" << a.MapQuality << "\t";
+    AppendInteger(out, a.Position+1);
+    out += '\t';
+    AppendInteger(out, a.MapQuality);
+    out += '\t';
     
     // write CIGAR
-    const vector<CigarOp>& cigarData = a.CigarData;
-    if ( cigarData.empty() ) m_out << "*\t";
-    else {
-        vector<CigarOp>::const_iterator cigarIter = cigarData.begin();
-        vector<CigarOp>::const_iterator cigarEnd  = cigarData.end();
-        for ( ; cigarIter != cigarEnd; ++cigarIter ) {
-            const CigarOp& op = (*cigarIter);
-            m_out << op.Length << op.Type;
-        }
-        m_out << "\t";
-    }
+    if ( a.CigarData.empty() )
+        out += '*';
+    else
+        AppendCigar(out, a.CigarData, 0);
+    out += '\t';
     
     // write mate reference name, mate position, & insert size
     if ( a.IsPaired() && (a.MateRefID >= 0) && (a.MateRefID < (int)m_references.size()) ) {
         if ( a.MateRefID == a.RefID )
-            m_out << "=\t";
+            out += '=';
         else
-           m_out << m_references[a.MateRefID].RefName << "\t";
-        m_out << a.MatePosition+1 << "\t" << a.InsertSize << "\t";
+            out += m_references[a.MateRefID].RefName;
+        out += '\t';
+        AppendInteger(out, a.MatePosition+1);
+        out += '\t';
+        AppendInteger(out, a.InsertSize);
+        out += '\t';
     } 
     else
-        m_out << "*\t0\t0\t";
+        out += "*\t0\t0\t";
     
     // write sequence
     if ( a.QueryBases.empty() )
-        m_out << "*\t";
+        out += '*';
     else
-        m_out << a.QueryBases << "\t";
+        out += a.QueryBases;
+    out += '\t';
     
     // write qualities
     if ( a.Qualities.empty() || (a.Qualities.at(0) == (char)0xFF) )
-        m_out << "*";
+        out += '*';
     else
-        m_out << a.Qualities;
+        out += a.Qualities;
     
     // write tag data
-    const char* tagData = a.TagData.c_str();
+    const char* tagData = a.TagData.data();
     const size_t tagDataLength = a.TagData.length();
     
     size_t index = 0;
-    while ( index < tagDataLength ) {
+    while ( index + Constants::BAM_TAG_TAGSIZE + Constants::BAM_TAG_TYPESIZE <= tagDataLength ) {
 
         // write tag name   
-        string tagName = a.TagData.substr(index, 2);
-        m_out << "\t" << tagName << ":";
-        index += 2;
+        out += '\t';
+        out.append(&tagData[index], Constants::BAM_TAG_TAGSIZE);
+        out += ':';
+        index += Constants::BAM_TAG_TAGSIZE;
         
         // get data type
-        char type = a.TagData.at(index);
+        const char type = tagData[index];
         ++index;
         switch ( type ) {
             case (Constants::BAM_TAG_TYPE_ASCII) :
-                m_out << "A:" << tagData[index];
+                out += "A:";
+                out += tagData[index];
                 ++index;
                 break;
 
-            case (Constants::BAM_TAG_TYPE_INT8) :
-                // force value into integer-type (instead of char value)
-                m_out << "i:" << static_cast<int16_t>(tagData[index]);
-                ++index;
-                break;
-
-            case (Constants::BAM_TAG_TYPE_UINT8) :
-                // force value into integer-type (instead of char value)
-                m_out << "i:" << static_cast<uint16_t>(tagData[index]);
-                ++index;
-                break;
-
-            case (Constants::BAM_TAG_TYPE_INT16) :
-                m_out << "i:" << BamTools::UnpackSignedShort(&tagData[index]);
-                index += sizeof(int16_t);
-                break;
-
-            case (Constants::BAM_TAG_TYPE_UINT16) :
-                m_out << "i:" << BamTools::UnpackUnsignedShort(&tagData[index]);
-                index += sizeof(uint16_t);
-                break;
-
-            case (Constants::BAM_TAG_TYPE_INT32) :
-                m_out << "i:" << BamTools::UnpackSignedInt(&tagData[index]);
-                index += sizeof(int32_t);
-                break;
-
-            case (Constants::BAM_TAG_TYPE_UINT32) :
-                m_out << "i:" << BamTools::UnpackUnsignedInt(&tagData[index]);
-                index += sizeof(uint32_t);
-                break;
-
             case (Constants::BAM_TAG_TYPE_FLOAT) :
-                m_out << "f:" << BamTools::UnpackFloat(&tagData[index]);
-                index += sizeof(float);
+                out += "f:";
+                index += AppendTagNumber(out, type, &tagData[index]);
                 break;
 
             case (Constants::BAM_TAG_TYPE_HEX)    : // fall-through
             case (Constants::BAM_TAG_TYPE_STRING) :
-                m_out << type << ":";
-                while (tagData[index]) {
-                    m_out << tagData[index];
+                out += type;
+                out += ':';
+                while ( index < tagDataLength && tagData[index] ) {
+                    out += tagData[index];
                     ++index;
                 }
                 ++index;
                 break;
-        }
 
-        if ( tagData[index] == '\0' )
-            break;
+            case (Constants::BAM_TAG_TYPE_ARRAY) :
+                index += AppendTagArray(out, &tagData[index], tagDataLength - index, "B:");
+                break;
+
+            default :
+                out += "i:";
+                index += AppendTagNumber(out, type, &tagData[index]);
+                break;
+        }
     }
 
-    m_out << endl;
+    out += '\n';
 }
 
-// Print BamAlignment in YAML format
-void ConvertTool::ConvertToolPrivate::PrintYaml(const BamAlignment& a) {
+// format BamAlignment as YAML
+void ConvertFormatter::FormatYaml(const BamAlignment& a, string& out) const {
 
     // write alignment name
-    m_out << "---" << endl;
-    m_out << a.Name << ":" << endl;
+    out += "---\n";
+    out += a.Name;
+    out += ":\n";
 
     // write alignment data
-    m_out << "   " << "AlndBases: "     << a.AlignedBases << endl;
-    m_out << "   " << "Qualities: "     << a.Qualities << endl;
-    m_out << "   " << "Name: "          << a.Name << endl;
-    m_out << "   " << "Length: "        << a.Length << endl;
-    m_out << "   " << "TagData: "       << a.TagData << endl;
-    m_out << "   " << "RefID: "         << a.RefID << endl;
-    m_out << "   " << "RefName: "       << m_references[a.RefID].RefName << endl;
-    m_out << "   " << "Position: "      << a.Position << endl;
-    m_out << "   " << "Bin: "           << a.Bin << endl;
-    m_out << "   " << "MapQuality: "    << a.MapQuality << endl;
-    m_out << "   " << "AlignmentFlag: " << a.AlignmentFlag << endl;
-    m_out << "   " << "MateRefID: "     << a.MateRefID << endl;
-    m_out << "   " << "MatePosition: "  << a.MatePosition << endl;
-    m_out << "   " << "InsertSize: "    << a.InsertSize << endl;
-    m_out << "   " << "Filename: "      << a.Filename << endl;
+    out += "   AlndBases: ";     out += a.AlignedBases;                  out += '\n';
+    out += "   Qualities: ";     out += a.Qualities;                     out += '\n';
+    out += "   Name: ";          out += a.Name;                          out += '\n';
+    out += "   Length: ";        AppendInteger(out, a.Length);           out += '\n';
+    out += "   TagData: ";       out += a.TagData;                       out += '\n';
+    out += "   RefID: ";         AppendInteger(out, a.RefID);            out += '\n';
+    out += "   RefName: ";
+    if ( (a.RefID >= 0) && (a.RefID < (int)m_references.size()) )
+        out += m_references[a.RefID].RefName;
+    out += '\n';
+    out += "   Position: ";      AppendInteger(out, a.Position);         out += '\n';
+    out += "   Bin: ";           AppendInteger(out, a.Bin);              out += '\n';
+    out += "   MapQuality: ";    AppendInteger(out, a.MapQuality);       out += '\n';
+    out += "   AlignmentFlag: "; AppendInteger(out, a.AlignmentFlag);    out += '\n';
+    out += "   MateRefID: ";     AppendInteger(out, a.MateRefID);        out += '\n';
+    out += "   MatePosition: ";  AppendInteger(out, a.MatePosition);     out += '\n';
+    out += "   InsertSize: ";    AppendInteger(out, a.InsertSize);       out += '\n';
+    out += "   Filename: ";      out += a.Filename;                      out += '\n';
 
     // write Cigar data
-    const vector<CigarOp>& cigarData = a.CigarData;
-    if ( !cigarData.empty() ) {
-        m_out << "   " <<  "Cigar: ";
-        vector<CigarOp>::const_iterator cigarBegin = cigarData.begin();
-        vector<CigarOp>::const_iterator cigarIter  = cigarBegin;
-        vector<CigarOp>::const_iterator cigarEnd   = cigarData.end();
-        for ( ; cigarIter != cigarEnd; ++cigarIter ) {
-            const CigarOp& op = (*cigarIter);
-            m_out << op.Length << op.Type;
-        }
-        m_out << endl;
+    if ( !a.CigarData.empty() ) {
+        out += "   Cigar: ";
+        AppendCigar(out, a.CigarData, 0);
+        out += '\n';
     }
 }
 
-bool ConvertTool::ConvertToolPrivate::RunPileupConversion(BamMultiReader* reader) {
-  
-    // check for valid BamMultiReader
-    if ( reader == 0 ) return false;
-  
-    // set up our pileup format 'visitor'
-    ConvertPileupFormatVisitor* v = new ConvertPileupFormatVisitor(m_references, 
-                                                                   m_settings->FastaFilename,
-                                                                   m_settings->IsPrintingPileupMapQualities, 
-                                                                   &m_out);
-
-    // set up PileupEngine
-    PileupEngine pileup;
-    pileup.AddVisitor(v);
-    
-    // iterate through data
-    BamAlignment al;
-    while ( reader->GetNextAlignment(al) )
-        pileup.AddAlignment(al);
-    pileup.Flush();
-    
-    // clean up
-    delete v;
-    v = 0;
-    
-    // return success
-    return true;
-}       
-
-// ---------------------------------------------
-// ConvertTool implementation
-
-ConvertTool::ConvertTool(void)
-    : AbstractTool()
-    , m_settings(new ConvertSettings)
-    , m_impl(0)
-{
-    // set program details
-    Options::SetProgramInfo("bamtools convert", "converts BAM to a number of other formats",
-                            "-format <FORMAT> [-in <filename> -in <filename> ... | -list <filelist>] [-out <filename>] [-region <REGION>] [format-specific options]");
-    
-    // set up options 
-    OptionGroup* IO_Opts = Options::CreateOptionGroup("Input & Output");
-    Options::AddValueOption("-in",     "BAM filename", "the input BAM file(s)", "", m_settings->HasInput,   m_settings->InputFiles,     IO_Opts, Options::StandardIn());
-    Options::AddValueOption("-list",   "filename", "the input BAM file list, one line per file", "", m_settings->HasInputFilelist,  m_settings->InputFilelist, IO_Opts);
-    Options::AddValueOption("-out",    "BAM filename", "the output BAM file",   "", m_settings->HasOutput,  m_settings->OutputFilename, IO_Opts, Options::StandardOut());
-    Options::AddValueOption("-format", "FORMAT", "the output file format - see README for recognized formats", "", m_settings->HasFormat, m_settings->Format, IO_Opts);
-    Options::AddValueOption("-region", "REGION", "genomic region. Index file is recommended for better performance, and is used automatically if it exists. See \'bamtools help index\' for more details on creating one", "", m_settings->HasRegion, m_settings->Region, IO_Opts);
-    
-    OptionGroup* PileupOpts = Options::CreateOptionGroup("Pileup Options");
-    Options::AddValueOption("-fasta", "FASTA filename", "FASTA reference file", "", m_settings->HasFastaFilename, m_settings->FastaFilename, PileupOpts);
-    Options::AddOption("-mapqual", "print the mapping qualities", m_settings->IsPrintingPileupMapQualities, PileupOpts);
-    
-    OptionGroup* SamOpts = Options::CreateOptionGroup("SAM Options");
-    Options::AddOption("-noheader", "omit the SAM header from output", m_settings->IsOmittingSamHeader, SamOpts);
-}
-
-ConvertTool::~ConvertTool(void) {
-
-    delete m_settings;
-    m_settings = 0;
-    
-    delete m_impl;
-    m_impl = 0;
-}
-
-int ConvertTool::Help(void) {
-    Options::DisplayHelp();
-    return 0;
-}
-
-int ConvertTool::Run(int argc, char* argv[]) {
-  
-    // parse command line arguments
-    Options::Parse(argc, argv, 1);
-    
-    // initialize ConvertTool with settings
-    m_impl = new ConvertToolPrivate(m_settings);
-    
-    // run ConvertTool, return success/fail
-    if ( m_impl->Run() ) 
-        return 0;
-    else 
-        return 1;
-}
-
 // ---------------------------------------------
 // ConvertPileupFormatVisitor implementation
 
@@ -2,7 +2,7 @@
 // bamtools_count.cpp (c) 2010 Derek Barnett, Erik Garrison
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 10 December 2012
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Prints alignment count for BAM file(s)
 // ***************************************************************************
@@ -11,16 +11,133 @@
 
 #include <api/BamAlgorithms.h>
 #include <api/BamMultiReader.h>
+#include <api/BamReader.h>
+#include <utils/bamtools_batch_pipeline.h>
 #include <utils/bamtools_options.h>
 #include <utils/bamtools_utilities.h>
 using namespace BamTools;
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
 using namespace std;
 
+namespace BamTools {
+
+// multi-threaded counting
+const unsigned int COUNT_DEFAULT_NUM_THREADS = 1;
+
+// a single counting job: one input file & the part of the requested region on a single
+// reference (or no region at all, to count entire file)
+struct CountBatch {
+    size_t FileIndex;
+    BamRegion Region;
+    uint64_t Count;
+    string ErrorString;
+
+    CountBatch(const size_t fileIndex = 0, const BamRegion& region = BamRegion())
+        : FileIndex(fileIndex)
+        , Region(region)
+        , Count(0)
+    { }
+};
+
+// BatchPipeline stages for counting (one job per batch):
+//   reader thread  : hands out counting jobs
+//   worker threads : count job's alignments, with an indexed reader taken from a per-file pool
+//   calling thread : sums up counts
+//
+// with a single thread, the same stages are simply called in turn
+class CountStages {
+
+    public:
+        CountStages(const vector<string>& filenames, const vector<CountBatch>& jobs)
+            : m_filenames(filenames)
+            , m_jobs(jobs)
+            , m_nextJob(0)
+            , m_freeReaders(filenames.size())
+            , m_total(0)
+        { }
+
+        ~CountStages(void) {
+            for ( size_t i = 0; i < m_readers.size(); ++i ) {
+                m_readers[i]->Close();
+                delete m_readers[i];
+            }
+        }
+
+        bool ReadBatch(CountBatch& batch) {
+            if ( m_nextJob == m_jobs.size() )
+                return false;
+            batch = m_jobs[m_nextJob++];
+            return true;
+        }
+
+        void ProcessBatch(CountBatch& batch) {
+
+            // take a free reader for job's file (no more are opened than workers run at once)
+            BamReader* reader = 0;
+            m_mutex.Lock();
+            vector<BamReader*>& freeReaders = m_freeReaders[batch.FileIndex];
+            if ( !freeReaders.empty() ) {
+                reader = freeReaders.back();
+                freeReaders.pop_back();
+            }
+            m_mutex.Unlock();
+
+            // open a new one, if necessary
+            if ( reader == 0 ) {
+                reader = new BamReader;
+                const string& filename = m_filenames[batch.FileIndex];
+                if ( !reader->Open(filename) ) {
+                    batch.ErrorString = string("could not open input BAM file: ") + filename;
+                    delete reader;
+                    return;
+                }
+                reader->LocateIndex();
+
+                m_mutex.Lock();
+                m_readers.push_back(reader);
+                m_mutex.Unlock();
+            }
+
+            if ( !reader->CountAlignments(batch.Region, batch.Count) )
+                batch.ErrorString = reader->GetErrorString();
+
+            m_mutex.Lock();
+            m_freeReaders[batch.FileIndex].push_back(reader);
+            m_mutex.Unlock();
+        }
+
+        void WriteBatch(CountBatch& batch) {
+            if ( !batch.ErrorString.empty() ) {
+                if ( m_errorString.empty() )
+                    m_errorString = batch.ErrorString;
+            } else
+                m_total += batch.Count;
+        }
+
+        // returns first error encountered (empty if all jobs were counted)
+        const string& ErrorString(void) const { return m_errorString; }
+        uint64_t Total(void) const { return m_total; }
+
+    private:
+        const vector<string>& m_filenames;
+        const vector<CountBatch>& m_jobs;
+        size_t m_nextJob;
+
+        vector<BamReader*> m_readers;
+        vector< vector<BamReader*> > m_freeReaders;  // per input file
+        BamMutex m_mutex;
+
+        uint64_t m_total;
+        string m_errorString;
+};
+
+} // namespace BamTools
+
 // ---------------------------------------------  
 // CountSettings implementation
 
@@ -30,17 +147,23 @@ struct CountTool::CountSettings {
     bool HasInput;
     bool HasInputFilelist;
     bool HasRegion;
+    bool HasNumThreads;
 
     // filenames
     vector<string> InputFiles;
     string InputFilelist;
     string Region;
+
+    // other parameters
+    unsigned int NumThreads;
     
     // constructor
     CountSettings(void)
         : HasInput(false)
         , HasInputFilelist(false)
         , HasRegion(false)
+        , HasNumThreads(false)
+        , NumThreads(COUNT_DEFAULT_NUM_THREADS)
     { }  
 }; 
   
@@ -61,6 +184,11 @@ struct CountTool::CountToolPrivate {
     public:
         bool Run(void);
 
+    // internal methods
+    private:
+        bool CountJobs(const vector<CountBatch>& jobs);
+        bool CountUnindexedRegion(BamMultiReader& reader, const BamRegion& region);
+
     // data members
     private:
         CountTool::CountSettings* m_settings;
@@ -86,76 +214,113 @@ bool CountTool::CountToolPrivate::Run(void) {
             m_settings->InputFiles.push_back(line);
     }
 
-    // open reader without index
-    BamMultiReader reader;
-    if ( !reader.Open(m_settings->InputFiles) ) {
-        cerr << "bamtools count ERROR: could not open input BAM file(s)... Aborting." << endl;
-        return false;
-    }
-
-    // alignment counter
-    BamAlignment al;
-    int alignmentCount(0);
+    // counting jobs, split up so that they may run in parallel
+    vector<CountBatch> jobs;
+    const size_t numFiles = m_settings->InputFiles.size();
 
-    // if no region specified, count entire file
+    // if no region specified, count entire files
     if ( !m_settings->HasRegion ) {
-        while ( reader.GetNextAlignmentCore(al) )
-            ++alignmentCount;
+        for ( size_t i = 0; i < numFiles; ++i )
+            jobs.push_back( CountBatch(i) );
     }
 
     // otherwise attempt to use region as constraint
     else {
 
-        // if region string parses OK
-        BamRegion region;
-        if ( Utilities::ParseRegionString(m_settings->Region, reader, region) ) {
-
-            // attempt to find index files
-            reader.LocateIndexes();
-
-            // if index data available for all BAM files, we can use SetRegion
-            if ( reader.HasIndexes() ) {
-
-                // attempt to set region on reader
-                if ( !reader.SetRegion(region.LeftRefID, region.LeftPosition, region.RightRefID, region.RightPosition) ) {
-                    cerr << "bamtools count ERROR: set region failed. Check that REGION describes a valid range" << endl;
-                    reader.Close();
-                    return false;
-                }
-
-                // everything checks out, just iterate through specified region, counting alignments
-                while ( reader.GetNextAlignmentCore(al) )
-                    ++alignmentCount;
-            }
-
-            // no index data available, we have to iterate through until we
-            // find overlapping alignments
-            else {
-                while ( reader.GetNextAlignmentCore(al) ) {
-                    if ( (al.RefID >= region.LeftRefID)  && ( (al.Position + al.Length) >= region.LeftPosition ) &&
-                          (al.RefID <= region.RightRefID) && ( al.Position <= region.RightPosition) )
-                    {
-                        ++alignmentCount;
-                    }
-                }
-            }
+        // open reader without index (region is checked against merged header data)
+        BamMultiReader reader;
+        if ( !reader.Open(m_settings->InputFiles) ) {
+            cerr << "bamtools count ERROR: could not open input BAM file(s)... Aborting." << endl;
+            return false;
         }
 
         // error parsing REGION string
-        else {
+        BamRegion region;
+        if ( !Utilities::ParseRegionString(m_settings->Region, reader, region) ) {
             cerr << "bamtools count ERROR: could not parse REGION - " << m_settings->Region << endl;
             cerr << "Check that REGION is in valid format (see documentation) and that the coordinates are valid"
                  << endl;
             reader.Close();
             return false;
         }
+
+        // no index data available, we have to iterate through until we
+        // find overlapping alignments
+        reader.LocateIndexes();
+        if ( !reader.HasIndexes() ) {
+            const bool ok = CountUnindexedRegion(reader, region);
+            reader.Close();
+            return ok;
+        }
+
+        // otherwise, count region's part on each reference separately
+        const RefVector references = reader.GetReferenceData();
+        reader.Close();
+        const int lastRefId = ( region.isRightBoundSpecified() ? region.RightRefID : (int)references.size() - 1 );
+        for ( size_t i = 0; i < numFiles; ++i ) {
+            for ( int refId = region.LeftRefID; refId <= lastRefId; ++refId ) {
+                const int begin = ( refId == region.LeftRefID ? region.LeftPosition : 0 );
+                const int end = ( (region.isRightBoundSpecified() && refId == region.RightRefID)
+                                  ? region.RightPosition : max(references.at(refId).RefLength, 1) );
+                jobs.push_back( CountBatch(i, BamRegion(refId, begin, refId, end)) );
+            }
+        }
+    }
+
+    return CountJobs(jobs);
+}
+
+// counts alignments of all jobs & prints total
+bool CountTool::CountToolPrivate::CountJobs(const vector<CountBatch>& jobs) {
+
+    CountStages stages(m_settings->InputFiles, jobs);
+
+    // if multiple threads requested, run jobs on worker threads
+    if ( m_settings->NumThreads > 1 && jobs.size() > 1 ) {
+        BatchPipeline<CountBatch, CountStages> pipeline(stages, m_settings->NumThreads);
+        pipeline.Run();
+    }
+
+    // otherwise run them one after another
+    else {
+        CountBatch batch;
+        while ( stages.ReadBatch(batch) ) {
+            stages.ProcessBatch(batch);
+            stages.WriteBatch(batch);
+        }
+    }
+
+    if ( !stages.ErrorString().empty() ) {
+        cerr << "bamtools count ERROR: could not count alignments: " << stages.ErrorString() << endl;
+        return false;
     }
 
     // print results
-    cout << alignmentCount << endl;
+    cout << stages.Total() << endl;
+    return true;
+}
 
-    // clean up & exit
-    reader.Close();
+// counts alignments overlapping region by checking every alignment (no index data available)
+bool CountTool::CountToolPrivate::CountUnindexedRegion(BamMultiReader& reader, const BamRegion& region) {
+
+    BamAlignment al;
+    uint64_t alignmentCount(0);
+    while ( reader.GetNextAlignmentCore(al) ) {
+        if ( (al.RefID >= region.LeftRefID)  && ( (al.Position + al.Length) >= region.LeftPosition ) &&
+              (al.RefID <= region.RightRefID) && ( al.Position <= region.RightPosition) )
+        {
+            ++alignmentCount;
+        }
+    }
+
+    // reading stops at input that can't be read (e.g. a malformed SAM line)
+    if ( !reader.GetErrorString().empty() ) {
+        cerr << "bamtools count ERROR: could not read input: " << reader.GetErrorString() << endl;
+        return false;
+    }
+
+    // print results
+    cout << alignmentCount << endl;
     return true;
 }
 
@@ -169,7 +334,7 @@ CountTool::CountTool(void)
 { 
     // set program details
     Options::SetProgramInfo("bamtools count", "prints number of alignments in BAM file(s)",
-                            "[-in <filename> -in <filename> ... | -list <filelist>] [-region <REGION>]");
+                            "[-in <filename> -in <filename> ... | -list <filelist>] [-region <REGION>] [-threads <count>]");
     
     // set up options 
     OptionGroup* IO_Opts = Options::CreateOptionGroup("Input & Output");
@@ -178,6 +343,10 @@ CountTool::CountTool(void)
     Options::AddValueOption("-region", "REGION",
                             "genomic region. Index file is recommended for better performance, and is used automatically if it exists. See \'bamtools help index\' for more details on creating one",
                             "", m_settings->HasRegion, m_settings->Region, IO_Opts);
+
+    OptionGroup* SettingsOpts = Options::CreateOptionGroup("Settings");
+    Options::AddValueOption("-threads", "count", "number of threads used to count separate references & files. Index statistics answer whole-reference counts without reading any alignments", "",
+                            m_settings->HasNumThreads, m_settings->NumThreads, SettingsOpts, COUNT_DEFAULT_NUM_THREADS);
 }
 
 CountTool::~CountTool(void) { 
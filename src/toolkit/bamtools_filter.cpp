@@ -11,6 +11,7 @@
 
 #include <api/BamMultiReader.h>
 #include <api/BamWriter.h>
+#include <utils/bamtools_batch_pipeline.h>
 #include <utils/bamtools_filter_engine.h>
 #include <utils/bamtools_options.h>
 #include <utils/bamtools_utilities.h>
@@ -57,175 +58,455 @@ const string QUERYBASES_PROPERTY          = "queryBases";
 const string REFERENCE_PROPERTY           = "reference";
 const string TAG_PROPERTY                 = "tag";
 
+// multi-threaded filtering
+const unsigned int FILTER_DEFAULT_NUM_THREADS = 1;
+
 // boolalpha
 const string TRUE_STR  = "true";
 const string FALSE_STR = "false";
     
 RefVector filterToolReferences;    
     
+// single typed test on an alignment, compiled from a (property, PropertyFilterValue) pair
+//
+// predicate types are listed in order of evaluation cost - a filter's predicates are sorted
+// on type, so that checks on core fields come first & char data is only built when needed
+struct AlignmentPredicate {
+
+    enum Type { FLAG_TEST = 0         // (AlignmentFlag & Mask) == Expected, optionally negated
+              , NUMERIC_COMPARE       // integer core field against Value
+              , REFERENCE_LOOKUP      // per-reference pass/fail table on RefID
+              , MATE_REFERENCE_LOOKUP // per-reference pass/fail table on MateRefID
+              , CIGAR_COMPARE         // CIGAR string against StringValue
+              , NAME_COMPARE          // -- predicates below need char data --
+              , QUERYBASES_COMPARE
+              , TAG_COMPARE
+              };
+
+    enum NumericField { ALIGNMENTFLAG_FIELD = 0
+                      , INSERTSIZE_FIELD
+                      , MAPQUALITY_FIELD
+                      , MATEREFID_FIELD
+                      , POSITION_FIELD
+                      };
+
+    // data members
+    Type PredicateType;
+    PropertyFilterValue::ValueCompareType CompareType;
+
+    // FLAG_TEST
+    uint32_t Mask;
+    uint32_t Expected;
+    bool IsNegated;
+
+    // NUMERIC_COMPARE
+    NumericField Field;
+    int64_t Value;
+
+    // REFERENCE_LOOKUP, MATE_REFERENCE_LOOKUP
+    std::vector<bool> PassTable;
+
+    // CIGAR_COMPARE, NAME_COMPARE, QUERYBASES_COMPARE
+    std::string StringValue;
+
+    // TAG_COMPARE - filter value parsed up front for each possible tag type
+    std::string TagName;
+    bool HasIntValue;
+    bool HasUIntValue;
+    bool HasRealValue;
+    bool HasStringValue;
+    int32_t  IntValue;
+    uint32_t UIntValue;
+    float    RealValue;
+    PropertyFilterValue::ValueCompareType IntCompareType;
+    PropertyFilterValue::ValueCompareType UIntCompareType;
+    PropertyFilterValue::ValueCompareType RealCompareType;
+    PropertyFilterValue::ValueCompareType StringCompareType;
+
+    // ctor
+    AlignmentPredicate(const Type& type = FLAG_TEST)
+        : PredicateType(type)
+        , CompareType(PropertyFilterValue::EXACT)
+        , Mask(0)
+        , Expected(0)
+        , IsNegated(false)
+        , Field(ALIGNMENTFLAG_FIELD)
+        , Value(0)
+        , HasIntValue(false)
+        , HasUIntValue(false)
+        , HasRealValue(false)
+        , HasStringValue(false)
+        , IntValue(0)
+        , UIntValue(0)
+        , RealValue(0.0f)
+        , IntCompareType(PropertyFilterValue::EXACT)
+        , UIntCompareType(PropertyFilterValue::EXACT)
+        , RealCompareType(PropertyFilterValue::EXACT)
+        , StringCompareType(PropertyFilterValue::EXACT)
+    { }
+
+    bool NeedsCharData(void) const { return PredicateType >= NAME_COMPARE; }
+};
+
+inline bool operator< (const AlignmentPredicate& lhs, const AlignmentPredicate& rhs) {
+    return lhs.PredicateType < rhs.PredicateType;
+}
+
 struct BamAlignmentChecker {
-    bool check(const PropertyFilter& filter, const BamAlignment& al) {
-      
-        bool keepAlignment = true;
+
+    // a filter set's properties, as a flat list of predicates (all must pass)
+    struct CompiledFilter {
+        std::vector<AlignmentPredicate> Predicates;
+        size_t FirstCharDataPredicate;
+        CompiledFilter(void) : FirstCharDataPredicate(0) { }
+    };
+
+    CompiledFilter compile(const PropertyFilter& filter) {
+
+        CompiledFilter result;
+        vector<AlignmentPredicate>& predicates = result.Predicates;
+
         const PropertyMap& properties = filter.Properties;
         PropertyMap::const_iterator propertyIter = properties.begin();
         PropertyMap::const_iterator propertyEnd  = properties.end();
         for ( ; propertyIter != propertyEnd; ++propertyIter ) {
-          
-            // check alignment data field depending on propertyName
+
+            // compile alignment data field check depending on propertyName
             const string& propertyName = (*propertyIter).first;
             const PropertyFilterValue& valueFilter = (*propertyIter).second;
-            
-            if      ( propertyName == ALIGNMENTFLAG_PROPERTY )  keepAlignment &= valueFilter.check(al.AlignmentFlag);
-            else if ( propertyName == CIGAR_PROPERTY ) {
-                stringstream cigarSs;
-                const vector<CigarOp>& cigarData = al.CigarData;
-                if ( !cigarData.empty() ) {
-                    vector<CigarOp>::const_iterator cigarBegin = cigarData.begin();
-                    vector<CigarOp>::const_iterator cigarIter = cigarBegin;
-                    vector<CigarOp>::const_iterator cigarEnd  = cigarData.end();
-                    for ( ; cigarIter != cigarEnd; ++cigarIter ) {
-                        const CigarOp& op = (*cigarIter);
-                        cigarSs << op.Length << op.Type;
-                    }
-                    keepAlignment &= valueFilter.check(cigarSs.str());
-                }
-            }
-            else if ( propertyName == INSERTSIZE_PROPERTY )           keepAlignment &= valueFilter.check(al.InsertSize);
-            else if ( propertyName == ISDUPLICATE_PROPERTY )          keepAlignment &= valueFilter.check(al.IsDuplicate());
-            else if ( propertyName == ISFAILEDQC_PROPERTY )           keepAlignment &= valueFilter.check(al.IsFailedQC());
-            else if ( propertyName == ISFIRSTMATE_PROPERTY )          keepAlignment &= valueFilter.check(al.IsFirstMate());
-            else if ( propertyName == ISMAPPED_PROPERTY )             keepAlignment &= valueFilter.check(al.IsMapped());
-            else if ( propertyName == ISMATEMAPPED_PROPERTY )         keepAlignment &= valueFilter.check(al.IsMateMapped());
-            else if ( propertyName == ISMATEREVERSESTRAND_PROPERTY )  keepAlignment &= valueFilter.check(al.IsMateReverseStrand());
-            else if ( propertyName == ISPAIRED_PROPERTY )             keepAlignment &= valueFilter.check(al.IsPaired());
-            else if ( propertyName == ISPRIMARYALIGNMENT_PROPERTY )   keepAlignment &= valueFilter.check(al.IsPrimaryAlignment());
-            else if ( propertyName == ISPROPERPAIR_PROPERTY )         keepAlignment &= valueFilter.check(al.IsProperPair());
-            else if ( propertyName == ISREVERSESTRAND_PROPERTY )      keepAlignment &= valueFilter.check(al.IsReverseStrand());
-            else if ( propertyName == ISSECONDMATE_PROPERTY )         keepAlignment &= valueFilter.check(al.IsSecondMate());
+
+            if      ( propertyName == ALIGNMENTFLAG_PROPERTY ) compileNumeric<uint32_t>(predicates, AlignmentPredicate::ALIGNMENTFLAG_FIELD, valueFilter);
+            else if ( propertyName == CIGAR_PROPERTY )         compileString(predicates, AlignmentPredicate::CIGAR_COMPARE, valueFilter);
+            else if ( propertyName == INSERTSIZE_PROPERTY )    compileNumeric<int32_t>(predicates, AlignmentPredicate::INSERTSIZE_FIELD, valueFilter);
+            else if ( propertyName == ISDUPLICATE_PROPERTY )          compileFlag(predicates, Constants::BAM_ALIGNMENT_DUPLICATE,          Constants::BAM_ALIGNMENT_DUPLICATE,          valueFilter);
+            else if ( propertyName == ISFAILEDQC_PROPERTY )           compileFlag(predicates, Constants::BAM_ALIGNMENT_QC_FAILED,          Constants::BAM_ALIGNMENT_QC_FAILED,          valueFilter);
+            else if ( propertyName == ISFIRSTMATE_PROPERTY )          compileFlag(predicates, Constants::BAM_ALIGNMENT_READ_1,             Constants::BAM_ALIGNMENT_READ_1,             valueFilter);
+            else if ( propertyName == ISMAPPED_PROPERTY )             compileFlag(predicates, Constants::BAM_ALIGNMENT_UNMAPPED,           0,                                           valueFilter);
+            else if ( propertyName == ISMATEMAPPED_PROPERTY )         compileFlag(predicates, Constants::BAM_ALIGNMENT_MATE_UNMAPPED,      0,                                           valueFilter);
+            else if ( propertyName == ISMATEREVERSESTRAND_PROPERTY )  compileFlag(predicates, Constants::BAM_ALIGNMENT_MATE_REVERSE_STRAND, Constants::BAM_ALIGNMENT_MATE_REVERSE_STRAND, valueFilter);
+            else if ( propertyName == ISPAIRED_PROPERTY )             compileFlag(predicates, Constants::BAM_ALIGNMENT_PAIRED,             Constants::BAM_ALIGNMENT_PAIRED,             valueFilter);
+            else if ( propertyName == ISPRIMARYALIGNMENT_PROPERTY )   compileFlag(predicates, Constants::BAM_ALIGNMENT_SECONDARY,          0,                                           valueFilter);
+            else if ( propertyName == ISPROPERPAIR_PROPERTY )         compileFlag(predicates, Constants::BAM_ALIGNMENT_PROPER_PAIR,        Constants::BAM_ALIGNMENT_PROPER_PAIR,        valueFilter);
+            else if ( propertyName == ISREVERSESTRAND_PROPERTY )      compileFlag(predicates, Constants::BAM_ALIGNMENT_REVERSE_STRAND,     Constants::BAM_ALIGNMENT_REVERSE_STRAND,     valueFilter);
+            else if ( propertyName == ISSECONDMATE_PROPERTY )         compileFlag(predicates, Constants::BAM_ALIGNMENT_READ_2,             Constants::BAM_ALIGNMENT_READ_2,             valueFilter);
             else if ( propertyName == ISSINGLETON_PROPERTY ) {
-                const bool isSingleton = al.IsPaired() && al.IsMapped() && !al.IsMateMapped();
-                keepAlignment &= valueFilter.check(isSingleton);
+                // paired, mapped & mate unmapped
+                compileFlag(predicates, SINGLETON_MASK, SINGLETON_EXPECTED, valueFilter);
             }
-            else if ( propertyName == MAPQUALITY_PROPERTY )           keepAlignment &= valueFilter.check(al.MapQuality);
-            else if ( propertyName == MATEPOSITION_PROPERTY )         keepAlignment &= ( al.IsPaired() && al.IsMateMapped() && valueFilter.check(al.MateRefID) );
-            else if ( propertyName == MATEREFERENCE_PROPERTY ) {
-                if ( !al.IsPaired() || !al.IsMateMapped() ) return false;
-                BAMTOOLS_ASSERT_MESSAGE( (al.MateRefID>=0 && (al.MateRefID<(int)filterToolReferences.size())), "Invalid MateRefID");
-                const string& refName = filterToolReferences.at(al.MateRefID).RefName;
-                keepAlignment &= valueFilter.check(refName);
+            else if ( propertyName == MAPQUALITY_PROPERTY ) compileNumeric<uint16_t>(predicates, AlignmentPredicate::MAPQUALITY_FIELD, valueFilter);
+            else if ( propertyName == MATEPOSITION_PROPERTY ) {
+                // requires paired & mate mapped, value is checked against MateRefID (as it always has been)
+                predicates.push_back( flagTest(MATE_MAPPED_MASK, MATE_MAPPED_EXPECTED, false) );
+                compileNumeric<int32_t>(predicates, AlignmentPredicate::MATEREFID_FIELD, valueFilter);
             }
-            else if ( propertyName == NAME_PROPERTY )                 keepAlignment &= valueFilter.check(al.Name);
-            else if ( propertyName == POSITION_PROPERTY )             keepAlignment &= valueFilter.check(al.Position);
-            else if ( propertyName == QUERYBASES_PROPERTY )           keepAlignment &= valueFilter.check(al.QueryBases);
-            else if ( propertyName == REFERENCE_PROPERTY ) {
-                BAMTOOLS_ASSERT_MESSAGE( (al.RefID>=0 && (al.RefID<(int)filterToolReferences.size())), "Invalid RefID");
-                const string& refName = filterToolReferences.at(al.RefID).RefName;
-                keepAlignment &= valueFilter.check(refName);
+            else if ( propertyName == MATEREFERENCE_PROPERTY ) {
+                // requires paired & mate mapped
+                predicates.push_back( flagTest(MATE_MAPPED_MASK, MATE_MAPPED_EXPECTED, false) );
+                compileReference(predicates, AlignmentPredicate::MATE_REFERENCE_LOOKUP, valueFilter);
             }
-            else if ( propertyName == TAG_PROPERTY ) keepAlignment &= checkAlignmentTag(valueFilter, al);
+            else if ( propertyName == NAME_PROPERTY )       compileString(predicates, AlignmentPredicate::NAME_COMPARE, valueFilter);
+            else if ( propertyName == POSITION_PROPERTY )   compileNumeric<int32_t>(predicates, AlignmentPredicate::POSITION_FIELD, valueFilter);
+            else if ( propertyName == QUERYBASES_PROPERTY ) compileString(predicates, AlignmentPredicate::QUERYBASES_COMPARE, valueFilter);
+            else if ( propertyName == REFERENCE_PROPERTY )  compileReference(predicates, AlignmentPredicate::REFERENCE_LOOKUP, valueFilter);
+            else if ( propertyName == TAG_PROPERTY )        compileTag(predicates, valueFilter);
             else BAMTOOLS_ASSERT_UNREACHABLE;
-            
+        }
+
+        // cheap core checks first, char data checks last
+        std::stable_sort(predicates.begin(), predicates.end());
+        result.FirstCharDataPredicate = predicates.size();
+        for ( size_t i = 0; i < predicates.size(); ++i ) {
+            if ( predicates[i].NeedsCharData() ) {
+                result.FirstCharDataPredicate = i;
+                break;
+            }
+        }
+        return result;
+    }
+
+    bool check(const CompiledFilter& filter, BamAlignment& al) {
+
+        const vector<AlignmentPredicate>& predicates = filter.Predicates;
+        const size_t numPredicates = predicates.size();
+        for ( size_t i = 0; i < numPredicates; ++i ) {
+
+            // only populate char data once all core checks have passed
+            if ( i == filter.FirstCharDataPredicate )
+                al.BuildCharData();
+
             // if alignment fails at ANY point, just quit and return false
-            if ( !keepAlignment ) return false;
+            if ( !checkPredicate(predicates[i], al) )
+                return false;
         }
-      
-        BAMTOOLS_ASSERT_MESSAGE( keepAlignment, "Error in BamAlignmentChecker... keepAlignment should be true here");
-        return keepAlignment;
+        return true;
     }
-    
-    bool checkAlignmentTag(const PropertyFilterValue& valueFilter, const BamAlignment& al) {
-     
-        // ensure filter contains string data
-        Variant entireTagFilter = valueFilter.Value;
-        if ( !entireTagFilter.is_type<string>() ) return false;
-
-        // localize string from variant
-        const string& entireTagFilterString = entireTagFilter.get<string>();
-
-        // ensure we have at least "XX:x"
-        if ( entireTagFilterString.length() < 4 ) return false;
-
-        // get tagName & lookup in alignment
-        // if found, set tagType to tag type character
-        // if not found, return false
-        const string& tagName = entireTagFilterString.substr(0,2);
-        char tagType = '\0';
-        if ( !al.GetTagType(tagName, tagType) ) return false;
-
-        // remove tagName & ":" from beginning tagFilter
-        string tagFilterString = entireTagFilterString.substr(3);
-
-        // switch on tag type to set tag query value & parse filter token
-        int32_t  intFilterValue,    intQueryValue;
-        uint32_t uintFilterValue,   uintQueryValue;
-        float    realFilterValue,   realQueryValue;
-        string   stringFilterValue, stringQueryValue;
-
-        PropertyFilterValue tagFilter;
-        PropertyFilterValue::ValueCompareType compareType;
-        bool keepAlignment = false;
-        switch (tagType) {
-
-            // signed int tag type
-            case 'c' :
-            case 's' :
-            case 'i' :
-                if ( al.GetTag(tagName, intQueryValue) ) {
-                    if ( FilterEngine<BamAlignmentChecker>::parseToken(tagFilterString, intFilterValue, compareType) ) {
-                        tagFilter.Value = intFilterValue;
-                        tagFilter.Type  = compareType;
-                        keepAlignment   = tagFilter.check(intQueryValue);
-                    }
-                }
-                break;
 
-            // unsigned int tag type
-            case 'C' :
-            case 'S' :
-            case 'I' :
-                if ( al.GetTag(tagName, uintQueryValue) ) {
-                    if ( FilterEngine<BamAlignmentChecker>::parseToken(tagFilterString, uintFilterValue, compareType) ) {
-                        tagFilter.Value = uintFilterValue;
-                        tagFilter.Type  = compareType;
-                        keepAlignment   = tagFilter.check(uintQueryValue);
-                    }
-                }
-                break;
+    private:
+
+        static const uint32_t MATE_MAPPED_MASK     = Constants::BAM_ALIGNMENT_PAIRED | Constants::BAM_ALIGNMENT_MATE_UNMAPPED;
+        static const uint32_t MATE_MAPPED_EXPECTED = Constants::BAM_ALIGNMENT_PAIRED;
+        static const uint32_t SINGLETON_MASK       = Constants::BAM_ALIGNMENT_PAIRED | Constants::BAM_ALIGNMENT_UNMAPPED | Constants::BAM_ALIGNMENT_MATE_UNMAPPED;
+        static const uint32_t SINGLETON_EXPECTED   = Constants::BAM_ALIGNMENT_PAIRED | Constants::BAM_ALIGNMENT_MATE_UNMAPPED;
+
+        static AlignmentPredicate flagTest(const uint32_t mask, const uint32_t expected, const bool isNegated) {
+            AlignmentPredicate predicate(AlignmentPredicate::FLAG_TEST);
+            predicate.Mask      = mask;
+            predicate.Expected  = expected;
+            predicate.IsNegated = isNegated;
+            return predicate;
+        }
+
+        // boolean property is true when (flag & mask) == expectedIfTrue
+        // the filter is evaluated for both possible values, to see which one(s) pass
+        void compileFlag(vector<AlignmentPredicate>& predicates,
+                         const uint32_t mask,
+                         const uint32_t expectedIfTrue,
+                         const PropertyFilterValue& valueFilter)
+        {
+            const bool passesIfTrue  = valueFilter.check(true);
+            const bool passesIfFalse = valueFilter.check(false);
+
+            if ( passesIfTrue && passesIfFalse )
+                return; // no constraint
+            else if ( passesIfTrue )
+                predicates.push_back( flagTest(mask, expectedIfTrue, false) );
+            else if ( passesIfFalse )
+                predicates.push_back( flagTest(mask, expectedIfTrue, true) );
+            else
+                predicates.push_back( flagTest(0, 0, true) ); // never passes
+        }
+
+        template<typename T>
+        void compileNumeric(vector<AlignmentPredicate>& predicates,
+                            const AlignmentPredicate::NumericField& field,
+                            const PropertyFilterValue& valueFilter)
+        {
+            AlignmentPredicate predicate(AlignmentPredicate::NUMERIC_COMPARE);
+            if ( valueFilter.Value.is_type<T>() ) {
+                predicate.Field       = field;
+                predicate.Value       = static_cast<int64_t>( valueFilter.Value.get<T>() );
+                predicate.CompareType = valueFilter.Type;
+            } else {
+                std::cerr << "Cannot compare different types!" << std::endl;
+                predicate = flagTest(0, 0, true);
+            }
+            predicates.push_back(predicate);
+        }
+
+        // reference names are known up front, so each filter is checked once per reference
+        void compileReference(vector<AlignmentPredicate>& predicates,
+                              const AlignmentPredicate::Type& type,
+                              const PropertyFilterValue& valueFilter)
+        {
+            AlignmentPredicate predicate(type);
+            predicate.PassTable.reserve(filterToolReferences.size());
+            RefVector::const_iterator refIter = filterToolReferences.begin();
+            RefVector::const_iterator refEnd  = filterToolReferences.end();
+            for ( ; refIter != refEnd; ++refIter )
+                predicate.PassTable.push_back( valueFilter.check((*refIter).RefName) );
+            predicates.push_back(predicate);
+        }
+
+        void compileString(vector<AlignmentPredicate>& predicates,
+                           const AlignmentPredicate::Type& type,
+                           const PropertyFilterValue& valueFilter)
+        {
+            AlignmentPredicate predicate(type);
+            if ( valueFilter.Value.is_type<string>() ) {
+                predicate.StringValue = valueFilter.Value.get<string>();
+                predicate.CompareType = valueFilter.Type;
+            } else {
+                std::cerr << "Cannot compare different types!" << std::endl;
+                predicate = flagTest(0, 0, true);
+            }
+            predicates.push_back(predicate);
+        }
+
+        // tag filters are stored as "TAG:VALUE", with VALUE parsed according to each alignment's tag type
+        void compileTag(vector<AlignmentPredicate>& predicates, const PropertyFilterValue& valueFilter) {
+
+            // ensure filter contains string data, of at least "XX:x"
+            if ( !valueFilter.Value.is_type<string>() ||
+                 valueFilter.Value.get<string>().length() < 4 )
+            {
+                predicates.push_back( flagTest(0, 0, true) );
+                return;
+            }
+
+            // split tag name & filter token
+            const string& entireTagFilterString = valueFilter.Value.get<string>();
+            const string tagFilterString = entireTagFilterString.substr(3);
+
+            AlignmentPredicate predicate(AlignmentPredicate::TAG_COMPARE);
+            predicate.TagName = entireTagFilterString.substr(0,2);
+            predicate.HasIntValue    = FilterEngine<BamAlignmentChecker>::parseToken(tagFilterString, predicate.IntValue,    predicate.IntCompareType);
+            predicate.HasUIntValue   = FilterEngine<BamAlignmentChecker>::parseToken(tagFilterString, predicate.UIntValue,   predicate.UIntCompareType);
+            predicate.HasRealValue   = FilterEngine<BamAlignmentChecker>::parseToken(tagFilterString, predicate.RealValue,   predicate.RealCompareType);
+            predicate.HasStringValue = FilterEngine<BamAlignmentChecker>::parseToken(tagFilterString, predicate.StringValue, predicate.StringCompareType);
+            predicates.push_back(predicate);
+        }
+
+        bool checkPredicate(const AlignmentPredicate& predicate, const BamAlignment& al) const {
+
+            switch ( predicate.PredicateType ) {
 
-            // 'real' tag type
-            case 'f' :
-                if ( al.GetTag(tagName, realQueryValue) ) {
-                    if ( FilterEngine<BamAlignmentChecker>::parseToken(tagFilterString, realFilterValue, compareType) ) {
-                        tagFilter.Value = realFilterValue;
-                        tagFilter.Type  = compareType;
-                        keepAlignment   = tagFilter.check(realQueryValue);
+                case ( AlignmentPredicate::FLAG_TEST ) :
+                    return ( ((al.AlignmentFlag & predicate.Mask) == predicate.Expected) != predicate.IsNegated );
+
+                case ( AlignmentPredicate::NUMERIC_COMPARE ) : {
+                    int64_t query = 0;
+                    switch ( predicate.Field ) {
+                        case ( AlignmentPredicate::ALIGNMENTFLAG_FIELD ) : query = al.AlignmentFlag; break;
+                        case ( AlignmentPredicate::INSERTSIZE_FIELD )    : query = al.InsertSize;    break;
+                        case ( AlignmentPredicate::MAPQUALITY_FIELD )    : query = al.MapQuality;    break;
+                        case ( AlignmentPredicate::MATEREFID_FIELD )     : query = al.MateRefID;     break;
+                        case ( AlignmentPredicate::POSITION_FIELD )      : query = al.Position;      break;
+                        default : BAMTOOLS_ASSERT_UNREACHABLE;
                     }
+                    return PropertyFilterValue::compare(query, predicate.Value, predicate.CompareType);
                 }
-                break;
 
-            // string tag type
-            case 'A':
-            case 'Z':
-            case 'H':
-                if ( al.GetTag(tagName, stringQueryValue) ) {
-                    if ( FilterEngine<BamAlignmentChecker>::parseToken(tagFilterString, stringFilterValue, compareType) ) {
-                        tagFilter.Value = stringFilterValue;
-                        tagFilter.Type  = compareType;
-                        keepAlignment   = tagFilter.check(stringQueryValue);
+                case ( AlignmentPredicate::REFERENCE_LOOKUP ) :
+                    return ( al.RefID >= 0 && al.RefID < (int)predicate.PassTable.size() && predicate.PassTable[al.RefID] );
+
+                case ( AlignmentPredicate::MATE_REFERENCE_LOOKUP ) :
+                    return ( al.MateRefID >= 0 && al.MateRefID < (int)predicate.PassTable.size() && predicate.PassTable[al.MateRefID] );
+
+                case ( AlignmentPredicate::CIGAR_COMPARE ) : {
+                    // alignments without CIGAR are not checked
+                    const vector<CigarOp>& cigarData = al.CigarData;
+                    if ( cigarData.empty() )
+                        return true;
+                    stringstream cigarSs;
+                    vector<CigarOp>::const_iterator cigarIter = cigarData.begin();
+                    vector<CigarOp>::const_iterator cigarEnd  = cigarData.end();
+                    for ( ; cigarIter != cigarEnd; ++cigarIter ) {
+                        const CigarOp& op = (*cigarIter);
+                        cigarSs << op.Length << op.Type;
                     }
+                    return PropertyFilterValue::compare(cigarSs.str(), predicate.StringValue, predicate.CompareType);
                 }
-                break;
 
-            // unknown tag type
-            default :
-                keepAlignment = false;
+                case ( AlignmentPredicate::NAME_COMPARE ) :
+                    return PropertyFilterValue::compare(al.Name, predicate.StringValue, predicate.CompareType);
+
+                case ( AlignmentPredicate::QUERYBASES_COMPARE ) :
+                    return PropertyFilterValue::compare(al.QueryBases, predicate.StringValue, predicate.CompareType);
+
+                case ( AlignmentPredicate::TAG_COMPARE ) :
+                    return checkAlignmentTag(predicate, al);
+
+                default :
+                    BAMTOOLS_ASSERT_UNREACHABLE;
+            }
+            return false;
         }
 
-        return keepAlignment;
-    }
-};    
-    
+        bool checkAlignmentTag(const AlignmentPredicate& predicate, const BamAlignment& al) const {
+
+            // lookup tagName in alignment
+            // if found, set tagType to tag type character
+            // if not found, return false
+            char tagType = '\0';
+            if ( !al.GetTagType(predicate.TagName, tagType) ) return false;
+
+            // switch on tag type to retrieve tag query value & compare with pre-parsed filter value
+            int32_t  intQueryValue;
+            uint32_t uintQueryValue;
+            float    realQueryValue;
+            string   stringQueryValue;
+
+            switch (tagType) {
+
+                // signed int tag type
+                case 'c' :
+                case 's' :
+                case 'i' :
+                    return ( predicate.HasIntValue &&
+                             al.GetTag(predicate.TagName, intQueryValue) &&
+                             PropertyFilterValue::compare(intQueryValue, predicate.IntValue, predicate.IntCompareType) );
+
+                // unsigned int tag type
+                case 'C' :
+                case 'S' :
+                case 'I' :
+                    return ( predicate.HasUIntValue &&
+                             al.GetTag(predicate.TagName, uintQueryValue) &&
+                             PropertyFilterValue::compare(uintQueryValue, predicate.UIntValue, predicate.UIntCompareType) );
+
+                // 'real' tag type
+                case 'f' :
+                    return ( predicate.HasRealValue &&
+                             al.GetTag(predicate.TagName, realQueryValue) &&
+                             PropertyFilterValue::compare(realQueryValue, predicate.RealValue, predicate.RealCompareType) );
+
+                // string tag type
+                case 'A':
+                case 'Z':
+                case 'H':
+                    return ( predicate.HasStringValue &&
+                             al.GetTag(predicate.TagName, stringQueryValue) &&
+                             PropertyFilterValue::compare(stringQueryValue, predicate.StringValue, predicate.StringCompareType) );
+
+                // unknown tag type
+                default :
+                    return false;
+            }
+        }
+};
+
+// batch of alignments, passed through the multi-threaded filter pipeline
+struct FilterBatch : public AlignmentBatch {
+    vector<char> IsKept;
+
+    FilterBatch(void)
+        : IsKept(Alignments.size(), 0)
+    { }
+};
+
+// BatchPipeline stages for filtering with multiple threads:
+//   reader thread  : reads alignment core data (& applies region, if not indexed)
+//   worker threads : check alignments against (pre-compiled) filter engine
+//   calling thread : writes kept alignments, in input order
+class FilterStages {
+
+    public:
+        FilterStages(BamMultiReader& reader,
+                     BamWriter& writer,
+                     FilterEngine<BamAlignmentChecker>& filterEngine,
+                     const bool isManualRegion,
+                     const BamRegion& region)
+            : m_reader(reader)
+            , m_writer(writer)
+            , m_filterEngine(filterEngine)
+            , m_isManualRegion(isManualRegion)
+            , m_region(region)
+        { }
+
+        bool ReadBatch(FilterBatch& batch) {
+            return ReadAlignmentBatch(m_reader, batch, false, ( m_isManualRegion ? &m_region : 0 ));
+        }
+
+        void ProcessBatch(FilterBatch& batch) {
+            for ( size_t i = 0; i < batch.Count; ++i )
+                batch.IsKept[i] = ( m_filterEngine.check(batch.Alignments[i]) ? 1 : 0 );
+        }
+
+        void WriteBatch(FilterBatch& batch) {
+            for ( size_t i = 0; i < batch.Count; ++i ) {
+                if ( batch.IsKept[i] )
+                    m_writer.SaveAlignment(batch.Alignments[i]);
+            }
+        }
+
+    private:
+        BamMultiReader& m_reader;
+        BamWriter& m_writer;
+        FilterEngine<BamAlignmentChecker>& m_filterEngine;
+        bool m_isManualRegion;
+        BamRegion m_region;
+};
+
 } // namespace BamTools
   
 // ---------------------------------------------
@@ -242,6 +523,7 @@ struct FilterTool::FilterSettings {
     bool HasOutput;
     bool HasRegion;
     bool HasScript;
+    bool HasNumThreads;
     bool IsForceCompression;
 
     // filenames
@@ -250,6 +532,7 @@ struct FilterTool::FilterSettings {
     string OutputFilename;
     string Region;
     string ScriptFilename;
+    unsigned int NumThreads;
 
     // -----------------------------------
     // General filter opts
@@ -310,8 +593,10 @@ struct FilterTool::FilterSettings {
         , HasOutput(false)
         , HasRegion(false)
         , HasScript(false)
+        , HasNumThreads(false)
         , IsForceCompression(false)
         , OutputFilename(Options::StandardOut())
+        , NumThreads(FILTER_DEFAULT_NUM_THREADS)
         , HasAlignmentFlagFilter(false)
         , HasInsertSizeFilter(false)
         , HasMapQualityFilter(false)
@@ -362,7 +647,7 @@ class FilterTool::FilterToolPrivate {
     // internal methods
     private:
         bool AddPropertyTokensToFilter(const string& filterName, const map<string, string>& propertyTokens);
-        bool CheckAlignment(const BamAlignment& al);
+        bool CheckAlignment(BamAlignment& al);
         const string GetScriptContents(void);
         void InitProperties(void);
         bool ParseCommandLine(void);
@@ -482,7 +767,7 @@ bool FilterTool::FilterToolPrivate::AddPropertyTokensToFilter(const string& filt
     return true;
 }
 
-bool FilterTool::FilterToolPrivate::CheckAlignment(const BamAlignment& al) {
+bool FilterTool::FilterToolPrivate::CheckAlignment(BamAlignment& al) {
     return m_filterEngine.check(al);
 }
 
@@ -729,75 +1014,74 @@ bool FilterTool::FilterToolPrivate::Run(void) {
     // open BamWriter
     BamWriter writer;
     writer.SetCompressionMode(compressionMode);
+    writer.SetNumThreads(m_settings->NumThreads);
     if ( !writer.Open(m_settings->OutputFilename, headerText, filterToolReferences) ) {
         cerr << "bamtools filter ERROR: could not open " << m_settings->OutputFilename << " for writing." << endl;
         reader.Close();
         return false;
     }
 
-    // if no region specified, filter entire file 
-    BamAlignment al;
-    if ( !m_settings->HasRegion ) {
-        while ( reader.GetNextAlignment(al) ) {
-            if ( CheckAlignment(al) ) 
-                writer.SaveAlignment(al);
-        }
-    }
-    
-    // otherwise attempt to use region as constraint
-    else {
-        
-        // if region string parses OK
-        BamRegion region;
-        if ( Utilities::ParseRegionString(m_settings->Region, reader, region) ) {
-
-            // attempt to find index files
-            reader.LocateIndexes();
+    // if region specified, attempt to use it as constraint
+    BamRegion region;
+    bool isManualRegion = false;
+    if ( m_settings->HasRegion ) {
 
-            // if index data available for all BAM files, we can use SetRegion
-            if ( reader.HasIndexes() ) {
-
-                // attempt to use SetRegion(), if failed report error
-                if ( !reader.SetRegion(region.LeftRefID, region.LeftPosition, region.RightRefID, region.RightPosition) ) {
-                    cerr << "bamtools filter ERROR: set region failed. Check that REGION describes a valid range" << endl;
-                    reader.Close();
-                    return false;
-                } 
-              
-                // everything checks out, just iterate through specified region, filtering alignments
-                while ( reader.GetNextAlignment(al) )
-                    if ( CheckAlignment(al) ) 
-                        writer.SaveAlignment(al);
-                }
-            
-            // no index data available, we have to iterate through until we
-            // find overlapping alignments
-            else {
-                while ( reader.GetNextAlignment(al) ) {
-                    if ( (al.RefID >= region.LeftRefID)  && ((al.Position + al.Length) >= region.LeftPosition) &&
-                         (al.RefID <= region.RightRefID) && ( al.Position <= region.RightPosition) ) 
-                    {
-                        if ( CheckAlignment(al) ) 
-                            writer.SaveAlignment(al);
-                    }
-                }
-            }
-        } 
-        
         // error parsing REGION string
-        else {
+        if ( !Utilities::ParseRegionString(m_settings->Region, reader, region) ) {
             cerr << "bamtools filter ERROR: could not parse REGION: " << m_settings->Region << endl;
             cerr << "Check that REGION is in valid format (see documentation) and that the coordinates are valid"
                  << endl;
             reader.Close();
             return false;
         }
+
+        // attempt to find index files
+        reader.LocateIndexes();
+
+        // if index data available for all BAM files, we can use SetRegion
+        if ( reader.HasIndexes() ) {
+
+            // attempt to use SetRegion(), if failed report error
+            if ( !reader.SetRegion(region.LeftRefID, region.LeftPosition, region.RightRefID, region.RightPosition) ) {
+                cerr << "bamtools filter ERROR: set region failed. Check that REGION describes a valid range" << endl;
+                reader.Close();
+                return false;
+            }
+        }
+
+        // no index data available, we have to iterate through until we
+        // find overlapping alignments
+        else isManualRegion = true;
     }
 
+    // if multiple threads requested, check alignments in batches on worker threads
+    if ( m_settings->NumThreads > 1 ) {
+        m_filterEngine.compile();
+        FilterStages stages(reader, writer, m_filterEngine, isManualRegion, region);
+        BatchPipeline<FilterBatch, FilterStages> pipeline(stages, m_settings->NumThreads);
+        pipeline.Run();
+    }
+
+    // otherwise filter alignments one at a time
+    else {
+        BamAlignment al;
+        while ( reader.GetNextAlignmentCore(al) ) {
+            if ( isManualRegion && !IsOverlapping(al, region) )
+                continue;
+            if ( CheckAlignment(al) )
+                writer.SaveAlignment(al);
+        }
+    }
+
+    // reading stops at input that can't be read (e.g. a malformed SAM line)
+    const bool isReadOk = reader.GetErrorString().empty();
+    if ( !isReadOk )
+        cerr << "bamtools filter ERROR: could not read input: " << reader.GetErrorString() << endl;
+
     // clean up & exit
     reader.Close();
     writer.Close();
-    return true;
+    return isReadOk;
 }
 
 bool FilterTool::FilterToolPrivate::SetupFilters(void) {
@@ -825,7 +1109,7 @@ FilterTool::FilterTool(void)
     // set program details
 
     const string usage = "[-in <filename> -in <filename> ... | -list <filelist>] "
-                         "[-out <filename> | [-forceCompression]] [-region <REGION>] "
+                         "[-out <filename> | [-forceCompression]] [-region <REGION>] [-threads <count>] "
                          "[ [-script <filename] | [filterOptions] ]";
 
     Options::SetProgramInfo("bamtools filter", "filters BAM file(s)", usage );
@@ -843,6 +1127,7 @@ FilterTool::FilterTool(void)
     const string forceDesc  = "if results are sent to stdout (like when piping to another tool), "
                               "default behavior is to leave output uncompressed. Use this flag to "
                               "override and force compression";
+    const string threadsDesc = "number of threads used to check & compress alignments";
 
     Options::AddValueOption("-in",     "BAM filename", inDesc,     "", m_settings->HasInput,  m_settings->InputFiles,     IO_Opts, Options::StandardIn());
     Options::AddValueOption("-list",   "filename",     listDesc,   "", m_settings->HasInputFilelist,  m_settings->InputFilelist, IO_Opts);
@@ -850,6 +1135,7 @@ FilterTool::FilterTool(void)
     Options::AddValueOption("-region", "REGION",       regionDesc, "", m_settings->HasRegion, m_settings->Region,         IO_Opts);
     Options::AddValueOption("-script", "filename",     scriptDesc, "", m_settings->HasScript, m_settings->ScriptFilename, IO_Opts);
     Options::AddOption("-forceCompression",forceDesc, m_settings->IsForceCompression, IO_Opts);
+    Options::AddValueOption("-threads", "count", threadsDesc, "", m_settings->HasNumThreads, m_settings->NumThreads, IO_Opts, FILTER_DEFAULT_NUM_THREADS);
 
     // ----------------------------------
     // general filter options
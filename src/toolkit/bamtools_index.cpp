@@ -17,6 +17,19 @@ using namespace BamTools;
 #include <string>
 using namespace std;
 
+namespace BamTools {
+
+// CSI defaults (same bins as standard BAM index)
+const unsigned int INDEX_DEFAULT_CSI_MIN_SHIFT = 14;
+const unsigned int INDEX_DEFAULT_CSI_DEPTH     = 5;
+const unsigned int INDEX_MIN_CSI_MIN_SHIFT     = 10;
+const unsigned int INDEX_MAX_CSI_DEPTH         = 10;    // bin IDs must fit in 32 bits
+
+// number of threads used to decompress input
+const unsigned int INDEX_DEFAULT_NUM_THREADS = 1;
+
+} // namespace BamTools
+
 // ---------------------------------------------
 // IndexSettings implementation
 
@@ -25,15 +38,33 @@ struct IndexTool::IndexSettings {
     // flags
     bool HasInputBamFilename;
     bool IsUsingBamtoolsIndex;
+    bool IsUsingCsiIndex;
+    bool HasMinShift;
+    bool HasDepth;
+    bool HasNumThreads;
 
     // filenames
     string InputBamFilename;
+
+    // CSI bin scheme
+    unsigned int MinShift;
+    unsigned int Depth;
+
+    // threading
+    unsigned int NumThreads;
     
     // constructor
     IndexSettings(void)
         : HasInputBamFilename(false)
         , IsUsingBamtoolsIndex(false)
+        , IsUsingCsiIndex(false)
+        , HasMinShift(false)
+        , HasDepth(false)
+        , HasNumThreads(false)
         , InputBamFilename(Options::StandardIn())
+        , MinShift(INDEX_DEFAULT_CSI_MIN_SHIFT)
+        , Depth(INDEX_DEFAULT_CSI_DEPTH)
+        , NumThreads(INDEX_DEFAULT_NUM_THREADS)
     { }
 };  
 
@@ -61,8 +92,23 @@ struct IndexTool::IndexToolPrivate {
 
 bool IndexTool::IndexToolPrivate::Run(void) {
 
+    // check CSI bin scheme up front
+    if ( m_settings->IsUsingCsiIndex ) {
+        if ( m_settings->MinShift < INDEX_MIN_CSI_MIN_SHIFT ) {
+            cerr << "bamtools index ERROR: -minshift must be at least " << INDEX_MIN_CSI_MIN_SHIFT
+                 << " (got " << m_settings->MinShift << ")" << endl;
+            return false;
+        }
+        if ( m_settings->Depth > INDEX_MAX_CSI_DEPTH ) {
+            cerr << "bamtools index ERROR: -depth must be at most " << INDEX_MAX_CSI_DEPTH
+                 << " (got " << m_settings->Depth << ")" << endl;
+            return false;
+        }
+    }
+
     // open our BAM reader
     BamReader reader;
+    reader.SetNumThreads(m_settings->NumThreads);
     if ( !reader.Open(m_settings->InputBamFilename) ) {
         cerr << "bamtools index ERROR: could not open BAM file: "
              << m_settings->InputBamFilename << endl;
@@ -70,9 +116,21 @@ bool IndexTool::IndexToolPrivate::Run(void) {
     }
 
     // create index for BAM file
-    const BamIndex::IndexType type = ( m_settings->IsUsingBamtoolsIndex ? BamIndex::BAMTOOLS
-                                                                        : BamIndex::STANDARD );
-    reader.CreateIndex(type);
+    bool ok = false;
+    if ( m_settings->IsUsingCsiIndex )
+        ok = reader.CreateCsiIndex(m_settings->MinShift, m_settings->Depth);
+    else {
+        const BamIndex::IndexType type = ( m_settings->IsUsingBamtoolsIndex ? BamIndex::BAMTOOLS
+                                                                            : BamIndex::STANDARD );
+        ok = reader.CreateIndex(type);
+    }
+    if ( !ok ) {
+        cerr << "bamtools index ERROR: could not create index for: "
+             << m_settings->InputBamFilename << endl
+             << reader.GetErrorString() << endl;
+        reader.Close();
+        return false;
+    }
 
     // clean & exit
     reader.Close();
@@ -88,12 +146,18 @@ IndexTool::IndexTool(void)
     , m_impl(0)
 {
     // set program details
-    Options::SetProgramInfo("bamtools index", "creates index for BAM file", "[-in <filename>] [-bti]");
+    Options::SetProgramInfo("bamtools index", "creates index for BAM file", "[-in <filename>] [-bti | -csi [-minshift <bits>] [-depth <levels>]] [-threads <count>]");
     
     // set up options 
     OptionGroup* IO_Opts = Options::CreateOptionGroup("Input & Output");
     Options::AddValueOption("-in", "BAM filename", "the input BAM file", "", m_settings->HasInputBamFilename, m_settings->InputBamFilename, IO_Opts, Options::StandardIn());
     Options::AddOption("-bti", "create (non-standard) BamTools index file (*.bti). Default behavior is to create standard BAM index (*.bai)", m_settings->IsUsingBamtoolsIndex, IO_Opts);
+    Options::AddOption("-csi", "create CSI index file (*.csi), supports references longer than 2^29 bases", m_settings->IsUsingCsiIndex, IO_Opts);
+    Options::AddValueOption("-threads", "count", "number of threads used to decompress input", "", m_settings->HasNumThreads, m_settings->NumThreads, IO_Opts, INDEX_DEFAULT_NUM_THREADS);
+
+    OptionGroup* CsiOpts = Options::CreateOptionGroup("CSI Options");
+    Options::AddValueOption("-minshift", "bits", "bit-width of the smallest bins, at least 10 (smaller = finer bins, faster region queries, larger index)", "", m_settings->HasMinShift, m_settings->MinShift, CsiOpts, INDEX_DEFAULT_CSI_MIN_SHIFT);
+    Options::AddValueOption("-depth", "levels", "number of bin levels, at most 10 (increased automatically to fit the longest reference)", "", m_settings->HasDepth, m_settings->Depth, CsiOpts, INDEX_DEFAULT_CSI_DEPTH);
 }
 
 IndexTool::~IndexTool(void) {
@@ -2,25 +2,242 @@
 // bamtools_merge.cpp (c) 2010 Derek Barnett, Erik Garrison
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 10 December 2012
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Merges multiple BAM files into one
 // ***************************************************************************
 
 #include "bamtools_merge.h"
 
-#include <api/BamMultiReader.h>
+#include <api/BamConstants.h>
+#include <api/BamReader.h>
 #include <api/BamWriter.h>
+#include <api/SamConstants.h>
+#include <api/algorithms/RecordBuffer.h>
+#include <shared/bamtools_raw_record.h>
+#include <shared/bamtools_worker_pool.h>
 #include <utils/bamtools_options.h>
 #include <utils/bamtools_utilities.h>
 using namespace BamTools;
+using namespace BamTools::Algorithms;
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <queue>
 #include <string>
 #include <vector>
 using namespace std;
 
+namespace BamTools {
+
+// multi-threaded merging
+static const unsigned int MERGE_DEFAULT_NUM_THREADS = 1;
+static const size_t MERGE_BATCH_SIZE = 0x10000; // 64 KB of records read ahead per input
+
+// ---------------------------------------------
+// MergeReaderPool declaration
+
+// Reads ahead a batch of raw records from each input, while the current batch
+// is being merged. Batches are read (& decompressed) on a pool of worker threads,
+// or inline when a batch runs out, for 1 thread.
+class MergeReaderPool {
+
+    // ctor & dtor
+    public:
+        MergeReaderPool(const vector<BamReader*>& readers, const unsigned int numThreads);
+
+    // MergeReaderPool interface
+    public:
+        // returns first input's read error (empty if all inputs were read to the end)
+        string GetErrorString(void) const;
+        // points @record at input's next raw record, returns false if none are left
+        // (record stays valid until next call for the same input)
+        bool ReadRecord(const size_t inputIndex, const char*& record);
+
+    // internal types
+    public:
+        struct Input {
+            BamReader* Reader;
+            string Records;             // batch being merged (main thread only)
+            size_t Offset;              // next record in batch
+            string NextRecords;         // batch read ahead
+            bool IsReadDone;            // reader has no records left
+            string ErrorString;         // set if reader failed, rather than running out of records
+            bool IsDone;                // no read pending on NextRecords (see BamWorkerPool)
+
+            Input(BamReader* reader = 0)
+                : Reader(reader)
+                , Offset(0)
+                , IsReadDone(false)
+                , IsDone(true)
+            { }
+        };
+
+    // BamWorkerPool operation
+    public:
+        // fills input's read-ahead batch (called on worker threads)
+        void Process(Input& input);
+
+    // internal methods
+    private:
+        static unsigned int NumWorkers(const size_t numInputs, const unsigned int numThreads);
+
+    // data members
+    private:
+        vector<Input> m_inputs;
+        bool m_isStarted;
+        BamWorkerPool<Input, MergeReaderPool> m_pool; // (last, so it is stopped before inputs go away)
+};
+
+// ---------------------------------------------
+// MergeReaderPool implementation
+
+MergeReaderPool::MergeReaderPool(const vector<BamReader*>& readers, const unsigned int numThreads)
+    : m_inputs(readers.begin(), readers.end())
+    , m_isStarted(false)
+    , m_pool(*this, NumWorkers(readers.size(), numThreads))
+{ }
+
+// returns first input's read error (empty if all inputs were read to the end)
+string MergeReaderPool::GetErrorString(void) const {
+    for ( size_t i = 0; i < m_inputs.size(); ++i ) {
+        const Input& input = m_inputs[i];
+        if ( !input.ErrorString.empty() )
+            return input.Reader->GetFilename() + ": " + input.ErrorString;
+    }
+    return string();
+}
+
+// no more workers than there are inputs to read, none at all for 1 thread
+unsigned int MergeReaderPool::NumWorkers(const size_t numInputs, const unsigned int numThreads) {
+    if ( numThreads <= 1 )
+        return 0;
+    return static_cast<unsigned int>( min(static_cast<size_t>(numThreads), numInputs) );
+}
+
+void MergeReaderPool::Process(Input& input) {
+    string record;
+    while ( input.NextRecords.size() < MERGE_BATCH_SIZE ) {
+        if ( !input.Reader->GetNextRawAlignment(record) ) {
+            input.ErrorString = input.Reader->GetErrorString();
+            input.IsReadDone = true;
+            break;
+        }
+        input.NextRecords.append(record);
+    }
+}
+
+bool MergeReaderPool::ReadRecord(const size_t inputIndex, const char*& record) {
+
+    // on first read, start reading ahead on all inputs
+    if ( !m_isStarted ) {
+        m_isStarted = true;
+        for ( size_t i = 0; i < m_inputs.size(); ++i )
+            m_pool.Submit(&m_inputs[i]);
+    }
+
+    Input& input = m_inputs[inputIndex];
+
+    // switch to read-ahead batch, once current one is used up
+    if ( input.Offset >= input.Records.size() ) {
+        m_pool.Wait(&input);
+        input.Records.swap(input.NextRecords);
+        input.NextRecords.clear();
+        input.Offset = 0;
+        if ( input.Records.empty() )
+            return false;
+
+        // & start reading the one after it
+        if ( !input.IsReadDone )
+            m_pool.Submit(&input);
+    }
+
+    record = input.Records.data() + input.Offset;
+    input.Offset += RawRecord::Size(record);
+    return true;
+}
+
+// ---------------------------------------------
+// merge ordering
+
+// orders merge candidates so that next record to write is on top
+// keys (& names, for name order) are compared as BamMultiReader compares alignments.
+// ties go to the candidate added first, so (like BamMultiReader) unsorted inputs
+// are interleaved record by record
+struct MergeEntry {
+    uint64_t Key;
+    uint64_t Sequence;      // order in which candidates were added
+    size_t InputIndex;
+
+    MergeEntry(const uint64_t key, const uint64_t sequence, const size_t inputIndex)
+        : Key(key)
+        , Sequence(sequence)
+        , InputIndex(inputIndex)
+    { }
+};
+
+struct MergeEntryGreater {
+
+    MergeEntryGreater(const vector<const char*>* records, const bool isMergingByName)
+        : m_records(records)
+        , m_isMergingByName(isMergingByName)
+    { }
+
+    bool operator()(const MergeEntry& lhs, const MergeEntry& rhs) const {
+        if ( lhs.Key != rhs.Key )
+            return ( lhs.Key > rhs.Key );
+        if ( m_isMergingByName ) {
+            const int result = RecordBuffer::CompareNames( (*m_records)[lhs.InputIndex],
+                                                           (*m_records)[rhs.InputIndex] );
+            if ( result != 0 )
+                return ( result > 0 );
+        }
+        return ( lhs.Sequence > rhs.Sequence );
+    }
+
+    private:
+        const vector<const char*>* m_records;
+        bool m_isMergingByName;
+};
+
+// returns true if raw record passes the region check used for inputs without index data
+// (same check as for BamAlignment RefID, Position & Length)
+static
+bool IsInUnindexedRegion(const char* record, const BamRegion& region) {
+    const int32_t refId    = RawRecord::RefID(record);
+    const int32_t position = RawRecord::Position(record);
+    const int32_t length   = static_cast<int32_t>( RawRecord::SeqLength(record) );
+    return ( (refId >= region.LeftRefID)  && ( (position + length) >= region.LeftPosition ) &&
+             (refId <= region.RightRefID) && ( position <= region.RightPosition) );
+}
+
+// merge keys of raw records
+typedef uint64_t (*MergeKeyFunction)(const char* record);
+
+// (refID, position), all unmapped reads (refID -1) compare equal
+static
+uint64_t MergePositionKey(const char* record) {
+    const int32_t refId = RawRecord::RefID(record);
+    if ( refId < 0 )
+        return static_cast<uint64_t>(-1);
+    const int64_t position = RawRecord::Position(record);
+    return ( static_cast<uint64_t>(refId) << 32 ) | static_cast<uint64_t>(position + 0x80000000LL);
+}
+
+// leading name bytes, ties are resolved on full name
+static
+uint64_t MergeNameKey(const char* record) {
+    return RecordBuffer::NameKey(record);
+}
+
+static
+uint64_t MergeUnsortedKey(const char*) {
+    return 0;
+}
+
+} // namespace BamTools
+
 // ---------------------------------------------
 // MergeSettings implementation
 
@@ -32,6 +249,9 @@ struct MergeTool::MergeSettings {
     bool HasOutput;
     bool IsForceCompression;
     bool HasRegion;
+    bool IsAsyncIO;
+    bool IsConcatenating;
+    bool HasNumThreads;
     
     // filenames
     vector<string> InputFiles;
@@ -40,6 +260,7 @@ struct MergeTool::MergeSettings {
     // other parameters
     string OutputFilename;
     string Region;
+    unsigned int NumThreads;
     
     // constructor
     MergeSettings(void)
@@ -48,7 +269,11 @@ struct MergeTool::MergeSettings {
         , HasOutput(false)
         , IsForceCompression(false)
         , HasRegion(false)
+        , IsAsyncIO(false)
+        , IsConcatenating(false)
+        , HasNumThreads(false)
         , OutputFilename(Options::StandardOut())
+        , NumThreads(MERGE_DEFAULT_NUM_THREADS)
     { }
 };  
 
@@ -63,47 +288,155 @@ struct MergeTool::MergeToolPrivate {
             : m_settings(settings)
         { }
 
-        ~MergeToolPrivate(void) { }
+        ~MergeToolPrivate(void) { CloseReaders(); }
 
     // interface
     public:
         bool Run(void);
 
+    // internal methods
+    private:
+        void CloseReaders(void);
+        // appends each input's alignment data to output in turn, copying compressed blocks as they are
+        bool ConcatenateFiles(void);
+        // merges raw records of all readers (in header's sort order) into writer
+        // if @filterRegion is given, only records passing the unindexed region check are written
+        bool MergeRecords(MergeReaderPool& pool, BamWriter& writer, const BamRegion* filterRegion);
+        bool OpenReaders(void);
+        bool OpenWriter(BamWriter& writer, const RefVector& references);
+        // checks that all inputs share first input's sort order & references
+        bool ValidateReaders(void) const;
+        // checks that all inputs' header text lists the same sequences (@SQ lines) as first input's
+        bool ValidateSequenceDictionaries(void) const;
+
     // data members
     private:
         MergeTool::MergeSettings* m_settings;
+        vector<BamReader*> m_readers;
+        SamHeader m_mergedHeader;
 };
 
-bool MergeTool::MergeToolPrivate::Run(void) {
+void MergeTool::MergeToolPrivate::CloseReaders(void) {
+    for ( size_t i = 0; i < m_readers.size(); ++i ) {
+        m_readers[i]->Close();
+        delete m_readers[i];
+    }
+    m_readers.clear();
+}
 
-    // set to default input if none provided
-    if ( !m_settings->HasInput && !m_settings->HasInputFilelist )
-        m_settings->InputFiles.push_back(Options::StandardIn());
+bool MergeTool::MergeToolPrivate::ConcatenateFiles(void) {
 
-    // add files in the filelist to the input file list
-    if ( m_settings->HasInputFilelist ) {
+    // records are copied without looking at them, so headers must agree on sequences too
+    if ( !ValidateSequenceDictionaries() )
+        return false;
 
-        ifstream filelist(m_settings->InputFilelist.c_str(), ios::in);
-        if ( !filelist.is_open() ) {
-            cerr << "bamtools merge ERROR: could not open input BAM file list... Aborting." << endl;
+    // only headers were needed from readers
+    const RefVector references = m_readers.front()->GetReferenceData();
+    CloseReaders();
+
+    // open BamWriter
+    BamWriter writer;
+    if ( !OpenWriter(writer, references) )
+        return false;
+
+    // append each file's alignments
+    vector<string>::const_iterator fileIter = m_settings->InputFiles.begin();
+    vector<string>::const_iterator fileEnd  = m_settings->InputFiles.end();
+    for ( ; fileIter != fileEnd; ++fileIter ) {
+        if ( !writer.CopyAlignments(*fileIter) ) {
+            cerr << "bamtools merge ERROR: could not copy alignments from " << (*fileIter) << ": "
+                 << writer.GetErrorString() << endl;
+            writer.Close();
             return false;
         }
+    }
 
-        string line;
-        while ( getline(filelist, line) )
-            m_settings->InputFiles.push_back(line);
+    writer.Close();
+    return true;
+}
+
+bool MergeTool::MergeToolPrivate::MergeRecords(MergeReaderPool& pool,
+                                               BamWriter& writer,
+                                               const BamRegion* filterRegion)
+{
+
+    typedef priority_queue<MergeEntry, vector<MergeEntry>, MergeEntryGreater> MergeQueue;
+
+    // pick key matching inputs' sort order (unsorted inputs all get the same key)
+    const string& sortOrder = m_mergedHeader.SortOrder;
+    const bool isMergingByName = ( sortOrder == Constants::SAM_HD_SORTORDER_QUERYNAME );
+    MergeKeyFunction keyFunction = &MergeUnsortedKey;
+    if ( sortOrder == Constants::SAM_HD_SORTORDER_COORDINATE )
+        keyFunction = &MergePositionKey;
+    else if ( isMergingByName )
+        keyFunction = &MergeNameKey;
+
+    const size_t numInputs = m_readers.size();
+    vector<const char*> records(numInputs, (const char*)0);
+    MergeQueue queue( MergeEntryGreater(&records, isMergingByName) );
+    uint64_t sequence = 0;
+
+    // fetch first record of each input
+    for ( size_t i = 0; i < numInputs; ++i ) {
+        if ( pool.ReadRecord(i, records[i]) )
+            queue.push( MergeEntry(keyFunction(records[i]), sequence++, i) );
     }
 
-    // opens the BAM files (by default without checking for indexes)
-    BamMultiReader reader;
-    if ( !reader.Open(m_settings->InputFiles) ) {
-        cerr << "bamtools merge ERROR: could not open input BAM file(s)... Aborting." << endl;
+    // write smallest record, then refill from the same input
+    while ( !queue.empty() ) {
+        const size_t inputIndex = queue.top().InputIndex;
+        queue.pop();
+
+        const char* record = records[inputIndex];
+        if ( (filterRegion == 0 || IsInUnindexedRegion(record, *filterRegion)) &&
+             !writer.SaveRawAlignment(record, RawRecord::Size(record)) )
+        {
+            cerr << "bamtools merge ERROR: could not write alignment: " << writer.GetErrorString() << endl;
+            return false;
+        }
+
+        if ( pool.ReadRecord(inputIndex, records[inputIndex]) )
+            queue.push( MergeEntry(keyFunction(records[inputIndex]), sequence++, inputIndex) );
+    }
+
+    // reading stops at input that can't be read (e.g. a malformed SAM line)
+    const string readError = pool.GetErrorString();
+    if ( !readError.empty() ) {
+        cerr << "bamtools merge ERROR: could not read input: " << readError << endl;
         return false;
     }
+    return true;
+}
+
+bool MergeTool::MergeToolPrivate::OpenReaders(void) {
+
+    // with fewer inputs than threads, each input also gets its own decompression threads
+    const size_t numInputs = m_settings->InputFiles.size();
+    const unsigned int numReaderThreads = max(1u, static_cast<unsigned int>(m_settings->NumThreads / numInputs));
+
+    for ( size_t i = 0; i < numInputs; ++i ) {
+        BamReader* reader = new BamReader;
+        reader->SetAsyncIO(m_settings->IsAsyncIO);
+        reader->SetNumThreads(numReaderThreads);
+        if ( !reader->Open(m_settings->InputFiles.at(i)) ) {
+            cerr << "bamtools merge ERROR: " << reader->GetErrorString() << endl;
+            delete reader;
+            return false;
+        }
+        m_readers.push_back(reader);
+    }
+
+    if ( !ValidateReaders() )
+        return false;
+
+    // merged header is first input's header, plus all other inputs' read groups
+    m_mergedHeader = m_readers.front()->GetHeader();
+    for ( size_t i = 1; i < numInputs; ++i )
+        m_mergedHeader.ReadGroups.Add( m_readers.at(i)->GetHeader().ReadGroups );
+    return true;
+}
 
-    // retrieve header & reference dictionary info
-    std::string mergedHeader = reader.GetHeaderText();
-    RefVector references = reader.GetReferenceData();
+bool MergeTool::MergeToolPrivate::OpenWriter(BamWriter& writer, const RefVector& references) {
 
     // determine compression mode for BamWriter
     bool writeUncompressed = ( m_settings->OutputFilename == Options::StandardOut() &&
@@ -112,81 +445,179 @@ bool MergeTool::MergeToolPrivate::Run(void) {
     if ( writeUncompressed ) compressionMode = BamWriter::Uncompressed;
 
     // open BamWriter
-    BamWriter writer;
     writer.SetCompressionMode(compressionMode);
-    if ( !writer.Open(m_settings->OutputFilename, mergedHeader, references) ) {
+    writer.SetNumThreads(m_settings->NumThreads);
+    if ( !writer.Open(m_settings->OutputFilename, m_mergedHeader, references) ) {
         cerr << "bamtools merge ERROR: could not open "
              << m_settings->OutputFilename << " for writing." << endl;
-        reader.Close();
         return false;
     }
+    return true;
+}
+
+bool MergeTool::MergeToolPrivate::Run(void) {
+
+    // set to default input if none provided
+    if ( !m_settings->HasInput && !m_settings->HasInputFilelist )
+        m_settings->InputFiles.push_back(Options::StandardIn());
+
+    // add files in the filelist to the input file list
+    if ( m_settings->HasInputFilelist ) {
+
+        ifstream filelist(m_settings->InputFilelist.c_str(), ios::in);
+        if ( !filelist.is_open() ) {
+            cerr << "bamtools merge ERROR: could not open input BAM file list... Aborting." << endl;
+            return false;
+        }
 
-    // if no region specified, store entire contents of file(s)
-    if ( !m_settings->HasRegion ) {
-        BamAlignment al;
-        while ( reader.GetNextAlignment(al) )
-            writer.SaveAlignment(al);
+        string line;
+        while ( getline(filelist, line) )
+            m_settings->InputFiles.push_back(line);
     }
 
-    // otherwise attempt to use region as constraint
-    else {
+    // concatenation re-opens input files to copy their data, and can't apply a region
+    if ( m_settings->IsConcatenating ) {
+        if ( m_settings->HasRegion ) {
+            cerr << "bamtools merge ERROR: -region can not be used with -concat... Aborting." << endl;
+            return false;
+        }
+        vector<string>::const_iterator fileIter = m_settings->InputFiles.begin();
+        vector<string>::const_iterator fileEnd  = m_settings->InputFiles.end();
+        for ( ; fileIter != fileEnd; ++fileIter ) {
+            if ( (*fileIter) == Options::StandardIn() ) {
+                cerr << "bamtools merge ERROR: -concat needs input files, stdin can't be read twice... Aborting." << endl;
+                return false;
+            }
+        }
+    }
 
-        // if region string parses OK
-        BamRegion region;
-        if ( Utilities::ParseRegionString(m_settings->Region, reader, region) ) {
+    // opens the BAM files (by default without checking for indexes)
+    if ( m_settings->InputFiles.empty() || !OpenReaders() ) {
+        cerr << "bamtools merge ERROR: could not open input BAM file(s)... Aborting." << endl;
+        return false;
+    }
 
-            // attempt to find index files
-            reader.LocateIndexes();
+    // inputs known to be disjoint & in order can simply be concatenated
+    if ( m_settings->IsConcatenating )
+        return ConcatenateFiles();
 
-            // if index data available for all BAM files, we can use SetRegion
-            if ( reader.HasIndexes() ) {
+    // records are read ahead (& decompressed) on worker threads, in batches per input
+    MergeReaderPool pool(m_readers, m_settings->NumThreads);
 
-                // attempt to use SetRegion(), if failed report error
-                if ( !reader.SetRegion(region.LeftRefID,
-                                       region.LeftPosition,
-                                       region.RightRefID,
-                                       region.RightPosition) )
-                {
+    // if region specified, attempt to use it as constraint
+    BamRegion region;
+    bool isFilteringRegion = false;
+    if ( m_settings->HasRegion ) {
+
+        // error parsing REGION string
+        if ( !Utilities::ParseRegionString(m_settings->Region, *m_readers.front(), region) ) {
+            cerr << "bamtools merge ERROR: could not parse REGION - " << m_settings->Region << endl;
+            cerr << "Check that REGION is in valid format (see documentation) and that the coordinates are valid"
+                 << endl;
+            return false;
+        }
+
+        // attempt to find index files
+        bool hasIndexes = true;
+        for ( size_t i = 0; i < m_readers.size(); ++i ) {
+            if ( !m_readers[i]->LocateIndex() )
+                hasIndexes = false;
+        }
+
+        // if index data available for all BAM files, we can use SetRegion
+        if ( hasIndexes ) {
+            for ( size_t i = 0; i < m_readers.size(); ++i ) {
+                if ( !m_readers[i]->SetRegion(region) ) {
                     cerr << "bamtools merge ERROR: set region failed. Check that REGION describes a valid range"
                          << endl;
-                    reader.Close();
                     return false;
                 }
-
-                // everything checks out, just iterate through specified region, storing alignments
-                BamAlignment al;
-                while ( reader.GetNextAlignmentCore(al) )
-                    writer.SaveAlignment(al);
             }
+        }
 
-            // no index data available, we have to iterate through until we
-            // find overlapping alignments
-            else {
-                BamAlignment al;
-                while ( reader.GetNextAlignmentCore(al) ) {
-                    if ( (al.RefID >= region.LeftRefID)  && ( (al.Position + al.Length) >= region.LeftPosition ) &&
-                         (al.RefID <= region.RightRefID) && ( al.Position <= region.RightPosition) )
-                    {
-                        writer.SaveAlignment(al);
-                    }
-                }
-            }
+        // no index data available, we have to iterate through until we
+        // find overlapping alignments
+        else
+            isFilteringRegion = true;
+    }
+
+    // open BamWriter
+    BamWriter writer;
+    if ( !OpenWriter(writer, m_readers.front()->GetReferenceData()) )
+        return false;
+
+    // merge raw records (never decoded) straight into output
+    const bool success = MergeRecords(pool, writer, ( isFilteringRegion ? &region : 0 ));
+    writer.Close();
+    return success;
+}
+
+bool MergeTool::MergeToolPrivate::ValidateReaders(void) const {
+
+    const BamReader* firstReader = m_readers.front();
+    const string firstSortOrder = firstReader->GetHeader().SortOrder;
+    const RefVector& firstReferences = firstReader->GetReferenceData();
+
+    for ( size_t i = 1; i < m_readers.size(); ++i ) {
+        const BamReader* reader = m_readers[i];
+
+        // check compatible sort order
+        const string sortOrder = reader->GetHeader().SortOrder;
+        if ( sortOrder != firstSortOrder ) {
+            cerr << "bamtools merge ERROR: mismatched sort order in " << reader->GetFilename()
+                 << ", expected " << firstSortOrder << ", but found " << sortOrder << endl;
+            return false;
         }
 
-        // error parsing REGION string
-        else {
-            cerr << "bamtools merge ERROR: could not parse REGION - " << m_settings->Region << endl;
-            cerr << "Check that REGION is in valid format (see documentation) and that the coordinates are valid"
-                 << endl;
-            reader.Close();
-            writer.Close();
+        // check identical references
+        const RefVector& references = reader->GetReferenceData();
+        if ( references.size() != firstReferences.size() ) {
+            cerr << "bamtools merge ERROR: mismatched reference count in " << reader->GetFilename()
+                 << ", expected " << firstReferences.size() << ", but found " << references.size() << endl;
             return false;
         }
+        for ( size_t j = 0; j < references.size(); ++j ) {
+            if ( references[j].RefName   != firstReferences[j].RefName ||
+                 references[j].RefLength != firstReferences[j].RefLength )
+            {
+                cerr << "bamtools merge ERROR: mismatched references found in " << reader->GetFilename()
+                     << ", expected: " << firstReferences[j].RefName << " (" << firstReferences[j].RefLength
+                     << "), but found: " << references[j].RefName << " (" << references[j].RefLength << ")" << endl;
+                return false;
+            }
+        }
     }
+    return true;
+}
 
-    // clean & exit
-    reader.Close();
-    writer.Close();
+bool MergeTool::MergeToolPrivate::ValidateSequenceDictionaries(void) const {
+
+    const SamSequenceDictionary firstSequences = m_readers.front()->GetHeader().Sequences;
+
+    for ( size_t i = 1; i < m_readers.size(); ++i ) {
+        const BamReader* reader = m_readers[i];
+        const SamSequenceDictionary sequences = reader->GetHeader().Sequences;
+
+        // check sequence count
+        if ( sequences.Size() != firstSequences.Size() ) {
+            cerr << "bamtools merge ERROR: mismatched @SQ line count in " << reader->GetFilename()
+                 << ", expected " << firstSequences.Size() << ", but found " << sequences.Size() << endl;
+            return false;
+        }
+
+        // check each sequence (name, length & checksum, if both have one), in order
+        SamSequenceConstIterator firstIter = firstSequences.ConstBegin();
+        SamSequenceConstIterator seqIter   = sequences.ConstBegin();
+        SamSequenceConstIterator seqEnd    = sequences.ConstEnd();
+        for ( ; seqIter != seqEnd; ++seqIter, ++firstIter ) {
+            if ( !((*seqIter) == (*firstIter)) ) {
+                cerr << "bamtools merge ERROR: mismatched @SQ lines found in " << reader->GetFilename()
+                     << ", expected: " << firstIter->Name << " (" << firstIter->Length
+                     << "), but found: " << seqIter->Name << " (" << seqIter->Length << ")" << endl;
+                return false;
+            }
+        }
+    }
     return true;
 }
 
@@ -200,7 +631,7 @@ MergeTool::MergeTool(void)
 {
     // set program details
     Options::SetProgramInfo("bamtools merge", "merges multiple BAM files into one",
-                            "[-in <filename> -in <filename> ... | -list <filelist>] [-out <filename> | [-forceCompression]] [-region <REGION>]");
+                            "[-in <filename> -in <filename> ... | -list <filelist>] [-out <filename> | [-forceCompression]] [-region <REGION> | -concat] [-async] [-threads <count>]");
     
     // set up options 
     OptionGroup* IO_Opts = Options::CreateOptionGroup("Input & Output");
@@ -209,6 +640,12 @@ MergeTool::MergeTool(void)
     Options::AddValueOption("-out", "BAM filename", "the output BAM file",   "", m_settings->HasOutput, m_settings->OutputFilename, IO_Opts);
     Options::AddOption("-forceCompression", "if results are sent to stdout (like when piping to another tool), default behavior is to leave output uncompressed. Use this flag to override and force compression", m_settings->IsForceCompression, IO_Opts);
     Options::AddValueOption("-region", "REGION", "genomic region. See README for more details", "", m_settings->HasRegion, m_settings->Region, IO_Opts);
+    Options::AddOption("-async", "read input files asynchronously, keeping several reads in flight (io_uring, where available)", m_settings->IsAsyncIO, IO_Opts);
+    Options::AddOption("-concat", "input files are already disjoint & in order (e.g. per-chromosome shards of a sorted file): append their alignment data in turn, copying compressed blocks instead of decoding & re-encoding alignments", m_settings->IsConcatenating, IO_Opts);
+
+    OptionGroup* SettingsOpts = Options::CreateOptionGroup("Settings");
+    Options::AddValueOption("-threads", "count", "number of threads used to read (decompress) input files & to compress output",
+                            "", m_settings->HasNumThreads, m_settings->NumThreads, SettingsOpts, MERGE_DEFAULT_NUM_THREADS);
 }
 
 MergeTool::~MergeTool(void) {
@@ -2,7 +2,7 @@
 // bamtools_random.cpp (c) 2010 Derek Barnett, Erik Garrison
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 10 December 2012 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Grab a random subset of alignments (testing tool)
 // ***************************************************************************
@@ -11,10 +11,12 @@
 
 #include <api/BamMultiReader.h>
 #include <api/BamWriter.h>
+#include <utils/bamtools_batch_pipeline.h>
 #include <utils/bamtools_options.h>
 #include <utils/bamtools_utilities.h>
 using namespace BamTools;
 
+#include <algorithm>
 #include <ctime>
 #include <cstdlib>
 #include <fstream>
@@ -27,13 +29,192 @@ namespace BamTools {
   
 // define constants
 const unsigned int RANDOM_MAX_ALIGNMENT_COUNT = 10000;
+const unsigned int RANDOM_DEFAULT_CACHE_SIZE  = 64;   // MB, per input file
+const unsigned int RANDOM_DEFAULT_NUM_THREADS = 1;
+const unsigned int RANDOM_DEFAULT_SEED        = 0;    // one-pass modes only, jumps are seeded from time otherwise
 
 // utility methods for RandomTool
 int getRandomInt(const int& lowerBound, const int& upperBound) {
     const int range = (upperBound - lowerBound) + 1;
     return ( lowerBound + (int)(range * (double)rand()/((double)RAND_MAX + 1)) );
 }
-    
+
+// hashes read name together with seed (FNV-1a, with a final avalanche step)
+// mates share a name, so they always get the same hash
+uint64_t getReadNameHash(const string& name, const unsigned int seed) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for ( unsigned int i = 0; i < sizeof(seed); ++i ) {
+        hash ^= (seed >> (8*i)) & 0xff;
+        hash *= 0x100000001b3ULL;
+    }
+    const size_t length = name.size();
+    for ( size_t i = 0; i < length; ++i ) {
+        hash ^= static_cast<unsigned char>(name[i]);
+        hash *= 0x100000001b3ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// ---------------------------------------------
+// one-pass samplers: each alignment is offered with a key from its read name
+// hash (in input order), the sampler decides what gets written
+
+class RandomSampler {
+    public:
+        virtual ~RandomSampler(void) { }
+        // offers next alignment & its key
+        virtual void Add(const BamAlignment& al, const uint64_t key) = 0;
+        // writes anything held back, once all alignments are offered
+        virtual void Finish(void) { }
+};
+
+// keeps each alignment whose key falls below a fraction of the 64-bit key range
+class FractionSampler : public RandomSampler {
+
+    public:
+        FractionSampler(BamWriter& writer, const double fraction)
+            : m_writer(writer)
+            , m_isKeepingAll( fraction >= 1.0 )
+            , m_threshold( static_cast<uint64_t>(fraction * 18446744073709551616.0) )
+        { }
+
+        void Add(const BamAlignment& al, const uint64_t key) {
+            if ( m_isKeepingAll || key < m_threshold )
+                m_writer.SaveAlignment(al);
+        }
+
+    private:
+        BamWriter& m_writer;
+        bool m_isKeepingAll;
+        uint64_t m_threshold;
+};
+
+// keeps the alignments with the smallest keys (ties broken by input order), a uniform
+// sample of fixed size. Kept alignments are written in input order.
+class ReservoirSampler : public RandomSampler {
+
+    public:
+        ReservoirSampler(BamWriter& writer, const size_t capacity)
+            : m_writer(writer)
+            , m_capacity(capacity)
+            , m_numOffered(0)
+        { }
+
+        void Add(const BamAlignment& al, const uint64_t key) {
+
+            const Entry entry(key, m_numOffered++, m_alignments.size());
+
+            // fill reservoir first
+            if ( m_reservoir.size() < m_capacity ) {
+                m_alignments.push_back(al);
+                m_reservoir.push_back(entry);
+                push_heap(m_reservoir.begin(), m_reservoir.end());
+            }
+
+            // then replace largest key, if this one is smaller
+            else if ( m_capacity > 0 && entry < m_reservoir.front() ) {
+                pop_heap(m_reservoir.begin(), m_reservoir.end());
+                Entry& replaced = m_reservoir.back();
+                m_alignments[replaced.Slot] = al;
+                replaced.Key = entry.Key;
+                replaced.Index = entry.Index;
+                push_heap(m_reservoir.begin(), m_reservoir.end());
+            }
+        }
+
+        void Finish(void) {
+            sort(m_reservoir.begin(), m_reservoir.end(), IsEarlierInput);
+            vector<Entry>::const_iterator entryIter = m_reservoir.begin();
+            vector<Entry>::const_iterator entryEnd  = m_reservoir.end();
+            for ( ; entryIter != entryEnd; ++entryIter )
+                m_writer.SaveAlignment( m_alignments[(*entryIter).Slot] );
+        }
+
+    private:
+        struct Entry {
+            uint64_t Key;
+            uint64_t Index;     // input order
+            size_t Slot;        // where alignment is stored
+
+            Entry(const uint64_t key, const uint64_t index, const size_t slot)
+                : Key(key)
+                , Index(index)
+                , Slot(slot)
+            { }
+
+            bool operator<(const Entry& other) const {
+                return ( Key < other.Key || (Key == other.Key && Index < other.Index) );
+            }
+        };
+
+        static bool IsEarlierInput(const Entry& lhs, const Entry& rhs) {
+            return ( lhs.Index < rhs.Index );
+        }
+
+    private:
+        BamWriter& m_writer;
+        size_t m_capacity;
+        uint64_t m_numOffered;
+        vector<BamAlignment> m_alignments;
+        vector<Entry> m_reservoir;  // max-heap, largest key on top
+};
+
+// batch of alignments & their read name hashes, passed through the multi-threaded sampling pipeline
+struct RandomBatch : public AlignmentBatch {
+    vector<uint64_t> Keys;
+
+    RandomBatch(void)
+        : Keys(Alignments.size(), 0)
+    { }
+};
+
+// BatchPipeline stages for one-pass sampling with multiple threads:
+//   reader thread  : reads alignment core data (& applies region, if not indexed)
+//   worker threads : parse char data & hash read names
+//   calling thread : offers alignments to sampler, in input order
+class RandomStages {
+
+    public:
+        RandomStages(BamMultiReader& reader,
+                     RandomSampler& sampler,
+                     const unsigned int seed,
+                     const bool isManualRegion,
+                     const BamRegion& region)
+            : m_reader(reader)
+            , m_sampler(sampler)
+            , m_seed(seed)
+            , m_isManualRegion(isManualRegion)
+            , m_region(region)
+        { }
+
+        bool ReadBatch(RandomBatch& batch) {
+            return ReadAlignmentBatch(m_reader, batch, false, ( m_isManualRegion ? &m_region : 0 ));
+        }
+
+        void ProcessBatch(RandomBatch& batch) {
+            for ( size_t i = 0; i < batch.Count; ++i ) {
+                BamAlignment& al = batch.Alignments[i];
+                al.BuildCharData();
+                batch.Keys[i] = getReadNameHash(al.Name, m_seed);
+            }
+        }
+
+        void WriteBatch(RandomBatch& batch) {
+            for ( size_t i = 0; i < batch.Count; ++i )
+                m_sampler.Add(batch.Alignments[i], batch.Keys[i]);
+        }
+
+    private:
+        BamMultiReader& m_reader;
+        RandomSampler& m_sampler;
+        unsigned int m_seed;
+        bool m_isManualRegion;
+        BamRegion m_region;
+};
+
 } // namespace BamTools
   
 // ---------------------------------------------  
@@ -43,29 +224,47 @@ struct RandomTool::RandomSettings {
 
     // flags
     bool HasAlignmentCount;
+    bool HasCacheSize;
+    bool HasFraction;
     bool HasInput;
     bool HasInputFilelist;
+    bool HasNumThreads;
     bool HasOutput;
     bool HasRegion;
+    bool HasSeed;
     bool IsForceCompression;
+    bool IsReservoir;
 
     // parameters
     unsigned int AlignmentCount;
+    unsigned int CacheSize;
+    double Fraction;
     vector<string> InputFiles;
     string InputFilelist;
+    unsigned int NumThreads;
     string OutputFilename;
     string Region;
+    unsigned int Seed;
     
     // constructor
     RandomSettings(void)
         : HasAlignmentCount(false)
+        , HasCacheSize(false)
+        , HasFraction(false)
         , HasInput(false)
         , HasInputFilelist(false)
+        , HasNumThreads(false)
         , HasOutput(false)
         , HasRegion(false)
+        , HasSeed(false)
         , IsForceCompression(false)
+        , IsReservoir(false)
         , AlignmentCount(RANDOM_MAX_ALIGNMENT_COUNT)
+        , CacheSize(RANDOM_DEFAULT_CACHE_SIZE)
+        , Fraction(1.0)
+        , NumThreads(RANDOM_DEFAULT_NUM_THREADS)
         , OutputFilename(Options::StandardOut())
+        , Seed(RANDOM_DEFAULT_SEED)
     { }  
 };  
 
@@ -86,6 +285,15 @@ struct RandomTool::RandomToolPrivate {
     public:
         bool Run(void);
 
+    // internal methods
+    private:
+        // jumps to random positions, keeping first alignment found at each one
+        void SampleJumps(BamMultiReader& reader, BamWriter& writer,
+                         const RefVector& references, const BamRegion& region);
+        // reads through input once, offering every alignment to sampler
+        void SampleOnePass(BamMultiReader& reader, RandomSampler& sampler,
+                           const bool isManualRegion, const BamRegion& region);
+
     // data members
     private:
         RandomTool::RandomSettings* m_settings;
@@ -93,6 +301,17 @@ struct RandomTool::RandomToolPrivate {
 
 bool RandomTool::RandomToolPrivate::Run(void) {
 
+    // one-pass modes don't mix, and need a usable fraction
+    const bool isOnePass = ( m_settings->HasFraction || m_settings->IsReservoir );
+    if ( m_settings->HasFraction && m_settings->IsReservoir ) {
+        cerr << "bamtools random ERROR: -fraction and -reservoir cannot be used together... Aborting." << endl;
+        return false;
+    }
+    if ( m_settings->HasFraction && !(m_settings->Fraction > 0.0 && m_settings->Fraction <= 1.0) ) {
+        cerr << "bamtools random ERROR: -fraction must be greater than 0 and at most 1... Aborting." << endl;
+        return false;
+    }
+
     // set to default stdin if no input files provided
     if ( !m_settings->HasInput && !m_settings->HasInputFilelist )
         m_settings->InputFiles.push_back(Options::StandardIn());
@@ -112,17 +331,23 @@ bool RandomTool::RandomToolPrivate::Run(void) {
     }
 
     // open our reader
+    // (nearby random positions often share BGZF blocks, so keep recently decompressed ones)
     BamMultiReader reader;
+    reader.SetNumThreads(m_settings->NumThreads);
+    if ( !isOnePass )
+        reader.SetBlockCacheSize(m_settings->CacheSize);
     if ( !reader.Open(m_settings->InputFiles) ) {
         cerr << "bamtools random ERROR: could not open input BAM file(s)... Aborting." << endl;
         return false;
     }
 
     // look up index files for all BAM files
-    reader.LocateIndexes();
+    // (one-pass modes only use them to jump to REGION, if given)
+    if ( !isOnePass || m_settings->HasRegion )
+        reader.LocateIndexes();
 
     // make sure index data is available
-    if ( !reader.HasIndexes() ) {
+    if ( !isOnePass && !reader.HasIndexes() ) {
         cerr << "bamtools random ERROR: could not load index data for all input BAM file(s)... Aborting." << endl;
         reader.Close();
         return false;
@@ -146,6 +371,7 @@ bool RandomTool::RandomToolPrivate::Run(void) {
     // open BamWriter
     BamWriter writer;
     writer.SetCompressionMode(compressionMode);
+    writer.SetNumThreads(m_settings->NumThreads);
     if ( !writer.Open(m_settings->OutputFilename, headerText, references) ) {
         cerr << "bamtools random ERROR: could not open " << m_settings->OutputFilename
              << " for writing... Aborting." << endl;
@@ -164,8 +390,50 @@ bool RandomTool::RandomToolPrivate::Run(void) {
         return false;
     }
 
+    // grab random alignments
+    if ( isOnePass ) {
+
+        // jump to REGION if possible, otherwise check each alignment against it
+        bool isManualRegion = false;
+        if ( m_settings->HasRegion ) {
+            if ( reader.HasIndexes() ) {
+                if ( !reader.SetRegion(region) ) {
+                    cerr << "bamtools random ERROR: set region failed. Check that REGION describes a valid range" << endl;
+                    reader.Close();
+                    writer.Close();
+                    return false;
+                }
+            }
+            else isManualRegion = true;
+        }
+
+        // keep each read (with its mate) with probability Fraction,
+        // or exactly AlignmentCount alignments (or all, if fewer)
+        if ( m_settings->HasFraction ) {
+            FractionSampler sampler(writer, m_settings->Fraction);
+            SampleOnePass(reader, sampler, isManualRegion, region);
+        } else {
+            ReservoirSampler sampler(writer, m_settings->AlignmentCount);
+            SampleOnePass(reader, sampler, isManualRegion, region);
+        }
+    }
+    else
+        SampleJumps(reader, writer, references, region);
+
+    // cleanup & exit
+    reader.Close();
+    writer.Close();
+    return true;
+}
+
+// jumps to random positions, keeping first alignment found at each one
+void RandomTool::RandomToolPrivate::SampleJumps(BamMultiReader& reader,
+                                                BamWriter& writer,
+                                                const RefVector& references,
+                                                const BamRegion& region)
+{
     // seed our random number generator
-    srand( time(NULL) );
+    srand( m_settings->HasSeed ? m_settings->Seed : time(NULL) );
 
     // grab random alignments
     BamAlignment al;
@@ -214,11 +482,36 @@ bool RandomTool::RandomToolPrivate::Run(void) {
             }
         }
     }
+}
 
-    // cleanup & exit
-    reader.Close();
-    writer.Close();
-    return true;
+// reads through input once, offering every alignment to sampler
+//
+// sampling keys only depend on read name & seed, so output is the same on every run
+// (& with any number of threads)
+void RandomTool::RandomToolPrivate::SampleOnePass(BamMultiReader& reader,
+                                                  RandomSampler& sampler,
+                                                  const bool isManualRegion,
+                                                  const BamRegion& region)
+{
+    // if multiple threads requested, parse & hash alignments in batches on worker threads
+    if ( m_settings->NumThreads > 1 ) {
+        RandomStages stages(reader, sampler, m_settings->Seed, isManualRegion, region);
+        BatchPipeline<RandomBatch, RandomStages> pipeline(stages, m_settings->NumThreads);
+        pipeline.Run();
+    }
+
+    // otherwise hash alignments one at a time
+    else {
+        BamAlignment al;
+        while ( reader.GetNextAlignmentCore(al) ) {
+            if ( isManualRegion && !IsOverlapping(al, region) )
+                continue;
+            al.BuildCharData();
+            sampler.Add(al, getReadNameHash(al.Name, m_settings->Seed));
+        }
+    }
+
+    sampler.Finish();
 }
 
 // ---------------------------------------------
@@ -231,7 +524,7 @@ RandomTool::RandomTool(void)
 { 
     // set program details
     Options::SetProgramInfo("bamtools random", "grab a random subset of alignments",
-                            "[-in <filename> -in <filename> ... | -list <filelist>] [-out <filename>] [-forceCompression] [-n] [-region <REGION>]");
+                            "[-in <filename> -in <filename> ... | -list <filelist>] [-out <filename>] [-forceCompression] [-n] [-fraction <F> | -reservoir] [-seed <N>] [-region <REGION>] [-cache <MB>] [-threads <count>]");
     
     // set up options 
     OptionGroup* IO_Opts = Options::CreateOptionGroup("Input & Output");
@@ -242,7 +535,12 @@ RandomTool::RandomTool(void)
     Options::AddValueOption("-region", "REGION", "only pull random alignments from within this genomic region. Index file is recommended for better performance, and is used automatically if it exists. See \'bamtools help index\' for more details on creating one", "", m_settings->HasRegion, m_settings->Region, IO_Opts);
     
     OptionGroup* SettingsOpts = Options::CreateOptionGroup("Settings");
-    Options::AddValueOption("-n", "count", "number of alignments to grab. Note - no duplicate checking is performed", "", m_settings->HasAlignmentCount, m_settings->AlignmentCount, SettingsOpts, RANDOM_MAX_ALIGNMENT_COUNT);
+    Options::AddValueOption("-n", "count", "number of alignments to grab. Note - no duplicate checking is performed, unless -reservoir is used", "", m_settings->HasAlignmentCount, m_settings->AlignmentCount, SettingsOpts, RANDOM_MAX_ALIGNMENT_COUNT);
+    Options::AddValueOption("-fraction", "F", "instead of jumping to random positions, read through input once & keep each read (along with its mate) with probability F. No index file is needed", "", m_settings->HasFraction, m_settings->Fraction, SettingsOpts);
+    Options::AddOption("-reservoir", "instead of jumping to random positions, read through input once & keep exactly -n distinct alignments (reservoir sampling). No index file is needed", m_settings->IsReservoir, SettingsOpts);
+    Options::AddValueOption("-seed", "N", "seed for random selection. -fraction & -reservoir always give the same output for the same seed (default 0), otherwise the current time is used", "", m_settings->HasSeed, m_settings->Seed, SettingsOpts);
+    Options::AddValueOption("-cache", "MB", "size of decompressed block cache per input file (0 disables cache)", "", m_settings->HasCacheSize, m_settings->CacheSize, SettingsOpts, RANDOM_DEFAULT_CACHE_SIZE);
+    Options::AddValueOption("-threads", "count", "number of threads used to decompress each input file & to compress output", "", m_settings->HasNumThreads, m_settings->NumThreads, SettingsOpts, RANDOM_DEFAULT_NUM_THREADS);
 }
 
 RandomTool::~RandomTool(void) { 
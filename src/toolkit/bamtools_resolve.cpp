@@ -2,7 +2,7 @@
 // bamtools_resolve.cpp (c) 2011
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 14 October 2011
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Resolves paired-end reads (marking the IsProperPair flag as needed).
 // ***************************************************************************
@@ -11,6 +11,7 @@
 #include "bamtools_version.h"
 #include <api/BamReader.h>
 #include <api/BamWriter.h>
+#include <utils/bamtools_batch_pipeline.h>
 #include <utils/bamtools_options.h>
 #include <utils/bamtools_utilities.h>
 using namespace BamTools;
@@ -20,6 +21,8 @@ using namespace BamTools;
 #include <cctype>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <fstream>
 #include <iostream>
 #include <map>
@@ -29,16 +32,30 @@ using namespace BamTools;
 #include <vector>
 using namespace std;
 
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
 // --------------------------------------------------------------------------
 // general ResolveTool constants
 // --------------------------------------------------------------------------
 
 static const int      NUM_MODELS = 8;
 static const string   READ_GROUP_TAG = "RG";
+static const string   MATE_MAPQUALITY_TAG = "MQ";
 static const double   DEFAULT_CONFIDENCE_INTERVAL = 0.9973;
 static const uint16_t DEFAULT_MIN_MAPQUALITY = 1;
 static const double   DEFAULT_UNUSEDMODEL_THRESHOLD = 0.1;
 
+// -onePass mode
+static const unsigned int DEFAULT_SAMPLE_PAIRS = 1000000;
+static const unsigned int DEFAULT_PAIR_BUFFER_SIZE = 500000;
+static const unsigned int DEFAULT_NUM_THREADS = 1;
+static const size_t       RESOLVE_BATCH_SIZE = 4096; // number of alignments per batch
+
 // --------------------------------------------------------------------------
 // stats file constants
 // --------------------------------------------------------------------------
@@ -77,9 +94,201 @@ static const string RG_FIELD_DESCRIPTION =
 // unique readname file constants
 // --------------------------------------------------------------------------
 
-static const string READNAME_FILE_SUFFIX = ".uniq_names.txt";
+static const string READNAME_FILE_SUFFIX = ".uniq_names.bin";
 static const string DEFAULT_READNAME_FILE = "bt_resolve_TEMP" + READNAME_FILE_SUFFIX;
 
+// binary layout: magic, number of read groups, then per read group:
+//   name length (uint32_t), name, padding to 8 bytes,
+//   number of names (uint64_t), sorted name fingerprints (uint64_t each)
+static const char     READNAME_FILE_MAGIC[4] = { 'B', 'T', 'R', 'N' };
+static const uint32_t READNAME_FILE_ALIGNMENT = 8;
+
+// --------------------------------------------------------------------------
+// read name fingerprints
+
+// read names are only kept as 64-bit hashes (FNV-1a, with a final avalanche step)
+uint64_t ReadNameFingerprint(const string& name) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const size_t length = name.size();
+    for ( size_t i = 0; i < length; ++i ) {
+        hash ^= static_cast<unsigned char>(name[i]);
+        hash *= 0x100000001b3ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// --------------------------------------------------------------------------
+// ReadNameTable implementation
+
+// open-addressing set of read names whose mate has not been seen yet,
+// each stored with whether the seen mate was unique
+class ReadNameTable {
+
+    // ctor
+    public:
+        ReadNameTable(void)
+            : m_slots(MIN_CAPACITY, 0)
+            , m_size(0)
+        { }
+
+    // ReadNameTable interface
+    public:
+        void Clear(void) {
+            vector<uint64_t>(MIN_CAPACITY, 0).swap(m_slots);
+            m_size = 0;
+        }
+
+        void Insert(const string& name, const bool isUnique) {
+
+            // keep load factor at or below 1/2
+            if ( (m_size + 1) * 2 > m_slots.size() )
+                Rehash(m_slots.size() * 2);
+
+            const uint64_t key = MakeKey(name);
+            size_t slot = FindSlot(key);
+            if ( m_slots[slot] == 0 )
+                ++m_size;
+            m_slots[slot] = key | ( isUnique ? UNIQUE_BIT : 0 );
+        }
+
+        // removes read name if present, returning its uniqueness in @isUnique
+        bool Remove(const string& name, bool& isUnique) {
+
+            size_t slot = FindSlot( MakeKey(name) );
+            if ( m_slots[slot] == 0 )
+                return false;
+            isUnique = ( (m_slots[slot] & UNIQUE_BIT) != 0 );
+
+            // shift following entries of the probe sequence back, so no tombstones are needed
+            const size_t mask = m_slots.size() - 1;
+            size_t next = slot;
+            while ( true ) {
+                next = (next + 1) & mask;
+                const uint64_t nextKey = m_slots[next];
+                if ( nextKey == 0 )
+                    break;
+                const size_t home = HomeSlot(nextKey & KEY_MASK);
+                const bool isBetween = ( slot <= next ? (slot < home && home <= next)
+                                                      : (slot < home || home <= next) );
+                if ( isBetween )
+                    continue;
+                m_slots[slot] = nextKey;
+                slot = next;
+            }
+            m_slots[slot] = 0;
+            --m_size;
+            return true;
+        }
+
+    // internal methods
+    private:
+        size_t FindSlot(const uint64_t& key) const {
+            const size_t mask = m_slots.size() - 1;
+            size_t slot = HomeSlot(key);
+            while ( m_slots[slot] != 0 && (m_slots[slot] & KEY_MASK) != key )
+                slot = (slot + 1) & mask;
+            return slot;
+        }
+
+        size_t HomeSlot(const uint64_t& key) const {
+            return static_cast<size_t>(key) & (m_slots.size() - 1);
+        }
+
+        // top bit holds uniqueness flag, 0 marks an empty slot
+        static uint64_t MakeKey(const string& name) {
+            const uint64_t key = ReadNameFingerprint(name) & KEY_MASK;
+            return ( key == 0 ? 1 : key );
+        }
+
+        void Rehash(const size_t capacity) {
+            vector<uint64_t> oldSlots(capacity, 0);
+            oldSlots.swap(m_slots);
+            const size_t mask = m_slots.size() - 1;
+            for ( size_t i = 0; i < oldSlots.size(); ++i ) {
+                if ( oldSlots[i] == 0 ) continue;
+                size_t slot = HomeSlot(oldSlots[i] & KEY_MASK);
+                while ( m_slots[slot] != 0 )
+                    slot = (slot + 1) & mask;
+                m_slots[slot] = oldSlots[i];
+            }
+        }
+
+    // data members
+    private:
+        vector<uint64_t> m_slots;
+        size_t m_size;
+
+    // constants
+    private:
+        static const size_t   MIN_CAPACITY = 1024;
+        static const uint64_t UNIQUE_BIT   = 0x8000000000000000ULL;
+        static const uint64_t KEY_MASK     = 0x7fffffffffffffffULL;
+};
+
+// --------------------------------------------------------------------------
+// ReadNameSet implementation
+
+// sorted set of read name fingerprints, either held in memory
+// or pointing into a (memory-mapped) read names file
+class ReadNameSet {
+
+    // ctor
+    public:
+        ReadNameSet(void)
+            : m_data(0)
+            , m_count(0)
+        { }
+
+    // ReadNameSet interface
+    public:
+        // adds read name (call Sort() once all are added)
+        void Add(const string& name) {
+            m_fingerprints.push_back( ReadNameFingerprint(name) );
+        }
+
+        void Clear(void) {
+            vector<uint64_t>().swap(m_fingerprints);
+            m_data  = 0;
+            m_count = 0;
+        }
+
+        bool Contains(const string& name) const {
+            const uint64_t* begin = Data();
+            const uint64_t* end   = begin + Size();
+            return binary_search(begin, end, ReadNameFingerprint(name));
+        }
+
+        const uint64_t* Data(void) const {
+            return ( m_data != 0 ? m_data : (m_fingerprints.empty() ? 0 : &m_fingerprints[0]) );
+        }
+
+        size_t Size(void) const {
+            return ( m_data != 0 ? m_count : m_fingerprints.size() );
+        }
+
+        // uses @count fingerprints at @data, which must stay valid while set is in use
+        void SetData(const uint64_t* data, const size_t count) {
+            Clear();
+            m_data  = data;
+            m_count = count;
+        }
+
+        void Sort(void) {
+            sort(m_fingerprints.begin(), m_fingerprints.end());
+            m_fingerprints.erase( unique(m_fingerprints.begin(), m_fingerprints.end()),
+                                  m_fingerprints.end() );
+        }
+
+    // data members
+    private:
+        vector<uint64_t> m_fingerprints;
+        const uint64_t* m_data;
+        size_t m_count;
+};
+
 // --------------------------------------------------------------------------
 // ModelType implementation
 
@@ -87,24 +296,19 @@ struct ModelType {
 
     // data members
     uint16_t ID;
-    vector<int32_t> FragmentLengths;
+    map<int32_t, uint64_t> FragmentLengths; // fragment length => count
+    size_t NumFragments;
 
     // ctor
     ModelType(const uint16_t id)
         : ID(id)
-    {
-        // preallocate space for 10K fragments per model type
-        FragmentLengths.reserve(10000);
-    }
+        , NumFragments(0)
+    { }
 
-    // convenience access to internal fragment lengths vector
-    vector<int32_t>::iterator begin(void) { return FragmentLengths.begin(); }
-    vector<int32_t>::const_iterator begin(void) const { return FragmentLengths.begin(); }
-    void clear(void) { FragmentLengths.clear(); }
-    vector<int32_t>::iterator end(void) { return FragmentLengths.end(); }
-    vector<int32_t>::const_iterator end(void) const { return FragmentLengths.end(); }
-    void push_back(const int32_t& x) { FragmentLengths.push_back(x); }
-    size_t size(void) const { return FragmentLengths.size(); }
+    // convenience access to fragment length counts
+    void clear(void) { FragmentLengths.clear(); NumFragments = 0; }
+    void push_back(const int32_t& x) { ++FragmentLengths[x]; ++NumFragments; }
+    size_t size(void) const { return NumFragments; }
 
     // constants
     static const uint16_t DUMMY_ID;
@@ -155,7 +359,8 @@ struct ReadGroupResolver {
     bool IsAmbiguous;
     bool HasData;
     vector<ModelType> Models;
-    map<string, bool> ReadNames;
+    ReadNameTable UnmatchedNames;   // mates seen once so far (while making stats)
+    ReadNameSet ReadNames;          // candidate proper pairs
 
     // ctor
     ReadGroupResolver(void);
@@ -166,6 +371,7 @@ struct ReadGroupResolver {
 
     // select 2 best models based on observed data
     void DetermineTopModels(const string& readGroupName);
+    static int32_t FragmentLengthAt(const map<int32_t, uint64_t>& fragments, const size_t index);
 
     // static settings
     static double ConfidenceInterval;
@@ -245,12 +451,13 @@ void ReadGroupResolver::DetermineTopModels(const string& readGroupName) {
              << endl;
     }
 
-    // store only the fragments from the best alignment models, then sort
-    vector<int32_t> fragments;
-    fragments.reserve( Models[0].size() + Models[1].size() );
-    fragments.insert( fragments.end(), Models[0].begin(), Models[0].end() );
-    fragments.insert( fragments.end(), Models[1].begin(), Models[1].end() );
-    sort ( fragments.begin(), fragments.end() );
+    // combine the fragment length counts from the best alignment models (kept in sorted order)
+    map<int32_t, uint64_t> fragments = Models[0].FragmentLengths;
+    map<int32_t, uint64_t>::const_iterator fragmentIter = Models[1].FragmentLengths.begin();
+    map<int32_t, uint64_t>::const_iterator fragmentEnd  = Models[1].FragmentLengths.end();
+    for ( ; fragmentIter != fragmentEnd; ++fragmentIter )
+        fragments[(*fragmentIter).first] += (*fragmentIter).second;
+    const size_t numFragmentLengths = Models[0].size() + Models[1].size();
 
     // clear out Model fragment data, not needed anymore
     Models.clear();
@@ -263,15 +470,27 @@ void ReadGroupResolver::DetermineTopModels(const string& readGroupName) {
         HasData = true;
 
     // calculate & store the min,median, & max fragment lengths
-    const unsigned int numFragmentLengths = fragments.size();
     const double halfNonConfidenceInterval = (1.0 - ReadGroupResolver::ConfidenceInterval)/2.0;
-    const unsigned int minIndex    = (unsigned int)(numFragmentLengths * halfNonConfidenceInterval);
-    const unsigned int medianIndex = (unsigned int)(numFragmentLengths * 0.5);
-    const unsigned int maxIndex    = (unsigned int)(numFragmentLengths * (1.0-halfNonConfidenceInterval));
+    const size_t minIndex    = (size_t)(numFragmentLengths * halfNonConfidenceInterval);
+    const size_t medianIndex = (size_t)(numFragmentLengths * 0.5);
+    const size_t maxIndex    = (size_t)(numFragmentLengths * (1.0-halfNonConfidenceInterval));
 
-    MinFragmentLength    = fragments[minIndex];
-    MedianFragmentLength = fragments[medianIndex];
-    MaxFragmentLength    = fragments[maxIndex];
+    MinFragmentLength    = FragmentLengthAt(fragments, minIndex);
+    MedianFragmentLength = FragmentLengthAt(fragments, medianIndex);
+    MaxFragmentLength    = FragmentLengthAt(fragments, maxIndex);
+}
+
+// returns the fragment length found at @index, if all counted lengths were laid out in sorted order
+int32_t ReadGroupResolver::FragmentLengthAt(const map<int32_t, uint64_t>& fragments, const size_t index) {
+    uint64_t numPassed = 0;
+    map<int32_t, uint64_t>::const_iterator fragmentIter = fragments.begin();
+    map<int32_t, uint64_t>::const_iterator fragmentEnd  = fragments.end();
+    for ( ; fragmentIter != fragmentEnd; ++fragmentIter ) {
+        numPassed += (*fragmentIter).second;
+        if ( index < numPassed )
+            return (*fragmentIter).first;
+    }
+    return ( fragments.empty() ? 0 : (*fragments.rbegin()).first );
 }
 
 void ReadGroupResolver::SetConfidenceInterval(const double& ci) {
@@ -282,6 +501,248 @@ void ReadGroupResolver::SetUnusedModelThreshold(const double& umt) {
     UnusedModelThreshold = umt;
 }
 
+// --------------------------------------------------------------------------
+// ProperPairMarker implementation
+
+// alignment waiting to be marked in -onePass mode, with the results of all checks
+// that do not depend on its mate
+struct ResolveEntry {
+
+    // data members
+    BamAlignment Alignment;
+    uint64_t NameFingerprint;
+    bool IsPairable;        // paired, with both mates mapped to the same reference
+    bool IsUnique;          // pairable, with map quality at or above cutoff
+    bool IsMarkable;        // unique, matching its read group's orientation & fragment length models
+    bool IsMateUnique;
+    bool IsDecided;         // mate's uniqueness is known (or does not matter)
+
+    // ctor
+    ResolveEntry(void)
+        : NameFingerprint(0)
+        , IsPairable(false)
+        , IsUnique(false)
+        , IsMarkable(false)
+        , IsMateUnique(false)
+        , IsDecided(false)
+    { }
+};
+
+// runs the mate-independent proper-pair checks on entry's alignment
+// (only reads from resolvers, so may be called from several threads at once)
+void ClassifyAlignment(ResolveEntry& entry,
+                       const map<string, ReadGroupResolver>& readGroups,
+                       const uint16_t minimumMapQuality)
+{
+    const BamAlignment& al = entry.Alignment;
+    entry.IsPairable = ( al.IsPaired() && al.IsMapped() && al.IsMateMapped() && al.RefID == al.MateRefID );
+    entry.IsUnique   = ( entry.IsPairable && al.MapQuality >= minimumMapQuality );
+    entry.IsMarkable = false;
+    entry.IsMateUnique = false;
+    entry.IsDecided = !entry.IsPairable;
+    if ( !entry.IsPairable ) return;
+
+    entry.NameFingerprint = ReadNameFingerprint(al.Name);
+
+    // if mate's map quality is stored with alignment, no need to wait for mate
+    uint32_t mateMapQuality = 0;
+    int32_t signedMateMapQuality = 0;
+    if ( al.GetTag(MATE_MAPQUALITY_TAG, mateMapQuality) ) {
+        entry.IsMateUnique = ( mateMapQuality >= minimumMapQuality );
+        entry.IsDecided = true;
+    } else if ( al.GetTag(MATE_MAPQUALITY_TAG, signedMateMapQuality) ) {
+        entry.IsMateUnique = ( signedMateMapQuality >= (int32_t)minimumMapQuality );
+        entry.IsDecided = true;
+    }
+
+    if ( !entry.IsUnique ) return;
+
+    // look up read group's 'resolver'
+    string readGroupName("");
+    al.GetTag(READ_GROUP_TAG, readGroupName);
+    map<string, ReadGroupResolver>::const_iterator rgIter = readGroups.find(readGroupName);
+    if ( rgIter == readGroups.end() ) {
+        cerr << "bamtools resolve ERROR - read group found that was not in header: "
+             << readGroupName << endl;
+        exit(1);
+    }
+    const ReadGroupResolver& resolver = (*rgIter).second;
+
+    // check pair orientation & distance (can differ for each RG)
+    entry.IsMarkable = ( resolver.IsValidOrientation(al) && resolver.IsValidInsertSize(al) );
+}
+
+// marks classified alignments as proper pairs once their mate has been seen, writing them
+// in input order. Alignments stay buffered only while their mate could still show up
+// within the next @bufferSize alignments; after that, the mate is assumed to be unique.
+class ProperPairMarker {
+
+    // ctor
+    public:
+        ProperPairMarker(BamWriter& writer, const size_t bufferSize)
+            : m_writer(writer)
+            , m_bufferSize( bufferSize == 0 ? 1 : bufferSize )
+            , m_firstIndex(0)
+            , m_nextIndex(0)
+        { }
+
+    // ProperPairMarker interface
+    public:
+        void Add(const ResolveEntry& entry) {
+
+            m_window.push_back(entry);
+            ResolveEntry& current = m_window.back();
+            const uint64_t index = m_nextIndex++;
+
+            // match with mate, if not done yet
+            if ( current.IsPairable && !current.IsDecided ) {
+
+                map<uint64_t, PendingMate>::iterator mateIter = m_pending.find(current.NameFingerprint);
+                if ( mateIter != m_pending.end() ) {
+
+                    // pass uniqueness both ways (mate may already have been written, if it did not need ours)
+                    const PendingMate& mate = (*mateIter).second;
+                    if ( mate.Index >= m_firstIndex ) {
+                        ResolveEntry& mateEntry = m_window[ static_cast<size_t>(mate.Index - m_firstIndex) ];
+                        if ( !mateEntry.IsDecided ) {
+                            mateEntry.IsMateUnique = current.IsUnique;
+                            mateEntry.IsDecided = true;
+                        }
+                    }
+                    current.IsMateUnique = mate.IsUnique;
+                    current.IsDecided = true;
+                    m_pending.erase(mateIter);
+                }
+
+                // otherwise wait for mate (only needed if this alignment may be marked)
+                else {
+                    m_pending.insert( make_pair(current.NameFingerprint, PendingMate(index, current.IsUnique)) );
+                    m_pendingOrder.push_back( make_pair(index, current.NameFingerprint) );
+                    current.IsDecided = !current.IsMarkable;
+                }
+            }
+
+            // forget mates that were seen too long ago
+            while ( !m_pendingOrder.empty() && m_pendingOrder.front().first + m_bufferSize < m_nextIndex ) {
+                map<uint64_t, PendingMate>::iterator mateIter = m_pending.find(m_pendingOrder.front().second);
+                if ( mateIter != m_pending.end() && (*mateIter).second.Index == m_pendingOrder.front().first )
+                    m_pending.erase(mateIter);
+                m_pendingOrder.pop_front();
+            }
+
+            WriteDecided(false);
+        }
+
+        // writes all remaining alignments
+        void Flush(void) {
+            WriteDecided(true);
+            m_pending.clear();
+            m_pendingOrder.clear();
+        }
+
+    // internal methods
+    private:
+        // writes decided alignments from front of buffer
+        // (or all, if @isFlushing), forcing a decision if buffer is full
+        void WriteDecided(const bool isFlushing) {
+            while ( !m_window.empty() ) {
+                ResolveEntry& entry = m_window.front();
+                if ( !entry.IsDecided ) {
+                    if ( !isFlushing && m_window.size() <= m_bufferSize )
+                        break;
+                    entry.IsMateUnique = true;
+                }
+                entry.Alignment.SetIsProperPair( entry.IsMarkable && entry.IsMateUnique );
+                m_writer.SaveAlignment(entry.Alignment);
+                m_window.pop_front();
+                ++m_firstIndex;
+            }
+        }
+
+    // internal types
+    private:
+        struct PendingMate {
+            uint64_t Index;
+            bool IsUnique;
+            PendingMate(const uint64_t index, const bool isUnique)
+                : Index(index)
+                , IsUnique(isUnique)
+            { }
+        };
+
+    // data members
+    private:
+        BamWriter& m_writer;
+        size_t m_bufferSize;
+        deque<ResolveEntry> m_window;                       // alignments not written yet
+        uint64_t m_firstIndex;                              // input index of m_window.front()
+        uint64_t m_nextIndex;
+        map<uint64_t, PendingMate> m_pending;               // name fingerprint => first mate seen
+        deque< pair<uint64_t, uint64_t> > m_pendingOrder;   // (index, name fingerprint), in input order
+};
+
+// batch of alignments, passed through the multi-threaded -onePass pipeline
+struct ResolveBatch {
+    vector<ResolveEntry> Entries;
+    size_t Count;
+
+    ResolveBatch(void)
+        : Entries(RESOLVE_BATCH_SIZE)
+        , Count(0)
+    { }
+};
+
+// BatchPipeline stages for -onePass mode with multiple threads:
+//   reader thread  : reads alignments (any held back while sampling first)
+//   worker threads : run mate-independent proper-pair checks
+//   calling thread : matches mates & writes marked alignments, in input order
+class ResolveStages {
+
+    public:
+        ResolveStages(BamReader& reader,
+                      deque<BamAlignment>& sampledAlignments,
+                      const map<string, ReadGroupResolver>& readGroups,
+                      const uint16_t minimumMapQuality,
+                      ProperPairMarker& marker)
+            : m_reader(reader)
+            , m_sampledAlignments(sampledAlignments)
+            , m_readGroups(readGroups)
+            , m_minimumMapQuality(minimumMapQuality)
+            , m_marker(marker)
+        { }
+
+        bool ReadBatch(ResolveBatch& batch) {
+            batch.Count = 0;
+            while ( batch.Count < RESOLVE_BATCH_SIZE ) {
+                BamAlignment& al = batch.Entries[batch.Count].Alignment;
+                if ( !m_sampledAlignments.empty() ) {
+                    al = m_sampledAlignments.front();
+                    m_sampledAlignments.pop_front();
+                } else if ( !m_reader.GetNextAlignment(al) )
+                    break;
+                ++batch.Count;
+            }
+            return ( batch.Count > 0 );
+        }
+
+        void ProcessBatch(ResolveBatch& batch) {
+            for ( size_t i = 0; i < batch.Count; ++i )
+                ClassifyAlignment(batch.Entries[i], m_readGroups, m_minimumMapQuality);
+        }
+
+        void WriteBatch(ResolveBatch& batch) {
+            for ( size_t i = 0; i < batch.Count; ++i )
+                m_marker.Add(batch.Entries[i]);
+        }
+
+    private:
+        BamReader& m_reader;
+        deque<BamAlignment>& m_sampledAlignments;
+        const map<string, ReadGroupResolver>& m_readGroups;
+        uint16_t m_minimumMapQuality;
+        ProperPairMarker& m_marker;
+};
+
 // --------------------------------------------------------------------------
 // ResolveSettings implementation
 
@@ -291,6 +752,7 @@ struct ResolveTool::ResolveSettings {
     bool IsMakeStats;
     bool IsMarkPairs;
     bool IsTwoPass;
+    bool IsOnePass;
 
     // I/O flags
     bool HasInputBamFile;
@@ -303,6 +765,9 @@ struct ResolveTool::ResolveSettings {
     bool HasForceMarkReadGroups;
     bool HasMinimumMapQuality;
     bool HasUnusedModelThreshold;
+    bool HasSamplePairs;
+    bool HasPairBufferSize;
+    bool HasNumThreads;
 
     // I/O filenames
     string InputBamFilename;
@@ -315,11 +780,17 @@ struct ResolveTool::ResolveSettings {
     uint16_t MinimumMapQuality;
     double   UnusedModelThreshold;
 
+    // one-pass options
+    unsigned int SamplePairs;
+    unsigned int PairBufferSize;
+    unsigned int NumThreads;
+
     // constructor
     ResolveSettings(void)
         : IsMakeStats(false)
         , IsMarkPairs(false)
         , IsTwoPass(false)
+        , IsOnePass(false)
         , HasInputBamFile(false)
         , HasOutputBamFile(false)
         , HasStatsFile(false)
@@ -328,6 +799,9 @@ struct ResolveTool::ResolveSettings {
         , HasForceMarkReadGroups(false)
         , HasMinimumMapQuality(false)
         , HasUnusedModelThreshold(false)
+        , HasSamplePairs(false)
+        , HasPairBufferSize(false)
+        , HasNumThreads(false)
         , InputBamFilename(Options::StandardIn())
         , OutputBamFilename(Options::StandardOut())
         , StatsFilename("")
@@ -335,6 +809,9 @@ struct ResolveTool::ResolveSettings {
         , ConfidenceInterval(DEFAULT_CONFIDENCE_INTERVAL)
         , MinimumMapQuality(DEFAULT_MIN_MAPQUALITY)
         , UnusedModelThreshold(DEFAULT_UNUSEDMODEL_THRESHOLD)
+        , SamplePairs(DEFAULT_SAMPLE_PAIRS)
+        , PairBufferSize(DEFAULT_PAIR_BUFFER_SIZE)
+        , NumThreads(DEFAULT_NUM_THREADS)
     { }
 };
 
@@ -344,61 +821,121 @@ struct ResolveTool::ResolveSettings {
 struct ResolveTool::ReadNamesFileReader {
 
     // ctor & dtor
-    ReadNamesFileReader(void) { }
+    ReadNamesFileReader(void)
+        : m_data(0)
+        , m_dataLength(0)
+    { }
     ~ReadNamesFileReader(void) { Close(); }
 
     // main reader interface
     public:
         void Close(void);
         bool Open(const string& filename);
+        // N.B. - read groups refer to file data until reader is closed
         bool Read(map<string, ReadGroupResolver>& readGroups);
 
     // data members
     private:
-        ifstream m_stream;
+        char* m_data;
+        size_t m_dataLength;
+        vector<uint64_t> m_buffer;  // file contents, if file could not be mapped
 };
 
 void ResolveTool::ReadNamesFileReader::Close(void) {
-    if ( m_stream.is_open() )
-        m_stream.close();
+#ifndef _WIN32
+    if ( m_data != 0 && m_buffer.empty() )
+        munmap(m_data, m_dataLength);
+#endif
+    m_data = 0;
+    m_dataLength = 0;
+    vector<uint64_t>().swap(m_buffer);
 }
 
 bool ResolveTool::ReadNamesFileReader::Open(const string& filename) {
 
-    // make sure stream is fresh
+    // make sure reader is fresh
     Close();
 
-    // attempt to open filename, return status
-    m_stream.open(filename.c_str(), ifstream::in);
-    return m_stream.good();
+#ifndef _WIN32
+
+    // map file, so fingerprints can be searched in place
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if ( fd < 0 ) return false;
+    struct stat fileStats;
+    if ( fstat(fd, &fileStats) != 0 ) {
+        close(fd);
+        return false;
+    }
+    m_dataLength = static_cast<size_t>(fileStats.st_size);
+    if ( m_dataLength > 0 ) {
+        void* data = mmap(0, m_dataLength, PROT_READ, MAP_PRIVATE, fd, 0);
+        if ( data != MAP_FAILED )
+            m_data = static_cast<char*>(data);
+    }
+    close(fd);
+    if ( m_data != 0 || m_dataLength == 0 )
+        return true;
+
+#endif // _WIN32
+
+    // otherwise load file contents (into 8-byte aligned storage)
+    ifstream stream(filename.c_str(), ifstream::in | ifstream::binary);
+    if ( !stream.good() ) return false;
+    stream.seekg(0, ios::end);
+    m_dataLength = static_cast<size_t>(stream.tellg());
+    stream.seekg(0, ios::beg);
+    m_buffer.assign( (m_dataLength + sizeof(uint64_t) - 1) / sizeof(uint64_t) + 1, 0 );
+    m_data = reinterpret_cast<char*>(&m_buffer[0]);
+    stream.read(m_data, m_dataLength);
+    return stream.good();
 }
 
 bool ResolveTool::ReadNamesFileReader::Read(map<string, ReadGroupResolver>& readGroups) {
 
-    // up-front sanity check
-    if ( !m_stream.is_open() ) return false;
+    // check magic number
+    size_t offset = 0;
+    if ( m_dataLength < sizeof(READNAME_FILE_MAGIC) + sizeof(uint32_t) ||
+         memcmp(m_data, READNAME_FILE_MAGIC, sizeof(READNAME_FILE_MAGIC)) != 0 )
+    {
+        return false;
+    }
+    offset += sizeof(READNAME_FILE_MAGIC);
+
+    // get number of read groups
+    uint32_t numReadGroups = 0;
+    memcpy(&numReadGroups, m_data + offset, sizeof(numReadGroups));
+    offset += sizeof(numReadGroups);
 
-    // parse read names file
-    string line;
-    vector<string> fields;
     map<string, ReadGroupResolver>::iterator rgIter;
     map<string, ReadGroupResolver>::iterator rgEnd = readGroups.end();
-    while ( getline(m_stream, line) ) {
-
-        // skip if empty line
-        if ( line.empty() ) continue;
-
-        // split line on '\t'
-        fields = Utilities::Split(line, TAB_CHAR);
-        if ( fields.size() != 2 ) continue;
+    for ( uint32_t i = 0; i < numReadGroups; ++i ) {
+
+        // read group name
+        uint32_t nameLength = 0;
+        if ( offset + sizeof(nameLength) > m_dataLength ) return false;
+        memcpy(&nameLength, m_data + offset, sizeof(nameLength));
+        offset += sizeof(nameLength);
+        if ( offset + nameLength > m_dataLength ) return false;
+        const string readGroupName(m_data + offset, nameLength);
+        offset += nameLength;
+        offset += (READNAME_FILE_ALIGNMENT - offset % READNAME_FILE_ALIGNMENT) % READNAME_FILE_ALIGNMENT;
+
+        // number of fingerprints
+        uint64_t numNames = 0;
+        if ( offset + sizeof(numNames) > m_dataLength ) return false;
+        memcpy(&numNames, m_data + offset, sizeof(numNames));
+        offset += sizeof(numNames);
+        if ( numNames > (m_dataLength - offset) / sizeof(uint64_t) ) return false;
 
         // look up resolver for read group
-        rgIter = readGroups.find( fields[0] );
+        rgIter = readGroups.find(readGroupName);
         if ( rgIter == rgEnd ) return false;
         ReadGroupResolver& resolver = (*rgIter).second;
 
-        // store read name with resolver
-        resolver.ReadNames.insert( make_pair<string,bool>(fields[1], true) ) ;
+        // point resolver's read names at (sorted) fingerprints
+        resolver.ReadNames.SetData( reinterpret_cast<const uint64_t*>(m_data + offset),
+                                    static_cast<size_t>(numNames) );
+        offset += static_cast<size_t>(numNames) * sizeof(uint64_t);
     }
 
     // if here, return success
@@ -418,11 +955,16 @@ struct ResolveTool::ReadNamesFileWriter {
     public:
         void Close(void);
         bool Open(const string& filename);
-        void Write(const string& readGroupName, const string& readName);
+        bool Write(const map<string, ReadGroupResolver>& readGroups);
+
+    // internal methods
+    private:
+        void WriteData(const void* data, const size_t length);
 
     // data members
     private:
         ofstream m_stream;
+        size_t m_offset;
 };
 
 void ResolveTool::ReadNamesFileWriter::Close(void) {
@@ -436,14 +978,50 @@ bool ResolveTool::ReadNamesFileWriter::Open(const string& filename) {
     Close();
 
     // attempt to open filename, return status
-    m_stream.open(filename.c_str(), ofstream::out);
+    m_stream.open(filename.c_str(), ofstream::out | ofstream::binary);
+    m_offset = 0;
     return m_stream.good();
 }
 
-void ResolveTool::ReadNamesFileWriter::Write(const string& readGroupName,
-                                             const string& readName)
-{
-    m_stream << readGroupName << TAB_CHAR << readName << endl;
+bool ResolveTool::ReadNamesFileWriter::Write(const map<string, ReadGroupResolver>& readGroups) {
+
+    static const char padding[READNAME_FILE_ALIGNMENT] = { 0 };
+
+    // only read groups with candidate read names are stored
+    uint32_t numReadGroups = 0;
+    map<string, ReadGroupResolver>::const_iterator rgIter = readGroups.begin();
+    map<string, ReadGroupResolver>::const_iterator rgEnd  = readGroups.end();
+    for ( ; rgIter != rgEnd; ++rgIter ) {
+        if ( (*rgIter).second.ReadNames.Size() > 0 )
+            ++numReadGroups;
+    }
+    WriteData(READNAME_FILE_MAGIC, sizeof(READNAME_FILE_MAGIC));
+    WriteData(&numReadGroups, sizeof(numReadGroups));
+
+    for ( rgIter = readGroups.begin(); rgIter != rgEnd; ++rgIter ) {
+        const string& name = (*rgIter).first;
+        const ReadNameSet& readNames = (*rgIter).second.ReadNames;
+        if ( readNames.Size() == 0 ) continue;
+
+        // read group name, padded so fingerprints are aligned when mapped
+        const uint32_t nameLength = static_cast<uint32_t>(name.size());
+        WriteData(&nameLength, sizeof(nameLength));
+        WriteData(name.data(), nameLength);
+        WriteData(padding, (READNAME_FILE_ALIGNMENT - m_offset % READNAME_FILE_ALIGNMENT) % READNAME_FILE_ALIGNMENT);
+
+        // sorted fingerprints
+        const uint64_t numNames = readNames.Size();
+        WriteData(&numNames, sizeof(numNames));
+        WriteData(readNames.Data(), static_cast<size_t>(numNames) * sizeof(uint64_t));
+    }
+
+    return m_stream.good();
+}
+
+void ResolveTool::ReadNamesFileWriter::WriteData(const void* data, const size_t length) {
+    if ( length == 0 ) return;
+    m_stream.write(static_cast<const char*>(data), length);
+    m_offset += length;
 }
 
 // --------------------------------------------------------------------------
@@ -816,11 +1394,14 @@ struct ResolveTool::ResolveToolPrivate {
 
     // internal methods
     private:
+        bool AddToStats(BamAlignment& al, const bool isStoringReadNames, uint64_t& numPairs);
         bool CheckSettings(vector<string>& errors);
+        void FinishStats(void);
         bool MakeStats(void);
         void ParseHeader(const SamHeader& header);
         bool ReadStatsFile(void);
         void ResolveAlignment(BamAlignment& al);
+        bool ResolveOnePass(void);
         bool ResolvePairs(void);
         bool WriteStatsFile(void);
 
@@ -830,6 +1411,64 @@ struct ResolveTool::ResolveToolPrivate {
         map<string, ReadGroupResolver> m_readGroups;
 };
 
+// adds alignment's pairing & fragment length info to its read group's stats
+// (increments @numPairs once both mates of a read have been seen)
+bool ResolveTool::ResolveToolPrivate::AddToStats(BamAlignment& al,
+                                                 const bool isStoringReadNames,
+                                                 uint64_t& numPairs)
+{
+    // skip if alignment is not paired, mapped, nor mate is mapped
+    if ( !al.IsPaired() || !al.IsMapped() || !al.IsMateMapped() )
+        return true;
+
+    // skip if alignment & mate not on same reference sequence
+    if ( al.RefID != al.MateRefID ) return true;
+
+    // flesh out the char data, so we can retrieve its read group ID
+    al.BuildCharData();
+
+    // get read group from alignment (OK if empty)
+    string readGroup("");
+    al.GetTag(READ_GROUP_TAG, readGroup);
+
+    // look up resolver for read group
+    map<string, ReadGroupResolver>::iterator rgIter = m_readGroups.find(readGroup);
+    if ( rgIter == m_readGroups.end() )  {
+        cerr << "bamtools resolve ERROR - unable to calculate stats, unknown read group encountered: "
+             << readGroup << endl;
+        return false;
+    }
+    ReadGroupResolver& resolver = (*rgIter).second;
+
+    // determine unique-ness of current alignment
+    const bool isCurrentMateUnique = ( al.MapQuality >= m_settings->MinimumMapQuality );
+
+    // look up read name, removing it if found (current alignment's mate already parsed)
+    bool isStoredMateUnique = false;
+    if ( resolver.UnmatchedNames.Remove(al.Name, isStoredMateUnique) ) {
+
+        ++numPairs;
+
+        // if both unique mates are unique, store read name & insert size for later
+        if ( isCurrentMateUnique && isStoredMateUnique ) {
+
+            // save read name as candidate for later pair marking
+            if ( isStoringReadNames )
+                resolver.ReadNames.Add(al.Name);
+
+            // determine model type & store fragment length for stats calculation
+            const uint16_t currentModelType = CalculateModelType(al);
+            assert( currentModelType != ModelType::DUMMY_ID );
+            resolver.Models[currentModelType].push_back( abs(al.InsertSize) );
+        }
+    }
+
+    // if read name not found, store new entry
+    else resolver.UnmatchedNames.Insert(al.Name, isCurrentMateUnique);
+
+    return true;
+}
+
 bool ResolveTool::ResolveToolPrivate::CheckSettings(vector<string>& errors) {
 
     // ensure clean slate
@@ -843,6 +1482,8 @@ bool ResolveTool::ResolveToolPrivate::CheckSettings(vector<string>& errors) {
             errors.push_back("Cannot run in both -makeStats & -markPairs modes. Please select ONE.");
         if ( m_settings->IsTwoPass )
             errors.push_back("Cannot run in both -makeStats & -twoPass modes. Please select ONE.");
+        if ( m_settings->IsOnePass )
+            errors.push_back("Cannot run in both -makeStats & -onePass modes. Please select ONE.");
 
         // error if output BAM options supplied
         if ( m_settings->HasOutputBamFile )
@@ -867,6 +1508,8 @@ bool ResolveTool::ResolveToolPrivate::CheckSettings(vector<string>& errors) {
             errors.push_back("Cannot run in both -makeStats & -markPairs modes. Please select ONE.");
         if ( m_settings->IsTwoPass )
             errors.push_back("Cannot run in both -markPairs & -twoPass modes. Please select ONE.");
+        if ( m_settings->IsOnePass )
+            errors.push_back("Cannot run in both -markPairs & -onePass modes. Please select ONE.");
 
         // make sure required stats file supplied
         if ( !m_settings->HasStatsFile )
@@ -885,15 +1528,31 @@ bool ResolveTool::ResolveToolPrivate::CheckSettings(vector<string>& errors) {
             errors.push_back("Cannot run in both -makeStats & -twoPass modes. Please select ONE.");
         if ( m_settings->IsMarkPairs )
             errors.push_back("Cannot run in both -markPairs & -twoPass modes. Please select ONE.");
+        if ( m_settings->IsOnePass )
+            errors.push_back("Cannot run in both -twoPass & -onePass modes. Please select ONE.");
 
         // make sure input is file not stdin
         if ( !m_settings->HasInputBamFile || m_settings->InputBamFilename == Options::StandardIn() )
             errors.push_back("Cannot run -twoPass mode with BAM data from stdin. Please specify existing file using -in option.");
     }
 
+    // if OnePass mode (other modes already ruled out above)
+    else if ( m_settings->IsOnePass ) {
+
+        // make sure some pairs are sampled
+        if ( m_settings->SamplePairs == 0 )
+            errors.push_back("Invalid number of sample pairs. Must be at least 1");
+    }
+
     // no mode selected
     else
-        errors.push_back("No resolve mode specified. Please select ONE of the following: -makeStats, -markPairs, or -twoPass. See help for more info.");
+        errors.push_back("No resolve mode specified. Please select ONE of the following: -makeStats, -markPairs, -twoPass, or -onePass. See help for more info.");
+
+    // check for OnePass options
+    if ( !m_settings->IsOnePass ) {
+        if ( m_settings->HasSamplePairs || m_settings->HasPairBufferSize || m_settings->HasNumThreads )
+            errors.push_back("Cannot use -samplePairs, -pairBuffer, or -threads. These options are only available in -onePass mode.");
+    }
 
     // boundary checks on values
     if ( m_settings->HasConfidenceInterval ) {
@@ -913,6 +1572,28 @@ bool ResolveTool::ResolveToolPrivate::CheckSettings(vector<string>& errors) {
     return ( errors.empty() );
 }
 
+// determines each read group's models once all stats are collected
+void ResolveTool::ResolveToolPrivate::FinishStats(void) {
+
+    // iterate back through read groups
+    map<string, ReadGroupResolver>::iterator rgIter = m_readGroups.begin();
+    map<string, ReadGroupResolver>::iterator rgEnd  = m_readGroups.end();
+    for ( ; rgIter != rgEnd; ++rgIter ) {
+        const string& name = (*rgIter).first;
+        ReadGroupResolver& resolver = (*rgIter).second;
+
+        // calculate acceptable orientation & insert sizes for this read group
+        resolver.DetermineTopModels(name);
+
+        // clear out left over read names
+        // (these have mates that did not pass filters or were already removed as non-unique)
+        resolver.UnmatchedNames.Clear();
+
+        // sort candidate read names for lookup
+        resolver.ReadNames.Sort();
+    }
+}
+
 bool ResolveTool::ResolveToolPrivate::MakeStats(void) {
 
     // pull resolver settings from command-line settings
@@ -942,83 +1623,33 @@ bool ResolveTool::ResolveToolPrivate::MakeStats(void) {
 
     // read through BAM file
     BamAlignment al;
-    string readGroup("");
-    map<string, ReadGroupResolver>::iterator rgIter;
-    map<string, bool>::iterator readNameIter;
+    uint64_t numPairs = 0;
     while ( bamReader.GetNextAlignmentCore(al) ) {
-
-        // skip if alignment is not paired, mapped, nor mate is mapped
-        if ( !al.IsPaired() || !al.IsMapped() || !al.IsMateMapped() )
-            continue;
-
-        // skip if alignment & mate not on same reference sequence
-        if ( al.RefID != al.MateRefID ) continue;
-
-        // flesh out the char data, so we can retrieve its read group ID
-        al.BuildCharData();
-
-        // get read group from alignment (OK if empty)
-        readGroup.clear();
-        al.GetTag(READ_GROUP_TAG, readGroup);
-
-        // look up resolver for read group
-        rgIter = m_readGroups.find(readGroup);
-        if ( rgIter == m_readGroups.end() )  {
-            cerr << "bamtools resolve ERROR - unable to calculate stats, unknown read group encountered: "
-                 << readGroup << endl;
+        if ( !AddToStats(al, true, numPairs) ) {
             bamReader.Close();
             return false;
         }
-        ReadGroupResolver& resolver = (*rgIter).second;
-
-        // determine unique-ness of current alignment
-        const bool isCurrentMateUnique = ( al.MapQuality >= m_settings->MinimumMapQuality );
-
-        // look up read name
-        readNameIter = resolver.ReadNames.find(al.Name);
-
-        // if read name found (current alignment's mate already parsed)
-        if ( readNameIter != resolver.ReadNames.end() ) {
-
-            // if both unique mates are unique, store read name & insert size for later
-            const bool isStoredMateUnique  = (*readNameIter).second;
-            if ( isCurrentMateUnique && isStoredMateUnique ) {
-
-                // save read name in temp file as candidates for later pair marking
-                readNamesWriter.Write(readGroup, al.Name);
-
-                // determine model type & store fragment length for stats calculation
-                const uint16_t currentModelType = CalculateModelType(al);
-                assert( currentModelType != ModelType::DUMMY_ID );
-                resolver.Models[currentModelType].push_back( abs(al.InsertSize) );
-            }
-
-            // unique or not, remove read name from map
-            resolver.ReadNames.erase(readNameIter);
-        }
-
-        // if read name not found, store new entry
-        else resolver.ReadNames.insert( make_pair<string, bool>(al.Name, isCurrentMateUnique) );
     }
-
-    // close files
-    readNamesWriter.Close();
     bamReader.Close();
 
-    // iterate back through read groups
-    map<string, ReadGroupResolver>::iterator rgEnd  = m_readGroups.end();
-    for ( rgIter = m_readGroups.begin(); rgIter != rgEnd; ++rgIter ) {
-        const string& name = (*rgIter).first;
-        ReadGroupResolver& resolver = (*rgIter).second;
+    // calculate acceptable orientation & insert sizes for each read group
+    FinishStats();
 
-        // calculate acceptable orientation & insert sizes for this read group
-        resolver.DetermineTopModels(name);
-
-        // clear out left over read names
-        // (these have mates that did not pass filters or were already removed as non-unique)
-        resolver.ReadNames.clear();
+    // save candidate read names to temp file, for later pair marking
+    const bool isWritten = readNamesWriter.Write(m_readGroups);
+    readNamesWriter.Close();
+    if ( !isWritten ) {
+        cerr << "bamtools resolve ERROR: could not write (temp) output read names file: "
+             << m_settings->ReadNamesFilename << endl;
+        return false;
     }
 
+    // drop in-memory read names, these are reloaded from file
+    map<string, ReadGroupResolver>::iterator rgIter = m_readGroups.begin();
+    map<string, ReadGroupResolver>::iterator rgEnd  = m_readGroups.end();
+    for ( ; rgIter != rgEnd; ++rgIter )
+        (*rgIter).second.ReadNames.Clear();
+
     // if we get here, return success
     return true;
 }
@@ -1097,15 +1728,108 @@ void ResolveTool::ResolveToolPrivate::ResolveAlignment(BamAlignment& al) {
     if ( !resolver.IsValidInsertSize(al) ) return;
 
     // quit check if alignment is not a "candidate proper pair"
-    map<string, bool>::const_iterator readNameIter;
-    readNameIter = resolver.ReadNames.find(al.Name);
-    if ( readNameIter == resolver.ReadNames.end() )
+    if ( !resolver.ReadNames.Contains(al.Name) )
         return;
 
     // if we get here, alignment is OK - set 'proper pair' flag
     al.SetIsProperPair(true);
 }
 
+bool ResolveTool::ResolveToolPrivate::ResolveOnePass(void) {
+
+    // pull resolver settings from command-line settings
+    ReadGroupResolver::SetConfidenceInterval(m_settings->ConfidenceInterval);
+    ReadGroupResolver::SetUnusedModelThreshold(m_settings->UnusedModelThreshold);
+
+    // open our BAM reader
+    BamReader reader;
+    if ( !reader.Open(m_settings->InputBamFilename) ) {
+        cerr << "bamtools resolve ERROR: could not open input BAM file: "
+             << m_settings->InputBamFilename << endl;
+        return false;
+    }
+
+    // retrieve header & parse for read groups
+    const SamHeader& header = reader.GetHeader();
+    const RefVector& references = reader.GetReferenceData();
+    ParseHeader(header);
+
+    // build stats from the first pairs only
+    // stdin can't be rewound, so sampled alignments are held until marking starts
+    const bool isRewindable = ( m_settings->InputBamFilename != Options::StandardIn() );
+    deque<BamAlignment> sampledAlignments;
+    BamAlignment al;
+    uint64_t numPairs = 0;
+    while ( numPairs < m_settings->SamplePairs && reader.GetNextAlignment(al) ) {
+        if ( !AddToStats(al, false, numPairs) ) {
+            reader.Close();
+            return false;
+        }
+        if ( !isRewindable )
+            sampledAlignments.push_back(al);
+    }
+    FinishStats();
+    if ( isRewindable && !reader.Rewind() ) {
+        cerr << "bamtools resolve ERROR: could not rewind input BAM file: "
+             << m_settings->InputBamFilename << endl;
+        reader.Close();
+        return false;
+    }
+
+    // if stats file requested, write stats to file
+    // emit warning if write fails, but paired-end resolution should be allowed to proceed
+    if ( m_settings->HasStatsFile && !WriteStatsFile() )
+        cerr << "bamtools resolve WARNING - could not write stats file: "
+             << m_settings->StatsFilename << endl;
+
+    // determine compression mode for BamWriter
+    bool writeUncompressed = ( m_settings->OutputBamFilename == Options::StandardOut() &&
+                               !m_settings->IsForceCompression );
+    BamWriter::CompressionMode compressionMode = BamWriter::Compressed;
+    if ( writeUncompressed ) compressionMode = BamWriter::Uncompressed;
+
+    // open BamWriter
+    BamWriter writer;
+    writer.SetCompressionMode(compressionMode);
+    writer.SetNumThreads(m_settings->NumThreads);
+    if ( !writer.Open(m_settings->OutputBamFilename, header, references) ) {
+        cerr << "bamtools resolve ERROR: could not open "
+             << m_settings->OutputBamFilename << " for writing." << endl;
+        reader.Close();
+        return false;
+    }
+
+    // mark alignments, as mates are matched up
+    ProperPairMarker marker(writer, m_settings->PairBufferSize);
+
+    // if multiple threads requested, check alignments in batches on worker threads
+    if ( m_settings->NumThreads > 1 ) {
+        ResolveStages stages(reader, sampledAlignments, m_readGroups, m_settings->MinimumMapQuality, marker);
+        BatchPipeline<ResolveBatch, ResolveStages> pipeline(stages, m_settings->NumThreads);
+        pipeline.Run();
+    }
+
+    // otherwise check alignments one at a time
+    else {
+        ResolveEntry entry;
+        while ( true ) {
+            if ( !sampledAlignments.empty() ) {
+                entry.Alignment = sampledAlignments.front();
+                sampledAlignments.pop_front();
+            } else if ( !reader.GetNextAlignment(entry.Alignment) )
+                break;
+            ClassifyAlignment(entry, m_readGroups, m_settings->MinimumMapQuality);
+            marker.Add(entry);
+        }
+    }
+    marker.Flush();
+
+    // clean up & return success
+    reader.Close();
+    writer.Close();
+    return true;
+}
+
 bool ResolveTool::ResolveToolPrivate::ResolvePairs(void) {
 
     // open file containing read names of candidate proper pairs
@@ -1124,8 +1848,8 @@ bool ResolveTool::ResolveToolPrivate::ResolvePairs(void) {
         return false;
     }
 
-    // close read name file reader & delete temp file
-    readNamesReader.Close();
+    // delete temp file
+    // (read names stay available to reader until it is closed)
     if ( remove(m_settings->ReadNamesFilename.c_str()) != 0 ) {
         cerr << "bamtools resolve WARNING: could not delete temp file: "
              << m_settings->ReadNamesFilename << endl;
@@ -1229,6 +1953,16 @@ bool ResolveTool::ResolveToolPrivate::Run(void) {
         }
     }
 
+    // -onePass mode
+    else if ( m_settings->IsOnePass ) {
+
+        // generate stats data from sampled pairs & resolve in the same stream
+        if ( !ResolveOnePass() ) {
+            cerr << "bamtools resolve ERROR - could not resolve pairs" << endl;
+            return false;
+        }
+    }
+
     // -twoPass mode
     else {
 
@@ -1315,6 +2049,14 @@ ResolveTool::ResolveTool(void)
             "All MakeStats & MarkPairs Mode Settings are available. "
             "The intermediate stats file is not necessary, but if the -stats options is used, then one will be generated. "
             "You may find this useful for documentation purposes.";
+    const string onePassDescription = "like -twoPass, but reads the input only once, so BAM data may be piped via stdin. "
+            "Fragment-length stats are generated from the first pairs (see -samplePairs), then all alignments are marked "
+            "as their mates come in. A mate's uniqueness is taken from its MQ tag if present; otherwise from the mate itself, "
+            "if it follows within -pairBuffer alignments (if not, it is assumed to be unique). "
+            "If the -stats option is used, the stats file will be generated as well.";
+    const string samplePairsDescription = "number of pairs (from start of input) used to generate fragment-length stats";
+    const string pairBufferDescription = "maximum number of alignments held while waiting for their mate";
+    const string numThreadsDescription = "number of threads used to check & compress alignments";
     const string minMapQualDescription = "minimum map quality. Used in -makeStats mode as a heuristic for determining a mate's "
             "uniqueness. Used in -markPairs mode as a filter for marking candidate proper pairs.";
     const string confidenceIntervalDescription = "confidence interval. Set min/max fragment lengths such that we capture "
@@ -1351,6 +2093,7 @@ ResolveTool::ResolveTool(void)
     Options::AddOption("-makeStats", makeStatsDescription, m_settings->IsMakeStats, ModeOpts);
     Options::AddOption("-markPairs", markPairsDescription, m_settings->IsMarkPairs, ModeOpts);
     Options::AddOption("-twoPass",   twoPassDescription,   m_settings->IsTwoPass,   ModeOpts);
+    Options::AddOption("-onePass",   onePassDescription,   m_settings->IsOnePass,   ModeOpts);
 
     OptionGroup* GeneralOpts = Options::CreateOptionGroup("General Resolve Options (available in all modes)");
     Options::AddValueOption("-minMQ", "unsigned short", minMapQualDescription, "",
@@ -1364,6 +2107,14 @@ ResolveTool::ResolveTool(void)
 
     OptionGroup* MarkPairsOpts = Options::CreateOptionGroup("MarkPairs Mode Options (disabled in -makeStats mode)");
     Options::AddOption("-force", forceMarkDescription, m_settings->HasForceMarkReadGroups, MarkPairsOpts);
+
+    OptionGroup* OnePassOpts = Options::CreateOptionGroup("OnePass Mode Options");
+    Options::AddValueOption("-samplePairs", "count", samplePairsDescription, "",
+                            m_settings->HasSamplePairs, m_settings->SamplePairs, OnePassOpts, DEFAULT_SAMPLE_PAIRS);
+    Options::AddValueOption("-pairBuffer", "count", pairBufferDescription, "",
+                            m_settings->HasPairBufferSize, m_settings->PairBufferSize, OnePassOpts, DEFAULT_PAIR_BUFFER_SIZE);
+    Options::AddValueOption("-threads", "count", numThreadsDescription, "",
+                            m_settings->HasNumThreads, m_settings->NumThreads, OnePassOpts, DEFAULT_NUM_THREADS);
 }
 
 ResolveTool::~ResolveTool(void) {
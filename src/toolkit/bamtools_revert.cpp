@@ -2,28 +2,230 @@
 // bamtools_revert.cpp (c) 2010 Derek Barnett, Alistair Ward
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 7 April 2011
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Removes duplicate marks and restores original base qualities
 // ***************************************************************************
 
 #include "bamtools_revert.h"
 
+#include <api/BamConstants.h>
 #include <api/BamReader.h>
 #include <api/BamWriter.h>
+#include <shared/bamtools_raw_record.h>
+#include <utils/bamtools_batch_pipeline.h>
 #include <utils/bamtools_options.h>
 #include <utils/bamtools_utilities.h>
 using namespace BamTools;
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <vector>
 using namespace std;
 
 namespace BamTools {
 
 static const string OQ_TAG = "OQ";
 
-} // namespace BamTools;
+static const unsigned int REVERT_DEFAULT_NUM_THREADS = 1;
+static const size_t REVERT_BATCH_SIZE = 0x100000; // 1 MB of records per batch
+
+// ---------------------------------------------
+// RecordReverter implementation
+
+// 'reverts' raw BAM records in place (no BamAlignment is built)
+// default behavior (for now) is:
+//   1 - replace qualities with OQ contents
+//   2 - clear IsDuplicate flag
+// can override default behavior using command line options, & remove further tags
+//
+// All tags are handled in a single pass over the record's tag data, so a record
+// is shifted at most once, however many tags are removed. Revert() only reads the
+// reverter's settings, so records can be reverted on several threads at once.
+class RecordReverter {
+
+    public:
+        RecordReverter(const bool isKeepDuplicateFlag,
+                       const bool isKeepQualities,
+                       const vector<string>& removedTags)
+            : m_isKeepDuplicateFlag(isKeepDuplicateFlag)
+            , m_isKeepQualities(isKeepQualities)
+            , m_removedTags(removedTags)
+        { }
+
+        // reverts record, returns its new size (never larger than before)
+        size_t Revert(char* record) const {
+
+            // clear duplicate flag, if requested
+            if ( !m_isKeepDuplicateFlag ) {
+                char* flagAndCigarCount = record + RawRecord::FlagNumCigarOffset;
+                RawRecord::WriteUInt32(flagAndCigarCount, RawRecord::ReadUInt32(flagAndCigarCount) & ~(0x400u << 16));
+            }
+
+            // locate qualities & tags
+            const uint32_t seqLength = RawRecord::SeqLength(record);
+            char* qualities = record + RawRecord::QualitiesOffset(record);
+            char* tagData = qualities + seqLength;
+            const size_t recordSize = RawRecord::Size(record);
+            const char* tagEnd = record + recordSize;
+            if ( tagData > tagEnd )
+                return recordSize;
+
+            // walk tags, moving each kept tag down over any removed before it
+            bool isOriginalQualitiesFound = m_isKeepQualities;
+            char* writePosition = tagData;
+            const char* readPosition = tagData;
+            while ( readPosition < tagEnd ) {
+
+                // leave anything that can't be parsed as it is
+                const char* nextTag = RawRecord::SkipTag(readPosition, tagEnd);
+                if ( nextTag == 0 ) {
+                    if ( writePosition != readPosition )
+                        memmove(writePosition, readPosition, tagEnd - readPosition);
+                    writePosition += tagEnd - readPosition;
+                    break;
+                }
+
+                bool isRemoved = IsRemovedTag(readPosition);
+
+                // restore qualities from (first) OQ, as BamAlignment::GetTag() would read it, if requested
+                if ( !isOriginalQualitiesFound &&
+                     readPosition[0] == OQ_TAG[0] && readPosition[1] == OQ_TAG[1] &&
+                     ( readPosition[Constants::BAM_TAG_TAGSIZE] == Constants::BAM_TAG_TYPE_STRING ||
+                       readPosition[Constants::BAM_TAG_TAGSIZE] == Constants::BAM_TAG_TYPE_HEX ) )
+                {
+                    isOriginalQualitiesFound = true;
+                    if ( RestoreQualities(qualities, seqLength, readPosition + Constants::BAM_TAG_TAGSIZE
+                                                                + Constants::BAM_TAG_TYPESIZE) )
+                        isRemoved = true;
+                }
+
+                // keep tag
+                const size_t tagLength = nextTag - readPosition;
+                if ( !isRemoved ) {
+                    if ( writePosition != readPosition )
+                        memmove(writePosition, readPosition, tagLength);
+                    writePosition += tagLength;
+                }
+                readPosition = nextTag;
+            }
+
+            // store new size
+            const size_t newRecordSize = writePosition - record;
+            RawRecord::WriteUInt32(record, static_cast<uint32_t>(newRecordSize - Constants::BAM_SIZEOF_INT));
+            return newRecordSize;
+        }
+
+    private:
+        bool IsRemovedTag(const char* tagData) const {
+            vector<string>::const_iterator tagIter = m_removedTags.begin();
+            vector<string>::const_iterator tagEnd  = m_removedTags.end();
+            for ( ; tagIter != tagEnd; ++tagIter ) {
+                if ( tagData[0] == (*tagIter)[0] && tagData[1] == (*tagIter)[1] )
+                    return true;
+            }
+            return false;
+        }
+
+        // overwrites qualities with (null-terminated) OQ contents, converted to phred scores
+        // returns false, leaving qualities unchanged, if OQ is too short for the sequence
+        // (any extra OQ characters are ignored)
+        static bool RestoreQualities(char* qualities, const uint32_t seqLength, const char* originalQualities) {
+            const size_t length = strlen(originalQualities);
+            if ( length == 0 || (length == 1 && originalQualities[0] == '*') ) {
+                memset(qualities, 0xff, seqLength);   // missing qualities
+                return true;
+            }
+            if ( length < seqLength )
+                return false;
+            for ( uint32_t i = 0; i < seqLength; ++i )
+                qualities[i] = originalQualities[i] - 33;   // FASTQ ASCII -> phred score conversion
+            return true;
+        }
+
+    private:
+        bool m_isKeepDuplicateFlag;
+        bool m_isKeepQualities;
+        vector<string> m_removedTags;
+};
+
+// batch of raw records, passed through the multi-threaded revert pipeline
+// (Records holds records back to back, & is reused from batch to batch)
+struct RevertBatch {
+    string Records;
+    size_t Length;  // bytes in use
+
+    RevertBatch(void)
+        : Length(0)
+    { }
+};
+
+// BatchPipeline stages for reverting with multiple threads:
+//   reader thread  : reads raw records
+//   worker threads : revert records in place, packing them back to back
+//   calling thread : writes reverted records, in input order
+class RevertStages {
+
+    public:
+        RevertStages(BamReader& reader, BamWriter& writer, const RecordReverter& reverter)
+            : m_reader(reader)
+            , m_writer(writer)
+            , m_reverter(reverter)
+            , m_isWriteOk(true)
+        { }
+
+        bool ReadBatch(RevertBatch& batch) {
+            batch.Length = 0;
+            while ( batch.Length < REVERT_BATCH_SIZE && m_reader.GetNextRawAlignment(m_record) ) {
+                if ( batch.Records.size() < batch.Length + m_record.size() )
+                    batch.Records.resize( max(2*batch.Records.size(), batch.Length + m_record.size()) );
+                memcpy(&batch.Records[batch.Length], m_record.data(), m_record.size());
+                batch.Length += m_record.size();
+            }
+            return ( batch.Length > 0 );
+        }
+
+        void ProcessBatch(RevertBatch& batch) {
+            char* records = &batch.Records[0];
+            size_t readOffset  = 0;
+            size_t writeOffset = 0;
+            while ( readOffset < batch.Length ) {
+                const size_t recordSize = RawRecord::Size(records + readOffset);
+                const size_t newRecordSize = m_reverter.Revert(records + readOffset);
+                if ( writeOffset != readOffset )
+                    memmove(records + writeOffset, records + readOffset, newRecordSize);
+                readOffset  += recordSize;
+                writeOffset += newRecordSize;
+            }
+            batch.Length = writeOffset;
+        }
+
+        void WriteBatch(RevertBatch& batch) {
+            const char* records = batch.Records.data();
+            size_t offset = 0;
+            while ( offset < batch.Length ) {
+                const size_t recordSize = RawRecord::Size(records + offset);
+                if ( m_isWriteOk && !m_writer.SaveRawAlignment(records + offset, recordSize) )
+                    m_isWriteOk = false;
+                offset += recordSize;
+            }
+        }
+
+        bool IsWriteOk(void) const {
+            return m_isWriteOk;
+        }
+
+    private:
+        BamReader& m_reader;
+        BamWriter& m_writer;
+        const RecordReverter& m_reverter;
+        string m_record;
+        bool m_isWriteOk;
+};
+
+} // namespace BamTools
 
 // ---------------------------------------------
 // RevertSettings implementation
@@ -36,10 +238,16 @@ struct RevertTool::RevertSettings {
     bool IsForceCompression;
     bool IsKeepDuplicateFlag;
     bool IsKeepQualities;
+    bool HasRemovedTags;
+    bool HasNumThreads;
 
     // filenames
     string InputFilename;
     string OutputFilename;
+
+    // other parameters
+    vector<string> RemovedTags;
+    unsigned int NumThreads;
     
     // constructor
     RevertSettings(void)
@@ -48,8 +256,11 @@ struct RevertTool::RevertSettings {
         , IsForceCompression(false)
         , IsKeepDuplicateFlag(false)
         , IsKeepQualities(false)
+        , HasRemovedTags(false)
+        , HasNumThreads(false)
         , InputFilename(Options::StandardIn())
         , OutputFilename(Options::StandardOut())
+        , NumThreads(REVERT_DEFAULT_NUM_THREADS)
     { }
 };  
 
@@ -69,40 +280,27 @@ struct RevertTool::RevertToolPrivate {
     public:
         bool Run(void);
         
-    // internal methods
-    private:
-        void RevertAlignment(BamAlignment& al);
-        
     // data members
     private:
         RevertTool::RevertSettings* m_settings;
 };
 
-// 'reverts' a BAM alignment
-// default behavior (for now) is:
-//   1 - replace Qualities with OQ contents
-//   2 - clear IsDuplicate flag
-// can override default behavior using command line options
-void RevertTool::RevertToolPrivate::RevertAlignment(BamAlignment& al) {
-
-    // replace Qualities with OQ contents, if requested
-    if ( !m_settings->IsKeepQualities ) {
-        string originalQualities;
-        if ( al.GetTag(OQ_TAG, originalQualities) ) {
-            al.Qualities = originalQualities;
-            al.RemoveTag(OQ_TAG);
+bool RevertTool::RevertToolPrivate::Run(void) {
+
+    // check tags to remove
+    vector<string>::const_iterator tagIter = m_settings->RemovedTags.begin();
+    vector<string>::const_iterator tagEnd  = m_settings->RemovedTags.end();
+    for ( ; tagIter != tagEnd; ++tagIter ) {
+        if ( (*tagIter).size() != Constants::BAM_TAG_TAGSIZE ) {
+            cerr << "bamtools revert ERROR: invalid tag: " << (*tagIter)
+                 << " (tags are 2 characters long)... Aborting." << endl;
+            return false;
         }
     }
-
-    // clear duplicate flag, if requested
-    if ( !m_settings->IsKeepDuplicateFlag )
-        al.SetIsDuplicate(false);
-}
-
-bool RevertTool::RevertToolPrivate::Run(void) {
   
     // opens the BAM file without checking for indexes
     BamReader reader;
+    reader.SetNumThreads(m_settings->NumThreads);
     if ( !reader.Open(m_settings->InputFilename) ) {
         cerr << "bamtools revert ERROR: could not open " << m_settings->InputFilename
              << " for reading... Aborting." << endl;
@@ -122,6 +320,7 @@ bool RevertTool::RevertToolPrivate::Run(void) {
     // open BamWriter
     BamWriter writer;
     writer.SetCompressionMode(compressionMode);
+    writer.SetNumThreads(m_settings->NumThreads);
     if ( !writer.Open(m_settings->OutputFilename, headerText, references) ) {
         cerr << "bamtools revert ERROR: could not open " << m_settings->OutputFilename
              << " for writing... Aborting." << endl;
@@ -129,17 +328,41 @@ bool RevertTool::RevertToolPrivate::Run(void) {
         return false;
     }
 
-    // plow through file, reverting alignments
-    BamAlignment al;
-    while ( reader.GetNextAlignment(al) ) {
-        RevertAlignment(al);
-        writer.SaveAlignment(al);
+    const RecordReverter reverter(m_settings->IsKeepDuplicateFlag,
+                                  m_settings->IsKeepQualities,
+                                  m_settings->RemovedTags);
+    bool isWriteOk = true;
+
+    // if multiple threads requested, revert batches of records on worker threads
+    if ( m_settings->NumThreads > 1 ) {
+        RevertStages stages(reader, writer, reverter);
+        BatchPipeline<RevertBatch, RevertStages> pipeline(stages, m_settings->NumThreads);
+        pipeline.Run();
+        isWriteOk = stages.IsWriteOk();
     }
+
+    // otherwise plow through file, reverting records one at a time
+    else {
+        string record;
+        while ( isWriteOk && reader.GetNextRawAlignment(record) ) {
+            const size_t recordSize = reverter.Revert(&record[0]);
+            isWriteOk = writer.SaveRawAlignment(record.data(), recordSize);
+        }
+    }
+
+    if ( !isWriteOk )
+        cerr << "bamtools revert ERROR: could not write alignments to " << m_settings->OutputFilename
+             << ": " << writer.GetErrorString() << endl;
+
+    // reading stops at input that can't be read (e.g. a malformed SAM line)
+    const bool isReadOk = reader.GetErrorString().empty();
+    if ( !isReadOk )
+        cerr << "bamtools revert ERROR: could not read input: " << reader.GetErrorString() << endl;
     
     // clean and exit
     reader.Close();
     writer.Close();
-    return true; 
+    return ( isWriteOk && isReadOk ); 
 }
 
 // ---------------------------------------------
@@ -151,17 +374,19 @@ RevertTool::RevertTool(void)
     , m_impl(0)
 {
     // set program details
-    Options::SetProgramInfo("bamtools revert", "removes duplicate marks and restores original (non-recalibrated) base qualities", "[-in <filename> -in <filename> ...] [-out <filename> | [-forceCompression]] [revertOptions]");
+    Options::SetProgramInfo("bamtools revert", "removes duplicate marks and restores original (non-recalibrated) base qualities", "[-in <filename> -in <filename> ...] [-out <filename> | [-forceCompression]] [-threads <count>] [revertOptions]");
     
     // set up options 
     OptionGroup* IO_Opts = Options::CreateOptionGroup("Input & Output");
     Options::AddValueOption("-in",  "BAM filename", "the input BAM file",  "", m_settings->HasInput,  m_settings->InputFilename,  IO_Opts, Options::StandardIn());
     Options::AddValueOption("-out", "BAM filename", "the output BAM file", "", m_settings->HasOutput, m_settings->OutputFilename, IO_Opts, Options::StandardOut());
     Options::AddOption("-forceCompression", "if results are sent to stdout (like when piping to another tool), default behavior is to leave output uncompressed. Use this flag to override and force compression", m_settings->IsForceCompression, IO_Opts);
+    Options::AddValueOption("-threads", "count", "number of threads used to decompress, revert & compress alignments", "", m_settings->HasNumThreads, m_settings->NumThreads, IO_Opts, REVERT_DEFAULT_NUM_THREADS);
 
     OptionGroup* RevertOpts = Options::CreateOptionGroup("Revert Options");
     Options::AddOption("-keepDuplicate", "keep duplicates marked", m_settings->IsKeepDuplicateFlag, RevertOpts);
     Options::AddOption("-keepQualities", "keep base qualities (do not replace with OQ contents)", m_settings->IsKeepQualities, RevertOpts);
+    Options::AddValueOption("-removeTag", "TAG", "also remove this tag from all alignments (e.g. MD, NM); may be given several times", "", m_settings->HasRemovedTags, m_settings->RemovedTags, RevertOpts);
 }
 
 RevertTool::~RevertTool(void) {
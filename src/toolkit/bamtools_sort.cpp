@@ -10,18 +10,19 @@
 #include "bamtools_sort.h"
 
 #include <api/SamConstants.h>
-#include <api/BamMultiReader.h>
+#include <api/BamReader.h>
 #include <api/BamWriter.h>
-#include <api/algorithms/Sort.h>
+#include <api/algorithms/RecordBuffer.h>
 #include <utils/bamtools_options.h>
 using namespace BamTools;
 using namespace BamTools::Algorithms;
 
 #include <cstdio>
-#include <algorithm>
 #include <iostream>
+#include <queue>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 using namespace std;
 
@@ -89,11 +90,12 @@ class SortTool::SortToolPrivate {
         
     // internal methods
     private:
-        bool CreateSortedTempFile(vector<BamAlignment>& buffer);
+        bool CreateSortedTempFile(RecordBuffer& buffer);
         bool GenerateSortedRuns(void);
+        bool IsBufferFull(const RecordBuffer& buffer) const;
         bool MergeSortedRuns(void);
-        bool WriteTempFile(const vector<BamAlignment>& buffer, const string& tempFilename);
-        void SortBuffer(vector<BamAlignment>& buffer);
+        void RemoveTempFiles(void);
+        bool WriteTempFile(const RecordBuffer& buffer, const string& tempFilename);
         
     // data members
     private:
@@ -103,12 +105,43 @@ class SortTool::SortToolPrivate {
         string m_headerText;
         RefVector m_references;
         vector<string> m_tempFilenames;
+        bool m_isOutputWritten;
+};
+
+// orders merge candidates (key, run index) so that smallest record is on top
+// ties on key are broken by full name comparison (name sort only), then by run
+// index - that way merge stays stable
+struct MergeEntryGreater {
+
+    typedef pair<uint64_t, size_t> MergeEntry;
+
+    MergeEntryGreater(const vector<string>* records, const bool isSortingByName)
+        : m_records(records)
+        , m_isSortingByName(isSortingByName)
+    { }
+
+    bool operator()(const MergeEntry& lhs, const MergeEntry& rhs) const {
+        if ( lhs.first != rhs.first )
+            return ( lhs.first > rhs.first );
+        if ( m_isSortingByName ) {
+            const int result = RecordBuffer::CompareNames( (*m_records)[lhs.second].data(),
+                                                           (*m_records)[rhs.second].data() );
+            if ( result != 0 )
+                return ( result > 0 );
+        }
+        return ( lhs.second > rhs.second );
+    }
+
+    private:
+        const vector<string>* m_records;
+        bool m_isSortingByName;
 };
 
 // constructor
 SortTool::SortToolPrivate::SortToolPrivate(SortTool::SortSettings* settings) 
     : m_settings(settings)
     , m_numberOfRuns(0) 
+    , m_isOutputWritten(false)
 { 
     // set filename stub depending on inputfile path
     // that way multiple sort runs don't trip on each other's temp files
@@ -121,6 +154,7 @@ SortTool::SortToolPrivate::SortToolPrivate(SortTool::SortSettings* settings)
 }
 
 // generates mutiple sorted temp BAM files from single unsorted BAM file
+// if all records fit in a single buffer, they are written directly to the output file
 bool SortTool::SortToolPrivate::GenerateSortedRuns(void) {
     
     // open input BAM file
@@ -141,72 +175,54 @@ bool SortTool::SortToolPrivate::GenerateSortedRuns(void) {
     m_headerText = header.ToString();
     m_references = reader.GetReferenceData();
     
-    // set up alignments buffer
-    BamAlignment al;
-    vector<BamAlignment> buffer;
-    buffer.reserve( (size_t)(m_settings->MaxBufferCount*1.1) );
-    bool bufferFull = false;
-
-    // if sorting by name, we need to generate full char data
-    // so can't use GetNextAlignmentCore()
-    if ( m_settings->IsSortingByName ) {
-
-        // iterate through file
-        while ( reader.GetNextAlignment(al)) {
-
-            // check buffer's usage
-            bufferFull = ( buffer.size() >= m_settings->MaxBufferCount );
-
-            // store alignments until buffer is "full"
-            if ( !bufferFull )
-                buffer.push_back(al);
-
-            // if buffer is "full"
-            else {
-                // so create a sorted temp file with current buffer contents
-                // then push "al" into fresh buffer
-                CreateSortedTempFile(buffer);
-                buffer.push_back(al);
-            }
-        }
+    // set up record buffer, keyed on name prefix or (refID, position, strand)
+    // either way, records are kept raw & never decoded
+    RecordBuffer buffer( m_settings->IsSortingByName ? RecordBuffer::ByName
+                                                     : RecordBuffer::ByPosition );
+
+    // iterate through file, storing records until buffer is "full"
+    while ( buffer.Add(reader) ) {
+        if ( IsBufferFull(buffer) )
+            CreateSortedTempFile(buffer);
     }
 
-    // sorting by position, can take advantage of GNACore() speedup
-    else {
+    // reading stops at input that can't be read (e.g. a malformed SAM line)
+    if ( !reader.GetErrorString().empty() ) {
+        cerr << "bamtools sort ERROR: could not read input: " << reader.GetErrorString() << endl;
+        reader.Close();
+        RemoveTempFiles();
+        return false;
+    }
+    reader.Close();
 
-        // iterate through file
-        while ( reader.GetNextAlignmentCore(al) ) {
+    // if no temp files were needed, sort & write straight to output
+    if ( m_tempFilenames.empty() ) {
 
-            // check buffer's usage
-            bufferFull = ( buffer.size() >= m_settings->MaxBufferCount );
+        BamWriter writer;
+        if ( !writer.Open(m_settings->OutputBamFilename, m_headerText, m_references) ) {
+            cerr << "bamtools sort ERROR: could not open " << m_settings->OutputBamFilename
+                 << " for writing... Aborting." << endl;
+            return false;
+        }
 
-            // store alignments until buffer is "full"
-            if ( !bufferFull )
-                buffer.push_back(al);
+        buffer.Sort();
+        const bool success = buffer.Write(writer);
+        writer.Close();
 
-            // if buffer is "full"
-            else {
-                // create a sorted temp file with current buffer contents
-                // then push "al" into fresh buffer
-                CreateSortedTempFile(buffer);
-                buffer.push_back(al);
-            }
-        }
+        m_isOutputWritten = true;
+        return success;
     }
 
-    // handle any leftover buffer contents
-    if ( !buffer.empty() )
+    // otherwise handle any leftover buffer contents
+    if ( !buffer.IsEmpty() )
         CreateSortedTempFile(buffer);
-    
-    // close reader & return success
-    reader.Close();
     return true;
 }
 
-bool SortTool::SortToolPrivate::CreateSortedTempFile(vector<BamAlignment>& buffer) {
+bool SortTool::SortToolPrivate::CreateSortedTempFile(RecordBuffer& buffer) {
  
     // do sorting
-    SortBuffer(buffer);
+    buffer.Sort();
   
     // write sorted contents to temp file, store success/fail
     stringstream tempStr;
@@ -217,7 +233,7 @@ bool SortTool::SortToolPrivate::CreateSortedTempFile(vector<BamAlignment>& buffe
     m_tempFilenames.push_back(tempStr.str());
     
     // clear buffer contents & update run counter
-    buffer.clear();
+    buffer.Clear();
     ++m_numberOfRuns;
     
     // return success/fail of writing to temp file
@@ -225,71 +241,103 @@ bool SortTool::SortToolPrivate::CreateSortedTempFile(vector<BamAlignment>& buffe
     return success;
 }
 
+bool SortTool::SortToolPrivate::IsBufferFull(const RecordBuffer& buffer) const {
+    const size_t maxBufferBytes = static_cast<size_t>(m_settings->MaxBufferMemory) * 1024 * 1024;
+    return ( buffer.Count() >= m_settings->MaxBufferCount ||
+             buffer.MemoryUsage() >= maxBufferBytes );
+}
+
 // merges sorted temp BAM files into single sorted output BAM file
 bool SortTool::SortToolPrivate::MergeSortedRuns(void) {
-  
-    // open up multi reader for all of our temp files
-    // this might get broken up if we do a multi-pass system later ??
-    BamMultiReader multiReader;
-    if ( !multiReader.Open(m_tempFilenames) ) {
-        cerr << "bamtools sort ERROR: could not open BamMultiReader for merging temp files... Aborting."
-             << endl;
-        return false;
-    }
+
+    typedef MergeEntryGreater::MergeEntry MergeEntry;
+    typedef priority_queue<MergeEntry, vector<MergeEntry>, MergeEntryGreater> MergeQueue;
+
+    const bool isSortingByName = m_settings->IsSortingByName;
+    const size_t numRuns = m_tempFilenames.size();
+    vector<BamReader*> readers(numRuns, (BamReader*)0);
+    vector<string> records(numRuns);
+    MergeQueue queue( MergeEntryGreater(&records, isSortingByName) );
+    bool success = true;
 
     // open writer for our completely sorted output BAM file
     BamWriter mergedWriter;
     if ( !mergedWriter.Open(m_settings->OutputBamFilename, m_headerText, m_references) ) {
         cerr << "bamtools sort ERROR: could not open " << m_settings->OutputBamFilename
              << " for writing... Aborting." << endl;
-        multiReader.Close();
         return false;
     }
-    
-    // while data available in temp files
-    BamAlignment al;
-    while ( multiReader.GetNextAlignmentCore(al) )
-        mergedWriter.SaveAlignment(al);
-  
+
+    // open each run & fetch its first record
+    for ( size_t i = 0; i < numRuns; ++i ) {
+        readers[i] = new BamReader;
+        if ( !readers[i]->Open(m_tempFilenames.at(i)) ) {
+            cerr << "bamtools sort ERROR: could not open " << m_tempFilenames.at(i)
+                 << " for merging... Aborting." << endl;
+            success = false;
+            break;
+        }
+        if ( readers[i]->GetNextRawAlignment(records[i]) ) {
+            const char* record = records[i].data();
+            const uint64_t key = ( isSortingByName ? RecordBuffer::NameKey(record)
+                                                   : RecordBuffer::PositionKey(record) );
+            queue.push( make_pair(key, i) );
+        }
+    }
+
+    // write smallest record, then refill from the same run
+    while ( success && !queue.empty() ) {
+        const size_t run = queue.top().second;
+        queue.pop();
+
+        success = mergedWriter.SaveRawAlignment(records[run].data(), records[run].size());
+
+        if ( readers[run]->GetNextRawAlignment(records[run]) ) {
+            const char* record = records[run].data();
+            const uint64_t key = ( isSortingByName ? RecordBuffer::NameKey(record)
+                                                   : RecordBuffer::PositionKey(record) );
+            queue.push( make_pair(key, run) );
+        }
+    }
+
     // close files
-    multiReader.Close();
+    for ( size_t i = 0; i < numRuns; ++i ) {
+        if ( readers[i] ) {
+            readers[i]->Close();
+            delete readers[i];
+        }
+    }
     mergedWriter.Close();
-    
+
     // delete all temp files
+    RemoveTempFiles();
+    return success;
+}
+
+void SortTool::SortToolPrivate::RemoveTempFiles(void) {
     vector<string>::const_iterator tempIter = m_tempFilenames.begin();
     vector<string>::const_iterator tempEnd  = m_tempFilenames.end();
     for ( ; tempIter != tempEnd; ++tempIter ) {
         const string& tempFilename = (*tempIter);
         remove(tempFilename.c_str());
     }
-  
-    // return success
-    return true;
 }
 
 bool SortTool::SortToolPrivate::Run(void) {
  
     // this does a single pass, chunking up the input file into smaller sorted temp files, 
-    // then write out using BamMultiReader to handle merging
+    // then merges the temp files' raw records on their sort keys
     
-    if ( GenerateSortedRuns() )
-        return MergeSortedRuns();
-    else 
+    if ( !GenerateSortedRuns() )
         return false;
+
+    // skip merging if sorted data already went straight to output
+    if ( m_isOutputWritten )
+        return true;
+    return MergeSortedRuns();
 } 
     
-void SortTool::SortToolPrivate::SortBuffer(vector<BamAlignment>& buffer) {
- 
-    // ** add further custom sort options later ?? **
-    
-    // sort buffer by desired method
-    if ( m_settings->IsSortingByName )
-        std::stable_sort( buffer.begin(), buffer.end(), Sort::ByName() );
-    else
-        std::stable_sort( buffer.begin(), buffer.end(), Sort::ByPosition() );
-}
-    
-bool SortTool::SortToolPrivate::WriteTempFile(const vector<BamAlignment>& buffer,
+bool SortTool::SortToolPrivate::WriteTempFile(const RecordBuffer& buffer,
                                               const string& tempFilename)
 {
     // open temp file for writing
@@ -300,17 +348,10 @@ bool SortTool::SortToolPrivate::WriteTempFile(const vector<BamAlignment>& buffer
         return false;
     }
   
-    // write data
-    vector<BamAlignment>::const_iterator buffIter = buffer.begin();
-    vector<BamAlignment>::const_iterator buffEnd  = buffer.end();
-    for ( ; buffIter != buffEnd; ++buffIter )  {
-        const BamAlignment& al = (*buffIter);
-        tempWriter.SaveAlignment(al);
-    }
-  
-    // close temp file & return success
+    // write data, close temp file & return success/fail
+    const bool success = buffer.Write(tempWriter);
     tempWriter.Close();
-    return true;
+    return success;
 }
 
 // ---------------------------------------------
@@ -2,7 +2,7 @@
 // bamtools_split.cpp (c) 2010 Derek Barnett, Erik Garrison
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 8 December 2011 (DB)
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Splits a BAM file on user-specified property, creating a new BAM output
 // file for each value found
@@ -13,15 +13,22 @@
 #include <api/BamConstants.h>
 #include <api/BamReader.h>
 #include <api/BamWriter.h>
+#include <shared/bamtools_raw_record.h>
+#include <shared/bamtools_thread.h>
+#include <shared/bamtools_worker_pool.h>
 #include <utils/bamtools_options.h>
 #include <utils/bamtools_variant.h>
 using namespace BamTools;
 
+#include <algorithm>
+#include <cstring>
 #include <ctime>
 #include <iostream>
+#include <list>
 #include <map>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 using namespace std;
 
@@ -34,6 +41,13 @@ static const string SPLIT_PAIRED_TOKEN    = ".PAIRED_END";
 static const string SPLIT_SINGLE_TOKEN    = ".SINGLE_END";
 static const string SPLIT_REFERENCE_TOKEN = ".REF_";
 
+// writer pool constants
+static const unsigned int SPLIT_DEFAULT_NUM_THREADS    = 1;
+static const unsigned int SPLIT_DEFAULT_MAX_OPEN_FILES = 256;
+static const unsigned int SPLIT_JOBS_PER_THREAD        = 2;
+static const size_t SPLIT_BATCH_SIZE      = 0x100000;  // 1 MB of records buffered per output
+static const size_t SPLIT_MAX_BUFFER_SIZE = 0x10000000; // 256 MB of records buffered overall
+
 string GetTimestampString(void) {
 
     // get human readable timestamp
@@ -58,6 +72,391 @@ string RemoveFilenameExtension(const string& filename) {
     size_t found = filename.rfind(".");
     return filename.substr(0, found);
 }
+
+// ---------------------------------------------
+// raw record access
+
+// retrieves tag value from raw record (converted as BamAlignment::GetTag() would)
+template<typename T>
+bool GetRawTag(const char* record, const string& tag, T& destination) {
+
+    char type(0);
+    const char* value = RawRecord::FindTag(record, tag, type);
+    if ( value == 0 || !TagTypeHelper<T>::CanConvertFrom(type) )
+        return false;
+
+    destination = 0;
+    memcpy(&destination, value, RawRecord::TagValueSize(type));
+    return true;
+}
+
+template<>
+bool GetRawTag<string>(const char* record, const string& tag, string& destination) {
+
+    char type(0);
+    const char* value = RawRecord::FindTag(record, tag, type);
+    if ( value == 0 )
+        return false;
+
+    if ( type == Constants::BAM_TAG_TYPE_ASCII )
+        destination.assign(value, 1);
+    else
+        destination.assign(value);
+    return true;
+}
+
+// ---------------------------------------------
+// SplitWriterPool declaration
+
+// Buffers each output's raw records in memory & writes them out in batches,
+// keeping at most a fixed number of output files open at once. Outputs whose
+// writers get closed to make room are later reopened in append mode. Batches
+// are compressed & written on a pool of worker threads (or inline, for 1 thread),
+// but never more than one batch per output at a time, so record order is kept.
+// (each output has a single job object, reused for all of its batches)
+class SplitWriterPool {
+
+    // ctor & dtor
+    public:
+        SplitWriterPool(const string& header,
+                        const RefVector& references,
+                        const unsigned int numThreads,
+                        const unsigned int maxOpenFiles);
+        ~SplitWriterPool(void);
+
+    // SplitWriterPool interface
+    public:
+        // registers a new output file, returns its index
+        size_t AddOutput(const string& filename);
+        // writes all buffered records, closes all outputs
+        bool Close(void);
+        // returns a description of the last error
+        string GetErrorString(void) const;
+        // buffers a raw record for output
+        bool SaveRecord(const size_t outputIndex, const string& record);
+
+    // internal types
+    private:
+        struct Output {
+            string Filename;
+            string Records;             // buffered raw records
+            BamWriter* Writer;          // open writer (if any, and not lent to a job)
+            bool IsCreated;             // file has been written before (so must be appended to)
+            bool IsBusy;                // a job is writing to (or closing) this output
+            list<size_t>::iterator OpenPosition;
+
+            Output(const string& filename)
+                : Filename(filename)
+                , Writer(0)
+                , IsCreated(false)
+                , IsBusy(false)
+            { }
+        };
+
+        struct Job {
+            size_t OutputIndex;
+            string Filename;
+            string Records;
+            BamWriter* Writer;          // output's writer, 0 if it must be opened
+            bool IsAppending;
+            bool IsEvicting;            // must close another output's writer before opening ours
+            BamWriter* EvictedWriter;
+            size_t EvictedIndex;
+            string ErrorString;
+            bool IsDone;                // (see BamWorkerPool)
+
+            Job(const size_t outputIndex, const string& filename)
+                : OutputIndex(outputIndex)
+                , Filename(filename)
+                , Writer(0)
+                , IsAppending(false)
+                , IsEvicting(false)
+                , EvictedWriter(0)
+                , EvictedIndex(0)
+                , IsDone(true)
+            { }
+        };
+
+    // BamWorkerPool operation
+    public:
+        // writes job's records, then releases its outputs (called on worker threads)
+        void Process(Job& job);
+
+    // internal methods
+    private:
+        // hands output's buffered records to a job
+        bool Flush(const size_t outputIndex);
+        // flushes the biggest buffers, until half of the memory budget is free again
+        bool FlushLargest(void);
+        // releases job's outputs for further writes
+        void FinishJob(Job* job);
+        // opens writer if necessary & writes job's records
+        void RunJob(Job* job);
+        // waits for all jobs to finish
+        void WaitForJobs(void);
+
+    // data members
+    private:
+        string m_header;
+        RefVector m_references;
+        unsigned int m_maxOpenFiles;
+        unsigned int m_maxJobs;
+
+        vector<Output> m_outputs;
+        vector<Job*> m_jobs;            // one per output
+        list<size_t> m_openOutputs;     // outputs with writers, most recently used first
+        size_t m_bufferSize;            // total bytes of records buffered (main thread only)
+
+        bool m_hasFailed;
+        string m_errorString;
+        unsigned int m_numJobs;         // jobs queued or running
+
+        mutable BamMutex m_mutex;
+        BamWaitCondition m_jobDone;
+
+        BamWorkerPool<Job, SplitWriterPool> m_pool; // (last, so it is stopped before outputs go away)
+};
+
+// ---------------------------------------------
+// SplitWriterPool implementation
+
+SplitWriterPool::SplitWriterPool(const string& header,
+                                 const RefVector& references,
+                                 const unsigned int numThreads,
+                                 const unsigned int maxOpenFiles)
+    : m_header(header)
+    , m_references(references)
+    , m_maxOpenFiles(maxOpenFiles)
+    , m_maxJobs(1)
+    , m_bufferSize(0)
+    , m_hasFailed(false)
+    , m_numJobs(0)
+    , m_pool(*this, ( numThreads > 1 ? numThreads : 0 ))
+{
+    // keep workers busy (if any)
+    if ( m_pool.NumWorkers() > 0 )
+        m_maxJobs = numThreads * SPLIT_JOBS_PER_THREAD;
+
+    // every job may need an open file, and still leave one to evict
+    if ( m_maxOpenFiles < m_maxJobs )
+        m_maxOpenFiles = m_maxJobs;
+}
+
+SplitWriterPool::~SplitWriterPool(void) {
+
+    // let any remaining jobs finish, then drop writers (Close() handles normal shutdown)
+    WaitForJobs();
+    for ( size_t i = 0; i < m_outputs.size(); ++i ) {
+        delete m_outputs[i].Writer;
+        m_outputs[i].Writer = 0;
+        delete m_jobs[i];
+        m_jobs[i] = 0;
+    }
+}
+
+size_t SplitWriterPool::AddOutput(const string& filename) {
+    BamMutexLocker locker(m_mutex);
+    m_outputs.push_back( Output(filename) );
+    m_jobs.push_back( new Job(m_outputs.size() - 1, filename) );
+    return m_outputs.size() - 1;
+}
+
+bool SplitWriterPool::Close(void) {
+
+    // write remaining records
+    for ( size_t i = 0; i < m_outputs.size(); ++i ) {
+        if ( !m_outputs[i].Records.empty() && !Flush(i) )
+            break;
+    }
+    WaitForJobs();
+
+    // close open outputs
+    for ( list<size_t>::iterator iter = m_openOutputs.begin(); iter != m_openOutputs.end(); ++iter ) {
+        Output& output = m_outputs[*iter];
+        if ( output.Writer ) {
+            output.Writer->Close();
+            delete output.Writer;
+            output.Writer = 0;
+        }
+    }
+    m_openOutputs.clear();
+
+    BamMutexLocker locker(m_mutex);
+    return !m_hasFailed;
+}
+
+void SplitWriterPool::FinishJob(Job* job) {
+
+    BamMutexLocker locker(m_mutex);
+
+    // return writer to its output
+    Output& output = m_outputs[job->OutputIndex];
+    output.Writer = job->Writer;
+    output.IsBusy = false;
+    if ( job->IsEvicting )
+        m_outputs[job->EvictedIndex].IsBusy = false;
+
+    // store any error
+    if ( !job->ErrorString.empty() && !m_hasFailed ) {
+        m_hasFailed = true;
+        m_errorString = job->ErrorString;
+    }
+
+    --m_numJobs;
+    m_jobDone.WakeAll();
+}
+
+bool SplitWriterPool::Flush(const size_t outputIndex) {
+
+    Job* job = m_jobs[outputIndex];
+
+    {
+        BamMutexLocker locker(m_mutex);
+
+        // wait for previous batch of this output (& for room in job queue)
+        Output& output = m_outputs[outputIndex];
+        while ( !m_hasFailed && (output.IsBusy || m_numJobs >= m_maxJobs) )
+            m_jobDone.Wait(m_mutex);
+        if ( m_hasFailed )
+            return false;
+
+        // reset output's job (its previous batch is done, but pool may still be handing it back)
+        m_pool.Wait(job);
+        job->Writer        = 0;
+        job->IsAppending   = false;
+        job->IsEvicting    = false;
+        job->EvictedWriter = 0;
+        job->EvictedIndex  = 0;
+        job->ErrorString.clear();
+
+        // take over output's records
+        m_bufferSize -= output.Records.size();
+        job->Records.clear();
+        job->Records.swap(output.Records);
+
+        // use output's open writer if it has one
+        if ( output.Writer ) {
+            job->Writer = output.Writer;
+            output.Writer = 0;
+            m_openOutputs.splice(m_openOutputs.begin(), m_openOutputs, output.OpenPosition);
+        }
+
+        // otherwise it will be (re)opened, after closing least recently used writer if necessary
+        else {
+            job->IsAppending = output.IsCreated;
+            output.IsCreated = true;
+
+            if ( m_openOutputs.size() >= m_maxOpenFiles ) {
+                list<size_t>::reverse_iterator iter = m_openOutputs.rbegin();
+                while ( m_outputs[*iter].IsBusy )
+                    ++iter;
+                Output& evicted = m_outputs[*iter];
+                job->IsEvicting    = true;
+                job->EvictedWriter = evicted.Writer;
+                job->EvictedIndex  = *iter;
+                evicted.Writer = 0;
+                evicted.IsBusy = true;
+                m_openOutputs.erase( --iter.base() );
+            }
+
+            m_openOutputs.push_front(outputIndex);
+            output.OpenPosition = m_openOutputs.begin();
+        }
+
+        output.IsBusy = true;
+        ++m_numJobs;
+    }
+
+    // queue job for workers (or run it right here, if there are none)
+    m_pool.Submit(job);
+    BamMutexLocker locker(m_mutex);
+    return !m_hasFailed;
+}
+
+bool SplitWriterPool::FlushLargest(void) {
+
+    // sort outputs by buffer size
+    vector< pair<size_t, size_t> > bufferSizes;
+    for ( size_t i = 0; i < m_outputs.size(); ++i ) {
+        if ( !m_outputs[i].Records.empty() )
+            bufferSizes.push_back( make_pair(m_outputs[i].Records.size(), i) );
+    }
+    sort(bufferSizes.begin(), bufferSizes.end());
+
+    // flush biggest buffers first
+    vector< pair<size_t, size_t> >::reverse_iterator iter = bufferSizes.rbegin();
+    for ( ; iter != bufferSizes.rend() && m_bufferSize > SPLIT_MAX_BUFFER_SIZE/2; ++iter ) {
+        if ( !Flush(iter->second) )
+            return false;
+    }
+    return true;
+}
+
+string SplitWriterPool::GetErrorString(void) const {
+    BamMutexLocker locker(m_mutex);
+    return m_errorString;
+}
+
+void SplitWriterPool::Process(Job& job) {
+    RunJob(&job);
+    FinishJob(&job);
+}
+
+void SplitWriterPool::RunJob(Job* job) {
+
+    // close evicted writer first, so no more than the max number of files are ever open
+    if ( job->EvictedWriter ) {
+        job->EvictedWriter->Close();
+        delete job->EvictedWriter;
+        job->EvictedWriter = 0;
+    }
+
+    // open writer if needed
+    if ( job->Writer == 0 ) {
+        job->Writer = new BamWriter;
+        const bool isOpen = ( job->IsAppending ? job->Writer->OpenForAppend(job->Filename)
+                                               : job->Writer->Open(job->Filename, m_header, m_references) );
+        if ( !isOpen ) {
+            job->ErrorString = "could not open " + job->Filename + " for writing.";
+            delete job->Writer;
+            job->Writer = 0;
+            return;
+        }
+    }
+
+    // write records
+    const char* record = job->Records.data();
+    const char* recordsEnd = record + job->Records.size();
+    while ( record < recordsEnd ) {
+        const size_t recordSize = RawRecord::Size(record);
+        if ( !job->Writer->SaveRawAlignment(record, recordSize) ) {
+            job->ErrorString = "could not write to " + job->Filename + ": " + job->Writer->GetErrorString();
+            return;
+        }
+        record += recordSize;
+    }
+}
+
+bool SplitWriterPool::SaveRecord(const size_t outputIndex, const string& record) {
+
+    // buffer record
+    string& records = m_outputs[outputIndex].Records;
+    records.append(record);
+    m_bufferSize += record.size();
+
+    // hand over a full batch, or make room if too much is buffered overall
+    if ( records.size() >= SPLIT_BATCH_SIZE )
+        return Flush(outputIndex);
+    if ( m_bufferSize > SPLIT_MAX_BUFFER_SIZE )
+        return FlushLargest();
+    return true;
+}
+
+void SplitWriterPool::WaitForJobs(void) {
+    BamMutexLocker locker(m_mutex);
+    while ( m_numJobs > 0 )
+        m_jobDone.Wait(m_mutex);
+}
     
 } // namespace BamTools
 
@@ -70,6 +469,8 @@ struct SplitTool::SplitSettings {
     bool HasInputFilename;
     bool HasCustomOutputStub;
     bool HasCustomRefPrefix;
+    bool HasMaxOpenFiles;
+    bool HasNumThreads;
     bool IsSplittingMapped;
     bool IsSplittingPaired;
     bool IsSplittingReference;
@@ -80,12 +481,18 @@ struct SplitTool::SplitSettings {
     string CustomRefPrefix;
     string InputFilename;
     string TagToSplit;
+
+    // numeric args
+    unsigned int MaxOpenFiles;
+    unsigned int NumThreads;
     
     // constructor
     SplitSettings(void)
         : HasInputFilename(false)
         , HasCustomOutputStub(false)
         , HasCustomRefPrefix(false)
+        , HasMaxOpenFiles(false)
+        , HasNumThreads(false)
         , IsSplittingMapped(false)
         , IsSplittingPaired(false)
         , IsSplittingReference(false)
@@ -94,6 +501,8 @@ struct SplitTool::SplitSettings {
         , CustomRefPrefix("")
         , InputFilename(Options::StandardIn())
         , TagToSplit("")
+        , MaxOpenFiles(SPLIT_DEFAULT_MAX_OPEN_FILES)
+        , NumThreads(SPLIT_DEFAULT_NUM_THREADS)
     { } 
 };  
 
@@ -118,26 +527,23 @@ class SplitTool::SplitToolPrivate {
         
     // internal methods
     private:
-        // close & delete BamWriters in map
-        template<typename T>
-        void CloseWriters(map<T, BamWriter*>& writers);
         // calculate output stub based on IO args given
         void DetermineOutputFilenameStub(void);
         // open our BamReader
         bool OpenReader(void);
         // split alignments in BAM file based on isMapped property
-        bool SplitMapped(void);
+        bool SplitMapped(SplitWriterPool& writers);
         // split alignments in BAM file based on isPaired property
-        bool SplitPaired(void);
+        bool SplitPaired(SplitWriterPool& writers);
         // split alignments in BAM file based on refID property
-        bool SplitReference(void);
+        bool SplitReference(SplitWriterPool& writers);
         // finds first alignment and calls corresponding SplitTagImpl<> 
         // depending on tag type
-        bool SplitTag(void);
+        bool SplitTag(SplitWriterPool& writers);
         // templated split tag implementation 
         // handle the various types that are possible for tags
         template<typename T>
-        bool SplitTagImpl(BamAlignment& al);    
+        bool SplitTagImpl(SplitWriterPool& writers, const string& record);
         
     // data members
     private:
@@ -185,122 +591,130 @@ bool SplitTool::SplitToolPrivate::Run(void) {
     // open up BamReader
     if ( !OpenReader() )
         return false;
+
+    // if we get here, no property was specified 
+    if ( !m_settings->IsSplittingMapped && !m_settings->IsSplittingPaired &&
+         !m_settings->IsSplittingReference && !m_settings->IsSplittingTag )
+    {
+        cerr << "bamtools split ERROR: no property given to split on... " << endl
+             << "Please use -mapped, -paired, -reference, or -tag TAG to specifiy desired split behavior." << endl;
+        return false;
+    }
+
+    // set up output files
+    const unsigned int maxOpenFiles = max(m_settings->MaxOpenFiles, 1u);
+    SplitWriterPool writers(m_header, m_references, m_settings->NumThreads, maxOpenFiles);
     
     // determine split type from settings
-    if ( m_settings->IsSplittingMapped )    return SplitMapped();
-    if ( m_settings->IsSplittingPaired )    return SplitPaired();
-    if ( m_settings->IsSplittingReference ) return SplitReference();
-    if ( m_settings->IsSplittingTag )       return SplitTag();
+    bool isSplit = false;
+    if      ( m_settings->IsSplittingMapped )    isSplit = SplitMapped(writers);
+    else if ( m_settings->IsSplittingPaired )    isSplit = SplitPaired(writers);
+    else if ( m_settings->IsSplittingReference ) isSplit = SplitReference(writers);
+    else                                         isSplit = SplitTag(writers);
+
+    // write out remaining alignments
+    if ( !writers.Close() || !isSplit ) {
+        const string errorString = writers.GetErrorString();
+        if ( !errorString.empty() )
+            cerr << "bamtools split ERROR: " << errorString << endl;
+        return false;
+    }
 
-    // if we get here, no property was specified 
-    cerr << "bamtools split ERROR: no property given to split on... " << endl
-         << "Please use -mapped, -paired, -reference, or -tag TAG to specifiy desired split behavior." << endl;
-    return false;
+    // reading stops at input that can't be read (e.g. a malformed SAM line)
+    if ( !m_reader.GetErrorString().empty() ) {
+        cerr << "bamtools split ERROR: could not read input: " << m_reader.GetErrorString() << endl;
+        return false;
+    }
+    return true;
 }    
 
-bool SplitTool::SplitToolPrivate::SplitMapped(void) {
+bool SplitTool::SplitToolPrivate::SplitMapped(SplitWriterPool& writers) {
     
     // set up splitting data structure
-    map<bool, BamWriter*> outputFiles;
-    map<bool, BamWriter*>::iterator writerIter;
+    map<bool, size_t> outputFiles;
+    map<bool, size_t>::iterator outputIter;
     
     // iterate through alignments
-    BamAlignment al;
-    BamWriter* writer;
+    string record;
+    size_t outputIndex;
     bool isCurrentAlignmentMapped;
-    while ( m_reader.GetNextAlignment(al) ) {
+    while ( m_reader.GetNextRawAlignment(record) ) {
       
         // see if bool value exists
-        isCurrentAlignmentMapped = al.IsMapped();
-        writerIter = outputFiles.find(isCurrentAlignmentMapped);
+        isCurrentAlignmentMapped = ( (RawRecord::AlignmentFlag(record.data()) & Constants::BAM_ALIGNMENT_UNMAPPED) == 0 );
+        outputIter = outputFiles.find(isCurrentAlignmentMapped);
           
-        // if no writer associated with this value
-        if ( writerIter == outputFiles.end() ) {
+        // if no output associated with this value
+        if ( outputIter == outputFiles.end() ) {
         
-            // open new BamWriter
+            // set up new output file
             const string outputFilename = m_outputFilenameStub + ( isCurrentAlignmentMapped
                                                                   ? SPLIT_MAPPED_TOKEN
                                                                   : SPLIT_UNMAPPED_TOKEN ) + ".bam";
-            writer = new BamWriter;
-            if ( !writer->Open(outputFilename, m_header, m_references) ) {
-                cerr << "bamtools split ERROR: could not open " << outputFilename
-                     << " for writing." << endl;
-                return false;
-            }
+            outputIndex = writers.AddOutput(outputFilename);
           
             // store in map
-            outputFiles.insert( make_pair(isCurrentAlignmentMapped, writer) );
+            outputFiles.insert( make_pair(isCurrentAlignmentMapped, outputIndex) );
         } 
         
-        // else grab corresponding writer
-        else writer = (*writerIter).second;
+        // else grab corresponding output
+        else outputIndex = (*outputIter).second;
         
         // store alignment in proper BAM output file 
-        if ( writer )
-            writer->SaveAlignment(al);
+        if ( !writers.SaveRecord(outputIndex, record) )
+            return false;
     }
     
-    // clean up BamWriters 
-    CloseWriters(outputFiles);
-    
     // return success
     return true;
 }
 
-bool SplitTool::SplitToolPrivate::SplitPaired(void) {
+bool SplitTool::SplitToolPrivate::SplitPaired(SplitWriterPool& writers) {
   
     // set up splitting data structure
-    map<bool, BamWriter*> outputFiles;
-    map<bool, BamWriter*>::iterator writerIter;
+    map<bool, size_t> outputFiles;
+    map<bool, size_t>::iterator outputIter;
     
     // iterate through alignments
-    BamAlignment al;
-    BamWriter* writer;
+    string record;
+    size_t outputIndex;
     bool isCurrentAlignmentPaired;
-    while ( m_reader.GetNextAlignment(al) ) {
+    while ( m_reader.GetNextRawAlignment(record) ) {
       
         // see if bool value exists
-        isCurrentAlignmentPaired = al.IsPaired();
-        writerIter = outputFiles.find(isCurrentAlignmentPaired);
+        isCurrentAlignmentPaired = ( (RawRecord::AlignmentFlag(record.data()) & Constants::BAM_ALIGNMENT_PAIRED) != 0 );
+        outputIter = outputFiles.find(isCurrentAlignmentPaired);
           
-        // if no writer associated with this value
-        if ( writerIter == outputFiles.end() ) {
+        // if no output associated with this value
+        if ( outputIter == outputFiles.end() ) {
         
-            // open new BamWriter
+            // set up new output file
             const string outputFilename = m_outputFilenameStub + ( isCurrentAlignmentPaired
                                                                   ? SPLIT_PAIRED_TOKEN
                                                                   : SPLIT_SINGLE_TOKEN ) + ".bam";
-            writer = new BamWriter;
-            if ( !writer->Open(outputFilename, m_header, m_references) ) {
-                cerr << "bamtool split ERROR: could not open " << outputFilename
-                     << " for writing." << endl;
-                return false;
-            }
+            outputIndex = writers.AddOutput(outputFilename);
           
             // store in map
-            outputFiles.insert( make_pair(isCurrentAlignmentPaired, writer) );
+            outputFiles.insert( make_pair(isCurrentAlignmentPaired, outputIndex) );
         } 
         
-        // else grab corresponding writer
-        else writer = (*writerIter).second;
+        // else grab corresponding output
+        else outputIndex = (*outputIter).second;
         
         // store alignment in proper BAM output file 
-        if ( writer ) 
-            writer->SaveAlignment(al);
+        if ( !writers.SaveRecord(outputIndex, record) )
+            return false;
     }
     
-    // clean up BamWriters 
-    CloseWriters(outputFiles);
-    
     // return success
     return true;  
 }
 
-bool SplitTool::SplitToolPrivate::SplitReference(void) {
+bool SplitTool::SplitToolPrivate::SplitReference(SplitWriterPool& writers) {
   
     // set up splitting data structure
-    map<int32_t, BamWriter*> outputFiles;
-    map<int32_t, BamWriter*>::iterator writerIter;
+    map<int32_t, size_t> outputFiles;
+    map<int32_t, size_t>::iterator outputIter;
     
     // determine reference prefix
     string refPrefix = SPLIT_REFERENCE_TOKEN;
@@ -313,17 +727,17 @@ bool SplitTool::SplitToolPrivate::SplitReference(void) {
         refPrefix = string(".") + refPrefix;
 
     // iterate through alignments
-    BamAlignment al;
-    BamWriter* writer;
+    string record;
+    size_t outputIndex;
     int32_t currentRefId;
-    while ( m_reader.GetNextAlignment(al) ) {
+    while ( m_reader.GetNextRawAlignment(record) ) {
       
         // see if bool value exists
-        currentRefId = al.RefID;
-        writerIter = outputFiles.find(currentRefId);
+        currentRefId = RawRecord::RefID(record.data());
+        outputIter = outputFiles.find(currentRefId);
           
-        // if no writer associated with this value
-        if ( writerIter == outputFiles.end() ) {
+        // if no output associated with this value
+        if ( outputIter == outputFiles.end() ) {
         
             // fetch reference name for ID
             string refName;
@@ -334,44 +748,34 @@ bool SplitTool::SplitToolPrivate::SplitReference(void) {
 
             // construct new output filename
             const string outputFilename = m_outputFilenameStub + refPrefix + refName + ".bam";
-
-            // open new BamWriter
-            writer = new BamWriter;
-            if ( !writer->Open(outputFilename, m_header, m_references) ) {
-                cerr << "bamtools split ERROR: could not open " << outputFilename
-                     << " for writing." << endl;
-                return false;
-            }
+            outputIndex = writers.AddOutput(outputFilename);
 
             // store in map
-            outputFiles.insert( make_pair(currentRefId, writer) );
+            outputFiles.insert( make_pair(currentRefId, outputIndex) );
         } 
         
-        // else grab corresponding writer
-        else writer = (*writerIter).second;
+        // else grab corresponding output
+        else outputIndex = (*outputIter).second;
         
         // store alignment in proper BAM output file 
-        if ( writer ) 
-            writer->SaveAlignment(al);
+        if ( !writers.SaveRecord(outputIndex, record) )
+            return false;
     }
     
-    // clean up BamWriters 
-    CloseWriters(outputFiles);
-    
     // return success
     return true;
 }
 
 // finds first alignment and calls corresponding SplitTagImpl<>() depending on tag type
-bool SplitTool::SplitToolPrivate::SplitTag(void) {  
+bool SplitTool::SplitToolPrivate::SplitTag(SplitWriterPool& writers) {  
   
     // iterate through alignments, until we hit TAG
-    BamAlignment al;
-    while ( m_reader.GetNextAlignment(al) ) {
+    string record;
+    while ( m_reader.GetNextRawAlignment(record) ) {
       
         // look for tag in this alignment and get tag type
         char tagType(0);
-        if ( !al.GetTagType(m_settings->TagToSplit, tagType) )
+        if ( RawRecord::FindTag(record.data(), m_settings->TagToSplit, tagType) == 0 )
             continue;
         
         // request split method based on tag type
@@ -381,20 +785,20 @@ bool SplitTool::SplitToolPrivate::SplitTag(void) {
             case (Constants::BAM_TAG_TYPE_INT8)  :
             case (Constants::BAM_TAG_TYPE_INT16) :
             case (Constants::BAM_TAG_TYPE_INT32) :
-                return SplitTagImpl<int32_t>(al);
+                return SplitTagImpl<int32_t>(writers, record);
                 
             case (Constants::BAM_TAG_TYPE_UINT8)  :
             case (Constants::BAM_TAG_TYPE_UINT16) :
             case (Constants::BAM_TAG_TYPE_UINT32) :
-                return SplitTagImpl<uint32_t>(al);
+                return SplitTagImpl<uint32_t>(writers, record);
               
             case (Constants::BAM_TAG_TYPE_FLOAT)  :
-                return SplitTagImpl<float>(al);
+                return SplitTagImpl<float>(writers, record);
             
             case (Constants::BAM_TAG_TYPE_ASCII)  :
             case (Constants::BAM_TAG_TYPE_STRING) :
             case (Constants::BAM_TAG_TYPE_HEX)    :
-                return SplitTagImpl<string>(al);
+                return SplitTagImpl<string>(writers, record);
 
             case (Constants::BAM_TAG_TYPE_ARRAY) :
                 cerr << "bamtools split ERROR: array tag types are not supported" << endl;
@@ -416,108 +820,56 @@ bool SplitTool::SplitToolPrivate::SplitTag(void) {
 //                    goes against normal practices, but works here because these
 //                    are purely internal (no one can call from outside this file)
 
-// close BamWriters & delete pointers
-template<typename T>
-void SplitTool::SplitToolPrivate::CloseWriters(map<T, BamWriter*>& writers) {
-  
-    typedef map<T, BamWriter*> WriterMap;
-    typedef typename WriterMap::iterator WriterMapIterator;
-  
-    // iterate over writers
-    WriterMapIterator writerIter = writers.begin();
-    WriterMapIterator writerEnd  = writers.end();
-    for ( ; writerIter != writerEnd; ++writerIter ) {
-        BamWriter* writer = (*writerIter).second;
-        if ( writer == 0 ) continue;
-
-        // close BamWriter
-        writer->Close();
-
-        // destroy BamWriter
-        delete writer;
-        writer = 0;
-    }
-
-    // clear the container (destroying the items doesn't remove them)
-    writers.clear();
-}
-
 // handle the various types that are possible for tags
 template<typename T>
-bool SplitTool::SplitToolPrivate::SplitTagImpl(BamAlignment& al) {
+bool SplitTool::SplitToolPrivate::SplitTagImpl(SplitWriterPool& writers, const string& firstRecord) {
   
     typedef T TagValueType;
-    typedef map<TagValueType, BamWriter*> WriterMap;
-    typedef typename WriterMap::iterator WriterMapIterator;
+    typedef map<TagValueType, size_t> OutputMap;
+    typedef typename OutputMap::iterator OutputMapIterator;
   
     // set up splitting data structure
-    WriterMap outputFiles;
-    WriterMapIterator writerIter;
+    OutputMap outputFiles;
+    OutputMapIterator outputIter;
 
     // local variables
     const string tag = m_settings->TagToSplit;
-    BamWriter* writer;
+    size_t outputIndex;
     stringstream outputFilenameStream("");
     TagValueType currentValue;
     
-    // retrieve first alignment tag value
-    if ( al.GetTag(tag, currentValue) ) {
-      
-        // open new BamWriter, save first alignment
-        outputFilenameStream << m_outputFilenameStub << ".TAG_" << tag << "_" << currentValue << ".bam";
-        writer = new BamWriter;
-        if ( !writer->Open(outputFilenameStream.str(), m_header, m_references) ) {
-            cerr << "bamtools split ERROR: could not open " << outputFilenameStream.str()
-                 << " for writing." << endl;
-            return false;
-        }
-        writer->SaveAlignment(al);
-        
-        // store in map
-        outputFiles.insert( make_pair(currentValue, writer) );
-        
-        // reset stream
-        outputFilenameStream.str("");
-    }
-    
-    // iterate through remaining alignments
-    while ( m_reader.GetNextAlignment(al) ) {
+    // iterate through alignments, starting with the first one that has TAG
+    string record = firstRecord;
+    do {
       
         // skip if this alignment doesn't have TAG 
-        if ( !al.GetTag(tag, currentValue) ) continue;
+        if ( !GetRawTag(record.data(), tag, currentValue) ) continue;
         
         // look up tag value in map
-        writerIter = outputFiles.find(currentValue);
+        outputIter = outputFiles.find(currentValue);
           
-        // if no writer associated with this value
-        if ( writerIter == outputFiles.end() ) {
+        // if no output associated with this value
+        if ( outputIter == outputFiles.end() ) {
         
-            // open new BamWriter
+            // set up new output file
             outputFilenameStream << m_outputFilenameStub << ".TAG_" << tag << "_" << currentValue << ".bam";
-            writer = new BamWriter;
-            if ( !writer->Open(outputFilenameStream.str(), m_header, m_references) ) {
-                cerr << "bamtool split ERROR: could not open " << outputFilenameStream.str()
-                     << " for writing." << endl;
-                return false;
-            }
+            outputIndex = writers.AddOutput(outputFilenameStream.str());
 
             // store in map
-            outputFiles.insert( make_pair(currentValue, writer) );
+            outputFiles.insert( make_pair(currentValue, outputIndex) );
             
             // reset stream
             outputFilenameStream.str("");
         } 
         
-        // else grab corresponding writer
-        else writer = (*writerIter).second;
+        // else grab corresponding output
+        else outputIndex = (*outputIter).second;
         
         // store alignment in proper BAM output file 
-        if ( writer ) 
-            writer->SaveAlignment(al);
-    }
-    
-    // clean up BamWriters  
-    CloseWriters(outputFiles);
+        if ( !writers.SaveRecord(outputIndex, record) )
+            return false;
+
+    } while ( m_reader.GetNextRawAlignment(record) );
     
     // return success
     return true;  
@@ -534,7 +886,7 @@ SplitTool::SplitTool(void)
     // set program details
     const string name = "bamtools split";
     const string description = "splits a BAM file on user-specified property, creating a new BAM output file for each value found";
-    const string args = "[-in <filename>] [-stub <filename stub>] < -mapped | -paired | -reference [-refPrefix <prefix>] | -tag <TAG> > ";
+    const string args = "[-in <filename>] [-stub <filename stub>] [-threads <count>] [-maxOpen <count>] < -mapped | -paired | -reference [-refPrefix <prefix>] | -tag <TAG> > ";
     Options::SetProgramInfo(name, description, args);
     
     // set up options 
@@ -544,6 +896,10 @@ SplitTool::SplitTool(void)
                             m_settings->HasCustomRefPrefix, m_settings->CustomRefPrefix, IO_Opts);
     Options::AddValueOption("-stub", "filename stub", "prefix stub for output BAM files (default behavior is to use input filename, without .bam extension, as stub). If input is stdin and no stub provided, a timestamp is generated as the stub.", "",
                             m_settings->HasCustomOutputStub, m_settings->CustomOutputStub, IO_Opts);
+    Options::AddValueOption("-threads", "count", "number of threads used to compress output files", "",
+                            m_settings->HasNumThreads, m_settings->NumThreads, IO_Opts, SPLIT_DEFAULT_NUM_THREADS);
+    Options::AddValueOption("-maxOpen", "count", "maximum number of output files kept open at once. Outputs closed to stay below this limit are appended to when more of their alignments arrive.", "",
+                            m_settings->HasMaxOpenFiles, m_settings->MaxOpenFiles, IO_Opts, SPLIT_DEFAULT_MAX_OPEN_FILES);
     
     OptionGroup* SplitOpts = Options::CreateOptionGroup("Split Options");
     Options::AddOption("-mapped",    "split mapped/unmapped alignments",       m_settings->IsSplittingMapped,    SplitOpts);
@@ -2,7 +2,7 @@
 // bamtools_cpp (c) 2010 Derek Barnett, Erik Garrison
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 10 December 2012
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Prints general alignment statistics for BAM file(s).
 // ***************************************************************************
@@ -10,19 +10,284 @@
 #include "bamtools_stats.h"
 
 #include <api/BamMultiReader.h>
+#include <utils/bamtools_batch_pipeline.h>
 #include <utils/bamtools_options.h>
 using namespace BamTools;
 
 #include <cmath>
+#include <cstdlib>
 #include <algorithm>
 #include <fstream>
 #include <functional>
 #include <iostream>
-#include <numeric>
+#include <map>
 #include <string>
 #include <vector>
 using namespace std;
 
+namespace BamTools {
+
+// multi-threaded stats
+const unsigned int STATS_DEFAULT_NUM_THREADS = 1;
+
+// insert sizes below this are counted in a dense histogram, larger ones individually
+const int STATS_INSERT_SIZE_BINS = 65536;
+
+// insert size percentiles reported (besides median)
+const int STATS_INSERT_SIZE_PERCENTILES[] = { 5, 25, 75, 95 };
+const size_t STATS_NUM_INSERT_SIZE_PERCENTILES = 4;
+
+// ---------------------------------------------
+// StatsCounters implementation
+
+// accumulated alignment statistics
+// (with multiple threads, each worker fills its own block & these are merged at the end)
+struct StatsCounters {
+
+    // alignment counts
+    uint64_t NumReads;
+    uint64_t NumPaired;
+    uint64_t NumProperPair;
+    uint64_t NumMapped;
+    uint64_t NumBothMatesMapped;
+    uint64_t NumForwardStrand;
+    uint64_t NumReverseStrand;
+    uint64_t NumFirstMate;
+    uint64_t NumSecondMate;
+    uint64_t NumSingletons;
+    uint64_t NumFailedQC;
+    uint64_t NumDuplicates;
+
+    // insert sizes (absolute value) of first mates
+    uint64_t NumInsertSizes;
+    uint64_t InsertSizeTotal;
+    vector<uint64_t> InsertSizeBins;        // count per insert size < STATS_INSERT_SIZE_BINS
+    map<int, uint64_t> LargeInsertSizes;    // count per larger insert size
+
+    // distributions
+    vector<uint64_t> MapQualities;          // count per MAPQ, of mapped reads
+    vector<uint64_t> ReadLengths;           // count per read length (grown as needed)
+    vector<uint64_t> MappedPerReference;    // count of mapped reads, per reference
+    vector<uint64_t> UnmappedPerReference;  // count of unmapped reads placed on reference
+    uint64_t NumUnplaced;                   // count of reads without reference
+
+    // ctor
+    StatsCounters(const size_t numReferences, const bool isCountingInsertSizes)
+        : NumReads(0)
+        , NumPaired(0)
+        , NumProperPair(0)
+        , NumMapped(0)
+        , NumBothMatesMapped(0)
+        , NumForwardStrand(0)
+        , NumReverseStrand(0)
+        , NumFirstMate(0)
+        , NumSecondMate(0)
+        , NumSingletons(0)
+        , NumFailedQC(0)
+        , NumDuplicates(0)
+        , NumInsertSizes(0)
+        , InsertSizeTotal(0)
+        , InsertSizeBins( isCountingInsertSizes ? STATS_INSERT_SIZE_BINS : 0, 0 )
+        , MapQualities(256, 0)
+        , MappedPerReference(numReferences, 0)
+        , UnmappedPerReference(numReferences, 0)
+        , NumUnplaced(0)
+    { }
+
+    // use alignment to update stats
+    void Add(const BamAlignment& al) {
+
+        // increment total alignment counter
+        ++NumReads;
+
+        // incrememt counters for pairing-independent flags
+        if ( al.IsDuplicate() ) ++NumDuplicates;
+        if ( al.IsFailedQC()  ) ++NumFailedQC;
+        if ( al.IsMapped()    ) ++NumMapped;
+
+        // increment strand counters
+        if ( al.IsReverseStrand() )
+            ++NumReverseStrand;
+        else
+            ++NumForwardStrand;
+
+        // update distributions
+        if ( al.IsMapped() )
+            ++MapQualities[al.MapQuality];
+        const size_t readLength = static_cast<size_t>( al.Length < 0 ? 0 : al.Length );
+        if ( readLength >= ReadLengths.size() )
+            ReadLengths.resize(readLength + 1, 0);
+        ++ReadLengths[readLength];
+        if ( al.RefID >= 0 && al.RefID < static_cast<int>(MappedPerReference.size()) ) {
+            if ( al.IsMapped() )
+                ++MappedPerReference[al.RefID];
+            else
+                ++UnmappedPerReference[al.RefID];
+        } else
+            ++NumUnplaced;
+
+        // if alignment is paired-end
+        if ( al.IsPaired() ) {
+
+            // increment PE counter
+            ++NumPaired;
+
+            // increment first mate/second mate counters
+            if ( al.IsFirstMate()  ) ++NumFirstMate;
+            if ( al.IsSecondMate() ) ++NumSecondMate;
+
+            // if alignment is mapped, check mate status
+            if ( al.IsMapped() ) {
+                // if mate mapped
+                if ( al.IsMateMapped() )
+                    ++NumBothMatesMapped;
+                // else singleton
+                else
+                    ++NumSingletons;
+            }
+
+            // check for explicit proper pair flag
+            if ( al.IsProperPair() )
+                ++NumProperPair;
+
+            // store insert size for first mate
+            if ( !InsertSizeBins.empty() && al.IsFirstMate() && (al.InsertSize != 0) ) {
+                const int insertSize = abs(al.InsertSize);
+                if ( insertSize < STATS_INSERT_SIZE_BINS )
+                    ++InsertSizeBins[insertSize];
+                else
+                    ++LargeInsertSizes[insertSize];
+                ++NumInsertSizes;
+                InsertSizeTotal += insertSize;
+            }
+        }
+    }
+
+    // adds other block's stats to these
+    void Merge(const StatsCounters& other) {
+
+        NumReads           += other.NumReads;
+        NumPaired          += other.NumPaired;
+        NumProperPair      += other.NumProperPair;
+        NumMapped          += other.NumMapped;
+        NumBothMatesMapped += other.NumBothMatesMapped;
+        NumForwardStrand   += other.NumForwardStrand;
+        NumReverseStrand   += other.NumReverseStrand;
+        NumFirstMate       += other.NumFirstMate;
+        NumSecondMate      += other.NumSecondMate;
+        NumSingletons      += other.NumSingletons;
+        NumFailedQC        += other.NumFailedQC;
+        NumDuplicates      += other.NumDuplicates;
+
+        NumInsertSizes  += other.NumInsertSizes;
+        InsertSizeTotal += other.InsertSizeTotal;
+        for ( size_t i = 0; i < InsertSizeBins.size(); ++i )
+            InsertSizeBins[i] += other.InsertSizeBins[i];
+        map<int, uint64_t>::const_iterator largeIter = other.LargeInsertSizes.begin();
+        map<int, uint64_t>::const_iterator largeEnd  = other.LargeInsertSizes.end();
+        for ( ; largeIter != largeEnd; ++largeIter )
+            LargeInsertSizes[largeIter->first] += largeIter->second;
+
+        for ( size_t i = 0; i < MapQualities.size(); ++i )
+            MapQualities[i] += other.MapQualities[i];
+        if ( ReadLengths.size() < other.ReadLengths.size() )
+            ReadLengths.resize(other.ReadLengths.size(), 0);
+        for ( size_t i = 0; i < other.ReadLengths.size(); ++i )
+            ReadLengths[i] += other.ReadLengths[i];
+        for ( size_t i = 0; i < MappedPerReference.size(); ++i ) {
+            MappedPerReference[i]   += other.MappedPerReference[i];
+            UnmappedPerReference[i] += other.UnmappedPerReference[i];
+        }
+        NumUnplaced += other.NumUnplaced;
+    }
+
+    // returns the insert size at (1-based) @rank, in sorted order
+    int InsertSizeAtRank(uint64_t rank) const {
+        for ( size_t i = 0; i < InsertSizeBins.size(); ++i ) {
+            if ( rank <= InsertSizeBins[i] )
+                return static_cast<int>(i);
+            rank -= InsertSizeBins[i];
+        }
+        map<int, uint64_t>::const_iterator largeIter = LargeInsertSizes.begin();
+        map<int, uint64_t>::const_iterator largeEnd  = LargeInsertSizes.end();
+        for ( ; largeIter != largeEnd; ++largeIter ) {
+            if ( rank <= largeIter->second )
+                return largeIter->first;
+            rank -= largeIter->second;
+        }
+        return 0;
+    }
+};
+
+// batch of alignments, passed through the multi-threaded stats pipeline
+typedef AlignmentBatch StatsBatch;
+
+// BatchPipeline stages for stats with multiple threads:
+//   reader thread  : reads alignment core data
+//   worker threads : add alignments to a counter block of their own (taken from a pool)
+//   calling thread : nothing to do, blocks are merged once all input is processed
+class StatsStages {
+
+    public:
+        StatsStages(BamMultiReader& reader, const size_t numReferences, const bool isCountingInsertSizes)
+            : m_reader(reader)
+            , m_numReferences(numReferences)
+            , m_isCountingInsertSizes(isCountingInsertSizes)
+        { }
+
+        ~StatsStages(void) {
+            for ( size_t i = 0; i < m_counters.size(); ++i )
+                delete m_counters[i];
+        }
+
+        bool ReadBatch(StatsBatch& batch) {
+            return ReadAlignmentBatch(m_reader, batch);
+        }
+
+        void ProcessBatch(StatsBatch& batch) {
+
+            // take a free counter block (no more are created than workers run at once)
+            m_mutex.Lock();
+            StatsCounters* counters = 0;
+            if ( m_freeCounters.empty() ) {
+                counters = new StatsCounters(m_numReferences, m_isCountingInsertSizes);
+                m_counters.push_back(counters);
+            } else {
+                counters = m_freeCounters.back();
+                m_freeCounters.pop_back();
+            }
+            m_mutex.Unlock();
+
+            for ( size_t i = 0; i < batch.Count; ++i )
+                counters->Add(batch.Alignments[i]);
+
+            m_mutex.Lock();
+            m_freeCounters.push_back(counters);
+            m_mutex.Unlock();
+        }
+
+        void WriteBatch(StatsBatch& batch) {
+            (void)batch;
+        }
+
+        // adds all counter blocks' stats to @total
+        void MergeInto(StatsCounters& total) const {
+            for ( size_t i = 0; i < m_counters.size(); ++i )
+                total.Merge(*m_counters[i]);
+        }
+
+    private:
+        BamMultiReader& m_reader;
+        size_t m_numReferences;
+        bool m_isCountingInsertSizes;
+
+        vector<StatsCounters*> m_counters;
+        vector<StatsCounters*> m_freeCounters;
+        BamMutex m_mutex;
+};
+
+} // namespace BamTools
+
 // ---------------------------------------------
 // StatsSettings implementation
 
@@ -31,17 +296,29 @@ struct StatsTool::StatsSettings {
     // flags
     bool HasInput;
     bool HasInputFilelist;
+    bool HasNumThreads;
     bool IsShowingInsertSizeSummary;
+    bool IsShowingMapQualities;
+    bool IsShowingReadLengths;
+    bool IsShowingReferences;
 
     // filenames
     vector<string> InputFiles;
     string InputFilelist;
+
+    // other parameters
+    unsigned int NumThreads;
     
     // constructor
     StatsSettings(void)
         : HasInput(false)
         , HasInputFilelist(false)
+        , HasNumThreads(false)
         , IsShowingInsertSizeSummary(false)
+        , IsShowingMapQualities(false)
+        , IsShowingReadLengths(false)
+        , IsShowingReferences(false)
+        , NumThreads(STATS_DEFAULT_NUM_THREADS)
     { }
 };  
 
@@ -61,161 +338,125 @@ struct StatsTool::StatsToolPrivate {
         
     // internal methods
     private:
-        bool CalculateMedian(vector<int>& data, double& median); 
-        void PrintStats(void);
-        void ProcessAlignment(const BamAlignment& al);
+        bool CalculateMedian(const StatsCounters& counters, double& median);
+        void PrintStats(const StatsCounters& counters, const RefVector& references);
         
     // data members
     private:
         StatsTool::StatsSettings* m_settings;
-        unsigned int m_numReads;
-        unsigned int m_numPaired;
-        unsigned int m_numProperPair;
-        unsigned int m_numMapped;
-        unsigned int m_numBothMatesMapped;
-        unsigned int m_numForwardStrand;
-        unsigned int m_numReverseStrand;
-        unsigned int m_numFirstMate;
-        unsigned int m_numSecondMate;
-        unsigned int m_numSingletons;
-        unsigned int m_numFailedQC;
-        unsigned int m_numDuplicates;
-        vector<int> m_insertSizes;
 };
 
 StatsTool::StatsToolPrivate::StatsToolPrivate(StatsTool::StatsSettings* settings)
     : m_settings(settings)
-    , m_numReads(0)
-    , m_numPaired(0)
-    , m_numProperPair(0)
-    , m_numMapped(0)
-    , m_numBothMatesMapped(0)
-    , m_numForwardStrand(0)
-    , m_numReverseStrand(0)
-    , m_numFirstMate(0)
-    , m_numSecondMate(0)
-    , m_numSingletons(0)
-    , m_numFailedQC(0)
-    , m_numDuplicates(0)
-{ 
-    m_insertSizes.reserve(100000);
-}
+{ }
 
 // median is of type double because in the case of even number of data elements,
 // we need to return the average of middle 2 elements
-bool StatsTool::StatsToolPrivate::CalculateMedian(vector<int>& data, double& median) { 
+bool StatsTool::StatsToolPrivate::CalculateMedian(const StatsCounters& counters, double& median) {
   
     // skip if data empty
-    if ( data.empty() )
+    const uint64_t numValues = counters.NumInsertSizes;
+    if ( numValues == 0 )
         return false;
 
     // find middle element
-    size_t middleIndex = data.size() / 2;
-    vector<int>::iterator target = data.begin() + middleIndex;
-    nth_element(data.begin(), target, data.end());
-    
+    const double rightTarget = (double)counters.InsertSizeAtRank(numValues/2 + 1);
+
     // odd number of elements
-    if ( (data.size() % 2) != 0) {
-        median = (double)(*target);
+    if ( (numValues % 2) != 0) {
+        median = rightTarget;
         return true;
     }
     
     // even number of elements
     else {
-        double rightTarget = (double)(*target);
-        vector<int>::iterator leftTarget = target - 1;
-        nth_element(data.begin(), leftTarget, data.end());
-        median = (double)((rightTarget+*leftTarget)/2.0);
+        const double leftTarget = (double)counters.InsertSizeAtRank(numValues/2);
+        median = (double)((rightTarget+leftTarget)/2.0);
         return true;
     }
 }
 
 // print BAM file alignment stats
-void StatsTool::StatsToolPrivate::PrintStats(void) {
+void StatsTool::StatsToolPrivate::PrintStats(const StatsCounters& counters, const RefVector& references) {
   
+    const uint64_t numReads  = counters.NumReads;
+    const uint64_t numPaired = counters.NumPaired;
+
     cout << endl;
     cout << "**********************************************" << endl;
     cout << "Stats for BAM file(s): " << endl;
     cout << "**********************************************" << endl;
     cout << endl;
-    cout << "Total reads:       " << m_numReads << endl;
-    cout << "Mapped reads:      " << m_numMapped << "\t(" << ((float)m_numMapped/m_numReads)*100 << "%)" << endl;
-    cout << "Forward strand:    " << m_numForwardStrand << "\t(" << ((float)m_numForwardStrand/m_numReads)*100 << "%)" << endl;
-    cout << "Reverse strand:    " << m_numReverseStrand << "\t(" << ((float)m_numReverseStrand/m_numReads)*100 << "%)" << endl;
-    cout << "Failed QC:         " << m_numFailedQC << "\t(" << ((float)m_numFailedQC/m_numReads)*100 << "%)" << endl;
-    cout << "Duplicates:        " << m_numDuplicates << "\t(" << ((float)m_numDuplicates/m_numReads)*100 << "%)" << endl;
-    cout << "Paired-end reads:  " << m_numPaired << "\t(" << ((float)m_numPaired/m_numReads)*100 << "%)" << endl;
+    cout << "Total reads:       " << numReads << endl;
+    cout << "Mapped reads:      " << counters.NumMapped << "\t(" << ((float)counters.NumMapped/numReads)*100 << "%)" << endl;
+    cout << "Forward strand:    " << counters.NumForwardStrand << "\t(" << ((float)counters.NumForwardStrand/numReads)*100 << "%)" << endl;
+    cout << "Reverse strand:    " << counters.NumReverseStrand << "\t(" << ((float)counters.NumReverseStrand/numReads)*100 << "%)" << endl;
+    cout << "Failed QC:         " << counters.NumFailedQC << "\t(" << ((float)counters.NumFailedQC/numReads)*100 << "%)" << endl;
+    cout << "Duplicates:        " << counters.NumDuplicates << "\t(" << ((float)counters.NumDuplicates/numReads)*100 << "%)" << endl;
+    cout << "Paired-end reads:  " << numPaired << "\t(" << ((float)numPaired/numReads)*100 << "%)" << endl;
     
-    if ( m_numPaired != 0 ) {
-        cout << "'Proper-pairs':    " << m_numProperPair << "\t(" << ((float)m_numProperPair/m_numPaired)*100 << "%)" << endl;
-        cout << "Both pairs mapped: " << m_numBothMatesMapped << "\t(" << ((float)m_numBothMatesMapped/m_numPaired)*100 << "%)" << endl;
-        cout << "Read 1:            " << m_numFirstMate << endl;
-        cout << "Read 2:            " << m_numSecondMate << endl;
-        cout << "Singletons:        " << m_numSingletons << "\t(" << ((float)m_numSingletons/m_numPaired)*100 << "%)" << endl;
+    if ( numPaired != 0 ) {
+        cout << "'Proper-pairs':    " << counters.NumProperPair << "\t(" << ((float)counters.NumProperPair/numPaired)*100 << "%)" << endl;
+        cout << "Both pairs mapped: " << counters.NumBothMatesMapped << "\t(" << ((float)counters.NumBothMatesMapped/numPaired)*100 << "%)" << endl;
+        cout << "Read 1:            " << counters.NumFirstMate << endl;
+        cout << "Read 2:            " << counters.NumSecondMate << endl;
+        cout << "Singletons:        " << counters.NumSingletons << "\t(" << ((float)counters.NumSingletons/numPaired)*100 << "%)" << endl;
     }
     
     if ( m_settings->IsShowingInsertSizeSummary ) {
       
         double avgInsertSize = 0.0;
-        if ( !m_insertSizes.empty() ) {
-            avgInsertSize = ( accumulate(m_insertSizes.begin(), m_insertSizes.end(), 0.0) / (double)m_insertSizes.size() );
+        if ( counters.NumInsertSizes != 0 ) {
+            avgInsertSize = ( (double)counters.InsertSizeTotal / (double)counters.NumInsertSizes );
             cout << "Average insert size (absolute value): " << avgInsertSize << endl;
         }
         
         double medianInsertSize = 0.0;
-        if ( CalculateMedian(m_insertSizes, medianInsertSize) )
+        if ( CalculateMedian(counters, medianInsertSize) ) {
             cout << "Median insert size (absolute value): " << medianInsertSize << endl;
+
+            // nearest-rank percentiles
+            cout << "Insert size percentiles (absolute value):";
+            for ( size_t i = 0; i < STATS_NUM_INSERT_SIZE_PERCENTILES; ++i ) {
+                const int percentile = STATS_INSERT_SIZE_PERCENTILES[i];
+                const uint64_t rank = ( counters.NumInsertSizes * percentile + 99 ) / 100;
+                cout << "  " << percentile << "%: " << counters.InsertSizeAtRank( max(rank, (uint64_t)1) );
+            }
+            cout << endl;
+        }
     }
-    cout << endl;
-}
 
-// use current input alignment to update BAM file alignment stats
-void StatsTool::StatsToolPrivate::ProcessAlignment(const BamAlignment& al) {
-  
-    // increment total alignment counter
-    ++m_numReads;
-    
-    // incrememt counters for pairing-independent flags
-    if ( al.IsDuplicate() ) ++m_numDuplicates;
-    if ( al.IsFailedQC()  ) ++m_numFailedQC;
-    if ( al.IsMapped()    ) ++m_numMapped;
-    
-    // increment strand counters
-    if ( al.IsReverseStrand() ) 
-        ++m_numReverseStrand;
-    else 
-        ++m_numForwardStrand;
-    
-    // if alignment is paired-end
-    if ( al.IsPaired() ) {
-      
-        // increment PE counter
-        ++m_numPaired;
-      
-        // increment first mate/second mate counters
-        if ( al.IsFirstMate()  ) ++m_numFirstMate;
-        if ( al.IsSecondMate() ) ++m_numSecondMate;
-        
-        // if alignment is mapped, check mate status
-        if ( al.IsMapped() ) {
-            // if mate mapped
-            if ( al.IsMateMapped() ) 
-                ++m_numBothMatesMapped;
-            // else singleton
-            else 
-                ++m_numSingletons;
+    if ( m_settings->IsShowingMapQualities ) {
+        cout << endl;
+        cout << "Mapping quality distribution (mapped reads):" << endl;
+        for ( size_t i = 0; i < counters.MapQualities.size(); ++i ) {
+            const uint64_t count = counters.MapQualities[i];
+            if ( count != 0 )
+                cout << "  MAPQ " << i << ":\t" << count << "\t(" << ((float)count/counters.NumMapped)*100 << "%)" << endl;
         }
-        
-        // check for explicit proper pair flag
-        if ( al.IsProperPair() )
-            ++m_numProperPair;
-        
-        // store insert size for first mate 
-        if ( m_settings->IsShowingInsertSizeSummary && al.IsFirstMate() && (al.InsertSize != 0) ) {
-            int insertSize = abs(al.InsertSize);
-            m_insertSizes.push_back( insertSize );
+    }
+
+    if ( m_settings->IsShowingReadLengths ) {
+        cout << endl;
+        cout << "Read length distribution:" << endl;
+        for ( size_t i = 0; i < counters.ReadLengths.size(); ++i ) {
+            const uint64_t count = counters.ReadLengths[i];
+            if ( count != 0 )
+                cout << "  " << i << " bp:\t" << count << "\t(" << ((float)count/numReads)*100 << "%)" << endl;
+        }
+    }
+
+    if ( m_settings->IsShowingReferences ) {
+        cout << endl;
+        cout << "Reads per reference (name, length, mapped, unmapped):" << endl;
+        for ( size_t i = 0; i < counters.MappedPerReference.size(); ++i ) {
+            cout << "  " << references[i].RefName << "\t" << references[i].RefLength
+                 << "\t" << counters.MappedPerReference[i]
+                 << "\t" << counters.UnmappedPerReference[i] << endl;
         }
+        cout << "  *\t0\t0\t" << counters.NumUnplaced << endl;
     }
+    cout << endl;
 }
 
 bool StatsTool::StatsToolPrivate::Run() {
@@ -245,15 +486,27 @@ bool StatsTool::StatsToolPrivate::Run() {
         reader.Close();
         return false;
     }
-    
-    // plow through alignments, keeping track of stats
-    BamAlignment al;
-    while ( reader.GetNextAlignmentCore(al) )
-        ProcessAlignment(al);
+    const RefVector references = reader.GetReferenceData();
+    StatsCounters counters(references.size(), m_settings->IsShowingInsertSizeSummary);
+
+    // if multiple threads requested, accumulate stats in batches on worker threads
+    if ( m_settings->NumThreads > 1 ) {
+        StatsStages stages(reader, references.size(), m_settings->IsShowingInsertSizeSummary);
+        BatchPipeline<StatsBatch, StatsStages> pipeline(stages, m_settings->NumThreads);
+        pipeline.Run();
+        stages.MergeInto(counters);
+    }
+
+    // otherwise plow through alignments, keeping track of stats
+    else {
+        BamAlignment al;
+        while ( reader.GetNextAlignmentCore(al) )
+            counters.Add(al);
+    }
     reader.Close();
     
     // print stats & exit
-    PrintStats();
+    PrintStats(counters, references);
     return true; 
 }
 
@@ -266,15 +519,19 @@ StatsTool::StatsTool(void)
     , m_impl(0)
 {
     // set program details
-    Options::SetProgramInfo("bamtools stats", "prints general alignment statistics", "[-in <filename> -in <filename> ... | -list <filelist>] [statsOptions]");
+    Options::SetProgramInfo("bamtools stats", "prints general alignment statistics", "[-in <filename> -in <filename> ... | -list <filelist>] [-threads <count>] [statsOptions]");
     
     // set up options 
     OptionGroup* IO_Opts = Options::CreateOptionGroup("Input & Output");
     Options::AddValueOption("-in", "BAM filename", "the input BAM file", "", m_settings->HasInput,  m_settings->InputFiles,  IO_Opts, Options::StandardIn());
     Options::AddValueOption("-list",  "filename", "the input BAM file list, one line per file", "", m_settings->HasInputFilelist,  m_settings->InputFilelist, IO_Opts);
+    Options::AddValueOption("-threads", "count", "number of threads used to accumulate stats", "", m_settings->HasNumThreads, m_settings->NumThreads, IO_Opts, STATS_DEFAULT_NUM_THREADS);
     
     OptionGroup* AdditionalOpts = Options::CreateOptionGroup("Additional Stats");
     Options::AddOption("-insert", "summarize insert size data", m_settings->IsShowingInsertSizeSummary, AdditionalOpts);
+    Options::AddOption("-mapq",   "show mapping quality distribution", m_settings->IsShowingMapQualities, AdditionalOpts);
+    Options::AddOption("-length", "show read length distribution", m_settings->IsShowingReadLengths, AdditionalOpts);
+    Options::AddOption("-refs",   "show number of reads per reference", m_settings->IsShowingReferences, AdditionalOpts);
 }
 
 StatsTool::~StatsTool(void) {
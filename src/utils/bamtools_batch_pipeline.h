@@ -0,0 +1,216 @@
+// ***************************************************************************
+// bamtools_batch_pipeline.h (c) 2026
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Last modified: 19 October 2026
+// ---------------------------------------------------------------------------
+// Provides a generic read => process => write pipeline, where batches of
+// records are processed by several worker threads but written in their
+// original order.
+//
+// BatchPipeline does not know anything about the data itself. Instead, it
+// drives a client-supplied 'Stages' object that provides:
+//
+//     bool ReadBatch(Batch& batch);     fills batch, returns false when input is exhausted
+//                                       (called on a dedicated reader thread)
+//     void ProcessBatch(Batch& batch);  does the actual work on a batch
+//                                       (called concurrently, from the worker threads)
+//     void WriteBatch(Batch& batch);    consumes a processed batch
+//                                       (called on the thread that calls Run(), in read order)
+//
+// Batch objects are recycled (a fixed number of them is allocated up front),
+// so the stages should reuse any storage they contain rather than reallocate.
+//
+// Reading & processing run on BamWorkerPools: a single-threaded one for the
+// reader (so batches are read in order), which passes each batch it fills on to
+// a pool of workers.
+//
+// AlignmentBatch & ReadAlignmentBatch() cover the common case of batches of
+// alignments read from a BamMultiReader. Tools derive their batch type from
+// AlignmentBatch to add per-alignment results.
+// ***************************************************************************
+
+#ifndef BAMTOOLS_BATCH_PIPELINE_H
+#define BAMTOOLS_BATCH_PIPELINE_H
+
+#include <api/BamAlignment.h>
+#include <api/BamAux.h>
+#include <api/BamMultiReader.h>
+#include "shared/bamtools_worker_pool.h"
+#include <deque>
+#include <vector>
+
+namespace BamTools {
+
+const size_t ALIGNMENT_BATCH_SIZE = 4096; // number of alignments per batch
+
+// batch of alignments read from BamMultiReader
+// (alignment objects are reused from batch to batch, so Count gives the number in use)
+struct AlignmentBatch {
+    std::vector<BamAlignment> Alignments;
+    size_t Count;
+
+    AlignmentBatch(void)
+        : Alignments(ALIGNMENT_BATCH_SIZE)
+        , Count(0)
+    { }
+};
+
+// returns true if alignment overlaps region (for input without index data)
+inline bool IsOverlapping(const BamAlignment& al, const BamRegion& region) {
+    return ( (al.RefID >= region.LeftRefID)  && ((al.Position + al.Length) >= region.LeftPosition) &&
+             (al.RefID <= region.RightRefID) && ( al.Position <= region.RightPosition) );
+}
+
+// fills batch with reader's next alignments, returns false if none were left
+// char data is only parsed if @isCharDataNeeded, & alignments outside @region (if any) are skipped
+inline bool ReadAlignmentBatch(BamMultiReader& reader,
+                               AlignmentBatch& batch,
+                               const bool isCharDataNeeded = false,
+                               const BamRegion* region = 0)
+{
+    batch.Count = 0;
+    while ( batch.Count < batch.Alignments.size() ) {
+        BamAlignment& al = batch.Alignments[batch.Count];
+        const bool isRead = ( isCharDataNeeded ? reader.GetNextAlignment(al)
+                                               : reader.GetNextAlignmentCore(al) );
+        if ( !isRead )
+            break;
+        if ( region && !IsOverlapping(al, *region) )
+            continue;
+        ++batch.Count;
+    }
+    return ( batch.Count > 0 );
+}
+
+template<typename Batch, typename Stages>
+class BatchPipeline {
+
+    // ctor & dtor
+    public:
+        BatchPipeline(Stages& stages, const unsigned int numThreads);
+        ~BatchPipeline(void);
+
+    // BatchPipeline interface
+    public:
+        // reads, processes & writes all batches, returns when input is exhausted
+        void Run(void);
+
+    // internal types
+    private:
+        struct Slot;
+
+        // a batch's turn in the reader & worker pools
+        struct ReadJob {
+            Slot* Owner;
+            bool IsDone;
+        };
+        struct ProcessJob {
+            Slot* Owner;
+            bool IsDone;
+        };
+
+        struct Slot {
+            Batch Data;
+            bool IsFilled;              // false if input ran out before this batch
+            ReadJob Reading;
+            ProcessJob Processing;
+        };
+
+        typedef BamWorkerPool<ReadJob, BatchPipeline>    ReaderPool;
+        typedef BamWorkerPool<ProcessJob, BatchPipeline> WorkerPool;
+
+    // BamWorkerPool processing (called from pools' threads)
+    public:
+        // fills next batch & hands it on to the workers
+        void Process(ReadJob& job);
+        // processes a filled batch
+        void Process(ProcessJob& job);
+
+    // not copyable
+    private:
+        BatchPipeline(const BatchPipeline&);
+        BatchPipeline& operator=(const BatchPipeline&);
+
+    // data members
+    private:
+        Stages& m_stages;
+        unsigned int m_numThreads;
+        std::vector<Slot> m_slots;
+        WorkerPool* m_workers;          // set during Run()
+        bool m_isReadDone;              // only touched by reader
+};
+
+template<typename Batch, typename Stages>
+BatchPipeline<Batch, Stages>::BatchPipeline(Stages& stages, const unsigned int numThreads)
+    : m_stages(stages)
+    , m_numThreads( numThreads == 0 ? 1 : numThreads )
+    , m_workers(0)
+    , m_isReadDone(false)
+{
+    // enough batches to keep every worker busy, with one being read & one being written
+    m_slots.resize(2*m_numThreads + 2);
+    for ( size_t i = 0; i < m_slots.size(); ++i ) {
+        Slot& slot = m_slots[i];
+        slot.IsFilled = false;
+        slot.Reading.Owner = &slot;
+        slot.Reading.IsDone = true;
+        slot.Processing.Owner = &slot;
+        slot.Processing.IsDone = true;
+    }
+}
+
+template<typename Batch, typename Stages>
+BatchPipeline<Batch, Stages>::~BatchPipeline(void) { }
+
+template<typename Batch, typename Stages>
+void BatchPipeline<Batch, Stages>::Process(ReadJob& job) {
+    Slot& slot = *job.Owner;
+    slot.IsFilled = ( !m_isReadDone && m_stages.ReadBatch(slot.Data) );
+    if ( slot.IsFilled )
+        m_workers->Submit(&slot.Processing);
+    else
+        m_isReadDone = true;
+}
+
+template<typename Batch, typename Stages>
+void BatchPipeline<Batch, Stages>::Process(ProcessJob& job) {
+    m_stages.ProcessBatch(job.Owner->Data);
+}
+
+template<typename Batch, typename Stages>
+void BatchPipeline<Batch, Stages>::Run(void) {
+
+    // (if threads can't be started, pools run jobs as they are submitted, on this thread)
+    WorkerPool workers(*this, m_numThreads);
+    ReaderPool reader(*this, 1);
+    m_workers = &workers;
+    m_isReadDone = false;
+
+    // queue up all batches for reading
+    std::deque<Slot*> pending;
+    for ( size_t i = 0; i < m_slots.size(); ++i ) {
+        pending.push_back(&m_slots[i]);
+        reader.Submit(&m_slots[i].Reading);
+    }
+
+    // write processed batches in read order, recycling each for another read
+    // stops at the first batch that found input exhausted (as will all batches after it)
+    while ( true ) {
+        Slot* slot = pending.front();
+        pending.pop_front();
+        reader.Wait(&slot->Reading);
+        if ( !slot->IsFilled )
+            break;
+        workers.Wait(&slot->Processing);
+        m_stages.WriteBatch(slot->Data);
+        pending.push_back(slot);
+        reader.Submit(&slot->Reading);
+    }
+
+    // pools finish any remaining (empty) reads as they go out of scope
+}
+
+} // namespace BamTools
+
+#endif // BAMTOOLS_BATCH_PIPELINE_H
@@ -35,6 +35,20 @@
 //      etc. )  
 //
 //    This allows for more complex queries (than simple isEqual?) against a variety of data types.
+//
+// Before the first query is checked, the engine 'compiles' itself:
+//
+//     each filter set is handed to FilterChecker::compile(), which returns a
+//     FilterChecker::CompiledFilter that FilterChecker::check() evaluates per query
+//
+//     the postfix rule queue is flattened into a list of FilterRuleOps, where AND|OR
+//     are turned into conditional jumps (so a rule stops as soon as its result is known)
+//
+// Changing filters, properties or rules afterwards simply triggers a re-compile.
+//
+// Once compiled, check() does not modify the engine, so it may be called from
+// several threads at once - provided that FilterChecker::check() is itself
+// thread-safe & compile() was called explicitly before the threads started.
 // 
 // ***************************************************************************
 
@@ -65,6 +79,34 @@ struct UTILS_EXPORT FilterCompareType {
     };
 };
   
+// -----------------------------------------------------------
+// FilterRuleOp
+
+// single instruction of a compiled rule expression
+//
+// a program is evaluated in order, keeping a single boolean result:
+//     CHECK_FILTER  : result = check query against compiled filter at index Argument
+//     NOT           : result = !result
+//     JUMP_IF_FALSE : if result is false, skip the next Argument instructions
+//     JUMP_IF_TRUE  : if result is true, skip the next Argument instructions
+struct UTILS_EXPORT FilterRuleOp {
+    enum Type { CHECK_FILTER = 0
+              , NOT
+              , JUMP_IF_FALSE
+              , JUMP_IF_TRUE
+    };
+
+    Type Op;
+    size_t Argument;
+
+    FilterRuleOp(const Type& op = CHECK_FILTER, const size_t argument = 0)
+        : Op(op)
+        , Argument(argument)
+    { }
+};
+
+typedef std::vector<FilterRuleOp> FilterRuleProgram;
+
 // -----------------------------------------------------------
 // FilterEngine
   
@@ -76,6 +118,7 @@ class UTILS_EXPORT FilterEngine {
         FilterEngine(void) 
             : m_ruleString("")
             , m_isRuleQueueGenerated(false)
+            , m_isCompiled(false)
             , m_defaultCompareType(FilterCompareType::OR)
             , AND_OPERATOR("&")
             , OR_OPERATOR("|")
@@ -131,15 +174,20 @@ class UTILS_EXPORT FilterEngine {
     // query evaluation
     public:
         // returns true if query passes all filters in FilterEngine
+        // (query is non-const so that checker may lazily populate any data it needs)
         template<typename T>
-        bool check(const T& query);
+        bool check(T& query);
+
+        // compiles filters & rule expression, done automatically on first check()
+        // (call explicitly before checking queries from multiple threads)
+        void compile(void);
 
     // internal rule-handling methods
     private:
         void buildDefaultRuleString(void);
         void buildRuleQueue(void);
         template<typename T>
-        bool evaluateFilterRules(const T& query);
+        bool evaluateFilterRules(T& query);
         
     // data members
     private:
@@ -158,6 +206,13 @@ class UTILS_EXPORT FilterEngine {
         
         // flag to test if the rule expression queue has been generated
         bool m_isRuleQueueGenerated;
+
+        // compiled filters (in order of first use in rule) & flattened rule expression
+        std::vector<typename FilterChecker::CompiledFilter> m_compiledFilters;
+        FilterRuleProgram m_ruleProgram;
+
+        // flag to test if filters & rules have been compiled (since last modification)
+        bool m_isCompiled;
         
         // 'default' comparison operator between filters if no rule string given
         // if this is changed, m_ruleString is used to build new m_ruleQueue
@@ -182,6 +237,7 @@ class UTILS_EXPORT FilterEngine {
 // creates a new filter set, returns true if created, false if error or already exists
 template<typename FilterChecker>
 inline bool FilterEngine<FilterChecker>::addFilter(const std::string& filterName) {
+    m_isCompiled = false;
     return (m_filters.insert(std::make_pair(filterName, PropertyFilter()))).second;
 }
 
@@ -258,16 +314,86 @@ inline void FilterEngine<FilterChecker>::buildRuleQueue(void) {
     
     // set flag if rule queue contains any values
     m_isRuleQueueGenerated = (!m_ruleQueue.empty());    
+    m_isCompiled = false;
 }
 
 // returns whether query value passes filter engine rules
 template<class FilterChecker> template<typename T>
-bool FilterEngine<FilterChecker>::check(const T& query) {
+bool FilterEngine<FilterChecker>::check(T& query) {
   
     // return result of querying against filter rules
     return evaluateFilterRules(query);
 }
 
+// compiles each filter used by rule expression & flattens postfix rule queue into a program
+template<typename FilterChecker>
+inline void FilterEngine<FilterChecker>::compile(void) {
+
+    // build ruleQueue if not done before
+    if ( !m_isRuleQueueGenerated )
+        buildRuleQueue();
+
+    m_compiledFilters.clear();
+    m_ruleProgram.clear();
+
+    // filter name => index in m_compiledFilters
+    std::map<std::string, size_t> filterIndexes;
+
+    // each stack entry holds the program for one (sub-)expression
+    std::stack<FilterRuleProgram> programStack;
+    std::queue<std::string> ruleQueueCopy = m_ruleQueue;
+    while ( !ruleQueueCopy.empty() ) {
+        const std::string& token = ruleQueueCopy.front();
+
+        // token is NOT_OPERATOR
+        if ( token == FilterEngine<FilterChecker>::NOT_OPERATOR ) {
+            BAMTOOLS_ASSERT_MESSAGE( !programStack.empty(), "Empty result stack - cannot apply operator: !" );
+            programStack.top().push_back( FilterRuleOp(FilterRuleOp::NOT) );
+        }
+
+        // token is AND_OPERATOR or OR_OPERATOR
+        // left operand is evaluated first, right operand is skipped if left already decides result
+        else if ( token == FilterEngine<FilterChecker>::AND_OPERATOR ||
+                  token == FilterEngine<FilterChecker>::OR_OPERATOR )
+        {
+            BAMTOOLS_ASSERT_MESSAGE( programStack.size() >= 2 , "Not enough operands - cannot apply operator" );
+            const FilterRuleProgram rightProgram = programStack.top();
+            programStack.pop();
+            FilterRuleProgram& leftProgram = programStack.top();
+
+            const FilterRuleOp::Type jumpType = ( token == FilterEngine<FilterChecker>::AND_OPERATOR
+                                                ? FilterRuleOp::JUMP_IF_FALSE
+                                                : FilterRuleOp::JUMP_IF_TRUE );
+            leftProgram.push_back( FilterRuleOp(jumpType, rightProgram.size()) );
+            leftProgram.insert( leftProgram.end(), rightProgram.begin(), rightProgram.end() );
+        }
+
+        // token is an operand
+        else {
+
+            // compile filter on first use
+            std::map<std::string, size_t>::const_iterator indexIter = filterIndexes.find(token);
+            if ( indexIter == filterIndexes.end() ) {
+                FilterMap::const_iterator filterIter = m_filters.find(token);
+                BAMTOOLS_ASSERT_MESSAGE( (filterIter != m_filters.end()), "Filter mentioned in rule, not found in FilterEngine" );
+                m_compiledFilters.push_back( m_checker.compile((*filterIter).second) );
+                indexIter = filterIndexes.insert( std::make_pair(token, m_compiledFilters.size()-1) ).first;
+            }
+
+            programStack.push( FilterRuleProgram(1, FilterRuleOp(FilterRuleOp::CHECK_FILTER, (*indexIter).second)) );
+        }
+
+        // pop token from ruleQueue
+        ruleQueueCopy.pop();
+    }
+
+    // store final program
+    BAMTOOLS_ASSERT_MESSAGE( programStack.size() == 1, "Result stack should only have one value remaining - cannot return result" );
+    if ( !programStack.empty() )
+        m_ruleProgram = programStack.top();
+    m_isCompiled = true;
+}
+
 // returns list of property names that are 'enabled' ( only those touched by setProperty() )
 template<typename FilterChecker>
 inline const std::vector<std::string> FilterEngine<FilterChecker>::enabledPropertyNames(void) {
@@ -284,60 +410,31 @@ inline const std::vector<std::string> FilterEngine<FilterChecker>::enabledProper
     return names;
 }
 
-// evaluates postfix rule queue - with each filter as an operand, AND|OR|NOT as operators
+// evaluates compiled rule program - with each filter check as an operand, AND|OR|NOT as jumps/negation
 template<class FilterChecker> template<typename T>
-bool FilterEngine<FilterChecker>::evaluateFilterRules(const T& query) {
+bool FilterEngine<FilterChecker>::evaluateFilterRules(T& query) {
   
-    // build ruleQueue if not done before
-    if ( !m_isRuleQueueGenerated ) 
-        buildRuleQueue();
+    // compile filters & rules if not done before
+    if ( !m_isCompiled ) 
+        compile();
     
-    std::stack<bool> resultStack;
-    FilterMap::const_iterator filterIter;
-    FilterMap::const_iterator filterEnd  = m_filters.end();
-    std::queue<std::string> ruleQueueCopy = m_ruleQueue;
-    while ( !ruleQueueCopy.empty() ) {
-        const std::string& token = ruleQueueCopy.front();
-        
-        // token is NOT_OPERATOR
-        if ( token == FilterEngine<FilterChecker>::NOT_OPERATOR ) {
-            BAMTOOLS_ASSERT_MESSAGE( !resultStack.empty(), "Empty result stack - cannot apply operator: !" );
-            resultStack.top() = !resultStack.top();
-        }
-        
-        // token is AND_OPERATOR
-        else if ( token == FilterEngine<FilterChecker>::AND_OPERATOR ) {
-            BAMTOOLS_ASSERT_MESSAGE( resultStack.size() >= 2 , "Not enough operands - cannot apply operator: &" );
-            bool topResult = resultStack.top();
-            resultStack.pop();
-            resultStack.top() &= topResult;
-        }
-        
-        // token is OR_OPERATOR
-        else if ( token == FilterEngine<FilterChecker>::OR_OPERATOR ) {
-            BAMTOOLS_ASSERT_MESSAGE( resultStack.size() >= 2 , "Not enough operands - cannot apply operator: |" );
-            bool topResult = resultStack.top();
-            resultStack.pop();
-            resultStack.top() |= topResult;
-        }
-        
-        // token is an operand 
-        else {
-            // look up PropertyFilter that matches this token 
-            filterIter = m_filters.find(token);
-            BAMTOOLS_ASSERT_MESSAGE( (filterIter != filterEnd), "Filter mentioned in rule, not found in FilterEngine" );
-            const PropertyFilter& filter = (*filterIter).second;
-            bool result = m_checker.check(filter, query);
-            resultStack.push( result );
+    BAMTOOLS_ASSERT_MESSAGE( !m_ruleProgram.empty(), "Empty rule program - cannot return result" );
+
+    bool result = false;
+    const size_t numOps = m_ruleProgram.size();
+    for ( size_t i = 0; i < numOps; ++i ) {
+        const FilterRuleOp& op = m_ruleProgram[i];
+        switch ( op.Op ) {
+            case ( FilterRuleOp::CHECK_FILTER )  : result = m_checker.check(m_compiledFilters[op.Argument], query); break;
+            case ( FilterRuleOp::NOT )           : result = !result; break;
+            case ( FilterRuleOp::JUMP_IF_FALSE ) : if ( !result ) i += op.Argument; break;
+            case ( FilterRuleOp::JUMP_IF_TRUE )  : if (  result ) i += op.Argument; break;
+            default : BAMTOOLS_ASSERT_UNREACHABLE;
         }
-        
-        // pop token from ruleQueue
-        ruleQueueCopy.pop();
     }
     
     // return last result
-    BAMTOOLS_ASSERT_MESSAGE( resultStack.size() == 1, "Result stack should only have one value remaining - cannot return result" );
-    return resultStack.top();
+    return result;
 }
 
 // return list of current filter names
@@ -498,6 +595,7 @@ bool FilterEngine<FilterChecker>::setProperty(const std::string& filterName,
     // lookup filter by name, return false if not found
     FilterMap::iterator filterIter = m_filters.find(filterName);
     if ( filterIter == m_filters.end() ) return false;
+    m_isCompiled = false;
       
     // lookup property for filter, add new PropertyFilterValue if not found, modify if already exists
     PropertyFilter& filter = (*filterIter).second;
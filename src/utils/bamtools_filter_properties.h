@@ -76,6 +76,12 @@ struct UTILS_EXPORT PropertyFilterValue {
     template<typename T>
     bool check(const T& query) const;
     bool check(const std::string& query) const;
+
+    // compare query against an (already extracted) value
+    // used directly by compiled filters, to skip the Variant lookups in check()
+    template<typename T>
+    static bool compare(const T& query, const T& value, const ValueCompareType& type);
+    static bool compare(const std::string& query, const std::string& value, const ValueCompareType& type);
              
     // data members
     Variant Value;
@@ -99,13 +105,19 @@ bool PropertyFilterValue::check(const T& query) const {
     } 
     
     // numeric matching based on our filter type
-    switch ( Type ) {
-        case ( PropertyFilterValue::EXACT)              : return ( query == Value.get<T>() );
-        case ( PropertyFilterValue::GREATER_THAN)       : return ( query >  Value.get<T>() ); 
-        case ( PropertyFilterValue::GREATER_THAN_EQUAL) : return ( query >= Value.get<T>() ); 
-        case ( PropertyFilterValue::LESS_THAN)          : return ( query <  Value.get<T>() );
-        case ( PropertyFilterValue::LESS_THAN_EQUAL)    : return ( query <= Value.get<T>() );
-        case ( PropertyFilterValue::NOT)                : return ( query != Value.get<T>() );
+    return compare(query, Value.get<T>(), Type);
+}
+
+// checks a numeric query against a value, using compare type
+template<typename T>
+bool PropertyFilterValue::compare(const T& query, const T& value, const ValueCompareType& type) {
+    switch ( type ) {
+        case ( PropertyFilterValue::EXACT)              : return ( query == value );
+        case ( PropertyFilterValue::GREATER_THAN)       : return ( query >  value ); 
+        case ( PropertyFilterValue::GREATER_THAN_EQUAL) : return ( query >= value ); 
+        case ( PropertyFilterValue::LESS_THAN)          : return ( query <  value );
+        case ( PropertyFilterValue::LESS_THAN_EQUAL)    : return ( query <= value );
+        case ( PropertyFilterValue::NOT)                : return ( query != value );
         default : BAMTOOLS_ASSERT_UNREACHABLE;
     }
     return false;
@@ -121,11 +133,17 @@ bool PropertyFilterValue::check(const std::string& query) const {
         return false;
     }
   
-    // localize string version of our filter value
-    const std::string& valueString = Value.get<std::string>();
-    
     // string matching based on our filter type
-    switch ( Type ) {
+    return compare(query, Value.get<std::string>(), Type);
+}
+
+// checks a string query against a value, using compare type
+inline
+bool PropertyFilterValue::compare(const std::string& query,
+                                  const std::string& valueString,
+                                  const ValueCompareType& type)
+{
+    switch ( type ) {
         case ( PropertyFilterValue::CONTAINS)           : return ( query.find(valueString) != std::string::npos );
         case ( PropertyFilterValue::ENDS_WITH)          : return ( query.find(valueString) == (query.length() - valueString.length()) ); 
         case ( PropertyFilterValue::EXACT)              : return ( query == valueString );
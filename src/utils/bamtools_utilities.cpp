@@ -2,7 +2,7 @@
 // bamtools_utilities.cpp (c) 2010 Derek Barnett, Erik Garrison
 // Marth Lab, Department of Biology, Boston College
 // ---------------------------------------------------------------------------
-// Last modified: 8 October 2011
+// Last modified: 19 October 2026
 // ---------------------------------------------------------------------------
 // Provides general utilities used by BamTools sub-tools.
 // ***************************************************************************
@@ -88,7 +88,7 @@ bool Utilities::ParseRegionString(const string& regionString,
         startChrom = regionString;
         startPos   = 0;
         stopChrom  = regionString;
-        stopPos    = 0;
+        stopPos    = -1;
     }
     
     // colon found, so we at least have some sort of startPos requested